@@ -0,0 +1,60 @@
+#include "candlewick/utils/LoadMesh.h"
+#include "candlewick/utils/MeshData.h"
+#include <benchmark/benchmark.h>
+
+#include <assimp/mesh.h>
+
+#include <array>
+#include <memory>
+
+using namespace candlewick;
+
+/// Triangulated n x n grid with normals and tangents, as produced by the
+/// assimp importer.
+static aiMesh *makeGridMesh(unsigned n) {
+  auto *mesh = new aiMesh;
+  mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+  mesh->mNumVertices = n * n;
+  mesh->mVertices = new aiVector3D[n * n];
+  mesh->mNormals = new aiVector3D[n * n];
+  mesh->mTangents = new aiVector3D[n * n];
+  mesh->mBitangents = new aiVector3D[n * n];
+  for (unsigned i = 0; i < n; i++) {
+    for (unsigned j = 0; j < n; j++) {
+      const unsigned k = i * n + j;
+      mesh->mVertices[k] = aiVector3D(ai_real(i), ai_real(j), 0);
+      mesh->mNormals[k] = aiVector3D(0, 0, 1);
+      mesh->mTangents[k] = aiVector3D(1, 0, 0);
+      mesh->mBitangents[k] = aiVector3D(0, 1, 0);
+    }
+  }
+  mesh->mNumFaces = 2 * (n - 1) * (n - 1);
+  mesh->mFaces = new aiFace[mesh->mNumFaces];
+  unsigned f = 0;
+  for (unsigned i = 0; i + 1 < n; i++) {
+    for (unsigned j = 0; j + 1 < n; j++) {
+      const unsigned k = i * n + j;
+      const std::array<unsigned, 3> tris[] = {{k, k + 1, k + n},
+                                              {k + 1, k + n + 1, k + n}};
+      for (const auto &tri : tris) {
+        aiFace &face = mesh->mFaces[f++];
+        face.mNumIndices = 3;
+        face.mIndices = new unsigned[3]{tri[0], tri[1], tri[2]};
+      }
+    }
+  }
+  return mesh;
+}
+
+static void BM_loadAiMesh(benchmark::State &state) {
+  const auto n = unsigned(state.range(0));
+  std::unique_ptr<aiMesh> mesh{makeGridMesh(n)};
+  aiMatrix4x4 transform;
+  aiMatrix4x4::Translation(aiVector3D(1, 2, 3), transform);
+  for (auto _ : state) {
+    MeshData md = loadAiMesh(mesh.get(), transform);
+    benchmark::DoNotOptimize(md.vertexData().data());
+  }
+  state.SetItemsProcessed(state.iterations() * n * n);
+}
+BENCHMARK(BM_loadAiMesh)->RangeMultiplier(4)->Range(16, 1024);
@@ -0,0 +1,50 @@
+#include "candlewick/utils/MeshData.h"
+#include "candlewick/utils/MeshTransforms.h"
+#include "candlewick/primitives/Sphere.h"
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace candlewick;
+
+static void BM_apply3DTransformInPlace(benchmark::State &state) {
+  const auto rings = Uint32(state.range(0));
+  MeshData mesh = loadUvSphereSolid(rings, 2 * rings);
+  const Eigen::Affine3f tr = Eigen::Translation3f(0.1f, 0.2f, 0.3f) *
+                             Eigen::AngleAxisf(0.5f, Float3::UnitZ()) *
+                             Eigen::Scaling(1.01f);
+  for (auto _ : state) {
+    apply3DTransformInPlace(mesh, tr);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * mesh.numVertices());
+}
+BENCHMARK(BM_apply3DTransformInPlace)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_triangleStripGenerateIndices(benchmark::State &state) {
+  const auto vertexCount = Uint32(state.range(0));
+  std::vector<Uint32> indices;
+  for (auto _ : state) {
+    indices.clear();
+    triangleStripGenerateIndices(vertexCount, indices);
+    benchmark::DoNotOptimize(indices.data());
+  }
+  state.SetItemsProcessed(state.iterations() * vertexCount);
+}
+BENCHMARK(BM_triangleStripGenerateIndices)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 19);
+
+static void BM_mergeMeshes(benchmark::State &state) {
+  const auto numMeshes = size_t(state.range(0));
+  std::vector<MeshData> meshes;
+  meshes.reserve(numMeshes);
+  for (size_t i = 0; i < numMeshes; i++)
+    meshes.push_back(loadUvSphereSolid(12, 24));
+  for (auto _ : state) {
+    MeshData merged = mergeMeshes(std::span<const MeshData>(meshes));
+    benchmark::DoNotOptimize(merged.vertexData().data());
+  }
+  state.SetItemsProcessed(state.iterations() * numMeshes);
+}
+BENCHMARK(BM_mergeMeshes)->RangeMultiplier(4)->Range(4, 256);
@@ -0,0 +1,91 @@
+#include "candlewick/utils/PixelFormatConversion.h"
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+using namespace candlewick;
+
+// 1920 x 1080 frame
+static constexpr Uint32 kNumPixels = 1920 * 1080;
+
+static void setLevelOrSkip(benchmark::State &state) {
+  auto level = SimdLevel(state.range(0));
+  if (!setSimdLevel(level))
+    state.SkipWithError("Instruction set not supported by this CPU.");
+}
+
+static void dispatchArgs(benchmark::internal::Benchmark *b) {
+  b->ArgName("simd");
+  for (auto level : {SimdLevel::Scalar, SimdLevel::SSE4_1, SimdLevel::AVX2,
+                     SimdLevel::NEON})
+    b->Arg(int(level));
+}
+
+static std::vector<float> makeDepths() {
+  std::mt19937 gen{0};
+  std::uniform_real_distribution<float> dist{0.f, 1.f};
+  std::vector<float> depth(kNumPixels);
+  for (auto &d : depth)
+    d = dist(gen);
+  return depth;
+}
+
+static void BM_bgraToRgba(benchmark::State &state) {
+  setLevelOrSkip(state);
+  std::vector<Uint32> in(kNumPixels, 0xFF102030);
+  std::vector<Uint32> out(kNumPixels);
+  for (auto _ : state) {
+    bgraToRgbaConvert(in.data(), out.data(), kNumPixels);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPixels * 4);
+}
+BENCHMARK(BM_bgraToRgba)->Apply(dispatchArgs);
+
+static void BM_bgraToRgbaInPlace(benchmark::State &state) {
+  setLevelOrSkip(state);
+  std::vector<Uint32> pixels(kNumPixels, 0xFF102030);
+  for (auto _ : state) {
+    bgraToRgbaConvert(pixels.data(), kNumPixels);
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPixels * 4);
+}
+BENCHMARK(BM_bgraToRgbaInPlace)->Apply(dispatchArgs);
+
+static void BM_rgbaToRgb(benchmark::State &state) {
+  setLevelOrSkip(state);
+  std::vector<Uint8> in(4 * kNumPixels, 0x7F);
+  std::vector<Uint8> out(3 * kNumPixels);
+  for (auto _ : state) {
+    rgbaToRgbConvert(in.data(), out.data(), kNumPixels);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPixels * 4);
+}
+BENCHMARK(BM_rgbaToRgb)->Apply(dispatchArgs);
+
+static void BM_depthToUint16(benchmark::State &state) {
+  setLevelOrSkip(state);
+  const auto in = makeDepths();
+  std::vector<Uint16> out(kNumPixels);
+  for (auto _ : state) {
+    depthToUint16Convert(in.data(), out.data(), kNumPixels, 65535.f);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPixels * 4);
+}
+BENCHMARK(BM_depthToUint16)->Apply(dispatchArgs);
+
+static void BM_linearizeDepth(benchmark::State &state) {
+  setLevelOrSkip(state);
+  const auto in = makeDepths();
+  std::vector<float> out(kNumPixels);
+  for (auto _ : state) {
+    linearizeDepthConvert(in.data(), out.data(), kNumPixels, 0.01f, 100.f);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPixels * 4);
+}
+BENCHMARK(BM_linearizeDepth)->Apply(dispatchArgs);
@@ -0,0 +1,81 @@
+#include "candlewick/primitives/Primitives.h"
+#include <benchmark/benchmark.h>
+
+using namespace candlewick;
+
+static void BM_loadUvSphereSolid(benchmark::State &state) {
+  const auto rings = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadUvSphereSolid(rings, 2 * rings);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadUvSphereSolid)->RangeMultiplier(4)->Range(8, 128);
+
+static void BM_loadCylinderSolid(benchmark::State &state) {
+  const auto segments = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadCylinderSolid(4, segments, 0.5f, 1.f);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadCylinderSolid)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_loadCapsuleSolid(benchmark::State &state) {
+  const auto segments = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadCapsuleSolid(segments / 2, segments, 1.f);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadCapsuleSolid)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_loadConeSolid(benchmark::State &state) {
+  const auto segments = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadConeSolid(segments, 0.5f, 1.f);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadConeSolid)->RangeMultiplier(4)->Range(16, 256);
+
+static void BM_loadArrowSolid(benchmark::State &state) {
+  for (auto _ : state) {
+    MeshData mesh = loadArrowSolid(true);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadArrowSolid);
+
+static void BM_loadGrid(benchmark::State &state) {
+  const auto halfSize = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadGrid(halfSize);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadGrid)->RangeMultiplier(4)->Range(8, 512);
+
+static void BM_loadPlaneTiled(benchmark::State &state) {
+  const auto repeat = Uint32(state.range(0));
+  for (auto _ : state) {
+    MeshData mesh = loadPlaneTiled(0.5f, repeat, repeat);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+}
+BENCHMARK(BM_loadPlaneTiled)->RangeMultiplier(4)->Range(4, 256);
+
+static void BM_loadHeightfield(benchmark::State &state) {
+  const auto n = Eigen::Index(state.range(0));
+  const Eigen::VectorXf grid = Eigen::VectorXf::LinSpaced(n, -1.f, 1.f);
+  Eigen::MatrixXf heights(n, n);
+  for (Eigen::Index i = 0; i < n; i++)
+    for (Eigen::Index j = 0; j < n; j++)
+      heights(i, j) = 0.1f * std::sin(4.f * grid[i]) * std::cos(4.f * grid[j]);
+  for (auto _ : state) {
+    MeshData mesh = loadHeightfield(heights, grid, grid);
+    benchmark::DoNotOptimize(mesh.vertexData().data());
+  }
+  state.SetItemsProcessed(state.iterations() * n * n);
+}
+BENCHMARK(BM_loadHeightfield)->RangeMultiplier(4)->Range(16, 1024);
@@ -0,0 +1,50 @@
+#include "candlewick/multibody/Multibody.h"
+#include "candlewick/multibody/RobotScene.h"
+#include "candlewick/core/Components.h"
+#include <benchmark/benchmark.h>
+
+#include <coal/shape/geometric_shapes.h>
+#include <pinocchio/multibody/geometry.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace candlewick;
+using namespace candlewick::multibody;
+
+/// Registry holding one entity per geometry object, without any GPU mesh.
+struct SyntheticRobot {
+  pin::GeometryModel geomModel;
+  pin::GeometryData geomData{geomModel};
+  entt::registry registry;
+
+  explicit SyntheticRobot(size_t numGeoms) {
+    auto box = std::make_shared<coal::Box>(0.1, 0.1, 0.1);
+    for (size_t i = 0; i < numGeoms; i++) {
+      pin::GeometryObject gobj{"geom_" + std::to_string(i), 0,
+                               pin::SE3::Identity(), box};
+      gobj.meshScale.setConstant(2.);
+      geomModel.addGeometryObject(gobj);
+    }
+    geomData = pin::GeometryData{geomModel};
+    for (auto &oMg : geomData.oMg)
+      oMg.setRandom();
+    for (pin::GeomIndex i = 0; i < geomModel.ngeoms; i++) {
+      auto ent = registry.create();
+      registry.emplace<PinGeomObjComponent>(ent, i);
+      registry.emplace<TransformComponent>(ent, Mat4f::Identity());
+      registry.emplace<MeshMaterialComponent>(ent, Mesh{NoInit},
+                                              std::vector<PbrMaterial>{});
+    }
+  }
+};
+
+static void BM_updateRobotTransforms(benchmark::State &state) {
+  SyntheticRobot robot{size_t(state.range(0))};
+  for (auto _ : state) {
+    updateRobotTransforms(robot.registry, robot.geomModel, robot.geomData);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_updateRobotTransforms)->RangeMultiplier(4)->Range(16, 4096);
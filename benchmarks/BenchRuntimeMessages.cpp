@@ -0,0 +1,56 @@
+#include "candlewick/runtime/Messages.h"
+#include <benchmark/benchmark.h>
+
+using namespace candlewick::runtime;
+
+/// State update packed as `(q, v)` by the Python client.
+static msgpack::sbuffer packStateUpdate(Eigen::Index n) {
+  auto make_array = [n](double value) {
+    ArrayMessage msg{"float64", {long(n)}, {}};
+    const Eigen::VectorXd x = Eigen::VectorXd::Constant(n, value);
+    const auto *bytes = reinterpret_cast<const uint8_t *>(x.data());
+    msg.data.assign(bytes, bytes + n * Eigen::Index(sizeof(double)));
+    return msg;
+  };
+  msgpack::sbuffer buffer;
+  msgpack::pack(buffer, std::make_tuple(make_array(1.), make_array(2.)));
+  return buffer;
+}
+
+// Decoding by conversion to owning ArrayMessage objects.
+static void BM_decodeArrayMessage(benchmark::State &state) {
+  const msgpack::sbuffer buffer = packStateUpdate(state.range(0));
+  for (auto _ : state) {
+    auto handle = msgpack::unpack(buffer.data(), buffer.size());
+    auto [q, v] = handle.get().as<std::tuple<ArrayMessage, ArrayMessage>>();
+    benchmark::DoNotOptimize(q.data.data());
+    benchmark::DoNotOptimize(v.data.data());
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(buffer.size()));
+}
+BENCHMARK(BM_decodeArrayMessage)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Decoding in place, as done by the runtime for state updates.
+static void BM_decodeArrayMessageView(benchmark::State &state) {
+  const msgpack::sbuffer buffer = packStateUpdate(state.range(0));
+  msgpack::zone zone;
+  Eigen::VectorXd q_scratch, v_scratch;
+  for (auto _ : state) {
+    zone.clear();
+    std::size_t offset = 0;
+    msgpack::object obj = msgpack::unpack(zone, buffer.data(), buffer.size(),
+                                          offset, unpack_reference_all);
+    ArrayMessageView q_msg, v_msg;
+    if (!get_array_view(obj.via.array.ptr[0], q_msg) ||
+        !get_array_view(obj.via.array.ptr[1], v_msg)) {
+      state.SkipWithError("Failed to decode state update.");
+      break;
+    }
+    auto q = get_vector_map(q_msg, q_scratch);
+    auto v = get_vector_map(v_msg, v_scratch);
+    benchmark::DoNotOptimize(q.data());
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(buffer.size()));
+}
+BENCHMARK(BM_decodeArrayMessageView)->RangeMultiplier(8)->Range(8, 1 << 15);
@@ -0,0 +1,14 @@
+#include "candlewick/core/Shader.h"
+#include <benchmark/benchmark.h>
+
+using namespace candlewick;
+
+static void BM_loadShaderMetadata(benchmark::State &state, const char *name) {
+  setShadersDirectory(CANDLEWICK_COMPILED_SHADERS_DIR);
+  for (auto _ : state) {
+    auto config = loadShaderMetadata(name);
+    benchmark::DoNotOptimize(config);
+  }
+}
+BENCHMARK_CAPTURE(BM_loadShaderMetadata, DrawQuad_vert, "DrawQuad.vert");
+BENCHMARK_CAPTURE(BM_loadShaderMetadata, PbrBasic_frag, "PbrBasic.frag");
@@ -0,0 +1,450 @@
+/// \file RenderThroughput.cpp
+/// \brief End-to-end render throughput benchmark on procedurally generated
+/// scenes.
+///
+/// Renders a fixed number of frames of a RobotScene and a DebugScene into a
+/// hidden window, without presenting, and reports the frame rate, the CPU time
+/// spent in each pass and the render statistics as JSON.
+///
+/// To benchmark on machines without a GPU, use a software Vulkan driver
+/// (e.g. Mesa's lavapipe) and SDL's offscreen video driver:
+///
+///     VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json \
+///       candlewick_render_benchmark --gpu-driver vulkan \
+///       --video-driver offscreen --robots 16 --output results.json
+#include "candlewick/core/CameraControls.h"
+#include "candlewick/core/DebugScene.h"
+#include "candlewick/core/DepthAndShadowPass.h"
+#include "candlewick/core/RenderContext.h"
+#include "candlewick/core/RenderStats.h"
+#include "candlewick/multibody/RobotScene.h"
+#include "candlewick/primitives/Primitives.h"
+
+#include <pinocchio/algorithm/geometry.hpp>
+#include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/multibody/geometry.hpp>
+#include <pinocchio/multibody/model.hpp>
+
+#include <coal/shape/geometric_shapes.h>
+
+#include <SDL3/SDL_hints.h>
+#include <SDL3/SDL_init.h>
+
+#include <CLI/App.hpp>
+#include <CLI/Config.hpp>
+#include <CLI/Formatter.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace pin = pinocchio;
+using namespace candlewick;
+using multibody::RobotScene;
+
+namespace {
+
+struct Options {
+  Uint32 robots = 1;
+  Uint32 envObjects = 0;
+  Uint32 transparentObjects = 0;
+  Uint32 lights = 2;
+  Uint32 frames = 300;
+  Uint32 warmupFrames = 30;
+  Uint32 width = 1280;
+  Uint32 height = 720;
+  Uint32 msaa = 1;
+  bool shadows = true;
+  bool ssao = true;
+  bool instancing = true;
+  std::string gpuDriver;
+  std::string videoDriver;
+  std::string output;
+};
+
+/// CPU timings of the parts of a frame, in the order they are recorded.
+enum FramePart {
+  UPDATE,
+  SHADOW,
+  OPAQUE_PASS,
+  DEBUG,
+  TRANSPARENT_PASS,
+  SUBMIT_AND_WAIT,
+  NUM_FRAME_PARTS,
+};
+constexpr const char *kFramePartNames[] = {
+    "update", "shadow", "opaque", "debug", "transparent", "submit_and_wait",
+};
+
+constexpr const char *kStatsPassNames[] = {
+    "other", "shadow", "ssao", "opaque", "debug", "transparent", "gui",
+};
+static_assert(std::size(kStatsPassNames) == kNumRenderStatsPasses);
+
+/// Serial arm on a floating base: alternating revolute joints with capsule
+/// links, a box at the wrist and a translucent sphere as end-effector.
+void buildSyntheticRobot(pin::Model &model, pin::GeometryModel &geom_model) {
+  constexpr int kNumLinks = 6;
+  constexpr double kLinkLength = 0.2;
+  pin::JointIndex parent =
+      model.addJoint(0, pin::JointModelFreeFlyer(), pin::SE3::Identity(),
+                     "root_joint");
+  auto base = std::make_shared<coal::Cylinder>(0.1, 0.05);
+  pin::GeometryObject base_obj{"base", parent, base, pin::SE3::Identity()};
+  base_obj.meshColor << 0.3, 0.3, 0.35, 1.;
+  base_obj.overrideMaterial = true;
+  geom_model.addGeometryObject(base_obj);
+
+  pin::SE3 joint_placement = pin::SE3::Identity();
+  joint_placement.translation() << 0., 0., 0.025;
+  for (int i = 0; i < kNumLinks; i++) {
+    const std::string name = "link" + std::to_string(i);
+    if (i % 2 == 0)
+      parent = model.addJoint(parent, pin::JointModelRZ(), joint_placement,
+                              name + "_joint");
+    else
+      parent = model.addJoint(parent, pin::JointModelRY(), joint_placement,
+                              name + "_joint");
+    model.appendBodyToJoint(parent, pin::Inertia::Identity());
+
+    pin::SE3 link_placement = pin::SE3::Identity();
+    link_placement.translation() << 0., 0., 0.5 * kLinkLength;
+    auto capsule = std::make_shared<coal::Capsule>(0.03, kLinkLength);
+    pin::GeometryObject link{name, parent, capsule, link_placement};
+    link.meshColor << 0.9, 0.5 + 0.08 * i, 0.1, 1.;
+    link.overrideMaterial = true;
+    geom_model.addGeometryObject(link);
+    joint_placement.translation() << 0., 0., kLinkLength;
+  }
+
+  pin::SE3 tip = pin::SE3::Identity();
+  tip.translation() << 0., 0., kLinkLength;
+  auto wrist = std::make_shared<coal::Box>(0.08, 0.08, 0.04);
+  pin::GeometryObject wrist_obj{"wrist", parent, wrist, tip};
+  wrist_obj.meshColor << 0.2, 0.2, 0.2, 1.;
+  wrist_obj.overrideMaterial = true;
+  geom_model.addGeometryObject(wrist_obj);
+
+  // translucent, so that robots also exercise the transparent pass
+  tip.translation() << 0., 0., kLinkLength + 0.06;
+  auto ee = std::make_shared<coal::Sphere>(0.05);
+  pin::GeometryObject ee_obj{"end_effector", parent, ee, tip};
+  ee_obj.meshColor << 0.1, 0.6, 0.9, 0.5;
+  ee_obj.overrideMaterial = true;
+  geom_model.addGeometryObject(ee_obj);
+}
+
+struct RobotInstance {
+  pin::Data data;
+  pin::GeometryData geomData;
+  Eigen::VectorXd q;
+  double phase;
+
+  RobotInstance(const pin::Model &model, const pin::GeometryModel &geom_model,
+                double phase)
+      : data(model)
+      , geomData(geom_model)
+      , q(pin::neutral(model))
+      , phase(phase) {}
+};
+
+/// Side length of the square grid holding \p count items.
+Uint32 gridSide(Uint32 count) {
+  return std::max(1u, Uint32(std::ceil(std::sqrt(double(count)))));
+}
+
+void addEnvironment(RobotScene &scene, const Options &opts, float extent) {
+  std::mt19937 gen{42};
+  std::uniform_real_distribution<float> pos{-extent, extent};
+  std::uniform_real_distribution<float> unit{0.f, 1.f};
+
+  MeshData ground = loadPlaneTiled(0.5f, 8, 8);
+  ground.material.baseColor << 0.8f, 0.8f, 0.8f, 1.f;
+  const Eigen::Affine3f ground_pose{Eigen::Scaling(2.f * extent)};
+  scene.addEnvironmentObject(std::move(ground), ground_pose);
+
+  auto place = [&](float z) {
+    Eigen::Affine3f T = Eigen::Affine3f::Identity();
+    T.translate(Float3{pos(gen), pos(gen), z});
+    T.scale(0.1f + 0.2f * unit(gen));
+    return T;
+  };
+  for (Uint32 i = 0; i < opts.envObjects; i++) {
+    MeshData mesh = (i % 2 == 0) ? loadUvSphereSolid(16, 32)
+                                 : loadCylinderSolid(4, 32, 0.5f, 1.f);
+    mesh.material.baseColor << unit(gen), unit(gen), unit(gen), 1.f;
+    scene.addEnvironmentObject(std::move(mesh), place(0.2f));
+  }
+  for (Uint32 i = 0; i < opts.transparentObjects; i++) {
+    MeshData mesh = loadUvSphereSolid(16, 32);
+    mesh.material.baseColor << unit(gen), unit(gen), unit(gen), 0.4f;
+    scene.addEnvironmentObject(std::move(mesh), place(0.5f));
+  }
+}
+
+void setupLights(RobotScene &scene, Uint32 numLights) {
+  for (Uint32 i = 0; i < kNumLights; i++) {
+    auto &light = scene.directionalLight[i];
+    const float angle = 2.f * constants::Pif * float(i) / float(numLights);
+    light.direction = {std::cos(angle), std::sin(angle), -1.f};
+    light.color.setOnes();
+    light.intensity = i < numLights ? 8.f / float(numLights) : 0.f;
+  }
+}
+
+nlohmann::json countersToJson(const RenderCounters &c, double frames) {
+  return {
+      {"draw_calls", double(c.drawCalls) / frames},
+      {"instances", double(c.instances) / frames},
+      {"triangles", double(c.triangles) / frames},
+      {"pipeline_binds", double(c.pipelineBinds) / frames},
+      {"vertex_buffer_binds", double(c.vertexBufferBinds) / frames},
+      {"index_buffer_binds", double(c.indexBufferBinds) / frames},
+      {"uniform_bytes", double(c.uniformBytes) / frames},
+      {"render_passes", double(c.renderPasses) / frames},
+  };
+}
+
+SDL_GPUSampleCount sampleCountFromValue(Uint32 samples) {
+  switch (samples) {
+  case 1:
+    return SDL_GPU_SAMPLECOUNT_1;
+  case 2:
+    return SDL_GPU_SAMPLECOUNT_2;
+  case 4:
+    return SDL_GPU_SAMPLECOUNT_4;
+  case 8:
+    return SDL_GPU_SAMPLECOUNT_8;
+  default:
+    terminate_with_message("Unsupported MSAA sample count {:d}.", samples);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opts;
+  CLI::App app{"Candlewick end-to-end render throughput benchmark"};
+  argv = app.ensure_utf8(argv);
+  app.add_option("--robots", opts.robots, "Number of robot instances")
+      ->check(CLI::PositiveNumber);
+  app.add_option("--env-objects", opts.envObjects,
+                 "Number of opaque environment objects");
+  app.add_option("--transparent", opts.transparentObjects,
+                 "Number of transparent environment objects");
+  app.add_option("--lights", opts.lights, "Number of directional lights")
+      ->check(CLI::Range(1u, Uint32(kNumLights)));
+  app.add_option("--frames", opts.frames, "Number of measured frames");
+  app.add_option("--warmup", opts.warmupFrames, "Number of warmup frames");
+  app.add_option("--width", opts.width, "Render width");
+  app.add_option("--height", opts.height, "Render height");
+  app.add_option("--msaa", opts.msaa, "MSAA sample count (1, 2, 4 or 8)");
+  app.add_flag("!--no-shadows", opts.shadows, "Disable shadow maps");
+  app.add_flag("!--no-ssao", opts.ssao, "Disable ambient occlusion");
+  app.add_flag("!--no-instancing", opts.instancing,
+               "Disable instanced draws of shared meshes");
+  app.add_option("--gpu-driver", opts.gpuDriver,
+                 "SDL GPU driver (e.g. vulkan, metal)");
+  app.add_option("--video-driver", opts.videoDriver,
+                 "SDL video driver (e.g. offscreen for headless machines)");
+  app.add_option("-o,--output", opts.output,
+                 "JSON output file (default: standard output)");
+  CLI11_PARSE(app, argc, argv);
+
+  if (!opts.gpuDriver.empty())
+    SDL_SetHint(SDL_HINT_GPU_DRIVER, opts.gpuDriver.c_str());
+  if (!opts.videoDriver.empty())
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, opts.videoDriver.c_str());
+  if (!SDL_Init(SDL_INIT_VIDEO))
+    terminate_with_message("Failed to init video: {:s}", SDL_GetError());
+
+  RenderContext renderer{Device{auto_detect_shader_format_subset()},
+                         Window{"Candlewick render benchmark", int(opts.width),
+                                int(opts.height), SDL_WINDOW_HIDDEN},
+                         SDL_GPU_TEXTUREFORMAT_D32_FLOAT};
+  renderer.enableMSAA(sampleCountFromValue(opts.msaa));
+  const Device &device = renderer.device;
+
+  // Scene setup
+  pin::Model model;
+  pin::GeometryModel geom_model;
+  buildSyntheticRobot(model, geom_model);
+
+  const Uint32 side = gridSide(opts.robots);
+  const float spacing = 1.f;
+  const float extent = 0.5f * spacing * float(side) + 1.f;
+  std::vector<std::unique_ptr<RobotInstance>> robots;
+  for (Uint32 i = 0; i < opts.robots; i++) {
+    auto &robot = robots.emplace_back(std::make_unique<RobotInstance>(
+        model, geom_model, 0.37 * double(i)));
+    robot->q[0] = spacing * (double(i % side) - 0.5 * double(side - 1));
+    robot->q[1] = spacing * (double(i / side) - 0.5 * double(side - 1));
+  }
+
+  entt::registry registry;
+  RobotScene robot_scene{registry, renderer};
+  RobotScene::Config config;
+  config.enable_shadows = opts.shadows;
+  config.enable_ssao = opts.ssao;
+  config.enable_instancing = opts.instancing;
+  config.shadow_config.numLights = opts.lights;
+  robot_scene.setConfig(config);
+  for (Uint32 i = 0; i < opts.robots; i++) {
+    robot_scene.addRobot("robot" + std::to_string(i), geom_model,
+                         robots[i]->geomData);
+  }
+  addEnvironment(robot_scene, opts, extent);
+  setupLights(robot_scene, opts.lights);
+
+  DebugScene debug_scene{registry, renderer};
+  debug_scene.addLineGrid();
+  debug_scene.addTriad();
+
+  AABB world_bounds{Eigen::Vector3d(-extent, -extent, 0.),
+                    Eigen::Vector3d(extent, extent, 1.5)};
+
+  CylindricalCamera controller;
+  controller.lookAt(Float3{1.2f * extent, 1.2f * extent, 0.8f * extent},
+                    Float3::Zero());
+  controller.camera.projection =
+      perspectiveFromFov(55.0_degf, float(opts.width) / float(opts.height),
+                         0.01f, 100.f);
+
+  // Frame loop
+  using clock = std::chrono::steady_clock;
+  std::array<double, NUM_FRAME_PARTS> part_ms{};
+  std::vector<double> frame_ms;
+  frame_ms.reserve(opts.frames);
+  RenderStats stats_sum;
+
+  render_stats::endFrame(); // discard the uploads of the scene setup
+  const Uint32 total_frames = opts.warmupFrames + opts.frames;
+  clock::time_point measure_start;
+  for (Uint32 frame = 0; frame < total_frames; frame++) {
+    const bool measured = frame >= opts.warmupFrames;
+    if (frame == opts.warmupFrames)
+      measure_start = clock::now();
+    const double t = double(frame) / 60.;
+    std::array<clock::time_point, NUM_FRAME_PARTS + 1> stamps;
+    stamps[0] = clock::now();
+
+    for (auto &robot : robots) {
+      for (int j = 0; j < model.nv - 6; j++)
+        robot->q[7 + j] = 0.6 * std::sin(t + robot->phase + 0.5 * j);
+      pin::forwardKinematics(model, robot->data, robot->q);
+      pin::updateGeometryPlacements(model, robot->data, geom_model,
+                                    robot->geomData);
+    }
+    robot_scene.update();
+    debug_scene.update();
+    stamps[1] = clock::now();
+
+    CommandBuffer command_buffer = renderer.acquireCommandBuffer();
+    debug_scene.collectInstances(command_buffer);
+    if (robot_scene.shadowsEnabled()) {
+      robot_scene.collectOpaqueCastables(command_buffer);
+      renderShadowPassFromAABB(command_buffer, robot_scene.shadowPass,
+                               robot_scene.directionalLight,
+                               robot_scene.castables(), world_bounds,
+                               robot_scene.instancedCastables());
+    }
+    stamps[2] = clock::now();
+    robot_scene.renderOpaque(command_buffer, controller);
+    stamps[3] = clock::now();
+    debug_scene.render(command_buffer, controller);
+    stamps[4] = clock::now();
+    robot_scene.renderTransparent(command_buffer, controller);
+    stamps[5] = clock::now();
+
+    // wait for the GPU, so that the frame rate accounts for GPU time
+    SDL_GPUFence *fence = command_buffer.submitAndAcquireFence();
+    if (!fence)
+      terminate_with_message("Failed to submit command buffer: {:s}",
+                             SDL_GetError());
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+    SDL_ReleaseGPUFence(device, fence);
+    stamps[6] = clock::now();
+
+    if (measured) {
+      for (size_t i = 0; i < NUM_FRAME_PARTS; i++) {
+        part_ms[i] += std::chrono::duration<double, std::milli>(stamps[i + 1] -
+                                                                stamps[i])
+                          .count();
+      }
+      frame_ms.push_back(
+          std::chrono::duration<double, std::milli>(stamps[6] - stamps[0])
+              .count());
+      const RenderStats &frame_stats = render_stats::currentFrame();
+      for (size_t i = 0; i < kNumRenderStatsPasses; i++)
+        stats_sum.passes[i] += frame_stats.passes[i];
+    }
+    render_stats::endFrame();
+  }
+  const double wall_s =
+      std::chrono::duration<double>(clock::now() - measure_start).count();
+
+  // Report
+  const double n = std::max(1., double(opts.frames));
+  std::vector<double> sorted_ms = frame_ms;
+  std::sort(sorted_ms.begin(), sorted_ms.end());
+  auto percentile = [&](double p) {
+    if (sorted_ms.empty())
+      return 0.;
+    return sorted_ms[size_t(p * double(sorted_ms.size() - 1))];
+  };
+
+  nlohmann::json report;
+  report["config"] = {
+      {"robots", opts.robots},
+      {"robot_geometries", geom_model.ngeoms},
+      {"env_objects", opts.envObjects},
+      {"transparent_objects", opts.transparentObjects},
+      {"lights", opts.lights},
+      {"frames", opts.frames},
+      {"warmup_frames", opts.warmupFrames},
+      {"width", opts.width},
+      {"height", opts.height},
+      {"msaa", opts.msaa},
+      {"shadows", opts.shadows},
+      {"ssao", opts.ssao},
+      {"instancing", opts.instancing},
+  };
+  report["device"] = {
+      {"gpu_driver", device.driverName()},
+      {"video_driver", SDL_GetCurrentVideoDriver()},
+  };
+  report["fps"] = wall_s > 0. ? double(opts.frames) / wall_s : 0.;
+  report["frame_ms"] = {
+      {"mean", 1e3 * wall_s / n},
+      {"p50", percentile(0.5)},
+      {"p95", percentile(0.95)},
+      {"max", sorted_ms.empty() ? 0. : sorted_ms.back()},
+  };
+  for (size_t i = 0; i < NUM_FRAME_PARTS; i++)
+    report["cpu_ms"][kFramePartNames[i]] = part_ms[i] / n;
+  for (size_t i = 0; i < kNumRenderStatsPasses; i++)
+    report["render_stats"][kStatsPassNames[i]] =
+        countersToJson(stats_sum.passes[i], n);
+  report["render_stats"]["total"] = countersToJson(stats_sum.total(), n);
+
+  if (opts.output.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file{opts.output};
+    if (!file)
+      terminate_with_message("Failed to open output file {:s}.", opts.output);
+    file << report.dump(2) << std::endl;
+  }
+
+  robot_scene.release();
+  debug_scene.release();
+  renderer.destroy();
+  SDL_Quit();
+  return 0;
+}
@@ -3,6 +3,7 @@ import zmq
 import numpy as np
 import msgspec
 
+from multiprocessing import resource_tracker, shared_memory
 from pinocchio.visualize import BaseVisualizer
 from typing import Any, Type, Optional
 
@@ -56,6 +57,57 @@ def send_cam_pose(sock: zmq.Socket, M: np.ndarray):
     return sock.recv()
 
 
+class SharedMemoryStatePublisher:
+    """Client for the shared memory state transport of the candlewick runtime
+    (`candlewick-visualizer --shm-name <name>`), for clients on the same host.
+
+    This mirrors `candlewick::runtime::SharedMemoryState`: the segment holds the
+    latest (q, v) record, protected by a seqlock. The segment is created by the
+    runtime once it has received the models.
+
+    .. note:: This relies on 8-byte aligned stores being atomic and not
+        reordered, which holds on x86-64.
+    """
+
+    MAGIC = 0x53574443
+    VERSION = 1
+    SEQUENCE_OFFSET = 64
+    HAS_VELOCITY_OFFSET = 72
+    DATA_OFFSET = 128
+
+    def __init__(self, name: str):
+        self._shm = shared_memory.SharedMemory(name=name, create=False)
+        # the runtime owns the segment: don't let the resource tracker unlink it
+        # when this process exits
+        resource_tracker.unregister(self._shm._name, "shared_memory")
+        header = np.ndarray((4,), dtype=np.uint32, buffer=self._shm.buf)
+        if header[0] != self.MAGIC or header[1] != self.VERSION:
+            raise RuntimeError(f"Shared memory segment '{name}' has an unexpected header.")
+        self.nq = int(header[2])
+        self.nv = int(header[3])
+        buf = self._shm.buf
+        self._seq = np.ndarray((1,), np.uint64, buf, offset=self.SEQUENCE_OFFSET)
+        self._has_v = np.ndarray((1,), np.uint32, buf, offset=self.HAS_VELOCITY_OFFSET)
+        self._q = np.ndarray((self.nq,), np.float64, buf, offset=self.DATA_OFFSET)
+        self._v = np.ndarray(
+            (self.nv,), np.float64, buf, offset=self.DATA_OFFSET + 8 * self.nq
+        )
+
+    def write(self, q: np.ndarray, v: Optional[np.ndarray] = None):
+        """Publish a new state. This never blocks."""
+        seq = int(self._seq[0])
+        self._seq[0] = seq + 1  # odd: write in progress
+        self._q[:] = q
+        if v is not None:
+            self._v[:] = v
+        self._has_v[0] = v is not None
+        self._seq[0] = seq + 2
+
+    def close(self):
+        self._seq = self._has_v = self._q = self._v = None
+        self._shm.close()
+
+
 class AsyncVisualizer(BaseVisualizer):
     """A visualizer-like client for the candlewick runtime."""
 
@@ -69,6 +121,8 @@ class AsyncVisualizer(BaseVisualizer):
         self.zmq_ctx = zmq.Context.instance()
         self.sync_sock = self.zmq_ctx.socket(zmq.REQ)
         self.publisher = self.zmq_ctx.socket(zmq.PUB)
+        self.shm_publisher: Optional[SharedMemoryStatePublisher] = None
+        self.robots: dict[str, pin.Model] = {}
         self.model: pin.Model
         self.visual_model: pin.GeometryModel
 
@@ -90,6 +144,14 @@ class AsyncVisualizer(BaseVisualizer):
         response = send_models(self.sync_sock, model_str, geom_str).decode()
         assert response == "ok"
 
+    def connectSharedMemory(self, name: str):
+        """Publish states through the runtime's shared memory segment instead
+        of the ZMQ state socket. The runtime must have been started with
+        `--shm-name <name>`, and the models must have been loaded."""
+        self.shm_publisher = SharedMemoryStatePublisher(name)
+        assert self.shm_publisher.nq == self.model.nq
+        assert self.shm_publisher.nv == self.model.nv
+
     def rebuildData(self):
         raise NotImplementedError(
             f"""This method is not implemented. {type(self).__name__} does not "
@@ -104,22 +166,141 @@ class AsyncVisualizer(BaseVisualizer):
         response = self.sync_sock.recv().decode()
         assert response == "ok"
 
-    def display(self, q: np.ndarray, v: Optional[np.ndarray] = None):
-        """Publish the robot state."""
-        assert q.size == self.model.nq
+    def addRobot(self, name: str, model: pin.Model, visual_model: pin.GeometryModel):
+        """Add a named robot to the runtime's scene, after the main models were
+        loaded. Its states are published with `display(q, v, robot=name)`."""
+        payload = _encoder.encode(
+            (name, model.saveToString(), visual_model.saveToString())
+        )
+        self._send_command(b"add_robot", payload)
+        self.robots[name] = model
+
+    def addRobotInstance(self, name: str, source: Optional[str] = None):
+        """Add another instance of the robot `source` (the main robot by
+        default). The runtime reuses the models and GPU meshes of `source`,
+        and draws the instances together."""
+        payload = _encoder.encode((name, source or ""))
+        self._send_command(b"add_robot_instance", payload)
+        self.robots[name] = self.model if source is None else self.robots[source]
+
+    def display(
+        self,
+        q: np.ndarray,
+        v: Optional[np.ndarray] = None,
+        robot: Optional[str] = None,
+    ):
+        """Publish the state of the main robot, or of the robot called `robot`
+        (see addRobot())."""
+        model = self.model if robot is None else self.robots[robot]
+        assert q.size == model.nq
         if v is not None:
-            assert v.size == self.model.nv
+            assert v.size == model.nv
+        if robot is None and self.shm_publisher is not None:
+            self.shm_publisher.write(q, v)
+            return
+        topic = b"state_update"
+        if robot is not None:
+            topic += b"/" + robot.encode("utf-8")
         payload = _encoder.encode((q, v))
-        self.sync_sock.send_multipart([b"state_update", payload])
+        self.publisher.send_multipart([topic, payload])
+
+    def setPointCloud(
+        self, name: str, points: np.ndarray, colors: Optional[np.ndarray] = None
+    ):
+        """Publish the points of the point cloud called `name`, created on first
+        use, e.g. at the rate of a depth camera. Only the newest cloud is drawn
+        when several arrive within a frame.
+
+        :param points: positions, of shape (N, 3), converted to float32.
+        :param colors: optional RGBA colors, of shape (N, 4), as uint8.
+        """
+        points = np.ascontiguousarray(points, dtype=np.float32)
+        assert points.ndim == 2 and points.shape[1] == 3
+        if colors is not None:
+            colors = np.ascontiguousarray(colors, dtype=np.uint8)
+            assert colors.shape == (points.shape[0], 4)
+        topic = b"point_cloud/" + name.encode("utf-8")
+        self.publisher.send_multipart([topic, _encoder.encode((points, colors))])
+
+    def getRuntimeStats(self) -> dict:
+        """Counters of the runtime's state stream: number of rendered
+        `frames`, and number of states `received`, `applied` and `dropped`
+        (superseded by a newer state before being displayed)."""
+        self.sync_sock.send_multipart([b"get_runtime_stats", b""])
+        return msgspec.msgpack.decode(self.sync_sock.recv())
+
+    def _send_command(self, header: bytes, payload: bytes = b""):
+        self.sync_sock.send_multipart([header, payload])
+        response = self.sync_sock.recv().decode("utf-8")
+        if response != "ok":
+            raise RuntimeError(f"Visualizer runtime error: {response}")
+
+    def sendTrajectory(
+        self,
+        qs: np.ndarray,
+        times: Optional[np.ndarray] = None,
+        vs: Optional[np.ndarray] = None,
+        dt: Optional[float] = None,
+        play: bool = True,
+        loop: bool = False,
+        rate: float = 1.0,
+    ):
+        """Upload a whole trajectory to the runtime, which plays it back on its
+        own, interpolating configurations on the configuration manifold.
+
+        :param qs: configurations, of shape (T, nq).
+        :param times: strictly increasing timestamps, of shape (T,). If None,
+            waypoints are spaced by `dt`.
+        :param vs: optional velocities, of shape (T, nv).
+        :param play: start playing right away.
+        :param loop: restart from the beginning when reaching the end.
+        :param rate: playback rate, 1 being real-time.
+        """
+        qs = np.ascontiguousarray(qs, dtype=np.float64)
+        assert qs.ndim == 2 and qs.shape[1] == self.model.nq
+        if times is None:
+            if dt is None:
+                raise ValueError("Either times or dt must be provided.")
+            times = dt * np.arange(qs.shape[0])
+        times = np.ascontiguousarray(times, dtype=np.float64)
+        assert times.shape == (qs.shape[0],)
+        if vs is not None:
+            vs = np.ascontiguousarray(vs, dtype=np.float64)
+            assert vs.shape == (qs.shape[0], self.model.nv)
+        self._send_command(b"send_trajectory", _encoder.encode((qs, vs, times)))
+        self.setTrajectoryLoop(loop)
+        self.setTrajectoryRate(rate)
+        if play:
+            self.playTrajectory()
+
+    def playTrajectory(self):
+        """Start or resume playing the uploaded trajectory."""
+        self._send_command(b"play_trajectory")
+
+    def pauseTrajectory(self):
+        self._send_command(b"pause_trajectory")
+
+    def seekTrajectory(self, t: float):
+        """Move the playback head to time `t`."""
+        self._send_command(b"seek_trajectory", _encoder.encode(float(t)))
+
+    def setTrajectoryRate(self, rate: float):
+        self._send_command(b"set_trajectory_rate", _encoder.encode(float(rate)))
+
+    def setTrajectoryLoop(self, loop: bool):
+        self._send_command(b"set_trajectory_loop", _encoder.encode(bool(loop)))
 
     def clean(self):
         """Clean the robot from the renderer. Equivalent to `viz.clean()` on the synchronous `Visualizer` class."""
         self.sync_sock.send_multipart([b"cmd_clean", b""])
         response = self.sync_sock.recv().decode()
         assert response == "ok"
+        self.robots.clear()
 
     def close(self):
         self.clean()
+        if self.shm_publisher is not None:
+            self.shm_publisher.close()
         self.publisher.close()
         self.sync_sock.close()
 
@@ -12,6 +12,8 @@ void exposeVideoRecorder() {
       ._c(fps, "Frame rate.")
       ._c(bitRate, "Video bitrate.")
       ._c(outputWidth, "Output video width.")
-      ._c(outputHeight, "Output video height.");
+      ._c(outputHeight, "Output video height.")
+      ._c(gpuConversion,
+          "Rescale and convert frames to YUV on the GPU before readback.");
 #undef _c
 }
@@ -57,4 +57,34 @@ void exposeRenderer() {
       .add_property("hasDepthTexture", &RenderContext::hasDepthTexture)
       .def("enableMSAA", &RenderContext::enableMSAA, ("self"_a, "samples"))
       .def("disableMSAA", &RenderContext::disableMSAA, ("self"_a));
+
+  bp::enum_<RenderStatsPass>("RenderStatsPass")
+      .value("Other", RenderStatsPass::Other)
+      .value("Shadow", RenderStatsPass::Shadow)
+      .value("Ssao", RenderStatsPass::Ssao)
+      .value("Opaque", RenderStatsPass::Opaque)
+      .value("Debug", RenderStatsPass::Debug)
+      .value("Transparent", RenderStatsPass::Transparent)
+      .value("Gui", RenderStatsPass::Gui);
+
+  bp::class_<RenderCounters>("RenderCounters", bp::init<>("self"_a))
+      .def_readonly("drawCalls", &RenderCounters::drawCalls)
+      .def_readonly("instances", &RenderCounters::instances)
+      .def_readonly("triangles", &RenderCounters::triangles)
+      .def_readonly("pipelineBinds", &RenderCounters::pipelineBinds)
+      .def_readonly("vertexBufferBinds", &RenderCounters::vertexBufferBinds)
+      .def_readonly("indexBufferBinds", &RenderCounters::indexBufferBinds)
+      .def_readonly("uniformBytes", &RenderCounters::uniformBytes)
+      .def_readonly("renderPasses", &RenderCounters::renderPasses);
+
+  bp::class_<RenderStats>("RenderStats", bp::init<>("self"_a))
+      .def(
+          "__getitem__",
+          +[](const RenderStats &s, RenderStatsPass pass) { return s[pass]; },
+          ("self"_a, "pass"))
+      .def("total", &RenderStats::total, ("self"_a));
+
+  bp::def(
+      "lastFrameRenderStats", +[] { return render_stats::lastFrame(); },
+      "Render statistics of the last frame drawn, by pass.");
 }
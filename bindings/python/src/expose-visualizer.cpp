@@ -8,6 +8,8 @@
 #include <pinocchio/multibody/model.hpp>
 #include <pinocchio/multibody/geometry.hpp>
 
+#include <cstring>
+
 using namespace candlewick;
 using namespace candlewick::multibody;
 
@@ -16,6 +18,80 @@ using namespace candlewick::multibody;
                           +[](Visualizer &v) -> auto & { return v.name(); },   \
                           bp::return_internal_reference<>()))
 
+/// Copy a buffer to a new numpy array of the given shape.
+template <typename T>
+static bp::object to_numpy(const std::vector<T> &data,
+                           std::vector<npy_intp> shape, int np_type) {
+  if (data.empty())
+    return bp::object();
+  PyArrayObject *array = eigenpy::call_PyArray_SimpleNew(
+      int(shape.size()), shape.data(), np_type);
+  std::memcpy(PyArray_DATA(array), data.data(), data.size() * sizeof(T));
+  return bp::object(bp::handle<>(reinterpret_cast<PyObject *>(array)));
+}
+
+static bp::dict capture_to_dict(const FrameCapture &capture,
+                                const FrameCaptureConfig &config) {
+  const npy_intp h = capture.height;
+  const npy_intp w = capture.width;
+  bp::dict out;
+  out["color"] = to_numpy(capture.color, {h, w, 4}, NPY_UINT8);
+  if (config.depthFormat == DepthFormat::FLOAT32)
+    out["depth"] = to_numpy(capture.depth, {h, w}, NPY_FLOAT32);
+  else
+    out["depth"] = to_numpy(capture.depthMm, {h, w}, NPY_UINT16);
+  out["normals"] = to_numpy(capture.normals, {h, w, 3}, NPY_FLOAT32);
+  out["instance_ids"] = to_numpy(capture.instanceIds, {h, w}, NPY_UINT32);
+  return out;
+}
+
+static bp::dict visualizer_capture_frame(Visualizer &viz,
+                                         const FrameCaptureConfig &config) {
+  return capture_to_dict(viz.captureFrame(config), config);
+}
+
+static bp::list visualizer_render_sensor_views(Visualizer &viz) {
+  const auto captures = viz.renderSensorViews();
+  bp::list out;
+  for (size_t i = 0; i < captures.size(); i++) {
+    const auto &config = viz.sensorView(i).config.capture;
+    out.append(capture_to_dict(captures[i], config));
+  }
+  return out;
+}
+
+/// Points as a (N, 3) numpy array, and colors as a (N, 4) array.
+using PointsRowMajor = Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>;
+using ColorsRowMajor = Eigen::Matrix<Uint8, Eigen::Dynamic, 4, Eigen::RowMajor>;
+
+/// View a row-major (N, K) array as the K x N column-major matrix with the
+/// same memory, to avoid copying numpy arrays.
+template <typename Scalar, int K>
+static auto columns_view(const Eigen::Ref<const Eigen::Matrix<
+                             Scalar, Eigen::Dynamic, K, Eigen::RowMajor>> &a) {
+  using MapType = Eigen::Map<const Eigen::Matrix<Scalar, K, Eigen::Dynamic>, 0,
+                             Eigen::OuterStride<>>;
+  return MapType{a.data(), K, a.rows(), Eigen::OuterStride<>(a.outerStride())};
+}
+
+static void
+visualizer_set_point_cloud(Visualizer &viz, const std::string &name,
+                           const Eigen::Ref<const PointsRowMajor> &points) {
+  viz.setPointCloud(name, columns_view(points));
+}
+
+static void visualizer_set_point_cloud_colors(
+    Visualizer &viz, const std::string &name,
+    const Eigen::Ref<const PointsRowMajor> &points,
+    const Eigen::Ref<const ColorsRowMajor> &colors) {
+  if (colors.rows() != points.rows()) {
+    PyErr_SetString(PyExc_ValueError,
+                    "colors must have as many rows as points.");
+    bp::throw_error_already_set();
+  }
+  viz.setPointCloud(name, columns_view(points), columns_view(colors));
+}
+
 static auto visualizer_get_frame_debugs(Visualizer &viz) {
   auto view = viz.registry.view<DebugMeshComponent, const PinFrameComponent>();
   bp::list out;
@@ -31,7 +107,10 @@ void exposeVisualizer() {
   eigenpy::OptionalConverter<Vector3, std::optional>::registration();
   eigenpy::OptionalConverter<float, std::optional>::registration();
   eigenpy::OptionalConverter<bool, std::optional>::registration();
+  eigenpy::OptionalConverter<pin::GeomIndex, std::optional>::registration();
   eigenpy::detail::NoneToPython<std::nullopt_t>::registration();
+  eigenpy::enableEigenPySpecific<PointsRowMajor>();
+  eigenpy::enableEigenPySpecific<ColorsRowMajor>();
 
   bp::class_<Visualizer::Config>("VisualizerConfig", bp::no_init)
       .def_readwrite("width", &Visualizer::Config::width)
@@ -40,9 +119,69 @@ void exposeVisualizer() {
                      "MSAA sample count.")
       .def_readwrite("ssaoKernelSize", &Visualizer::Config::ssaoKernelSize,
                      "Kernel size for the SSAO effect.")
+      .def_readwrite("enableInstanceIds",
+                     &Visualizer::Config::enableInstanceIds,
+                     "Render per-pixel instance IDs. This disables MSAA, "
+                     "sampleCount is ignored.")
+      .def_readwrite("loadMeshMaterials",
+                     &Visualizer::Config::loadMeshMaterials,
+                     "Import the mesh files of BVH geometries with their "
+                     "materials, instead of the vertices of the coal BVH "
+                     "models.")
       .def(bp::init<>("self"_a))
       .def(bp::init<Uint32, Uint32>(("self"_a, "width", "height")));
 
+  bp::enum_<DepthFormat>("DepthFormat")
+      .value("FLOAT32", DepthFormat::FLOAT32)
+      .value("UINT16_MM", DepthFormat::UINT16_MM);
+
+  bp::class_<FrameCaptureConfig>("FrameCaptureConfig", bp::init<>("self"_a))
+      .def_readwrite("color", &FrameCaptureConfig::color)
+      .def_readwrite("depth", &FrameCaptureConfig::depth)
+      .def_readwrite("normals", &FrameCaptureConfig::normals)
+      .def_readwrite("instanceIds", &FrameCaptureConfig::instanceIds,
+                     "Requires VisualizerConfig.enableInstanceIds.")
+      .def_readwrite("depthFormat", &FrameCaptureConfig::depthFormat,
+                     "Store depth as float32 meters or uint16 millimeters.");
+
+  bp::class_<CameraIntrinsics>("CameraIntrinsics", bp::init<>("self"_a))
+      .def_readwrite("fx", &CameraIntrinsics::fx)
+      .def_readwrite("fy", &CameraIntrinsics::fy)
+      .def_readwrite("cx", &CameraIntrinsics::cx)
+      .def_readwrite("cy", &CameraIntrinsics::cy)
+      .def_readwrite("width", &CameraIntrinsics::width)
+      .def_readwrite("height", &CameraIntrinsics::height)
+      .def_readwrite("zNear", &CameraIntrinsics::zNear)
+      .def_readwrite("zFar", &CameraIntrinsics::zFar)
+      .def(
+          "fromFov",
+          +[](float fovY, Uint32 width, Uint32 height, float zNear,
+              float zFar) {
+            return CameraIntrinsics::fromFov(Radf(fovY), width, height, zNear,
+                                             zFar);
+          },
+          ("fovY", "width", "height", "zNear"_a = 0.01f, "zFar"_a = 20.f),
+          "Intrinsics of a centered camera with vertical field of view fovY "
+          "(in radians).")
+      .staticmethod("fromFov")
+      .def("projection", &CameraIntrinsics::projection, ("self"_a));
+
+  bp::class_<SensorViewConfig>("SensorViewConfig", bp::init<>("self"_a))
+      .def_readwrite("intrinsics", &SensorViewConfig::intrinsics)
+      .def_readwrite("frame", &SensorViewConfig::frame,
+                     "Frame the sensor is attached to, or None for the world.")
+      .add_property(
+          "placement",
+          +[](const SensorViewConfig &c) -> pin::SE3 {
+            return c.placement.cast<double>();
+          },
+          +[](SensorViewConfig &c, const pin::SE3 &M) {
+            c.placement = M.cast<float>();
+          },
+          "Placement of the optical frame (x right, y down, z forward) "
+          "relative to the frame.")
+      .def_readwrite("capture", &SensorViewConfig::capture);
+
   bp::class_<Visualizer, boost::noncopyable>("Visualizer", bp::no_init)
       .def(bp::init<Visualizer::Config, const pin::Model &,
                     const pin::GeometryModel &>(
@@ -65,7 +204,113 @@ void exposeVisualizer() {
           +[](Visualizer &viz, const std::string &filename) {
             viz.takeScreenshot(filename);
           },
-          ("self"_a, "filename"), "Save a screenshot to the specified file.")
+          ("self"_a, "filename"),
+          "Save a screenshot to the specified file. The file is written "
+          "asynchronously, see waitScreenshots().")
+      .def("waitScreenshots", &Visualizer::waitScreenshots, ("self"_a),
+           "Wait until all pending screenshots are written to disk.")
+      .def("captureFrame", &visualizer_capture_frame,
+           ("self"_a, "config"_a = FrameCaptureConfig{}),
+           "Read back the color (HxWx4 uint8), metric depth (HxW) and "
+           "view-space normals (HxWx3 float32) and optionally instance IDs "
+           "(HxW uint32) of the last rendered frame, as a dict of numpy "
+           "arrays. Background pixels have zero depth, normal and ID.")
+      .def(
+          "readInstanceIds",
+          +[](Visualizer &viz, Uint16 x, Uint16 y, Uint16 width,
+              Uint16 height) {
+            auto ids = viz.readInstanceIds(x, y, width, height);
+            return to_numpy(ids, {height, width}, NPY_UINT32);
+          },
+          ("self"_a, "x", "y", "width"_a = 1, "height"_a = 1),
+          "Read back the instance IDs (HxW uint32) of a region of the last "
+          "rendered frame. Zero is the background.")
+      .def("geometryIndexFromInstanceId",
+           &Visualizer::geometryIndexFromInstanceId, ("self"_a, "id"),
+           "Index of the main robot's visual GeometryObject for an instance "
+           "ID, or None.")
+      .def(
+          "addRobot",
+          +[](Visualizer &viz, const std::string &name, const pin::Model &model,
+              const pin::GeometryModel &visual_model) {
+            viz.addRobot(name, model, visual_model);
+          },
+          ("self"_a, "name", "model", "visual_model"),
+          "Add a named robot to the scene, sharing its render passes. The "
+          "models are copied.")
+      .def(
+          "addRobotInstance",
+          +[](Visualizer &viz, const std::string &name,
+              const std::string &source) {
+            viz.addRobotInstance(name, source);
+          },
+          ("self"_a, "name", "source"_a = ""),
+          "Add another instance of the robot `source` (the main robot by "
+          "default), sharing its models and GPU meshes.")
+      .add_property("numRobots", &Visualizer::numRobots)
+      .def(
+          "robotNames",
+          +[](const Visualizer &viz) {
+            bp::list names;
+            for (size_t i = 0; i < viz.numRobots(); i++)
+              names.append(viz.robot(i).name);
+            return names;
+          },
+          ("self"_a), "Names of the robots added with addRobot().")
+      .def(
+          "setRobotState",
+          +[](Visualizer &viz, const std::string &name,
+              const ConstVectorRef &q,
+              const std::optional<ConstVectorRef> &v) {
+            if (v)
+              viz.setRobotState(name, q, *v);
+            else
+              viz.setRobotState(name, q);
+          },
+          ("self"_a, "name", "q", "v"_a = std::nullopt),
+          "Run forward kinematics for the named robot. Call display() to "
+          "draw all robots.")
+      .def(
+          "saveFrameCapture",
+          +[](Visualizer &viz, const std::string &basename,
+              const FrameCaptureConfig &config) {
+            viz.saveFrameCapture(basename, config);
+          },
+          ("self"_a, "basename", "config"_a = FrameCaptureConfig{}),
+          "Capture the last rendered frame and asynchronously write "
+          "<basename>_color.png, <basename>_depth.{exr,png} and "
+          "<basename>_normals.exr.")
+      .def("setPointCloud", &visualizer_set_point_cloud,
+           ("self"_a, "name", "points"),
+           "Set the points of the point cloud called `name`, created on first "
+           "use, from a (N, 3) float32 array. C-contiguous arrays are read "
+           "without copies. Can be called every frame.")
+      .def("setPointCloud", &visualizer_set_point_cloud_colors,
+           ("self"_a, "name", "points", "colors"),
+           "Set the points of the point cloud called `name` and their RGBA "
+           "colors, from (N, 3) float32 and (N, 4) uint8 arrays.")
+      .def(
+          "removePointCloud",
+          +[](Visualizer &viz, const std::string &name) {
+            viz.removePointCloud(name);
+          },
+          ("self"_a, "name"))
+      .def("addSensorView", &Visualizer::addSensorView, ("self"_a, "config"),
+           "Add an offscreen camera sensor. Returns its index.")
+      .def("clearSensorViews", &Visualizer::clearSensorViews, ("self"_a))
+      .add_property("numSensorViews", &Visualizer::numSensorViews)
+      .def("renderSensorViews", &visualizer_render_sensor_views, ("self"_a),
+           "Render all sensor views in a single pass, sharing the shadow "
+           "maps, and return one dict of numpy arrays per view (see "
+           "captureFrame()).")
+      .def(
+          "saveSensorViews",
+          +[](Visualizer &viz, const std::string &basename) {
+            viz.saveSensorViews(basename);
+          },
+          ("self"_a, "basename"),
+          "Render all sensor views and asynchronously write their buffers to "
+          "<basename>_<index>_* files.")
       .def(
           "startRecording",
           +[]([[maybe_unused]] Visualizer &viz,
@@ -1,5 +1,6 @@
 #include "fwd.hpp"
 #include "candlewick/config.h"
+#include "candlewick/core/Profiler.h"
 #include "candlewick/core/Shader.h"
 #include "candlewick/core/errors.h"
 
@@ -36,6 +37,22 @@ BOOST_PYTHON_MODULE(pycandlewick) {
     return false;
 #endif
       });
+  bp::def(
+      "hasProfilingSupport", +[] {
+#ifdef CANDLEWICK_WITH_PROFILING
+        return true;
+#else
+    return false;
+#endif
+      });
+  bp::def(
+      "writeProfilerTrace",
+      +[](const std::string &filename) {
+        FrameProfiler::instance().writeChromeTrace(filename);
+      },
+      ("filename"_a),
+      "Write the frames recorded by the frame profiler to a Chrome trace "
+      "JSON file.");
 
   // Register SDL_Quit() as a function to call when interpreter exits.
   Py_AtExit(SDL_Quit);
@@ -512,6 +512,7 @@ int main(int argc, char **argv) {
     if (renderer.waitAndAcquireSwapchain(command_buffer)) {
       const GpuMat4 viewProj = g_camera.camera.viewProj();
       robot_scene.collectOpaqueCastables();
+      debug_scene.collectInstances(command_buffer);
       auto &castables = robot_scene.castables();
       // renderShadowPassFromAABB(command_buffer, shadowPassInfo,
       //                          robot_scene.directionalLight, castables,
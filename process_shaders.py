@@ -15,7 +15,9 @@ STAGE_MAP = {
 }
 
 parser = argparse.ArgumentParser(description="Compile Slang shaders using slangc.")
-parser.add_argument("shader_name", help="Base shader name, e.g. 'PbrBasic'.")
+parser.add_argument(
+    "shader_name", nargs="?", help="Base shader name, e.g. 'PbrBasic'."
+)
 group = parser.add_mutually_exclusive_group(required=True)
 group.add_argument(
     "--stages",
@@ -29,19 +31,41 @@ group.add_argument(
     action="store_true",
     help="Process all .slang stage files found for the shader.",
 )
+group.add_argument(
+    "--missing",
+    action="store_true",
+    help="Process the .slang stage files of every shader whose compiled "
+    "artifacts are missing (no shader name needed).",
+)
 parser.add_argument(
     "--spv-only",
     action="store_true",
     help="Only emit SPIR-V and reflection JSON; skip MSL output.",
 )
 args = parser.parse_args()
+if not args.missing and args.shader_name is None:
+    parser.error("a shader name is required, unless --missing is given")
 
 SHADER_SRC_DIR = pt.Path("shaders/src")
 SHADER_OUT_DIR = pt.Path("shaders/compiled")
 
 print("Shader src dir:", SHADER_SRC_DIR.absolute())
 
-if args.all_stages:
+def is_compiled(stage_file: pt.Path) -> bool:
+    base_name = stage_file.name.removesuffix(".slang")
+    exts = [".spv", ".json"] if args.spv_only else [".spv", ".msl", ".json"]
+    return all((SHADER_OUT_DIR / (base_name + ext)).exists() for ext in exts)
+
+
+if args.missing:
+    # Stage files are named like PbrBasic.vert.slang, modules like utils.slang
+    stage_files = sorted(
+        f for f in SHADER_SRC_DIR.glob("*.[a-z]*.slang") if not is_compiled(f)
+    )
+    if not stage_files:
+        print("All shaders are compiled.")
+        sys.exit(0)
+elif args.all_stages:
     # Glob for PbrBasic.vert.slang, PbrBasic.frag.slang, etc.
     stage_files = sorted(SHADER_SRC_DIR.glob(f"{args.shader_name}.[a-z]*.slang"))
 else:
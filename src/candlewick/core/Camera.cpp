@@ -32,6 +32,22 @@ Mat4f perspectiveFromFov(Radf fovY, float aspectRatio, float nearZ,
   return result;
 }
 
+Mat4f perspectiveMatrix(float left, float right, float bottom, float top,
+                        float near, float far) {
+  const float sx = right - left;
+  const float sy = top - bottom;
+
+  Mat4f result = Mat4f::Zero();
+  result(0, 0) = 2.0f * near / sx;
+  result(0, 2) = (right + left) / sx;
+  result(1, 1) = 2.0f * near / sy;
+  result(1, 2) = (top + bottom) / sy;
+  result(2, 2) = (far + near) / (near - far);
+  result(3, 2) = -1.0f;
+  result(2, 3) = (2.0f * far * near) / (near - far);
+  return result;
+}
+
 Mat4f orthographicMatrix(float left, float right, float bottom, float top,
                          float near, float far) {
   const float sx = right - left;
@@ -39,6 +39,24 @@ inline std::array<Float3, 8> getAABBCorners(const AABB &aabb) {
   };
 }
 
+/// \brief Check whether an AABB lies entirely outside of one of the planes of
+/// the view frustum, given the model-view-projection matrix \p mvp.
+///
+/// This is conservative: boxes crossing the frustum corners are kept. The near
+/// plane is tested as \f$ z \geq -w \f$, which holds for both depth ranges.
+inline bool isAABBOutsideFrustum(const AABB &aabb, const Mat4f &mvp) {
+  Eigen::Matrix<float, 4, 8> clip;
+  const auto corners = getAABBCorners(aabb);
+  for (size_t i = 0; i < 8; i++)
+    clip.col(Eigen::Index(i)) = mvp * corners[i].homogeneous();
+  for (Eigen::Index axis = 0; axis < 3; axis++) {
+    if ((clip.row(axis).array() > clip.row(3).array()).all() ||
+        (clip.row(axis).array() < -clip.row(3).array()).all())
+      return true;
+  }
+  return false;
+}
+
 inline AABB applyTransformToAABB(const AABB &aabb, const Mat4f &tr_) {
   auto tr = tr_.cast<coal::CoalScalar>();
   coal::Matrix3s R = tr.topLeftCorner<3, 3>();
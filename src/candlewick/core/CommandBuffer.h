@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core.h"
+#include "RenderStats.h"
 #include <SDL3/SDL_gpu.h>
 #include <span>
 #include <spdlog/spdlog.h>
@@ -111,12 +112,14 @@ public:
   CommandBuffer &pushVertexUniformRaw(Uint32 slot_index, const void *data,
                                       Uint32 length) {
     SDL_PushGPUVertexUniformData(m_handle, slot_index, data, length);
+    render_stats::current().uniformBytes += length;
     return *this;
   }
   /// \brief Push uniform data to the fragment shader.
   CommandBuffer &pushFragmentUniformRaw(Uint32 slot_index, const void *data,
                                         Uint32 length) {
     SDL_PushGPUFragmentUniformData(m_handle, slot_index, data, length);
+    render_stats::current().uniformBytes += length;
     return *this;
   }
 };
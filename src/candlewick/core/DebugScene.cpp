@@ -6,17 +6,28 @@
 #include "../primitives/Arrow.h"
 #include "../primitives/Grid.h"
 
+#include <algorithm>
 #include <imgui.h>
 #include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
 
 namespace candlewick {
 
+/// Uniform block of Hud3dElementInstanced.vert.
+struct alignas(16) DebugCameraUbo {
+  GpuMat4 viewProj;
+  Uint32 firstInstance;
+  /// Index of the instance color to use, i.e. of the mesh view.
+  Uint32 colorIndex;
+};
+
 DebugScene::DebugScene(entt::registry &reg, const RenderContext &renderer)
     : m_registry(reg)
     , m_renderer(renderer)
     , m_trianglePipeline(NoInit)
     , m_linePipeline(NoInit)
-    , m_sharedMeshes() {
+    , m_sharedMeshes()
+    , m_instanceBuffer(renderer.device) {
   this->initializeSharedMeshes();
 }
 
@@ -26,7 +37,11 @@ DebugScene::DebugScene(DebugScene &&other)
     , m_trianglePipeline(std::move(other.m_trianglePipeline))
     , m_linePipeline(std::move(other.m_linePipeline))
     , m_subsystems(std::move(other.m_subsystems))
-    , m_sharedMeshes(std::move(other.m_sharedMeshes)) {}
+    , m_sharedMeshes(std::move(other.m_sharedMeshes))
+    , m_instanceBuffer(std::move(other.m_instanceBuffer))
+    , m_instanceData(std::move(other.m_instanceData))
+    , m_batches(std::move(other.m_batches))
+    , m_instanced(other.m_instanced) {}
 
 void DebugScene::initializeSharedMeshes() {
   {
@@ -74,8 +89,16 @@ DebugScene::addArrow(const Float4 &color) {
 void DebugScene::setupPipelines(const MeshLayout &layout) {
   if (m_linePipeline.initialized() && m_trianglePipeline.initialized())
     return;
-  auto vertexShader = Shader::fromMetadata(device(), "Hud3dElement.vert");
-  auto fragmentShader = Shader::fromMetadata(device(), "Hud3dElement.frag");
+  const char *instanced_shader = "Hud3dElementInstanced.vert";
+  m_instanced = shaderExists(device(), instanced_shader);
+  if (!m_instanced)
+    spdlog::warn("Shader '{:s}' not found, debug elements will be drawn one "
+                 "by one.",
+                 instanced_shader);
+  auto vertexShader = Shader::fromMetadata(
+      device(), m_instanced ? instanced_shader : "Hud3dElement.vert");
+  auto fragmentShader = Shader::fromMetadata(
+      device(), m_instanced ? "VertexColor.frag" : "Hud3dElement.frag");
   SDL_GPUColorTargetDescription color_desc;
   SDL_zero(color_desc);
   color_desc.format = m_renderer.colorFormat();
@@ -109,7 +132,52 @@ void DebugScene::setupPipelines(const MeshLayout &layout) {
     m_linePipeline = GraphicsPipeline(device(), info, "Debug [line]");
 }
 
+void DebugScene::collectInstances(CommandBuffer &cmdBuf) {
+  m_instanceData.clear();
+  m_batches.clear();
+  if (!m_instanced)
+    return;
+
+  constexpr size_t numMeshTypes = magic_enum::enum_count<DebugMeshType>();
+  constexpr size_t numKeys =
+      magic_enum::enum_count<DebugPipelines>() * numMeshTypes;
+  std::array<std::vector<DebugInstanceData>, numKeys> groups;
+
+  auto view =
+      m_registry.view<const DebugMeshComponent, const TransformComponent>(
+          entt::exclude<Disable>);
+  for (auto &&[ent, dmc, tr] : view.each()) {
+    if (!dmc.enable)
+      continue;
+    const size_t key = size_t(dmc.pipeline_type) * numMeshTypes +
+                       size_t(dmc.meshType);
+    DebugInstanceData &data = groups[key].emplace_back();
+    data.model = tr;
+    const size_t numColors =
+        std::min(dmc.colors.size(), size_t(DebugInstanceData::kMaxColors));
+    for (size_t i = 0; i < numColors; i++)
+      data.colors[i] = dmc.colors[i];
+  }
+
+  for (size_t key = 0; key < numKeys; key++) {
+    if (groups[key].empty())
+      continue;
+    m_batches.push_back({
+        .pipeline_type = DebugPipelines(key / numMeshTypes),
+        .meshType = DebugMeshType(key % numMeshTypes),
+        .firstInstance = Uint32(m_instanceData.size()),
+        .numInstances = Uint32(groups[key].size()),
+    });
+    m_instanceData.insert(m_instanceData.end(), groups[key].begin(),
+                          groups[key].end());
+  }
+  if (!m_instanceData.empty())
+    m_instanceBuffer.upload(cmdBuf,
+                            std::span<const DebugInstanceData>(m_instanceData));
+}
+
 void DebugScene::render(CommandBuffer &cmdBuf, const Camera &camera) const {
+  RenderStatsPassScope stats_pass{RenderStatsPass::Debug};
 
   SDL_GPUColorTargetInfo color_target_info;
   SDL_zero(color_target_info);
@@ -131,9 +199,49 @@ void DebugScene::render(CommandBuffer &cmdBuf, const Camera &camera) const {
   depth_target_info.texture = m_renderer.depthTarget();
   depth_target_info.cycle = false;
 
-  SDL_GPURenderPass *render_pass =
-      SDL_BeginGPURenderPass(cmdBuf, &color_target_info, 1, &depth_target_info);
+  SDL_GPURenderPass *render_pass = rend::beginRenderPass(
+      cmdBuf, {&color_target_info, 1}, &depth_target_info);
+
+  if (!m_instanced) {
+    renderEntities(cmdBuf, render_pass, camera);
+    SDL_EndGPURenderPass(render_pass);
+    return;
+  }
+
+  DebugCameraUbo ubo{camera.viewProj(), 0, 0};
 
+  if (!m_batches.empty()) {
+    SDL_GPUBuffer *instance_buffer = m_instanceBuffer.buffer();
+    SDL_BindGPUVertexStorageBuffers(render_pass, 0, &instance_buffer, 1);
+  }
+  for (const InstanceBatch &batch : m_batches) {
+    switch (batch.pipeline_type) {
+    case DebugPipelines::TRIANGLE_FILL:
+      m_trianglePipeline.bind(render_pass);
+      break;
+    case DebugPipelines::TRIANGLE_LINE:
+      m_linePipeline.bind(render_pass);
+      break;
+    }
+
+    auto &mesh = this->getMesh(batch.meshType);
+    CANDLEWICK_ASSERT(mesh.numViews() <= DebugInstanceData::kMaxColors,
+                      "Too many views in debug mesh.");
+    rend::bindMesh(render_pass, mesh);
+    ubo.firstInstance = batch.firstInstance;
+    for (Uint32 i = 0; i < mesh.numViews(); i++) {
+      ubo.colorIndex = i;
+      cmdBuf.pushVertexUniform(TRANSFORM_SLOT, ubo);
+      rend::drawView(render_pass, mesh.view(i), batch.numInstances);
+    }
+  }
+
+  SDL_EndGPURenderPass(render_pass);
+}
+
+void DebugScene::renderEntities(CommandBuffer &cmdBuf,
+                                SDL_GPURenderPass *render_pass,
+                                const Camera &camera) const {
   const Mat4f viewProj = camera.viewProj();
 
   auto group =
@@ -162,13 +270,14 @@ void DebugScene::render(CommandBuffer &cmdBuf, const Camera &camera) const {
       rend::drawView(render_pass, mesh.view(i));
     }
   });
-
-  SDL_EndGPURenderPass(render_pass);
 }
 
 void DebugScene::release() {
   m_trianglePipeline.release();
   m_linePipeline.release();
+  m_instanceBuffer.release();
+  m_instanceData.clear();
+  m_batches.clear();
 
   // clean up all DebugMeshComponent objects.
   auto view = m_registry.view<DebugMeshComponent>();
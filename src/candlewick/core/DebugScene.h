@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GraphicsPipeline.h"
+#include "InstanceBuffer.h"
 #include "Mesh.h"
 #include "RenderContext.h"
 #include "math_types.h"
@@ -38,12 +39,26 @@ protected:
 
 /// \brief Component for simple mesh with colors.
 ///
-/// This is meant for the \c Hud3dElement shader.
+/// This is meant for the \c Hud3dElementInstanced shader, or the \c
+/// Hud3dElement shader when the former is not available.
 struct DebugMeshComponent;
 
+/// \brief Per-instance data of a debug mesh, read from a storage buffer by the
+/// \c Hud3dElementInstanced shader.
+struct alignas(16) DebugInstanceData {
+  /// Maximum number of views (one color each) of a debug mesh.
+  static constexpr Uint32 kMaxColors = 3;
+  GpuMat4 model;
+  std::array<GpuVec4, kMaxColors> colors;
+};
+
 /// \brief %Scene for organizing debug entities and render systems.
 ///
-/// This implements a basic render system for DebugMeshComponent.
+/// This implements a basic render system for DebugMeshComponent. Entities
+/// sharing a pipeline and mesh type are drawn with instanced draws, with their
+/// transforms and colors in a storage buffer (see collectInstances()). If the
+/// \c Hud3dElementInstanced shader is not compiled, entities are drawn one by
+/// one.
 ///
 /// This scene and all subsystems are assumed to use the same shaders and
 /// pipelines.
@@ -56,6 +71,16 @@ class DebugScene {
                   std::unique_ptr<IDebugSubSystem>>
       m_subsystems;
   std::unordered_map<DebugMeshType, Mesh> m_sharedMeshes;
+  struct InstanceBatch {
+    DebugPipelines pipeline_type;
+    DebugMeshType meshType;
+    Uint32 firstInstance;
+    Uint32 numInstances;
+  };
+  InstanceBuffer m_instanceBuffer{NoInit};
+  std::vector<DebugInstanceData> m_instanceData;
+  std::vector<InstanceBatch> m_batches;
+  bool m_instanced = false;
   inline static const std::array<Float4, 3> m_triadColors = {
       Float4{1., 0., 0., 1.},
       Float4{0., 1., 0., 1.},
@@ -66,6 +91,10 @@ class DebugScene {
 
   void setupPipelines(const MeshLayout &layout);
 
+  /// Draw the enabled entities one by one, without instancing.
+  void renderEntities(CommandBuffer &cmdBuf, SDL_GPURenderPass *render_pass,
+                      const Camera &camera) const;
+
 public:
   enum : Uint32 { TRANSFORM_SLOT = 0 };
   enum : Uint32 { COLOR_SLOT = 0 };
@@ -129,6 +158,16 @@ public:
     }
   }
 
+  /// \brief Group the enabled entities into instance batches, and upload
+  /// their instance data.
+  ///
+  /// Call this once per frame, after update() and outside of a render pass,
+  /// before render(). Does nothing when instancing is not available.
+  void collectInstances(CommandBuffer &cmdBuf);
+
+  /// \brief Whether entities are drawn with instanced draws.
+  bool instancingEnabled() const { return m_instanced; }
+
   void render(CommandBuffer &cmdBuf, const Camera &camera) const;
 
   void release();
@@ -4,13 +4,16 @@
 #include "Collision.h"
 #include "Camera.h"
 
+#include <spdlog/spdlog.h>
+
 namespace candlewick {
 
 static GraphicsPipeline
 create_depth_pass_pipeline(const Device &device, const MeshLayout &layout,
                            SDL_GPUTextureFormat format,
-                           const DepthPass::Config config) {
-  auto vertexShader = Shader::fromMetadata(device, "ShadowCast.vert");
+                           const DepthPass::Config config,
+                           const char *vertex_shader = "ShadowCast.vert") {
+  auto vertexShader = Shader::fromMetadata(device, vertex_shader);
   auto fragmentShader = Shader::fromMetadata(device, "ShadowCast.frag");
   return GraphicsPipeline(
       device,
@@ -82,7 +85,7 @@ void DepthPass::render(CommandBuffer &command_buffer, const Mat4f &viewProj,
   };
 
   SDL_GPURenderPass *render_pass =
-      SDL_BeginGPURenderPass(command_buffer, nullptr, 0, &depth_info);
+      rend::beginRenderPass(command_buffer, {}, &depth_info);
   pipeline.bind(render_pass);
 
   for (auto &[mesh, tr] : castables) {
@@ -147,16 +150,28 @@ ShadowMapPass::ShadowMapPass(const Device &device, const MeshLayout &layout,
   shadowMap = Texture(device, texInfo, "Shadow atlas");
   this->configureAtlasRegions(config);
 
-  pipeline = create_depth_pass_pipeline(device, layout, format,
-                                        {
-                                            SDL_GPU_CULLMODE_FRONT,
-                                            config.depth_bias_constant_factor,
-                                            config.depth_bias_slope_factor,
-                                            config.enable_depth_bias,
-                                            config.enable_depth_clip,
-                                            nullptr,
-                                            SDL_GPU_SAMPLECOUNT_1,
-                                        });
+  const DepthPass::Config pipeline_config{
+      SDL_GPU_CULLMODE_FRONT,
+      config.depth_bias_constant_factor,
+      config.depth_bias_slope_factor,
+      config.enable_depth_bias,
+      config.enable_depth_clip,
+      nullptr,
+      SDL_GPU_SAMPLECOUNT_1,
+  };
+  pipeline =
+      create_depth_pass_pipeline(device, layout, format, pipeline_config);
+  if (config.enable_instancing) {
+    const char *instanced_shader = "ShadowCastInstanced.vert";
+    if (shaderExists(device, instanced_shader)) {
+      instancedPipeline = create_depth_pass_pipeline(
+          device, layout, format, pipeline_config, instanced_shader);
+    } else {
+      spdlog::warn("Shader '{:s}' not found, shadows of instanced objects "
+                   "will be drawn one by one.",
+                   instanced_shader);
+    }
+  }
 
   SDL_GPUSamplerCreateInfo sample_desc{
       .min_filter = SDL_GPU_FILTER_LINEAR,
@@ -176,6 +191,7 @@ ShadowMapPass::ShadowMapPass(ShadowMapPass &&other) noexcept
     , m_numLights(other.m_numLights)
     , shadowMap(std::move(other.shadowMap))
     , pipeline(std::move(other.pipeline))
+    , instancedPipeline(std::move(other.instancedPipeline))
     , sampler(other.sampler)
     , cam(std::move(other.cam))
     , regions(std::move(other.regions)) {
@@ -189,6 +205,7 @@ ShadowMapPass &ShadowMapPass::operator=(ShadowMapPass &&other) noexcept {
   shadowMap = std::move(other.shadowMap);
   sampler = other.sampler;
   pipeline = std::move(other.pipeline);
+  instancedPipeline = std::move(other.instancedPipeline);
   cam = std::move(other.cam);
   regions = std::move(other.regions);
 
@@ -205,12 +222,21 @@ void ShadowMapPass::release() noexcept {
     sampler = nullptr;
   }
   pipeline.release();
+  instancedPipeline.release();
   shadowMap.destroy();
   m_device = nullptr;
 }
 
+/// Vertex uniforms of ShadowCastInstanced.vert.
+struct alignas(16) InstancedLightUbo {
+  GpuMat4 viewProj;
+  Uint32 firstInstance;
+};
+
 void ShadowMapPass::render(CommandBuffer &command_buffer,
-                           std::span<const OpaqueCastable> castables) {
+                           std::span<const OpaqueCastable> castables,
+                           const InstancedCastables &instanced) {
+  RenderStatsPassScope stats_pass{RenderStatsPass::Shadow};
   SDL_GPUDepthStencilTargetInfo depth_info{
       .texture = shadowMap,
       .clear_depth = 1.0f,
@@ -221,7 +247,7 @@ void ShadowMapPass::render(CommandBuffer &command_buffer,
   };
 
   SDL_GPURenderPass *render_pass =
-      SDL_BeginGPURenderPass(command_buffer, nullptr, 0, &depth_info);
+      rend::beginRenderPass(command_buffer, {}, &depth_info);
   pipeline.bind(render_pass);
 
   for (size_t i = 0; i < numLights(); i++) {
@@ -240,13 +266,32 @@ void ShadowMapPass::render(CommandBuffer &command_buffer,
     }
   }
 
+  if (instancedPipeline.initialized() && !instanced.batches.empty()) {
+    instancedPipeline.bind(render_pass);
+    SDL_BindGPUVertexStorageBuffers(render_pass, 0, &instanced.instanceBuffer,
+                                    1);
+    for (size_t i = 0; i < numLights(); i++) {
+      SDL_GPUViewport vp = gpuViewportFromAtlasRegion(regions[i]);
+      SDL_SetGPUViewport(render_pass, &vp);
+      InstancedLightUbo ubo{cam[i].viewProj(), 0};
+      for (const auto &[mesh, firstInstance, numInstances] :
+           instanced.batches) {
+        rend::bindMesh(render_pass, mesh);
+        ubo.firstInstance = firstInstance;
+        command_buffer.pushVertexUniform(0, ubo);
+        rend::draw(render_pass, mesh, numInstances);
+      }
+    }
+  }
+
   SDL_EndGPURenderPass(render_pass);
 }
 
 void renderShadowPassFromFrustum(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                                  std::span<const DirectionalLight> dirLight,
                                  std::span<const OpaqueCastable> castables,
-                                 const FrustumCornersType &worldSpaceCorners) {
+                                 const FrustumCornersType &worldSpaceCorners,
+                                 const InstancedCastables &instanced) {
   auto [center, radius] = frustumBoundingSphereCenterRadius(worldSpaceCorners);
 
   for (size_t i = 0; i < passInfo.numLights(); i++) {
@@ -271,13 +316,14 @@ void renderShadowPassFromFrustum(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                                          float(bounds.max_.z()),
                                          float(bounds.min_.z()));
   }
-  passInfo.render(cmdBuf, castables);
+  passInfo.render(cmdBuf, castables, instanced);
 }
 
 void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                               std::span<const DirectionalLight> dirLight,
                               std::span<const OpaqueCastable> castables,
-                              const AABB &worldAABB) {
+                              const AABB &worldAABB,
+                              const InstancedCastables &instanced) {
   Float3 center = worldAABB.center().cast<float>();
 
   for (size_t i = 0; i < passInfo.numLights(); i++) {
@@ -297,6 +343,6 @@ void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                                          float(bounds.max_.z()),
                                          float(bounds.min_.z()));
   }
-  passInfo.render(cmdBuf, castables);
+  passInfo.render(cmdBuf, castables, instanced);
 }
 } // namespace candlewick
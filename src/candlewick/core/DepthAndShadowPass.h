@@ -38,6 +38,22 @@ namespace candlewick {
 /// use in depth or light pre-passes.
 using OpaqueCastable = std::tuple<const Mesh &, Mat4f>;
 
+/// \brief Batch of shadow-casting objects sharing a mesh, drawn with a single
+/// instanced draw. Their model matrices are read from a storage buffer of
+/// PbrInstanceData, starting at \p firstInstance.
+struct InstancedCastable {
+  const Mesh &mesh;
+  Uint32 firstInstance;
+  Uint32 numInstances;
+};
+
+/// \brief Instanced batches of shadow-casting objects, with the storage buffer
+/// holding their instance data.
+struct InstancedCastables {
+  SDL_GPUBuffer *instanceBuffer = nullptr;
+  std::span<const InstancedCastable> batches;
+};
+
 /// \brief Maximum number of lights.
 static constexpr size_t kNumLights = 4;
 
@@ -116,6 +132,9 @@ struct ShadowPassConfig {
   bool enable_depth_bias = false;
   bool enable_depth_clip = false;
   Uint32 numLights = 2;
+  /// Also create the pipeline for InstancedCastables, if its shader is
+  /// compiled (see ShadowMapPass::instancedPipeline).
+  bool enable_instancing = false;
 };
 
 /// \ingroup depth_pass
@@ -142,6 +161,10 @@ public:
   /// actually a texture atlas
   Texture shadowMap{NoInit};
   GraphicsPipeline pipeline{NoInit};
+  /// Pipeline for instanced batches, if ShadowPassConfig::enable_instancing
+  /// was set and ShadowCastInstanced.vert is compiled. Otherwise, it is not
+  /// initialized, and callers draw all castables with #pipeline.
+  GraphicsPipeline instancedPipeline{NoInit};
   SDL_GPUSampler *sampler = nullptr;
   std::array<Camera, kNumLights> cam;
   /// regions of the atlas
@@ -165,7 +188,8 @@ public:
     return pipeline.initialized() && (sampler != nullptr);
   }
 
-  void render(CommandBuffer &cmdBuf, std::span<const OpaqueCastable> castables);
+  void render(CommandBuffer &cmdBuf, std::span<const OpaqueCastable> castables,
+              const InstancedCastables &instanced = {});
 
   void release() noexcept;
   ~ShadowMapPass() noexcept { this->release(); }
@@ -191,10 +215,13 @@ public:
 /// \param dirLight Array (view) of directional lights
 /// \param castables Collection of shadow-casting objects
 /// \param worldAABB World-space scene AABB
+/// \param instanced Instanced batches of shadow-casting objects, drawn if the
+/// pass was created with ShadowPassConfig::enable_instancing
 void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                               std::span<const DirectionalLight> dirLight,
                               std::span<const OpaqueCastable> castables,
-                              const AABB &worldAABB);
+                              const AABB &worldAABB,
+                              const InstancedCastables &instanced = {});
 
 /// \ingroup depth_pass
 /// \brief Render shadow pass, using a provided world-space frustum.
@@ -207,7 +234,8 @@ void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
 void renderShadowPassFromFrustum(CommandBuffer &cmdBuf, ShadowMapPass &passInfo,
                                  std::span<const DirectionalLight> dirLight,
                                  std::span<const OpaqueCastable> castables,
-                                 const FrustumCornersType &worldSpaceCorners);
+                                 const FrustumCornersType &worldSpaceCorners,
+                                 const InstancedCastables &instanced = {});
 
 /// \brief Orthographic matrix which maps to the negative-Z half-volume of the
 /// NDC cube, for depth-testing/shadow mapping purposes.
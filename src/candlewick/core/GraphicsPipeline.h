@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core.h"
+#include "RenderStats.h"
 #include "Tags.h"
 #include "errors.h"
 #include <SDL3/SDL_gpu.h>
@@ -85,6 +86,7 @@ public:
 
   void bind(SDL_GPURenderPass *render_pass) const noexcept {
     SDL_BindGPUGraphicsPipeline(render_pass, m_pipeline);
+    render_stats::recordPipelineBind(m_meta.primitiveType);
   }
 
   void release() noexcept {
@@ -48,6 +48,7 @@ bool GuiSystem::init() {
 }
 
 void GuiSystem::render(CommandBuffer &cmdBuf) {
+  RenderStatsPassScope stats_pass{RenderStatsPass::Gui};
   ImGui_ImplSDLGPU3_NewFrame();
   ImGui_ImplSDL3_NewFrame();
   ImGui::NewFrame();
@@ -64,8 +65,21 @@ void GuiSystem::render(CommandBuffer &cmdBuf) {
       .load_op = SDL_GPU_LOADOP_LOAD,
       .store_op = SDL_GPU_STOREOP_STORE,
   };
-  auto render_pass = SDL_BeginGPURenderPass(cmdBuf, &info, 1, NULL);
+  auto render_pass = rend::beginRenderPass(cmdBuf, {&info, 1});
   ImGui_ImplSDLGPU3_RenderDrawData(draw_data, cmdBuf, render_pass);
+  // the ImGui backend draws with its own pipeline and buffers, outside of the
+  // rend:: helpers
+  if (draw_data->TotalVtxCount > 0) {
+    RenderCounters &stats = render_stats::current();
+    stats.pipelineBinds++;
+    stats.vertexBufferBinds++;
+    stats.indexBufferBinds++;
+    stats.triangles += Uint64(draw_data->TotalIdxCount / 3);
+    for (const ImDrawList *draw_list : draw_data->CmdLists) {
+      stats.drawCalls += Uint64(draw_list->CmdBuffer.Size);
+      stats.instances += Uint64(draw_list->CmdBuffer.Size);
+    }
+  }
 
   SDL_EndGPURenderPass(render_pass);
 }
@@ -0,0 +1,125 @@
+#include "HeightTexture.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "errors.h"
+
+#include <utility>
+
+namespace candlewick {
+
+HeightTexture::HeightTexture(const Device &device, Uint32 nx, Uint32 ny,
+                             const Float2 &origin, const Float2 &spacing)
+    : m_texture(device,
+                {.type = SDL_GPU_TEXTURETYPE_2D,
+                 .format = SDL_GPU_TEXTUREFORMAT_R32_FLOAT,
+                 .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+                 .width = nx,
+                 .height = ny,
+                 .layer_count_or_depth = 1,
+                 .num_levels = 1,
+                 .sample_count = SDL_GPU_SAMPLECOUNT_1,
+                 .props = 0},
+                "Height texture")
+    , origin(origin)
+    , spacing(spacing) {
+  // heights are fetched per texel, the sampler is not used for filtering
+  SDL_GPUSamplerCreateInfo sampler_ci{
+      .min_filter = SDL_GPU_FILTER_NEAREST,
+      .mag_filter = SDL_GPU_FILTER_NEAREST,
+      .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+      .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+      .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+      .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+  };
+  m_sampler = SDL_CreateGPUSampler(device, &sampler_ci);
+  if (!m_sampler)
+    terminate_with_message("Failed to create height texture sampler: {:s}",
+                           SDL_GetError());
+}
+
+HeightTexture::HeightTexture(HeightTexture &&other) noexcept
+    : m_texture(std::move(other.m_texture))
+    , m_sampler(std::exchange(other.m_sampler, nullptr))
+    , m_transferBuffer(std::exchange(other.m_transferBuffer, nullptr))
+    , m_transferCapacity(std::exchange(other.m_transferCapacity, 0u))
+    , origin(other.origin)
+    , spacing(other.spacing) {}
+
+HeightTexture &HeightTexture::operator=(HeightTexture &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    m_texture = std::move(other.m_texture);
+    m_sampler = std::exchange(other.m_sampler, nullptr);
+    m_transferBuffer = std::exchange(other.m_transferBuffer, nullptr);
+    m_transferCapacity = std::exchange(other.m_transferCapacity, 0u);
+    origin = other.origin;
+    spacing = other.spacing;
+  }
+  return *this;
+}
+
+void HeightTexture::upload(CommandBuffer &command_buffer, Uint32 x, Uint32 y,
+                           const Eigen::Ref<const Eigen::MatrixXf> &heights) {
+  const auto w = Uint32(heights.rows());
+  const auto h = Uint32(heights.cols());
+  if (w == 0 || h == 0)
+    return;
+  if (x + w > width() || y + h > height())
+    terminate_with_message(
+        "Height region ({:d}, {:d}) + ({:d}, {:d}) exceeds the {:d}x{:d} grid.",
+        x, y, w, h, width(), height());
+
+  SDL_GPUDevice *device = m_texture.device();
+  const Uint32 size = w * h * Uint32(sizeof(float));
+  if (size > m_transferCapacity) {
+    if (m_transferBuffer)
+      SDL_ReleaseGPUTransferBuffer(device, m_transferBuffer);
+    SDL_GPUTransferBufferCreateInfo transfer_ci{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = size,
+        .props = 0,
+    };
+    m_transferBuffer = SDL_CreateGPUTransferBuffer(device, &transfer_ci);
+    if (!m_transferBuffer)
+      terminate_with_message("Failed to create transfer buffer: {:s}",
+                             SDL_GetError());
+    m_transferCapacity = size;
+  }
+
+  // columns of heights are rows of texels
+  auto *mapped =
+      (float *)SDL_MapGPUTransferBuffer(device, m_transferBuffer, true);
+  Eigen::Map<Eigen::MatrixXf>(mapped, w, h) = heights;
+  SDL_UnmapGPUTransferBuffer(device, m_transferBuffer);
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  SDL_GPUTextureTransferInfo src{
+      .transfer_buffer = m_transferBuffer,
+      .offset = 0,
+      .pixels_per_row = w,
+      .rows_per_layer = h,
+  };
+  SDL_GPUTextureRegion dst{
+      .texture = m_texture, .x = x, .y = y, .w = w, .h = h, .d = 1};
+  // cycling discards the contents of the texture, only do so when replacing
+  // all of them
+  const bool cycle = w == width() && h == height();
+  SDL_UploadToGPUTexture(copy_pass, &src, &dst, cycle);
+  SDL_EndGPUCopyPass(copy_pass);
+}
+
+void HeightTexture::release() noexcept {
+  SDL_GPUDevice *device = m_texture.device();
+  if (device) {
+    if (m_sampler)
+      SDL_ReleaseGPUSampler(device, m_sampler);
+    if (m_transferBuffer)
+      SDL_ReleaseGPUTransferBuffer(device, m_transferBuffer);
+  }
+  m_sampler = nullptr;
+  m_transferBuffer = nullptr;
+  m_transferCapacity = 0;
+  m_texture.destroy();
+}
+
+} // namespace candlewick
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Core.h"
+#include "Tags.h"
+#include "Texture.h"
+#include "math_types.h"
+
+#include <SDL3/SDL_gpu.h>
+
+namespace candlewick {
+
+/// \brief Heights of a heightfield on a uniform grid, stored on the GPU as an
+/// \c R32_FLOAT texture with one texel per grid point.
+///
+/// A vertex shader displaces a flat grid mesh of the same size by sampling
+/// this texture, so that the vertex data can be shared between heightfields.
+/// Changing the heights of a region only uploads that region, through a
+/// persistent transfer buffer which grows as needed.
+/// \sa loadHeightfieldGrid()
+class HeightTexture {
+  Texture m_texture{NoInit};
+  SDL_GPUSampler *m_sampler{nullptr};
+  SDL_GPUTransferBuffer *m_transferBuffer{nullptr};
+  Uint32 m_transferCapacity{0};
+
+public:
+  /// Position of grid point (0, 0), in the heightfield frame.
+  Float2 origin;
+  /// Distance between grid points along x and y.
+  Float2 spacing;
+
+  HeightTexture(NoInitT) {}
+  /// \brief Create the texture, for \p nx by \p ny grid points.
+  HeightTexture(const Device &device, Uint32 nx, Uint32 ny,
+                const Float2 &origin, const Float2 &spacing);
+
+  HeightTexture(const HeightTexture &) = delete;
+  HeightTexture(HeightTexture &&other) noexcept;
+  HeightTexture &operator=(const HeightTexture &) = delete;
+  HeightTexture &operator=(HeightTexture &&other) noexcept;
+
+  bool initialized() const noexcept { return m_sampler; }
+
+  /// \brief Upload the heights of a rectangular region of the grid, whose
+  /// first grid point is (\p x, \p y), in a copy pass recorded to
+  /// \p command_buffer. This must happen outside of any render pass.
+  ///
+  /// \p heights is indexed as \c (i,j) for grid point \c (x+i,y+j). Like any
+  /// copy pass, the upload is only seen by render passes recorded after it.
+  ///
+  /// Uploading the entire grid cycles the texture, so that it does not wait
+  /// for frames in flight which still sample the previous heights. A partial
+  /// upload must keep the rest of the heights, which cycling would make
+  /// undefined, so it writes into the texture in place.
+  void upload(CommandBuffer &command_buffer, Uint32 x, Uint32 y,
+              const Eigen::Ref<const Eigen::MatrixXf> &heights);
+
+  /// \brief Upload the heights of the entire grid.
+  void upload(CommandBuffer &command_buffer,
+              const Eigen::Ref<const Eigen::MatrixXf> &heights) {
+    upload(command_buffer, 0, 0, heights);
+  }
+
+  const Texture &texture() const { return m_texture; }
+  Uint32 width() const { return m_texture.width(); }
+  Uint32 height() const { return m_texture.height(); }
+
+  /// \brief Binding for SDL_BindGPUVertexSamplers().
+  SDL_GPUTextureSamplerBinding samplerBinding() const {
+    return {.texture = m_texture, .sampler = m_sampler};
+  }
+
+  void release() noexcept;
+  ~HeightTexture() noexcept { this->release(); }
+};
+
+} // namespace candlewick
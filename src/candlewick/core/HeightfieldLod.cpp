@@ -0,0 +1,50 @@
+#include "HeightfieldLod.h"
+#include "Camera.h"
+#include "Collision.h"
+#include "errors.h"
+
+namespace candlewick {
+
+HeightfieldLodComponent::HeightfieldLodComponent(const Mesh &fullMesh,
+                                                 HeightfieldChunks &&chunks_,
+                                                 float lodDistance)
+    : chunks(std::move(chunks_))
+    , lodDistance(lodDistance)
+    , mesh(fullMesh.borrow())
+    , shadowMesh(fullMesh.borrow())
+    , lods(chunks.numChunks(), chunks.numLods - 1) {
+  // also rejects NaN
+  if (!(lodDistance > 0.f))
+    terminate_with_message("Heightfield LOD distance must be positive, got {}.",
+                           lodDistance);
+  mesh.clearViews();
+  shadowMesh.clearViews();
+  for (Uint32 k = 0; k < chunks.numChunks(); k++) {
+    addChunkView(mesh, k);
+    addChunkView(shadowMesh, k);
+  }
+}
+
+void HeightfieldLodComponent::update(const Mat4f &modelMatrix,
+                                     const Camera &camera) {
+  // levels are selected for all chunks, so that visible chunks are stitched
+  // to their culled neighbours as well
+  chunks.selectLods(modelMatrix, camera.position(), lodDistance, lods);
+  const Mat4f mvp = camera.viewProj() * modelMatrix;
+  mesh.clearViews();
+  shadowMesh.clearViews();
+  for (Uint32 k = 0; k < chunks.numChunks(); k++) {
+    addChunkView(shadowMesh, k);
+    if (!isAABBOutsideFrustum(chunks.bounds[k], mvp))
+      addChunkView(mesh, k);
+  }
+}
+
+void HeightfieldLodComponent::addChunkView(Mesh &target, Uint32 chunk) const {
+  const auto &range =
+      chunks.pattern(lods[chunk], chunks.stitchMask(lods, chunk));
+  target.addView(chunks.chunkVertexOffset(chunk), chunks.verticesPerChunk(),
+               range.indexOffset, range.indexCount);
+}
+
+} // namespace candlewick
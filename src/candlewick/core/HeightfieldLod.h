@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Mesh.h"
+#include "math_types.h"
+#include "../primitives/Heightfield.h"
+
+namespace candlewick {
+
+/// \brief Parameters of a chunked heightfield.
+/// \sa HeightfieldLodComponent
+struct HeightfieldLodConfig {
+  /// Number of cells along each side of a chunk, a power of two.
+  Uint32 chunkSize = 64;
+  /// Camera distance up to which chunks use the finest level of detail. It
+  /// doubles with each coarser level. Must be positive.
+  float lodDistance = 5.f;
+  /// Draw shaded triangles (with normals) instead of lines.
+  bool solid = false;
+};
+
+/// \brief Component for heightfield entities split into chunks, selecting the
+/// level of detail of each chunk and culling the chunks outside of the view
+/// frustum.
+///
+/// The chunks to draw are the views of #mesh, which borrows the buffers of the
+/// entity's MeshMaterialComponent. Shadow casting uses #shadowMesh instead,
+/// since chunks outside of the view frustum may still cast shadows into it.
+/// \sa loadHeightfieldChunks()
+struct HeightfieldLodComponent {
+  HeightfieldChunks chunks;
+  float lodDistance;
+  /// Mesh with one view per chunk to draw.
+  Mesh mesh;
+  /// Mesh with one view per chunk, at the same levels as #mesh but not culled.
+  Mesh shadowMesh;
+  /// Level of each chunk, including culled ones.
+  std::vector<Uint32> lods;
+
+  /// \brief Constructor. All chunks are drawn at the coarsest level, until the
+  /// first call to update().
+  /// \param lodDistance See HeightfieldLodConfig::lodDistance, must be
+  /// positive.
+  HeightfieldLodComponent(const Mesh &fullMesh, HeightfieldChunks &&chunks,
+                          float lodDistance);
+
+  /// \brief Select the levels of the chunks for \p camera, and the chunks
+  /// inside its view frustum. All chunks are kept in #shadowMesh.
+  void update(const Mat4f &modelMatrix, const Camera &camera);
+
+  Uint32 numVisibleChunks() const { return Uint32(mesh.numViews()); }
+
+private:
+  void addChunkView(Mesh &target, Uint32 chunk) const;
+};
+
+} // namespace candlewick
@@ -0,0 +1,104 @@
+#include "InstanceBuffer.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace candlewick {
+
+InstanceBuffer::InstanceBuffer(const Device &device) : m_device(device) {}
+
+InstanceBuffer::InstanceBuffer(InstanceBuffer &&other) noexcept
+    : m_device(std::exchange(other.m_device, nullptr))
+    , m_buffer(std::exchange(other.m_buffer, nullptr))
+    , m_transferBuffer(std::exchange(other.m_transferBuffer, nullptr))
+    , m_capacity(std::exchange(other.m_capacity, 0u))
+    , m_size(std::exchange(other.m_size, 0u)) {}
+
+InstanceBuffer &InstanceBuffer::operator=(InstanceBuffer &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    m_device = std::exchange(other.m_device, nullptr);
+    m_buffer = std::exchange(other.m_buffer, nullptr);
+    m_transferBuffer = std::exchange(other.m_transferBuffer, nullptr);
+    m_capacity = std::exchange(other.m_capacity, 0u);
+    m_size = std::exchange(other.m_size, 0u);
+  }
+  return *this;
+}
+
+void InstanceBuffer::reserve(Uint32 size) {
+  if (size <= m_capacity)
+    return;
+  // grow geometrically, to avoid reallocating while the instance count ramps
+  // up
+  Uint32 capacity = std::max(size, 2 * m_capacity);
+  if (m_buffer)
+    SDL_ReleaseGPUBuffer(m_device, m_buffer);
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(m_device, m_transferBuffer);
+
+  SDL_GPUBufferCreateInfo buffer_ci{
+      .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+      .size = capacity,
+      .props = 0,
+  };
+  m_buffer = SDL_CreateGPUBuffer(m_device, &buffer_ci);
+  if (!m_buffer)
+    terminate_with_message("Failed to create instance buffer: {:s}",
+                           SDL_GetError());
+
+  SDL_GPUTransferBufferCreateInfo transfer_ci{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = capacity,
+      .props = 0,
+  };
+  m_transferBuffer = SDL_CreateGPUTransferBuffer(m_device, &transfer_ci);
+  if (!m_transferBuffer)
+    terminate_with_message("Failed to create transfer buffer: {:s}",
+                           SDL_GetError());
+  m_capacity = capacity;
+}
+
+void InstanceBuffer::upload(CommandBuffer &command_buffer,
+                            std::span<const std::byte> data) {
+  m_size = Uint32(data.size());
+  if (data.empty())
+    return;
+  this->reserve(m_size);
+
+  void *mapped = SDL_MapGPUTransferBuffer(m_device, m_transferBuffer, true);
+  std::memcpy(mapped, data.data(), data.size());
+  SDL_UnmapGPUTransferBuffer(m_device, m_transferBuffer);
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  SDL_GPUTransferBufferLocation src{
+      .transfer_buffer = m_transferBuffer,
+      .offset = 0,
+  };
+  SDL_GPUBufferRegion dst{
+      .buffer = m_buffer,
+      .offset = 0,
+      .size = m_size,
+  };
+  SDL_UploadToGPUBuffer(copy_pass, &src, &dst, true);
+  SDL_EndGPUCopyPass(copy_pass);
+}
+
+void InstanceBuffer::release() noexcept {
+  if (!m_device)
+    return;
+  if (m_buffer)
+    SDL_ReleaseGPUBuffer(m_device, m_buffer);
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(m_device, m_transferBuffer);
+  m_buffer = nullptr;
+  m_transferBuffer = nullptr;
+  m_capacity = 0;
+  m_size = 0;
+}
+
+} // namespace candlewick
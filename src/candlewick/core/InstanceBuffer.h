@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Core.h"
+#include "Tags.h"
+#include "math_types.h"
+#include <SDL3/SDL_gpu.h>
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief GPU storage buffer for per-instance data (e.g. model matrices),
+/// read by vertex shaders to draw many copies of a mesh in a single instanced
+/// draw call.
+///
+/// The contents are re-uploaded every frame through a persistent transfer
+/// buffer. Both buffers grow as needed, and are never shrunk.
+class InstanceBuffer {
+  SDL_GPUDevice *m_device{nullptr};
+  SDL_GPUBuffer *m_buffer{nullptr};
+  SDL_GPUTransferBuffer *m_transferBuffer{nullptr};
+  Uint32 m_capacity{0};
+  Uint32 m_size{0};
+
+  void reserve(Uint32 size);
+
+public:
+  InstanceBuffer(NoInitT) {}
+  explicit InstanceBuffer(const Device &device);
+
+  InstanceBuffer(const InstanceBuffer &) = delete;
+  InstanceBuffer(InstanceBuffer &&other) noexcept;
+  InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+  InstanceBuffer &operator=(InstanceBuffer &&other) noexcept;
+
+  bool initialized() const noexcept { return m_device; }
+
+  /// \brief Upload \p data to the storage buffer, in a copy pass recorded to
+  /// \p command_buffer. This must happen outside of any render pass.
+  ///
+  /// The previous contents are cycled, so that render passes already recorded
+  /// in the command buffer keep reading them.
+  void upload(CommandBuffer &command_buffer, std::span<const std::byte> data);
+
+  template <typename T>
+  void upload(CommandBuffer &command_buffer, std::span<const T> data) {
+    upload(command_buffer, std::as_bytes(data));
+  }
+
+  /// \brief The storage buffer, to bind with
+  /// SDL_BindGPUVertexStorageBuffers().
+  SDL_GPUBuffer *buffer() const noexcept { return m_buffer; }
+
+  /// \brief Size of the last upload, in bytes.
+  Uint32 size() const noexcept { return m_size; }
+
+  void release() noexcept;
+  ~InstanceBuffer() noexcept { this->release(); }
+};
+
+/// \brief Per-instance data read by the PbrBasicInstanced.vert and
+/// ShadowCastInstanced.vert shaders.
+struct alignas(16) PbrInstanceData {
+  GpuMat4 model;
+  /// World-space normal matrix, in the top-left 3x3 block.
+  GpuMat4 normalMatrix;
+  /// Multiplies the base color of the materials.
+  GpuVec4 color;
+};
+
+/// \brief Sort \p items into batches drawn with instanced draws.
+///
+/// Items are sorted by \p batch_key, e.g. their mesh and materials, and each
+/// run of at least two items with the same key forms a batch. The other items
+/// are appended to \p unbatched.
+/// \returns The size of each batch. The batched items are kept at the front of
+/// \p items, in batch order, and \p items is resized to their number.
+template <typename T, typename KeyFn>
+std::vector<Uint32> sortInstanceBatches(std::vector<T> &items,
+                                        std::vector<T> &unbatched,
+                                        KeyFn batch_key) {
+  std::ranges::stable_sort(items, std::less<>{}, batch_key);
+  std::vector<Uint32> batch_sizes;
+  const size_t count = items.size();
+  size_t num_batched = 0;
+  for (size_t i = 0; i < count;) {
+    const auto key = batch_key(items[i]);
+    size_t end = i + 1;
+    while (end < count && batch_key(items[end]) == key)
+      end++;
+
+    const auto size = Uint32(end - i);
+    if (size == 1) {
+      unbatched.push_back(items[i]);
+    } else {
+      // compacting in place, since num_batched <= i
+      std::move(items.begin() + long(i), items.begin() + long(end),
+                items.begin() + long(num_batched));
+      batch_sizes.push_back(size);
+      num_batched += size;
+    }
+    i = end;
+  }
+  items.resize(num_batched);
+  return batch_sizes;
+}
+
+} // namespace candlewick
@@ -6,11 +6,15 @@
 #include "../primitives/Primitives.h"
 #include "../utils/MeshTransforms.h"
 
+#include <coal/BVH/BVH_model.h>
 #include <coal/shape/convex.h>
 #include <coal/shape/geometric_shapes.h>
 #include <coal/hfield.h>
 #include <SDL3/SDL_assert.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace candlewick {
 
 constexpr float kPlaneScale = 10.f;
@@ -39,6 +43,25 @@ getPlaneOrHalfspaceNormalOffset(const coal::CollisionGeometry &geometry,
   }
 }
 
+/// Call \p func on the ranges of a partition of [0, count) in parallel, or on
+/// the whole range if it is small.
+template <typename F> static void parallelForRanges(Uint32 count, F &&func) {
+  constexpr Uint32 kMinRangeSize = 1 << 14;
+  const Uint32 numThreads =
+      std::clamp(count / kMinRangeSize, 1u,
+                 std::max(1u, std::thread::hardware_concurrency()));
+  if (numThreads == 1) {
+    func(0u, count);
+    return;
+  }
+  std::vector<std::jthread> threads;
+  threads.reserve(numThreads - 1);
+  const Uint32 rangeSize = (count + numThreads - 1) / numThreads;
+  for (Uint32 begin = rangeSize; begin < count; begin += rangeSize)
+    threads.emplace_back(func, begin, std::min(begin + rangeSize, count));
+  func(0u, std::min(rangeSize, count));
+}
+
 MeshData loadCoalConvex(const coal::ConvexBase &geom_) {
   std::vector<DefaultVertex> vertexData;
   std::vector<MeshData::IndexType> indexData;
@@ -79,27 +102,51 @@ MeshData loadCoalConvex(const coal::ConvexBase &geom_) {
                   std::move(indexData)};
 }
 
+std::optional<CoalUnitShape> getCoalUnitShape(const coal::ShapeBase &geometry) {
+  using namespace coal;
+  switch (geometry.getNodeType()) {
+  case GEOM_BOX: {
+    auto &g = castCoalGeom<Box>(geometry);
+    return CoalUnitShape{CoalUnitPrimitive::CUBE, g.halfSide.cast<float>()};
+  }
+  case GEOM_SPHERE: {
+    auto &g = castCoalGeom<Sphere>(geometry);
+    return CoalUnitShape{CoalUnitPrimitive::UV_SPHERE,
+                         Float3::Constant(float(g.radius))};
+  }
+  case GEOM_ELLIPSOID: {
+    auto &g = castCoalGeom<Ellipsoid>(geometry);
+    return CoalUnitShape{CoalUnitPrimitive::UV_SPHERE, g.radii.cast<float>()};
+  }
+  default:
+    return std::nullopt;
+  }
+}
+
+MeshData loadCoalUnitPrimitive(CoalUnitPrimitive primitive) {
+  switch (primitive) {
+  case CoalUnitPrimitive::CUBE:
+    return loadCubeSolid().toOwned();
+  case CoalUnitPrimitive::UV_SPHERE:
+    return loadUvSphereSolid(12u, 24u);
+  }
+  unreachable();
+}
+
 MeshData loadCoalPrimitive(const coal::ShapeBase &geometry) {
   using namespace coal;
   CANDLEWICK_ASSERT(geometry.getObjectType() == OT_GEOM,
                     "CollisionGeometry object type must be OT_GEOM !");
   MeshData meshData{NoInit};
   Eigen::Affine3f transform = Eigen::Affine3f::Identity();
+  if (auto unit = getCoalUnitShape(geometry)) {
+    meshData = loadCoalUnitPrimitive(unit->primitive);
+    transform.scale(unit->scale);
+    apply3DTransformInPlace(meshData, transform);
+    return meshData;
+  }
   const NODE_TYPE nodeType = geometry.getNodeType();
   switch (nodeType) {
-  case GEOM_BOX: {
-    auto &g = castCoalGeom<Box>(geometry);
-    transform.scale(g.halfSide.cast<float>());
-    meshData = loadCubeSolid().toOwned();
-    break;
-  }
-  case GEOM_SPHERE: {
-    auto &g = castCoalGeom<Sphere>(geometry);
-    // sphere loader doesn't have a radius argument, so apply scaling
-    transform.scale(float(g.radius));
-    meshData = loadUvSphereSolid(12u, 24u);
-    break;
-  }
   case GEOM_TRIANGLE: {
     // auto &g = castGeom<TriangleP>(geometry);
     terminate_with_message("Geometry type \'GEOM_TRIANGLE\' not supported");
@@ -110,12 +157,6 @@ MeshData loadCoalPrimitive(const coal::ShapeBase &geometry) {
     meshData = loadCoalConvex(g);
     break;
   }
-  case GEOM_ELLIPSOID: {
-    auto &g = castCoalGeom<Ellipsoid>(geometry);
-    transform.scale(g.radii.cast<float>());
-    meshData = loadUvSphereSolid(12u, 24u);
-    break;
-  }
   case GEOM_CAPSULE: {
     auto &g = castCoalGeom<Capsule>(geometry);
     const float length = 2 * static_cast<float>(g.halfLength);
@@ -157,6 +198,69 @@ MeshData loadCoalPrimitive(const coal::ShapeBase &geometry) {
   return meshData;
 }
 
+MeshData loadCoalBVH(const coal::BVHModelBase &bvh) {
+  using namespace coal;
+  const Uint32 num_vertices = bvh.num_vertices;
+  std::vector<DefaultVertex> vertexData(num_vertices);
+  const auto &points = *bvh.vertices;
+  for (Uint32 i = 0; i < num_vertices; i++) {
+    vertexData[i].pos = points[i].cast<float>();
+    vertexData[i].normal.setZero();
+    vertexData[i].color.setOnes();
+    vertexData[i].tangent.setZero();
+  }
+
+  switch (bvh.getModelType()) {
+  case BVH_MODEL_POINTCLOUD:
+    return MeshData{SDL_GPU_PRIMITIVETYPE_POINTLIST, std::move(vertexData)};
+  case BVH_MODEL_TRIANGLES:
+    break;
+  case BVH_MODEL_UNKNOWN:
+    terminate_with_message("Unknown BVH model type.");
+  }
+
+  const Uint32 num_tris = bvh.num_tris;
+  const auto &tris = *bvh.tri_indices;
+  std::vector<MeshData::IndexType> indexData(3 * num_tris);
+  // area-weighted face normals
+  std::vector<Float3> faceNormals(num_tris);
+  parallelForRanges(num_tris, [&](Uint32 begin, Uint32 end) {
+    for (Uint32 i = begin; i < end; i++) {
+      const Triangle &t = tris[i];
+      for (Uint32 k = 0; k < 3; k++)
+        indexData[3 * i + k] = static_cast<Uint32>(t[k]);
+      const Float3 p0 = vertexData[t[0]].pos;
+      const Float3 p1 = vertexData[t[1]].pos;
+      const Float3 p2 = vertexData[t[2]].pos;
+      faceNormals[i] = (p1 - p0).cross(p2 - p0);
+    }
+  });
+
+  // gather the faces adjacent to each vertex (CSR layout), so that vertex
+  // normals can be summed without contention
+  std::vector<Uint32> adjOffsets(num_vertices + 1, 0u);
+  for (Uint32 idx : indexData)
+    adjOffsets[idx + 1]++;
+  for (Uint32 i = 0; i < num_vertices; i++)
+    adjOffsets[i + 1] += adjOffsets[i];
+  std::vector<Uint32> adjFaces(indexData.size());
+  std::vector<Uint32> cursor(adjOffsets.begin(), adjOffsets.end() - 1);
+  for (Uint32 j = 0; j < indexData.size(); j++)
+    adjFaces[cursor[indexData[j]]++] = j / 3;
+
+  parallelForRanges(num_vertices, [&](Uint32 begin, Uint32 end) {
+    for (Uint32 i = begin; i < end; i++) {
+      Float3 n = Float3::Zero();
+      for (Uint32 j = adjOffsets[i]; j < adjOffsets[i + 1]; j++)
+        n += faceNormals[adjFaces[j]];
+      vertexData[i].normal = n.stableNormalized();
+    }
+  });
+
+  return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, std::move(vertexData),
+                  std::move(indexData)};
+}
+
 namespace detail {
   template <typename BV>
   MeshData load_coal_heightfield_impl(const coal::HeightField<BV> &hf) {
@@ -3,12 +3,14 @@
 #include "../utils/Utils.h"
 
 #include <coal/shape/geometric_shapes.h>
+#include <optional>
 
 // fwd declarations
 
 namespace coal {
 template <typename BV> class HeightField;
 class OBBRSS;
+class BVHModelBase;
 } // namespace coal
 
 namespace candlewick {
@@ -28,8 +30,44 @@ decltype(auto) castCoalGeom(const coal::CollisionGeometry &geometry) {
 /// \sa primitives1
 MeshData loadCoalPrimitive(const coal::ShapeBase &geometry);
 
+/// \brief Unit meshes which coal primitives are exact scalings of.
+enum class CoalUnitPrimitive {
+  /// Cube of half-side 1, for boxes.
+  CUBE,
+  /// UV sphere of radius 1, for spheres and ellipsoids.
+  UV_SPHERE,
+};
+
+/// \brief Unit primitive of a coal shape, and the scaling mapping it onto the
+/// shape.
+struct CoalUnitShape {
+  CoalUnitPrimitive primitive;
+  Float3 scale;
+};
+
+/// \brief Get the unit primitive of \p geometry and its scaling, for the
+/// shapes whose parameters are exactly a scaling of a unit mesh (boxes,
+/// spheres and ellipsoids). Returns \c std::nullopt for other shapes.
+///
+/// The unit mesh can then be shared by all shapes of the same primitive, with
+/// the scaling applied in their transforms.
+/// \sa loadCoalUnitPrimitive()
+std::optional<CoalUnitShape> getCoalUnitShape(const coal::ShapeBase &geometry);
+
+/// \brief Load the unit mesh of a primitive, with the same tessellation as
+/// loadCoalPrimitive().
+MeshData loadCoalUnitPrimitive(CoalUnitPrimitive primitive);
+
 MeshData loadCoalConvex(const coal::ConvexBase &geom);
 
+/// \brief Convert the vertices and triangles stored in a coal BVH model to
+/// mesh data, without reading any mesh file.
+///
+/// Triangle models give an indexed triangle list, with smooth vertex normals
+/// (computed in parallel for large models). Point cloud models give a point
+/// list.
+MeshData loadCoalBVH(const coal::BVHModelBase &bvh);
+
 MeshData loadCoalHeightField(const coal::HeightField<coal::AABB> &collGeom);
 
 MeshData loadCoalHeightField(const coal::HeightField<coal::OBBRSS> &collGeom);
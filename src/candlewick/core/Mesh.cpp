@@ -64,6 +64,18 @@ Mesh &Mesh::operator=(Mesh &&other) noexcept {
   return *this;
 }
 
+Mesh Mesh::borrow() const {
+  Mesh mesh{NoInit};
+  // leave m_device null, so that release() is a no-op
+  mesh.m_views = m_views;
+  mesh.m_layout = m_layout;
+  mesh.vertexCount = vertexCount;
+  mesh.indexCount = indexCount;
+  mesh.vertexBuffers = vertexBuffers;
+  mesh.indexBuffer = indexBuffer;
+  return mesh;
+}
+
 Mesh &Mesh::bindVertexBuffer(Uint32 slot, SDL_GPUBuffer *buffer) {
   for (std::size_t i = 0; i < numVertexBuffers(); i++) {
     if (m_layout.m_bufferDescs[i].slot == slot) {
@@ -51,7 +51,8 @@ public:
 /// This class contains the layout, vertex (and index) count(s), and handles to
 /// the GPU vertex and index buffers the Mesh references.
 ///
-/// A Mesh **owns** its vertex and index buffers.
+/// A Mesh **owns** its vertex and index buffers, unless it was created with
+/// borrow().
 ///
 /// \sa MeshView
 class Mesh {
@@ -88,6 +89,16 @@ public:
   Mesh &operator=(const Mesh &) = delete;
   Mesh &operator=(Mesh &&other) noexcept;
 
+  /// \brief Create a Mesh referencing the same buffers and views, but which
+  /// does **not** own them. This allows several entities to draw the same
+  /// geometry without uploading it again.
+  /// \warning The returned Mesh must not outlive this one.
+  [[nodiscard]] Mesh borrow() const;
+
+  /// \brief Whether this Mesh releases its buffers when destroyed, i.e. it
+  /// was not created by borrow().
+  bool ownsBuffers() const { return m_device != nullptr; }
+
   const MeshView &view(size_t i) const { return m_views[i]; }
   std::span<const MeshView> views() const { return m_views; }
   size_t numViews() const { return m_views.size(); }
@@ -98,6 +109,10 @@ public:
   MeshView &addView(Uint32 vertexOffset, Uint32 vertexSubCount,
                     Uint32 indexOffset, Uint32 indexSubCount);
 
+  /// \brief Remove all stored views, e.g. to then add views of another subset
+  /// of the buffers.
+  void clearViews() { m_views.clear(); }
+
   /// \brief Bind an existing vertex buffer to a given slot of the Mesh.
   /// \warning This function will **take ownership of the buffer**.
   ///
@@ -0,0 +1,194 @@
+#include "MeshUpdater.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "Mesh.h"
+#include "errors.h"
+#include "../utils/MeshData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace candlewick {
+
+void MeshUpdateStaging::add(SDL_GPUBuffer *buffer, Uint32 bufferSize,
+                            Uint32 offset, std::span<const std::byte> data) {
+  CANDLEWICK_ASSERT(buffer, "Updated buffer must not be null.");
+  if (Uint64(offset) + data.size() > bufferSize)
+    terminate_with_message("Update of {:d} bytes at offset {:d} exceeds the "
+                           "buffer size ({:d} bytes).",
+                           data.size(), offset, bufferSize);
+  if (data.empty())
+    return;
+  const auto srcOffset = Uint32(m_data.size());
+  m_data.insert(m_data.end(), data.begin(), data.end());
+  m_uploads.push_back({buffer, srcOffset, offset, Uint32(data.size())});
+}
+
+void MeshUpdateStaging::coalesce() {
+  if (m_uploads.size() < 2)
+    return;
+  // sort by buffer and offset, keeping the staging order of equal offsets
+  std::vector<Uint32> order(m_uploads.size());
+  for (Uint32 i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::ranges::stable_sort(order, [this](Uint32 a, Uint32 b) {
+    const Upload &ua = m_uploads[a];
+    const Upload &ub = m_uploads[b];
+    if (ua.buffer != ub.buffer)
+      return std::less<>{}(ua.buffer, ub.buffer);
+    return ua.dstOffset < ub.dstOffset;
+  });
+
+  std::vector<std::byte> data;
+  data.reserve(m_data.size());
+  std::vector<Upload> uploads;
+  std::vector<Uint32> group;
+  for (size_t i = 0; i < order.size();) {
+    // sweep the ranges of the buffer which overlap or touch the first one
+    const Upload &first = m_uploads[order[i]];
+    const Uint32 begin = first.dstOffset;
+    Uint32 end = begin + first.size;
+    group.clear();
+    for (; i < order.size(); i++) {
+      const Upload &up = m_uploads[order[i]];
+      if (up.buffer != first.buffer || up.dstOffset > end)
+        break;
+      end = std::max(end, up.dstOffset + up.size);
+      group.push_back(order[i]);
+    }
+    // write the merged range in staging order, so later updates win
+    std::ranges::sort(group);
+    const auto srcOffset = Uint32(data.size());
+    data.resize(data.size() + (end - begin));
+    for (Uint32 k : group) {
+      const Upload &up = m_uploads[k];
+      std::memcpy(data.data() + srcOffset + (up.dstOffset - begin),
+                  m_data.data() + up.srcOffset, up.size);
+    }
+    uploads.push_back({first.buffer, srcOffset, begin, end - begin});
+  }
+  m_data = std::move(data);
+  m_uploads = std::move(uploads);
+}
+
+MeshUpdater::MeshUpdater(const Device &device) : m_device(device) {}
+
+MeshUpdater::MeshUpdater(MeshUpdater &&other) noexcept
+    : m_device(std::exchange(other.m_device, nullptr))
+    , m_transferBuffer(std::exchange(other.m_transferBuffer, nullptr))
+    , m_capacity(std::exchange(other.m_capacity, 0u))
+    , m_staging(std::move(other.m_staging)) {}
+
+MeshUpdater &MeshUpdater::operator=(MeshUpdater &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    m_device = std::exchange(other.m_device, nullptr);
+    m_transferBuffer = std::exchange(other.m_transferBuffer, nullptr);
+    m_capacity = std::exchange(other.m_capacity, 0u);
+    m_staging = std::move(other.m_staging);
+  }
+  return *this;
+}
+
+void MeshUpdater::reserve(Uint32 size) {
+  if (size <= m_capacity)
+    return;
+  // grow geometrically, as the amount of updated data varies between frames
+  const Uint32 capacity = std::max(size, 2 * m_capacity);
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(m_device, m_transferBuffer);
+
+  SDL_GPUTransferBufferCreateInfo transfer_ci{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = capacity,
+      .props = 0,
+  };
+  m_transferBuffer = SDL_CreateGPUTransferBuffer(m_device, &transfer_ci);
+  if (!m_transferBuffer)
+    terminate_with_message("Failed to create transfer buffer: {:s}",
+                           SDL_GetError());
+  m_capacity = capacity;
+}
+
+void MeshUpdater::update(SDL_GPUBuffer *buffer, Uint32 bufferSize,
+                         Uint32 offset, std::span<const std::byte> data) {
+  m_staging.add(buffer, bufferSize, offset, data);
+}
+
+void MeshUpdater::updateVertices(const Mesh &mesh, Uint32 firstVertex,
+                                 std::span<const std::byte> vertices,
+                                 Uint32 bufferIndex) {
+  const Uint32 pitch = mesh.layout().m_bufferDescs[bufferIndex].pitch;
+  CANDLEWICK_ASSERT(vertices.size() % pitch == 0,
+                    "Vertex data size must be a multiple of the pitch.");
+  update(mesh.vertexBuffers[bufferIndex], mesh.vertexCount * pitch,
+         firstVertex * pitch, vertices);
+}
+
+void MeshUpdater::updateIndices(const Mesh &mesh, Uint32 firstIndex,
+                                std::span<const Uint32> indices) {
+  const Uint32 indexSize = mesh.layout().indexSize();
+  update(mesh.indexBuffer, mesh.indexCount * indexSize, firstIndex * indexSize,
+         std::as_bytes(indices));
+}
+
+void MeshUpdater::update(const MeshView &view, const MeshData &data) {
+  CANDLEWICK_ASSERT(data.numVertices() == view.vertexCount &&
+                        data.numIndices() == view.indexCount,
+                    "MeshData does not match the size of the view.");
+  // the buffers hold at least the ranges of the view
+  const MeshLayout &layout = data.layout;
+  const Uint32 vertexSize = layout.vertexSize();
+  update(view.vertexBuffers[0],
+         (view.vertexOffset + view.vertexCount) * vertexSize,
+         view.vertexOffset * vertexSize,
+         std::as_bytes(std::span(data.vertexData())));
+  if (view.isIndexed()) {
+    const Uint32 indexSize = layout.indexSize();
+    update(view.indexBuffer, (view.indexOffset + view.indexCount) * indexSize,
+           view.indexOffset * indexSize,
+           std::as_bytes(std::span(data.indexData)));
+  }
+}
+
+void MeshUpdater::flush(CommandBuffer &command_buffer) {
+  if (m_staging.empty())
+    return;
+  m_staging.coalesce();
+  const auto data = m_staging.data();
+  this->reserve(Uint32(data.size()));
+
+  void *mapped = SDL_MapGPUTransferBuffer(m_device, m_transferBuffer, true);
+  std::memcpy(mapped, data.data(), data.size());
+  SDL_UnmapGPUTransferBuffer(m_device, m_transferBuffer);
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  for (const auto &upload : m_staging.uploads()) {
+    SDL_GPUTransferBufferLocation src{
+        .transfer_buffer = m_transferBuffer,
+        .offset = upload.srcOffset,
+    };
+    SDL_GPUBufferRegion dst{
+        .buffer = upload.buffer,
+        .offset = upload.dstOffset,
+        .size = upload.size,
+    };
+    SDL_UploadToGPUBuffer(copy_pass, &src, &dst, false);
+  }
+  SDL_EndGPUCopyPass(copy_pass);
+  m_staging.clear();
+}
+
+void MeshUpdater::release() noexcept {
+  if (!m_device)
+    return;
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(m_device, m_transferBuffer);
+  m_transferBuffer = nullptr;
+  m_capacity = 0;
+  m_staging.clear();
+}
+
+} // namespace candlewick
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Core.h"
+#include "Tags.h"
+
+#include <SDL3/SDL_gpu.h>
+#include <span>
+#include <vector>
+
+namespace candlewick {
+
+class MeshData;
+
+/// \brief CPU side of MeshUpdater: staged updates of GPU buffer ranges, and
+/// their data.
+///
+/// Updates are bounds-checked against the size of their buffer when staged.
+/// coalesce() then merges the updates of each buffer whose ranges overlap or
+/// are adjacent, so that each merged range is uploaded once.
+class MeshUpdateStaging {
+public:
+  struct Upload {
+    SDL_GPUBuffer *buffer;
+    /// Offset of the data in data(), in bytes.
+    Uint32 srcOffset;
+    /// Offset of the updated range in the buffer, in bytes.
+    Uint32 dstOffset;
+    Uint32 size;
+  };
+
+  /// \brief Stage an update of \p buffer with \p data, at \p offset (in
+  /// bytes). Terminates if the range exceeds \p bufferSize.
+  void add(SDL_GPUBuffer *buffer, Uint32 bufferSize, Uint32 offset,
+           std::span<const std::byte> data);
+
+  /// \brief Merge the staged updates of the same buffer whose ranges overlap
+  /// or are adjacent. Where updates overlap, the last one staged wins. The
+  /// data of the merged updates is compacted.
+  void coalesce();
+
+  std::span<const std::byte> data() const { return m_data; }
+  std::span<const Upload> uploads() const { return m_uploads; }
+  bool empty() const noexcept { return m_uploads.empty(); }
+  void clear() noexcept {
+    m_data.clear();
+    m_uploads.clear();
+  }
+
+private:
+  std::vector<std::byte> m_data;
+  std::vector<Upload> m_uploads;
+};
+
+/// \brief Batches in-place updates of vertex and index sub-ranges of existing
+/// meshes, e.g. for deformable or procedurally animated objects, without
+/// recreating their buffers.
+///
+/// The updates are staged on the CPU (see MeshUpdateStaging), and all of those
+/// made during a frame are coalesced and recorded by flush() in a single copy
+/// pass, from a cycled transfer buffer:
+/// updating every frame does not wait for the GPU to be done with the previous
+/// upload. The mesh buffers themselves are not cycled, since the rest of their
+/// contents must be kept: uploads are ordered after the render passes already
+/// recorded.
+class MeshUpdater {
+  SDL_GPUDevice *m_device{nullptr};
+  SDL_GPUTransferBuffer *m_transferBuffer{nullptr};
+  Uint32 m_capacity{0};
+  MeshUpdateStaging m_staging;
+
+  void reserve(Uint32 size);
+
+public:
+  MeshUpdater(NoInitT) {}
+  explicit MeshUpdater(const Device &device);
+
+  MeshUpdater(const MeshUpdater &) = delete;
+  MeshUpdater(MeshUpdater &&other) noexcept;
+  MeshUpdater &operator=(const MeshUpdater &) = delete;
+  MeshUpdater &operator=(MeshUpdater &&other) noexcept;
+
+  bool initialized() const noexcept { return m_device; }
+
+  /// \brief Stage an update of \p buffer, of size \p bufferSize, with \p
+  /// data, at \p offset (in bytes). Terminates if the range exceeds the
+  /// buffer.
+  void update(SDL_GPUBuffer *buffer, Uint32 bufferSize, Uint32 offset,
+              std::span<const std::byte> data);
+
+  /// \brief Stage an update of the vertices of vertex buffer \p bufferIndex of
+  /// \p mesh, starting at vertex \p firstVertex.
+  /// \param vertices Vertices, laid out with the pitch of the buffer. They must
+  /// lie within the mesh's Mesh::vertexCount vertices.
+  void updateVertices(const Mesh &mesh, Uint32 firstVertex,
+                      std::span<const std::byte> vertices,
+                      Uint32 bufferIndex = 0);
+
+  template <typename VertexT>
+  void updateVertices(const Mesh &mesh, Uint32 firstVertex,
+                      std::span<const VertexT> vertices,
+                      Uint32 bufferIndex = 0) {
+    updateVertices(mesh, firstVertex, std::as_bytes(vertices), bufferIndex);
+  }
+
+  /// \brief Stage an update of the indices of \p mesh, starting at index \p
+  /// firstIndex. They must lie within the mesh's Mesh::indexCount indices.
+  void updateIndices(const Mesh &mesh, Uint32 firstIndex,
+                     std::span<const Uint32> indices);
+
+  /// \brief Stage an update of the vertices (and indices, if any) of \p view
+  /// with \p data, which must have the same number of them as the view and a
+  /// single vertex buffer.
+  ///
+  /// Indices are relative to the view, as in uploadMeshToDevice().
+  void update(const MeshView &view, const MeshData &data);
+
+  /// \brief Whether updates are waiting for flush().
+  bool pending() const noexcept { return !m_staging.empty(); }
+
+  /// \brief Record all staged updates in a single copy pass, recorded to \p
+  /// command_buffer. This must happen outside of any render pass.
+  void flush(CommandBuffer &command_buffer);
+
+  void release() noexcept;
+  ~MeshUpdater() noexcept { this->release(); }
+};
+
+} // namespace candlewick
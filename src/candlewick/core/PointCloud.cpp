@@ -0,0 +1,176 @@
+#include "PointCloud.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace candlewick {
+
+static constexpr Uint32 kPositionSize = 3 * sizeof(float);
+static constexpr Uint32 kColorSize = 4 * sizeof(Uint8);
+
+PointCloud::PointCloud(const Device &device) : m_device(&device) {}
+
+PointCloud::PointCloud(PointCloud &&other) noexcept
+    : m_device(std::exchange(other.m_device, nullptr))
+    , m_mesh(std::move(other.m_mesh))
+    , m_transferBuffer(std::exchange(other.m_transferBuffer, nullptr))
+    , m_capacity(std::exchange(other.m_capacity, 0u))
+    , m_numPoints(std::exchange(other.m_numPoints, 0u))
+    , m_numDefaultColors(std::exchange(other.m_numDefaultColors, 0u))
+    , m_uploadColors(std::exchange(other.m_uploadColors, false))
+    , m_pending(std::exchange(other.m_pending, false))
+    , defaultColor(other.defaultColor) {}
+
+PointCloud &PointCloud::operator=(PointCloud &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    m_device = std::exchange(other.m_device, nullptr);
+    m_mesh = std::move(other.m_mesh);
+    m_transferBuffer = std::exchange(other.m_transferBuffer, nullptr);
+    m_capacity = std::exchange(other.m_capacity, 0u);
+    m_numPoints = std::exchange(other.m_numPoints, 0u);
+    m_numDefaultColors = std::exchange(other.m_numDefaultColors, 0u);
+    m_uploadColors = std::exchange(other.m_uploadColors, false);
+    m_pending = std::exchange(other.m_pending, false);
+    defaultColor = other.defaultColor;
+  }
+  return *this;
+}
+
+MeshLayout PointCloud::layout() {
+  return MeshLayout{}
+      .addBinding(0, kPositionSize)
+      .addAttribute(VertexAttrib::Position, 0,
+                    SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, 0)
+      .addBinding(1, kColorSize)
+      .addAttribute(VertexAttrib::Color0, 1,
+                    SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM, 0);
+}
+
+void PointCloud::reserve(Uint32 num_points) {
+  if (num_points <= m_capacity)
+    return;
+  // grow geometrically, for clouds whose size varies from frame to frame
+  const Uint32 capacity = std::max(num_points, 2 * m_capacity);
+  SDL_GPUDevice *device = *m_device;
+
+  // replacing the mesh releases the previous vertex buffers
+  m_mesh = Mesh{*m_device, layout()};
+  m_mesh.vertexCount = 0;
+  const Uint32 sizes[2] = {capacity * kPositionSize, capacity * kColorSize};
+  for (Uint32 slot = 0; slot < 2; slot++) {
+    SDL_GPUBufferCreateInfo buffer_ci{
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .size = sizes[slot],
+        .props = 0,
+    };
+    SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(device, &buffer_ci);
+    if (!buffer)
+      terminate_with_message("Failed to create point cloud buffer: {:s}",
+                             SDL_GetError());
+    m_mesh.bindVertexBuffer(slot, buffer);
+  }
+
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(device, m_transferBuffer);
+  SDL_GPUTransferBufferCreateInfo transfer_ci{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = sizes[0] + sizes[1],
+      .props = 0,
+  };
+  m_transferBuffer = SDL_CreateGPUTransferBuffer(device, &transfer_ci);
+  if (!m_transferBuffer)
+    terminate_with_message("Failed to create transfer buffer: {:s}",
+                           SDL_GetError());
+  m_capacity = capacity;
+  // the new color buffer holds no colors yet
+  m_numDefaultColors = 0;
+}
+
+void PointCloud::stage(const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+                       const Eigen::Ref<const ColorMatrix> *colors) {
+  CANDLEWICK_ASSERT(initialized(), "Point cloud was not initialized.");
+  const auto n = Uint32(positions.cols());
+  this->reserve(n);
+  // a staged color upload which was not flushed yet is lost when the transfer
+  // buffer cycles, and must be staged again
+  const bool refill = m_pending && m_uploadColors;
+  m_numPoints = n;
+  m_uploadColors = colors || refill || n > m_numDefaultColors;
+  m_pending = true;
+  if (n == 0)
+    return;
+
+  SDL_GPUDevice *device = *m_device;
+  auto *mapped =
+      (Uint8 *)SDL_MapGPUTransferBuffer(device, m_transferBuffer, true);
+  Eigen::Map<Eigen::Matrix3Xf>((float *)mapped, 3, n) = positions;
+  if (m_uploadColors) {
+    Eigen::Map<ColorMatrix> dst(mapped + n * kPositionSize, 4, n);
+    if (colors) {
+      dst = *colors;
+      m_numDefaultColors = 0;
+    } else {
+      dst = defaultColor.replicate(1, n);
+      m_numDefaultColors = n;
+    }
+  }
+  SDL_UnmapGPUTransferBuffer(device, m_transferBuffer);
+}
+
+void PointCloud::update(const Eigen::Ref<const Eigen::Matrix3Xf> &positions) {
+  this->stage(positions, nullptr);
+}
+
+void PointCloud::update(const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+                        const Eigen::Ref<const ColorMatrix> &colors) {
+  CANDLEWICK_ASSERT(colors.cols() == positions.cols(),
+                    "Point cloud needs as many colors as positions.");
+  this->stage(positions, &colors);
+}
+
+void PointCloud::flush(CommandBuffer &command_buffer) {
+  if (!m_pending)
+    return;
+  m_pending = false;
+  const Uint32 n = m_numPoints;
+  m_mesh.clearViews();
+  m_mesh.vertexCount = n;
+  if (n == 0)
+    return;
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  auto upload = [&](Uint32 slot, Uint32 offset, Uint32 size) {
+    SDL_GPUTransferBufferLocation src{
+        .transfer_buffer = m_transferBuffer,
+        .offset = offset,
+    };
+    SDL_GPUBufferRegion dst{
+        .buffer = m_mesh.vertexBuffers[slot],
+        .offset = 0,
+        .size = size,
+    };
+    SDL_UploadToGPUBuffer(copy_pass, &src, &dst, true);
+  };
+  upload(0, 0, n * kPositionSize);
+  if (m_uploadColors)
+    upload(1, n * kPositionSize, n * kColorSize);
+  SDL_EndGPUCopyPass(copy_pass);
+  m_mesh.addView(0, n, 0, 0);
+}
+
+void PointCloud::release() noexcept {
+  if (m_device && m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(*m_device, m_transferBuffer);
+  m_transferBuffer = nullptr;
+  m_mesh = Mesh{NoInit};
+  m_capacity = 0;
+  m_numPoints = 0;
+  m_numDefaultColors = 0;
+  m_pending = false;
+}
+
+} // namespace candlewick
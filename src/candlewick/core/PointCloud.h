@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Core.h"
+#include "Mesh.h"
+#include "Tags.h"
+#include "math_types.h"
+
+#include <SDL3/SDL_gpu.h>
+
+namespace candlewick {
+
+/// \brief Point cloud streamed to the GPU, e.g. from a depth camera, and drawn
+/// as point sprites.
+///
+/// Positions (\c float3, binding 0) and RGBA8 colors (binding 1) are stored in
+/// persistent vertex buffers, which grow as needed and are never shrunk.
+/// update() copies the points to a cycled transfer buffer, and the upload is
+/// recorded by flush() in the command buffer of the next frame: updating every
+/// frame does not wait for the GPU to be done with the previous points.
+class PointCloud {
+public:
+  using ColorMatrix = Eigen::Matrix<Uint8, 4, Eigen::Dynamic>;
+  using Color = Eigen::Matrix<Uint8, 4, 1>;
+
+private:
+  const Device *m_device{nullptr};
+  Mesh m_mesh{NoInit};
+  SDL_GPUTransferBuffer *m_transferBuffer{nullptr};
+  /// Capacity of the buffers, in points.
+  Uint32 m_capacity{0};
+  Uint32 m_numPoints{0};
+  /// Number of leading points whose color in the vertex buffer is
+  /// defaultColor.
+  Uint32 m_numDefaultColors{0};
+  bool m_uploadColors{false};
+  bool m_pending{false};
+
+  void reserve(Uint32 num_points);
+  void stage(const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+             const Eigen::Ref<const ColorMatrix> *colors);
+
+public:
+  /// Color of the points updated without colors.
+  Color defaultColor = Color::Constant(255);
+
+  PointCloud(NoInitT) {}
+  explicit PointCloud(const Device &device);
+
+  PointCloud(const PointCloud &) = delete;
+  PointCloud(PointCloud &&other) noexcept;
+  PointCloud &operator=(const PointCloud &) = delete;
+  PointCloud &operator=(PointCloud &&other) noexcept;
+
+  bool initialized() const noexcept { return m_device; }
+
+  /// \brief Vertex layout of point clouds.
+  static MeshLayout layout();
+
+  /// \brief Replace the points, drawn with defaultColor.
+  void update(const Eigen::Ref<const Eigen::Matrix3Xf> &positions);
+
+  /// \brief Replace the points and their colors.
+  void update(const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+              const Eigen::Ref<const ColorMatrix> &colors);
+
+  /// \brief Whether an update is waiting for flush().
+  bool pending() const noexcept { return m_pending; }
+
+  /// \brief Record the upload of the last update, in a copy pass recorded to
+  /// \p command_buffer. This must happen outside of any render pass.
+  ///
+  /// The vertex buffers are cycled, so that render passes already recorded
+  /// keep reading the previous points.
+  void flush(CommandBuffer &command_buffer);
+
+  Uint32 numPoints() const noexcept { return m_numPoints; }
+
+  /// \brief Mesh over the vertex buffers, with a single view of the points
+  /// (or none, if there are no points).
+  const Mesh &mesh() const noexcept { return m_mesh; }
+
+  void release() noexcept;
+  ~PointCloud() noexcept { this->release(); }
+};
+
+} // namespace candlewick
@@ -0,0 +1,290 @@
+#include "PointOctree.h"
+#include "Core.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace candlewick {
+
+namespace {
+  constexpr char kMagic[4] = {'C', 'W', 'P', 'O'};
+  constexpr Uint32 kVersion = 1;
+  constexpr Uint32 kSeed = 42u;
+
+  template <typename T> void writePod(std::ostream &os, const T &value) {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T> void readPod(std::istream &is, T &value) {
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+  }
+
+  Uint32 octantOf(const AABB &bounds, const Eigen::Vector3f &p) {
+    const coal::Vec3s c = bounds.center();
+    return Uint32(p.x() >= c.x()) | Uint32(p.y() >= c.y()) << 1 |
+           Uint32(p.z() >= c.z()) << 2;
+  }
+
+  AABB octantBounds(const AABB &bounds, Uint32 octant) {
+    const coal::Vec3s c = bounds.center();
+    AABB out = bounds;
+    for (int axis = 0; axis < 3; axis++) {
+      if (octant & (1u << axis))
+        out.min_[axis] = c[axis];
+      else
+        out.max_[axis] = c[axis];
+    }
+    return out;
+  }
+
+  struct OctreeBuilder {
+    const Eigen::Ref<const Eigen::Matrix3Xf> &positions;
+    const Eigen::Ref<const PointColorMatrix> &colors;
+    const PointOctreeBuildConfig &config;
+    std::ofstream &file;
+    std::vector<PointOctreeNode> nodes;
+    /// Last node to have occupied each cell of the sampling grid.
+    std::vector<Uint32> cellStamps;
+
+    void writePoints(std::span<const Uint32> indices) {
+      for (Uint32 i : indices)
+        file.write(reinterpret_cast<const char *>(positions.col(i).data()),
+                   3 * sizeof(float));
+      for (Uint32 i : indices)
+        file.write(reinterpret_cast<const char *>(colors.col(i).data()),
+                   4 * sizeof(Uint8));
+    }
+
+    /// Keep a subsample of \p indices in a new node, and recurse on the rest.
+    /// Returns the index of the node.
+    Uint32 build(const AABB &bounds, std::vector<Uint32> &&indices,
+                 Uint32 depth) {
+      const auto id = Uint32(nodes.size());
+      PointOctreeNode node;
+      node.bounds = bounds;
+      node.children.fill(PointOctreeNode::kNoChild);
+      node.depth = depth;
+      node.fileOffset = Uint64(file.tellp());
+
+      std::vector<Uint32> rest;
+      if (indices.size() > config.maxPointsPerNode && depth < config.maxDepth) {
+        // the indices are shuffled, so that keeping the first point of each
+        // cell gives a spread-out subsample
+        const Uint32 g = config.gridSize;
+        const Eigen::Vector3f lo = bounds.min_.cast<float>();
+        const Eigen::Vector3f scale =
+            float(g) / (bounds.max_ - bounds.min_).cast<float>().array();
+        std::vector<Uint32> kept;
+        kept.reserve(config.maxPointsPerNode);
+        rest.reserve(indices.size());
+        for (Uint32 i : indices) {
+          const Eigen::Array3f cellf =
+              ((positions.col(i) - lo).array() * scale.array()).floor();
+          const Eigen::Array3i cell = cellf.cast<int>().max(0).min(int(g) - 1);
+          const size_t c =
+              size_t(cell.x()) + g * (cell.y() + size_t(g) * cell.z());
+          if (kept.size() < config.maxPointsPerNode && cellStamps[c] != id) {
+            cellStamps[c] = id;
+            kept.push_back(i);
+          } else {
+            rest.push_back(i);
+          }
+        }
+        indices = std::move(kept);
+      }
+
+      node.numPoints = Uint32(indices.size());
+      writePoints(indices);
+      nodes.push_back(node);
+      indices = {};
+
+      if (rest.empty())
+        return id;
+
+      // split the remaining points between the octants, keeping their order
+      std::array<std::vector<Uint32>, 8> octants;
+      for (Uint32 i : rest)
+        octants[octantOf(bounds, positions.col(i))].push_back(i);
+      rest = {};
+      for (Uint32 k = 0; k < 8; k++) {
+        if (octants[k].empty())
+          continue;
+        const Uint32 child =
+            build(octantBounds(bounds, k), std::move(octants[k]), depth + 1);
+        nodes[id].children[k] = child;
+      }
+      return id;
+    }
+  };
+} // namespace
+
+void buildPointOctree(const std::string &path,
+                      const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+                      const Eigen::Ref<const PointColorMatrix> &colors,
+                      const PointOctreeBuildConfig &config) {
+  CANDLEWICK_ASSERT(positions.cols() == colors.cols(),
+                    "Positions and colors must have the same number of "
+                    "points.");
+  CANDLEWICK_ASSERT(config.maxPointsPerNode > 0 && config.gridSize > 0,
+                    "Invalid octree build parameters.");
+  const Uint64 maxPoints =
+      std::min(config.maxPoints, kMaxPointOctreeBuildPoints);
+  if (Uint64(positions.cols()) > maxPoints)
+    terminate_with_message("Point cloud of {:d} points exceeds the limit of "
+                           "{:d} points for building an octree in memory, "
+                           "split it into several octrees.",
+                           positions.cols(), maxPoints);
+  const auto numPoints = Uint32(positions.cols());
+
+  std::ofstream file{path, std::ios::binary};
+  if (!file)
+    terminate_with_message("Failed to open file '{:s}' for writing.", path);
+
+  // cubic root bounds, so that all nodes are cubes
+  AABB root;
+  if (numPoints > 0) {
+    const Eigen::Vector3f lo = positions.rowwise().minCoeff();
+    const Eigen::Vector3f hi = positions.rowwise().maxCoeff();
+    const Eigen::Vector3f center = 0.5f * (lo + hi);
+    const float half = std::max(0.5f * (hi - lo).maxCoeff(), 1e-6f) * 1.0001f;
+    root = AABB{(center.array() - half).matrix().cast<coal::CoalScalar>(),
+                (center.array() + half).matrix().cast<coal::CoalScalar>()};
+  } else {
+    root = AABB{coal::Vec3s::Zero(), coal::Vec3s::Zero()};
+  }
+
+  Uint32 numNodes = 0;
+  Uint64 tableOffset = 0;
+  file.write(kMagic, sizeof(kMagic));
+  writePod(file, kVersion);
+  writePod(file, numNodes);
+  writePod(file, tableOffset);
+
+  OctreeBuilder builder{positions, colors, config, file, {}, {}};
+  if (numPoints > 0) {
+    std::vector<Uint32> indices(numPoints);
+    std::iota(indices.begin(), indices.end(), 0u);
+    std::shuffle(indices.begin(), indices.end(), std::mt19937{kSeed});
+    builder.cellStamps.assign(
+        size_t(config.gridSize) * config.gridSize * config.gridSize,
+        PointOctreeNode::kNoChild);
+    builder.build(root, std::move(indices), 0);
+  }
+
+  tableOffset = Uint64(file.tellp());
+  numNodes = Uint32(builder.nodes.size());
+  for (const auto &node : builder.nodes) {
+    for (int axis = 0; axis < 3; axis++)
+      writePod(file, double(node.bounds.min_[axis]));
+    for (int axis = 0; axis < 3; axis++)
+      writePod(file, double(node.bounds.max_[axis]));
+    for (Uint32 child : node.children)
+      writePod(file, child);
+    writePod(file, node.depth);
+    writePod(file, node.numPoints);
+    writePod(file, node.fileOffset);
+  }
+  file.seekp(sizeof(kMagic) + sizeof(kVersion));
+  writePod(file, numNodes);
+  writePod(file, tableOffset);
+  if (!file)
+    terminate_with_message("Failed to write point cloud octree '{:s}'.", path);
+}
+
+PointOctreeFile::PointOctreeFile(const std::string &path)
+    : m_file(path, std::ios::binary) {
+  if (!m_file)
+    terminate_with_message("Failed to open point cloud octree '{:s}'.", path);
+
+  char magic[4];
+  Uint32 version = 0, numNodes = 0;
+  Uint64 tableOffset = 0;
+  m_file.read(magic, sizeof(magic));
+  readPod(m_file, version);
+  readPod(m_file, numNodes);
+  readPod(m_file, tableOffset);
+  if (!m_file || std::memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+      version != kVersion)
+    terminate_with_message("File '{:s}' is not a point cloud octree.", path);
+
+  m_file.seekg(std::streamoff(tableOffset));
+  m_nodes.resize(numNodes);
+  for (auto &node : m_nodes) {
+    double lo[3], hi[3];
+    for (double &x : lo)
+      readPod(m_file, x);
+    for (double &x : hi)
+      readPod(m_file, x);
+    node.bounds = AABB{coal::Vec3s(lo[0], lo[1], lo[2]),
+                       coal::Vec3s(hi[0], hi[1], hi[2])};
+    for (Uint32 &child : node.children)
+      readPod(m_file, child);
+    readPod(m_file, node.depth);
+    readPod(m_file, node.numPoints);
+    readPod(m_file, node.fileOffset);
+    m_numPoints += node.numPoints;
+  }
+  if (!m_file)
+    terminate_with_message("Truncated point cloud octree '{:s}'.", path);
+}
+
+void PointOctreeFile::readNode(Uint32 i, Eigen::Matrix3Xf &positions,
+                               PointColorMatrix &colors) {
+  const PointOctreeNode &n = m_nodes[i];
+  positions.resize(3, n.numPoints);
+  colors.resize(4, n.numPoints);
+  m_file.clear();
+  m_file.seekg(std::streamoff(n.fileOffset));
+  m_file.read(reinterpret_cast<char *>(positions.data()),
+              std::streamsize(3 * sizeof(float) * n.numPoints));
+  m_file.read(reinterpret_cast<char *>(colors.data()),
+              std::streamsize(4 * sizeof(Uint8) * n.numPoints));
+  if (!m_file)
+    terminate_with_message("Failed to read node {:d} of point cloud octree.",
+                           i);
+}
+
+void PointOctreeFile::selectNodes(const Mat4f &modelMatrix,
+                                  const Mat4f &viewProj,
+                                  const Float3 &cameraPos, Uint64 pointBudget,
+                                  std::vector<Uint32> &selected) const {
+  selected.clear();
+  if (m_nodes.empty())
+    return;
+
+  const Mat4f mvp = viewProj * modelMatrix;
+  using Entry = std::pair<float, Uint32>;
+  std::priority_queue<Entry> queue;
+  auto push = [&](Uint32 i) {
+    const AABB &bounds = m_nodes[i].bounds;
+    if (isAABBOutsideFrustum(bounds, mvp))
+      return;
+    const AABB world = applyTransformToAABB(bounds, modelMatrix);
+    const float radius = 0.5f * float((world.max_ - world.min_).norm());
+    const float distance =
+        (world.center().cast<float>() - cameraPos).norm() - radius;
+    queue.emplace(radius / std::max(distance, 1e-3f), i);
+  };
+
+  push(0);
+  Uint64 numPoints = 0;
+  while (!queue.empty()) {
+    const Uint32 i = queue.top().second;
+    queue.pop();
+    const PointOctreeNode &node = m_nodes[i];
+    if (numPoints + node.numPoints > pointBudget)
+      break;
+    numPoints += node.numPoints;
+    selected.push_back(i);
+    for (Uint32 child : node.children) {
+      if (child != PointOctreeNode::kNoChild)
+        push(child);
+    }
+  }
+}
+
+} // namespace candlewick
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Collision.h"
+#include "math_types.h"
+
+#include <array>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace candlewick {
+
+/// RGBA8 colors of a point cloud.
+using PointColorMatrix = Eigen::Matrix<Uint8, 4, Eigen::Dynamic>;
+
+/// \brief Parameters for building a point cloud octree.
+/// \sa buildPointOctree()
+struct PointOctreeBuildConfig {
+  /// Nodes with more points keep a subsample and split the rest between their
+  /// children.
+  Uint32 maxPointsPerNode = 20000;
+  /// Resolution of the grid over each node, in which a node keeps at most one
+  /// point per cell.
+  Uint32 gridSize = 64;
+  /// Depth at which nodes keep all their points.
+  Uint32 maxDepth = 16;
+  /// Maximum number of input points, see buildPointOctree(). At most
+  /// kMaxPointOctreeBuildPoints.
+  Uint64 maxPoints = 500'000'000;
+};
+
+/// Hard limit on the number of points of buildPointOctree(), which indexes
+/// them with 32-bit integers.
+inline constexpr Uint64 kMaxPointOctreeBuildPoints = 0xFFFFFFFFu;
+
+/// \brief Node of a point cloud octree.
+///
+/// Each node holds a subsample of the points inside its bounds, which are not
+/// held by its ancestors: drawing a node and its ancestors gives a uniform
+/// sample of the points, finer with depth.
+struct PointOctreeNode {
+  static constexpr Uint32 kNoChild = ~0u;
+
+  /// Cubic bounds of the node.
+  AABB bounds;
+  /// Index of the child in each octant, or kNoChild.
+  std::array<Uint32, 8> children;
+  Uint32 depth;
+  Uint32 numPoints;
+  /// Offset of the node's points in the file, in bytes.
+  Uint64 fileOffset;
+};
+
+/// \brief Build an octree over a point cloud, and write it to a chunked file
+/// at \p path, where the points of each node are stored contiguously.
+///
+/// The octree is built in memory, and the points are shuffled so that the
+/// subsample of each node is spread out. Colors are RGBA8.
+///
+/// Only the resulting file is out-of-core: on top of the input (16 bytes per
+/// point), building needs up to about 8 bytes per point of indices. Clouds
+/// which do not fit in memory must be split, e.g. into tiles, each with its
+/// own octree. Throws if there are more than PointOctreeBuildConfig::maxPoints
+/// points.
+/// \sa PointOctreeFile
+void buildPointOctree(const std::string &path,
+                      const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+                      const Eigen::Ref<const PointColorMatrix> &colors,
+                      const PointOctreeBuildConfig &config = {});
+
+/// \brief Point cloud octree file, from which the nodes are read on demand.
+///
+/// The file starts with a header, followed by the points of each node
+/// (positions as \c float3, then colors as RGBA8), and ends with the table of
+/// nodes. The root is node 0.
+/// \sa buildPointOctree()
+class PointOctreeFile {
+  std::ifstream m_file;
+  std::vector<PointOctreeNode> m_nodes;
+  Uint64 m_numPoints{0};
+
+public:
+  explicit PointOctreeFile(const std::string &path);
+
+  std::span<const PointOctreeNode> nodes() const { return m_nodes; }
+  const PointOctreeNode &node(Uint32 i) const { return m_nodes[i]; }
+  Uint32 numNodes() const { return Uint32(m_nodes.size()); }
+  Uint64 numPoints() const { return m_numPoints; }
+
+  /// \brief Read the points of node \p i.
+  void readNode(Uint32 i, Eigen::Matrix3Xf &positions,
+                PointColorMatrix &colors);
+
+  /// \brief Select the nodes to draw, within a budget of points.
+  ///
+  /// Nodes inside the view frustum are refined from the root, by decreasing
+  /// projected size (the ratio of their radius to their distance to the
+  /// camera), until the budget is reached. A node is only selected if its
+  /// parent is.
+  /// \param modelMatrix Placement of the point cloud in the world.
+  /// \param viewProj Camera view-projection matrix.
+  /// \param cameraPos Camera position, in the world.
+  /// \param pointBudget Maximum number of points in the selected nodes.
+  /// \param selected Output nodes, by decreasing projected size.
+  void selectNodes(const Mat4f &modelMatrix, const Mat4f &viewProj,
+                   const Float3 &cameraPos, Uint64 pointBudget,
+                   std::vector<Uint32> &selected) const;
+};
+
+} // namespace candlewick
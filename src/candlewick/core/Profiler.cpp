@@ -0,0 +1,201 @@
+#include "Profiler.h"
+#include "errors.h"
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <fstream>
+
+namespace candlewick {
+
+Uint64 FrameProfiler::Frame::zoneDuration(std::string_view name) const {
+  Uint64 total = 0;
+  for (const Zone &zone : zones) {
+    if (name == zone.name)
+      total += zone.duration;
+  }
+  return total;
+}
+
+// one more slot than the capacity, for the frame being recorded
+FrameProfiler::FrameProfiler(size_t capacity)
+    : m_origin(clock::now()), m_frames(std::max(capacity, size_t(1)) + 1) {}
+
+FrameProfiler &FrameProfiler::instance() {
+  static FrameProfiler profiler;
+  return profiler;
+}
+
+Uint64 FrameProfiler::now() const {
+  return Uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    clock::now() - m_origin)
+                    .count());
+}
+
+void FrameProfiler::beginFrame() {
+  if (!m_enabled)
+    return;
+  // reuse the zone storage of the frame being overwritten
+  Frame &frame = m_frames[m_head];
+  frame.index = m_frameIndex++;
+  frame.zones.clear();
+  m_stack.clear();
+  m_current = &frame;
+  m_thread = std::this_thread::get_id();
+  frame.start = now();
+}
+
+void FrameProfiler::endFrame() {
+  if (!m_current)
+    return;
+  const Uint64 t = now();
+  // close zones left open, e.g. by an early return from the frame
+  while (!m_stack.empty())
+    this->endZone();
+  m_current->duration = t - m_current->start;
+  m_current = nullptr;
+  m_head = (m_head + 1) % m_frames.size();
+  m_count = std::min(m_count + 1, capacity());
+}
+
+void FrameProfiler::beginZone(const char *name) {
+  if (!m_current || std::this_thread::get_id() != m_thread)
+    return;
+  m_stack.push_back(m_current->zones.size());
+  m_current->zones.push_back({name, Uint32(m_stack.size() - 1), now(), 0});
+}
+
+void FrameProfiler::endZone() {
+  if (!m_current || m_stack.empty() ||
+      std::this_thread::get_id() != m_thread)
+    return;
+  Zone &zone = m_current->zones[m_stack.back()];
+  zone.duration = now() - zone.start;
+  m_stack.pop_back();
+}
+
+void FrameProfiler::setEnabled(bool enabled) {
+  m_enabled = enabled;
+  m_current = nullptr;
+  m_stack.clear();
+}
+
+const FrameProfiler::Frame &FrameProfiler::frame(size_t i) const {
+  assert(i < m_count);
+  // the latest complete frame is right before the slot being recorded
+  const size_t n = m_frames.size();
+  return m_frames[(m_head + n - 1 - (m_count - 1 - i)) % n];
+}
+
+void FrameProfiler::clear() {
+  m_head = 0;
+  m_count = 0;
+  m_current = nullptr;
+  m_stack.clear();
+}
+
+void FrameProfiler::writeChromeTrace(const std::string &filename) const {
+  // Chrome trace timestamps and durations are in microseconds
+  auto us = [](Uint64 ns) { return double(ns) * 1e-3; };
+  nlohmann::json events = nlohmann::json::array();
+  for (size_t i = 0; i < m_count; i++) {
+    const Frame &f = frame(i);
+    events.push_back({
+        {"name", "frame"},
+        {"cat", "frame"},
+        {"ph", "X"},
+        {"ts", us(f.start)},
+        {"dur", us(f.duration)},
+        {"pid", 0},
+        {"tid", 0},
+        {"args", {{"index", f.index}}},
+    });
+    for (const Zone &zone : f.zones) {
+      events.push_back({
+          {"name", zone.name},
+          {"cat", "zone"},
+          {"ph", "X"},
+          {"ts", us(zone.start)},
+          {"dur", us(zone.duration)},
+          {"pid", 0},
+          {"tid", 0},
+      });
+    }
+  }
+
+  std::ofstream file{filename};
+  if (!file)
+    terminate_with_message("Failed to open trace file {:s}.", filename);
+  file << nlohmann::json{{"traceEvents", std::move(events)},
+                         {"displayTimeUnit", "ms"}};
+}
+
+namespace gui {
+  void addFrameProfilerPanel(FrameProfiler &profiler,
+                             const std::string &traceFilename) {
+    bool enabled = profiler.enabled();
+    if (ImGui::Checkbox("Record", &enabled))
+      profiler.setEnabled(enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+      profiler.clear();
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace")) {
+      try {
+        profiler.writeChromeTrace(traceFilename);
+        spdlog::info("Wrote frame profiler trace to {:s}", traceFilename);
+      } catch (const std::runtime_error &e) {
+        spdlog::error("{:s}", e.what());
+      }
+    }
+
+    const size_t n = profiler.numFrames();
+    if (n == 0) {
+      ImGui::TextDisabled("No frames recorded.");
+#ifndef CANDLEWICK_WITH_PROFILING
+      ImGui::TextDisabled("Candlewick was built without profiling zones.");
+#endif
+      return;
+    }
+
+    auto plot = [&](const char *label, auto &&duration) {
+      static std::vector<float> values;
+      values.resize(n);
+      float sum = 0.f;
+      for (size_t i = 0; i < n; i++) {
+        values[i] = float(duration(profiler.frame(i))) * 1e-6f;
+        sum += values[i];
+      }
+      char overlay[32];
+      std::snprintf(overlay, sizeof(overlay), "avg %.3f ms", sum / float(n));
+      ImGui::PlotLines(label, values.data(), int(n), 0, overlay, 0.f,
+                       FLT_MAX, ImVec2(0, 40));
+    };
+
+    plot("frame", [](const FrameProfiler::Frame &f) { return f.duration; });
+    // one graph per zone of the latest frame, indented by depth
+    const auto &zones = profiler.latestFrame().zones;
+    for (size_t i = 0; i < zones.size(); i++) {
+      const char *name = zones[i].name;
+      auto same_name = [&](const auto &z) {
+        return SDL_strcmp(name, z.name) == 0;
+      };
+      if (std::any_of(zones.begin(), zones.begin() + long(i), same_name))
+        continue;
+      const float indent = 8.f * float(zones[i].depth);
+      if (indent > 0.f)
+        ImGui::Indent(indent);
+      plot(name, [&](const FrameProfiler::Frame &f) {
+        return f.zoneDuration(name);
+      });
+      if (indent > 0.f)
+        ImGui::Unindent(indent);
+    }
+  }
+} // namespace gui
+
+} // namespace candlewick
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief CPU frame profiler, recording nested timing zones for the last few
+/// frames in a ring buffer.
+///
+/// Zones are recorded with the CANDLEWICK_PROFILE_SCOPE() macro, which
+/// compiles to nothing unless Candlewick is built with the
+/// `BUILD_WITH_PROFILING` CMake option (which defines
+/// `CANDLEWICK_WITH_PROFILING`). Frames are delimited with
+/// CANDLEWICK_PROFILE_FRAME().
+///
+/// Only zones opened from the thread which began the current frame are
+/// recorded, so that worker threads do not corrupt the zone stack.
+class FrameProfiler {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct Zone {
+    /// Zone name. Must have static storage duration, e.g. a string literal.
+    const char *name;
+    /// Nesting depth, zero for top-level zones.
+    Uint32 depth;
+    /// Start time, in nanoseconds since the profiler was created.
+    Uint64 start;
+    /// Duration, in nanoseconds.
+    Uint64 duration;
+  };
+
+  struct Frame {
+    Uint64 index;
+    Uint64 start;
+    Uint64 duration;
+    /// Zones in the order they were opened.
+    std::vector<Zone> zones;
+
+    /// \brief Total duration of the zones called \p name in this frame, in
+    /// nanoseconds.
+    Uint64 zoneDuration(std::string_view name) const;
+  };
+
+  static constexpr size_t DEFAULT_CAPACITY = 240;
+
+  explicit FrameProfiler(size_t capacity = DEFAULT_CAPACITY);
+
+  /// \brief The profiler used by the CANDLEWICK_PROFILE_* macros.
+  static FrameProfiler &instance();
+
+  void beginFrame();
+  void endFrame();
+
+  void beginZone(const char *name);
+  void endZone();
+
+  /// \brief Pause or resume recording. Frames in progress are discarded.
+  void setEnabled(bool enabled);
+  bool enabled() const { return m_enabled; }
+
+  /// \brief Number of recorded frames, at most capacity().
+  size_t numFrames() const { return m_count; }
+  size_t capacity() const { return m_frames.size() - 1; }
+
+  /// \brief Recorded frame \p i, from the oldest (0) to the latest.
+  const Frame &frame(size_t i) const;
+
+  /// \brief Latest complete frame. Requires `numFrames() > 0`.
+  const Frame &latestFrame() const { return frame(m_count - 1); }
+
+  void clear();
+
+  /// \brief Write the recorded frames to a JSON file in the Chrome trace
+  /// event format, which can be opened in `chrome://tracing` or Perfetto.
+  void writeChromeTrace(const std::string &filename) const;
+
+private:
+  Uint64 now() const;
+
+  clock::time_point m_origin;
+  /// Complete frames, and the slot of the frame being recorded.
+  std::vector<Frame> m_frames;
+  size_t m_head = 0; // slot of the next frame
+  size_t m_count = 0;
+  Uint64 m_frameIndex = 0;
+  Frame *m_current = nullptr;
+  std::vector<size_t> m_stack; // open zones, as indices into m_current->zones
+  std::thread::id m_thread;
+  bool m_enabled = true;
+};
+
+/// \brief RAII helper recording a zone of the global FrameProfiler.
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name) {
+    FrameProfiler::instance().beginZone(name);
+  }
+  ~ProfileScope() { FrameProfiler::instance().endZone(); }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+/// \brief RAII helper delimiting a frame of the global FrameProfiler.
+class ProfileFrameScope {
+public:
+  ProfileFrameScope() { FrameProfiler::instance().beginFrame(); }
+  ~ProfileFrameScope() { FrameProfiler::instance().endFrame(); }
+  ProfileFrameScope(const ProfileFrameScope &) = delete;
+  ProfileFrameScope &operator=(const ProfileFrameScope &) = delete;
+};
+
+namespace gui {
+  /// \brief Show rolling graphs of the frame time and of the zones
+  /// of a FrameProfiler, and a button to save a Chrome trace to
+  /// \p traceFilename.
+  void addFrameProfilerPanel(FrameProfiler &profiler,
+                             const std::string &traceFilename);
+} // namespace gui
+
+} // namespace candlewick
+
+#define CANDLEWICK_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CANDLEWICK_PROFILE_CONCAT(a, b) CANDLEWICK_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef CANDLEWICK_WITH_PROFILING
+/// \brief Record a zone called \p name until the end of the current scope.
+#define CANDLEWICK_PROFILE_SCOPE(name)                                        \
+  ::candlewick::ProfileScope CANDLEWICK_PROFILE_CONCAT(_cdw_profile_zone_,    \
+                                                       __LINE__)(name)
+/// \brief Delimit a profiler frame by the current scope.
+#define CANDLEWICK_PROFILE_FRAME()                                            \
+  ::candlewick::ProfileFrameScope CANDLEWICK_PROFILE_CONCAT(                  \
+      _cdw_profile_frame_, __LINE__)
+#else
+#define CANDLEWICK_PROFILE_SCOPE(name) static_cast<void>(0)
+#define CANDLEWICK_PROFILE_FRAME() static_cast<void>(0)
+#endif
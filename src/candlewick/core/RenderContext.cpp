@@ -170,6 +170,22 @@ void RenderContext::destroy() noexcept {
 }
 
 namespace rend {
+  SDL_GPURenderPass *
+  beginRenderPass(SDL_GPUCommandBuffer *command_buffer,
+                  std::span<const SDL_GPUColorTargetInfo> color_targets,
+                  const SDL_GPUDepthStencilTargetInfo *depth_stencil_target) {
+    render_stats::current().renderPasses++;
+    return SDL_BeginGPURenderPass(command_buffer, color_targets.data(),
+                                  Uint32(color_targets.size()),
+                                  depth_stencil_target);
+  }
+
+  void drawPrimitives(SDL_GPURenderPass *pass, Uint32 numVertices,
+                      Uint32 numInstances, Uint32 firstVertex) {
+    SDL_DrawGPUPrimitives(pass, numVertices, numInstances, firstVertex, 0);
+    render_stats::recordDraw(numVertices, numInstances);
+  }
+
   void bindMesh(SDL_GPURenderPass *pass, const Mesh &mesh) {
     const Uint32 num_buffers = Uint32(mesh.vertexBuffers.size());
     std::vector<SDL_GPUBufferBinding> vertex_bindings;
@@ -179,10 +195,12 @@ namespace rend {
     }
 
     SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings.data(), num_buffers);
+    render_stats::current().vertexBufferBinds++;
     if (mesh.isIndexed()) {
       SDL_GPUBufferBinding index_binding = mesh.getIndexBinding();
       SDL_BindGPUIndexBuffer(pass, &index_binding,
                              SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      render_stats::current().indexBufferBinds++;
     }
   }
 
@@ -195,10 +213,12 @@ namespace rend {
     }
 
     SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings.data(), num_buffers);
+    render_stats::current().vertexBufferBinds++;
     if (meshView.isIndexed()) {
       SDL_GPUBufferBinding index_binding = {meshView.indexBuffer, 0u};
       SDL_BindGPUIndexBuffer(pass, &index_binding,
                              SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      render_stats::current().indexBufferBinds++;
     }
   }
 
@@ -209,9 +229,9 @@ namespace rend {
       SDL_DrawGPUIndexedPrimitives(pass, mesh.indexCount, numInstances,
                                    mesh.indexOffset, Sint32(mesh.vertexOffset),
                                    0);
+      render_stats::recordDraw(mesh.indexCount, numInstances);
     } else {
-      SDL_DrawGPUPrimitives(pass, mesh.vertexCount, numInstances,
-                            mesh.vertexOffset, 0);
+      drawPrimitives(pass, mesh.vertexCount, numInstances, mesh.vertexOffset);
     }
   }
 
@@ -138,6 +138,18 @@ public:
 
 namespace rend {
 
+  /// \brief Begin a render pass, counting it in the render statistics.
+  SDL_GPURenderPass *
+  beginRenderPass(SDL_GPUCommandBuffer *command_buffer,
+                  std::span<const SDL_GPUColorTargetInfo> color_targets,
+                  const SDL_GPUDepthStencilTargetInfo *depth_stencil_target =
+                      nullptr);
+
+  /// \brief Draw non-indexed primitives without any vertex buffer bound, e.g.
+  /// a fullscreen quad generated in the vertex shader.
+  void drawPrimitives(SDL_GPURenderPass *pass, Uint32 numVertices,
+                      Uint32 numInstances = 1, Uint32 firstVertex = 0);
+
   /// \brief Bind a Mesh object.
   /// \sa bindMeshView()
   void bindMesh(SDL_GPURenderPass *pass, const Mesh &mesh);
@@ -0,0 +1,109 @@
+#include "RenderStats.h"
+
+#include <imgui.h>
+#include <magic_enum/magic_enum.hpp>
+
+namespace candlewick {
+
+static_assert(magic_enum::enum_count<RenderStatsPass>() ==
+              kNumRenderStatsPasses);
+
+RenderCounters &RenderCounters::operator+=(const RenderCounters &other) {
+  drawCalls += other.drawCalls;
+  instances += other.instances;
+  triangles += other.triangles;
+  pipelineBinds += other.pipelineBinds;
+  vertexBufferBinds += other.vertexBufferBinds;
+  indexBufferBinds += other.indexBufferBinds;
+  uniformBytes += other.uniformBytes;
+  renderPasses += other.renderPasses;
+  return *this;
+}
+
+RenderCounters RenderStats::total() const {
+  RenderCounters out;
+  for (const auto &counters : passes)
+    out += counters;
+  return out;
+}
+
+namespace render_stats {
+  static RenderStats g_current;
+  static RenderStats g_last;
+  static RenderStatsPass g_pass = RenderStatsPass::Other;
+  static SDL_GPUPrimitiveType g_primitiveType =
+      SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+
+  RenderCounters &current() { return g_current[g_pass]; }
+
+  RenderStatsPass currentPass() { return g_pass; }
+
+  void setCurrentPass(RenderStatsPass pass) { g_pass = pass; }
+
+  const RenderStats &currentFrame() { return g_current; }
+
+  const RenderStats &lastFrame() { return g_last; }
+
+  void endFrame() {
+    g_last = g_current;
+    g_current = {};
+  }
+
+  void recordDraw(Uint32 numElements, Uint32 numInstances) {
+    RenderCounters &c = current();
+    c.drawCalls++;
+    c.instances += numInstances;
+    Uint64 triangles = 0;
+    switch (g_primitiveType) {
+    case SDL_GPU_PRIMITIVETYPE_TRIANGLELIST:
+      triangles = numElements / 3;
+      break;
+    case SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP:
+      triangles = numElements >= 3 ? numElements - 2 : 0;
+      break;
+    default:
+      break;
+    }
+    c.triangles += triangles * numInstances;
+  }
+
+  void recordPipelineBind(SDL_GPUPrimitiveType primitiveType) {
+    current().pipelineBinds++;
+    g_primitiveType = primitiveType;
+  }
+} // namespace render_stats
+
+namespace gui {
+  void addRenderStatsTable(const RenderStats &stats) {
+    const ImGuiTableFlags flags = ImGuiTableFlags_Borders |
+                                  ImGuiTableFlags_RowBg |
+                                  ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("render_stats", 9, flags))
+      return;
+    for (const char *header : {"Pass", "Draws", "Instances", "Triangles",
+                               "Pipelines", "VB binds", "IB binds",
+                               "Uniform bytes", "Passes"})
+      ImGui::TableSetupColumn(header);
+    ImGui::TableHeadersRow();
+
+    auto row = [](const char *name, const RenderCounters &c) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name);
+      for (Uint64 value :
+           {c.drawCalls, c.instances, c.triangles, c.pipelineBinds,
+            c.vertexBufferBinds, c.indexBufferBinds, c.uniformBytes,
+            c.renderPasses}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", (unsigned long long)value);
+      }
+    };
+    for (auto pass : magic_enum::enum_values<RenderStatsPass>()) {
+      row(magic_enum::enum_name(pass).data(), stats[pass]);
+    }
+    row("Total", stats.total());
+    ImGui::EndTable();
+  }
+} // namespace gui
+
+} // namespace candlewick
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+
+#include <array>
+
+namespace candlewick {
+
+/// \brief Passes by which render statistics are bucketed.
+enum class RenderStatsPass : Uint8 {
+  Other,
+  Shadow,
+  Ssao,
+  Opaque,
+  Debug,
+  Transparent,
+  Gui,
+};
+inline constexpr size_t kNumRenderStatsPasses = 7;
+
+/// \brief GPU work recorded by the CPU during a frame.
+struct RenderCounters {
+  Uint64 drawCalls = 0;
+  /// Instances drawn, summed over all draw calls.
+  Uint64 instances = 0;
+  /// Triangles drawn (for triangle list and strip pipelines), including
+  /// instances.
+  Uint64 triangles = 0;
+  Uint64 pipelineBinds = 0;
+  Uint64 vertexBufferBinds = 0;
+  Uint64 indexBufferBinds = 0;
+  /// Bytes of uniform data pushed through the CommandBuffer.
+  Uint64 uniformBytes = 0;
+  Uint64 renderPasses = 0;
+
+  RenderCounters &operator+=(const RenderCounters &other);
+};
+
+/// \brief Render counters of a frame, by pass.
+struct RenderStats {
+  std::array<RenderCounters, kNumRenderStatsPasses> passes{};
+
+  RenderCounters &operator[](RenderStatsPass pass) {
+    return passes[size_t(pass)];
+  }
+  const RenderCounters &operator[](RenderStatsPass pass) const {
+    return passes[size_t(pass)];
+  }
+
+  /// \brief Counters summed over all passes.
+  RenderCounters total() const;
+};
+
+/// \brief Global render statistics.
+///
+/// The counters are incremented by the rend:: helpers,
+/// CommandBuffer::pushVertexUniformRaw(), pushFragmentUniformRaw() and
+/// GraphicsPipeline::bind(). They are not synchronized, and should only be
+/// touched from the thread recording render commands.
+namespace render_stats {
+  /// \brief Counters of the pass currently being recorded.
+  RenderCounters &current();
+
+  RenderStatsPass currentPass();
+  void setCurrentPass(RenderStatsPass pass);
+
+  /// \brief Statistics of the frame being recorded.
+  const RenderStats &currentFrame();
+
+  /// \brief Statistics of the last frame, as of the last call to endFrame().
+  const RenderStats &lastFrame();
+
+  /// \brief Store the statistics of the frame being recorded as lastFrame(),
+  /// and reset the counters.
+  void endFrame();
+
+  /// \brief Record a draw call of \p numElements vertices or indices, using
+  /// the primitive type of the last pipeline bound with
+  /// GraphicsPipeline::bind().
+  void recordDraw(Uint32 numElements, Uint32 numInstances);
+
+  void recordPipelineBind(SDL_GPUPrimitiveType primitiveType);
+} // namespace render_stats
+
+/// \brief RAII helper attributing the render statistics recorded in its scope
+/// to a pass, then restoring the previous pass.
+class RenderStatsPassScope {
+  RenderStatsPass m_previous;
+
+public:
+  explicit RenderStatsPassScope(RenderStatsPass pass)
+      : m_previous(render_stats::currentPass()) {
+    render_stats::setCurrentPass(pass);
+  }
+  ~RenderStatsPassScope() { render_stats::setCurrentPass(m_previous); }
+  RenderStatsPassScope(const RenderStatsPassScope &) = delete;
+  RenderStatsPassScope &operator=(const RenderStatsPassScope &) = delete;
+};
+
+namespace gui {
+  /// \brief Show a table of the render statistics of the last frame, by pass.
+  void addRenderStatsTable(const RenderStats &stats);
+} // namespace gui
+
+} // namespace candlewick
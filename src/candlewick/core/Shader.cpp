@@ -2,6 +2,8 @@
 #include "Device.h"
 #include "errors.h"
 
+#include <SDL3/SDL_filesystem.h>
+
 #define JSON_NO_IO
 #define JSON_USE_IMPLICIT_CONVERSIONS 0
 #include <nlohmann/json.hpp>
@@ -24,10 +26,15 @@ struct ShaderCode {
   ~ShaderCode() noexcept { SDL_free(data); }
 };
 
-ShaderCode loadShaderFile(const char *filename, const char *shader_ext) {
-  char shader_path[256];
+static void shaderFilePath(char (&shader_path)[256], const char *filename,
+                           const char *shader_ext) {
   SDL_snprintf(shader_path, sizeof(shader_path), "%s/%s.%s",
                g_shader_dir.c_str(), filename, shader_ext);
+}
+
+ShaderCode loadShaderFile(const char *filename, const char *shader_ext) {
+  char shader_path[256];
+  shaderFilePath(shader_path, filename, shader_ext);
 
   size_t code_size;
   void *code = SDL_LoadFile(shader_path, &code_size);
@@ -86,6 +93,25 @@ void Shader::release() noexcept {
   }
 }
 
+bool shaderExists(const Device &device, const char *shader_name) {
+  const SDL_GPUShaderFormat formats = device.shaderFormats();
+  const char *shader_ext;
+  if (formats & SDL_GPU_SHADERFORMAT_SPIRV)
+    shader_ext = "spv";
+  else if (formats & SDL_GPU_SHADERFORMAT_MSL)
+    shader_ext = "msl";
+  else
+    return false;
+
+  char shader_path[256];
+  for (const char *ext : {"json", shader_ext}) {
+    shaderFilePath(shader_path, shader_name, ext);
+    if (!SDL_GetPathInfo(shader_path, nullptr))
+      return false;
+  }
+  return true;
+}
+
 Shader::Config loadShaderMetadata(const char *filename) {
   auto data = loadShaderFile(filename, "json");
   auto json = nlohmann::json::parse(data.data, data.data + data.size);
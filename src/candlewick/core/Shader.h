@@ -69,6 +69,15 @@ inline Shader::Shader(Shader &&other) noexcept
 /// is inferred from the shader name.
 Shader::Config loadShaderMetadata(const char *shader_name);
 
+/// \brief Whether the compiled shader \p shader_name is present in the current
+/// shader directory: its metadata, and its code in a format supported by \p
+/// device.
+///
+/// This allows falling back to another path when optional shaders have not
+/// been compiled (see \c process_shaders.py), instead of failing in
+/// Shader::fromMetadata().
+bool shaderExists(const Device &device, const char *shader_name);
+
 inline Shader Shader::fromMetadata(const Device &device,
                                    const char *shader_name) {
   auto config = loadShaderMetadata(shader_name);
@@ -0,0 +1,196 @@
+#include "StreamedPointCloud.h"
+#include "Camera.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace candlewick {
+
+static constexpr Uint32 kPositionSize = 3 * sizeof(float);
+static constexpr Uint32 kColorSize = 4 * sizeof(Uint8);
+
+StreamedPointCloud::StreamedPointCloud(const Device &device,
+                                       const std::string &path,
+                                       const StreamedPointCloudConfig &config)
+    : m_device(&device), m_file(path), config(config) {}
+
+StreamedPointCloud::StreamedPointCloud(StreamedPointCloud &&other) noexcept
+    : m_device(std::exchange(other.m_device, nullptr))
+    , m_transferBuffer(std::exchange(other.m_transferBuffer, nullptr))
+    , m_transferCapacity(std::exchange(other.m_transferCapacity, 0u))
+    , m_uploads(std::move(other.m_uploads))
+    , m_file(std::move(other.m_file))
+    , m_lru(std::move(other.m_lru))
+    , m_resident(std::move(other.m_resident))
+    , m_numResidentPoints(std::exchange(other.m_numResidentPoints, 0u))
+    , m_selected(std::move(other.m_selected))
+    , m_visible(std::move(other.m_visible))
+    , m_positions(std::move(other.m_positions))
+    , m_colors(std::move(other.m_colors))
+    , config(other.config) {}
+
+StreamedPointCloud &
+StreamedPointCloud::operator=(StreamedPointCloud &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    m_device = std::exchange(other.m_device, nullptr);
+    m_transferBuffer = std::exchange(other.m_transferBuffer, nullptr);
+    m_transferCapacity = std::exchange(other.m_transferCapacity, 0u);
+    m_uploads = std::move(other.m_uploads);
+    m_file = std::move(other.m_file);
+    m_lru = std::move(other.m_lru);
+    m_resident = std::move(other.m_resident);
+    m_numResidentPoints = std::exchange(other.m_numResidentPoints, 0u);
+    m_selected = std::move(other.m_selected);
+    m_visible = std::move(other.m_visible);
+    m_positions = std::move(other.m_positions);
+    m_colors = std::move(other.m_colors);
+    config = other.config;
+  }
+  return *this;
+}
+
+void StreamedPointCloud::reserveTransfer(Uint32 size) {
+  if (size <= m_transferCapacity)
+    return;
+  SDL_GPUDevice *device = *m_device;
+  if (m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(device, m_transferBuffer);
+  SDL_GPUTransferBufferCreateInfo transfer_ci{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = size,
+      .props = 0,
+  };
+  m_transferBuffer = SDL_CreateGPUTransferBuffer(device, &transfer_ci);
+  if (!m_transferBuffer)
+    terminate_with_message("Failed to create transfer buffer: {:s}",
+                           SDL_GetError());
+  m_transferCapacity = size;
+}
+
+void StreamedPointCloud::update(const Mat4f &modelMatrix,
+                                const Camera &camera) {
+  m_file.selectNodes(modelMatrix, camera.viewProj(), camera.position(),
+                     config.pointBudget, m_selected);
+  m_visible.clear();
+
+  // nodes to load in this frame, staged together in the transfer buffer
+  const bool can_load = m_uploads.empty();
+  Uint32 numLoads = 0;
+  Uint32 staging_size = 0;
+  for (Uint32 node : m_selected) {
+    if (!can_load || numLoads == config.maxLoadsPerFrame)
+      break;
+    if (!m_resident.contains(node)) {
+      numLoads++;
+      staging_size += m_file.node(node).numPoints * (kPositionSize + kColorSize);
+    }
+  }
+  Uint8 *mapped = nullptr;
+  if (numLoads > 0) {
+    this->reserveTransfer(staging_size);
+    // the previous uploads were flushed, the transfer buffer can be cycled
+    mapped = (Uint8 *)SDL_MapGPUTransferBuffer(*m_device, m_transferBuffer,
+                                               true);
+  }
+
+  Uint32 offset = 0;
+  numLoads = 0;
+  for (Uint32 node : m_selected) {
+    if (auto it = m_resident.find(node); it != m_resident.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+    } else {
+      // not drawn until loaded, in a later frame
+      if (!mapped || numLoads == config.maxLoadsPerFrame)
+        continue;
+      numLoads++;
+      m_file.readNode(node, m_positions, m_colors);
+      const auto n = Uint32(m_positions.cols());
+      Eigen::Map<Eigen::Matrix3Xf>((float *)(mapped + offset), 3, n) =
+          m_positions;
+      Eigen::Map<PointColorMatrix>(mapped + offset + n * kPositionSize, 4, n) =
+          m_colors;
+
+      Mesh mesh{*m_device, PointCloud::layout()};
+      const Uint32 sizes[2] = {n * kPositionSize, n * kColorSize};
+      for (Uint32 slot = 0; slot < 2; slot++) {
+        SDL_GPUBufferCreateInfo buffer_ci{
+            .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+            .size = std::max(sizes[slot], 1u),
+            .props = 0,
+        };
+        SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(*m_device, &buffer_ci);
+        if (!buffer)
+          terminate_with_message("Failed to create point cloud buffer: {:s}",
+                                 SDL_GetError());
+        mesh.bindVertexBuffer(slot, buffer);
+      }
+      mesh.vertexCount = n;
+      m_lru.push_front({node, std::move(mesh)});
+      m_uploads.push_back({&m_lru.front().mesh, n, offset});
+      offset += sizes[0] + sizes[1];
+      m_resident.emplace(node, m_lru.begin());
+      m_numResidentPoints += m_file.node(node).numPoints;
+    }
+    m_visible.push_back(&m_lru.front().mesh);
+  }
+  if (mapped)
+    SDL_UnmapGPUTransferBuffer(*m_device, m_transferBuffer);
+
+  // the nodes drawn in this frame are at the front, and never evicted
+  while (m_numResidentPoints > config.maxResidentPoints &&
+         m_lru.size() > m_visible.size()) {
+    const Uint32 node = m_lru.back().node;
+    const Mesh *mesh = &m_lru.back().mesh;
+    std::erase_if(m_uploads, [mesh](const PendingUpload &upload) {
+      return upload.mesh == mesh;
+    });
+    m_numResidentPoints -= m_file.node(node).numPoints;
+    m_resident.erase(node);
+    m_lru.pop_back();
+  }
+}
+
+void StreamedPointCloud::flush(CommandBuffer &command_buffer) {
+  if (m_uploads.empty())
+    return;
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  for (const PendingUpload &upload : m_uploads) {
+    const Uint32 n = upload.numPoints;
+    const Uint32 offsets[2] = {upload.offset, upload.offset + n * kPositionSize};
+    const Uint32 sizes[2] = {n * kPositionSize, n * kColorSize};
+    for (Uint32 slot = 0; slot < 2 && n > 0; slot++) {
+      SDL_GPUTransferBufferLocation src{
+          .transfer_buffer = m_transferBuffer,
+          .offset = offsets[slot],
+      };
+      SDL_GPUBufferRegion dst{
+          .buffer = upload.mesh->vertexBuffers[slot],
+          .offset = 0,
+          .size = sizes[slot],
+      };
+      SDL_UploadToGPUBuffer(copy_pass, &src, &dst, false);
+    }
+    if (n > 0)
+      upload.mesh->addView(0, n, 0, 0);
+  }
+  SDL_EndGPUCopyPass(copy_pass);
+  m_uploads.clear();
+}
+
+void StreamedPointCloud::release() noexcept {
+  if (m_device && m_transferBuffer)
+    SDL_ReleaseGPUTransferBuffer(*m_device, m_transferBuffer);
+  m_transferBuffer = nullptr;
+  m_transferCapacity = 0;
+  m_uploads.clear();
+  m_visible.clear();
+  m_resident.clear();
+  m_lru.clear();
+  m_numResidentPoints = 0;
+}
+
+} // namespace candlewick
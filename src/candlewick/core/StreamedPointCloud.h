@@ -0,0 +1,109 @@
+#pragma once
+
+#include "PointCloud.h"
+#include "PointOctree.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace candlewick {
+
+/// \brief Parameters of a streamed point cloud.
+/// \sa StreamedPointCloud
+struct StreamedPointCloudConfig {
+  /// Maximum number of points drawn per frame.
+  Uint64 pointBudget = 5'000'000;
+  /// Maximum number of points kept on the GPU. The least recently drawn nodes
+  /// are evicted beyond this.
+  Uint64 maxResidentPoints = 20'000'000;
+  /// Maximum number of nodes read from the file and uploaded per frame. The
+  /// other selected nodes are loaded in the next frames.
+  Uint32 maxLoadsPerFrame = 16;
+};
+
+/// \brief Out-of-core point cloud, read from a point cloud octree file and
+/// streamed to the GPU by nodes, depending on the camera.
+///
+/// Each frame, update() selects the nodes to draw within the point budget, and
+/// loads the missing ones. Resident nodes are kept in an LRU list, each with
+/// its own vertex buffers (in the layout of PointCloud::layout()). The nodes
+/// loaded in a frame are staged together in one transfer buffer, shared by
+/// all nodes, and their uploads are recorded by flush().
+/// \sa buildPointOctree(), PointOctreeFile
+class StreamedPointCloud {
+  struct ResidentNode {
+    Uint32 node;
+    Mesh mesh;
+  };
+  using LruList = std::list<ResidentNode>;
+  /// Upload of a node loaded by update(), waiting for flush().
+  struct PendingUpload {
+    Mesh *mesh;
+    Uint32 numPoints;
+    /// Offset of the node's positions in the transfer buffer, followed by its
+    /// colors.
+    Uint32 offset;
+  };
+
+  const Device *m_device;
+  SDL_GPUTransferBuffer *m_transferBuffer{nullptr};
+  /// Capacity of the transfer buffer, in bytes.
+  Uint32 m_transferCapacity{0};
+  std::vector<PendingUpload> m_uploads;
+  PointOctreeFile m_file;
+  /// Resident nodes, the most recently drawn first.
+  LruList m_lru;
+  std::unordered_map<Uint32, LruList::iterator> m_resident;
+  Uint64 m_numResidentPoints{0};
+  std::vector<Uint32> m_selected;
+  std::vector<const Mesh *> m_visible;
+  // scratch buffers for reading nodes
+  Eigen::Matrix3Xf m_positions;
+  PointColorMatrix m_colors;
+
+  void reserveTransfer(Uint32 size);
+
+public:
+  StreamedPointCloudConfig config;
+
+  StreamedPointCloud(const Device &device, const std::string &path,
+                     const StreamedPointCloudConfig &config = {});
+
+  StreamedPointCloud(const StreamedPointCloud &) = delete;
+  StreamedPointCloud(StreamedPointCloud &&other) noexcept;
+  StreamedPointCloud &operator=(const StreamedPointCloud &) = delete;
+  StreamedPointCloud &operator=(StreamedPointCloud &&other) noexcept;
+
+  /// \brief Select the nodes to draw for \p camera, load the missing ones (up
+  /// to StreamedPointCloudConfig::maxLoadsPerFrame) and evict the least
+  /// recently drawn ones.
+  ///
+  /// No node is loaded while the uploads of the previous loads were not
+  /// flushed, as they share the transfer buffer.
+  void update(const Mat4f &modelMatrix, const Camera &camera);
+
+  /// \brief Record the upload of the nodes loaded by update(), in a copy pass
+  /// recorded to \p command_buffer. This must happen outside of any render
+  /// pass.
+  void flush(CommandBuffer &command_buffer);
+
+  /// \brief Meshes of the resident nodes to draw in this frame. Nodes whose
+  /// upload was not flushed yet have no view.
+  std::span<const Mesh *const> visibleNodes() const { return m_visible; }
+
+  /// \brief Call \p func on the mesh of every resident node, for views which
+  /// were not used to select the nodes.
+  template <typename F> void forEachResidentNode(F &&func) const {
+    for (const ResidentNode &resident : m_lru)
+      func(resident.mesh);
+  }
+
+  const PointOctreeFile &file() const { return m_file; }
+  Uint32 numResidentNodes() const { return Uint32(m_lru.size()); }
+  Uint64 numResidentPoints() const { return m_numResidentPoints; }
+
+  void release() noexcept;
+  ~StreamedPointCloud() noexcept { this->release(); }
+};
+
+} // namespace candlewick
@@ -65,7 +65,7 @@ void renderDepthDebug(const RenderContext &renderer,
   color_target.load_op = SDL_GPU_LOADOP_CLEAR;
   color_target.store_op = SDL_GPU_STOREOP_STORE;
   SDL_GPURenderPass *render_pass =
-      SDL_BeginGPURenderPass(command_buffer, &color_target, 1, nullptr);
+      rend::beginRenderPass(command_buffer, {&color_target, 1});
 
   pass.pipeline.bind(render_pass);
 
@@ -79,7 +79,7 @@ void renderDepthDebug(const RenderContext &renderer,
                           opts.cam_proj == CameraProjection::ORTHOGRAPHIC};
 
   command_buffer.pushFragmentUniform(0, cam_ubo);
-  SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+  rend::drawPrimitives(render_pass, 6);
 
   SDL_EndGPURenderPass(render_pass);
 }
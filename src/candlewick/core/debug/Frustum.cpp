@@ -62,7 +62,7 @@ namespace frustum_debug {
     depth_target.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
     depth_target.cycle = false;
 
-    return SDL_BeginGPURenderPass(cmdBuf, &color_target, 1, &depth_target);
+    return rend::beginRenderPass(cmdBuf, {&color_target, 1}, &depth_target);
   }
 
   void renderFrustum(CommandBuffer &cmdBuf, SDL_GPURenderPass *render_pass,
@@ -77,7 +77,7 @@ namespace frustum_debug {
     };
     cmdBuf.pushVertexUniform(0, ubo);
 
-    SDL_DrawGPUPrimitives(render_pass, NUM_VERTICES, 1, 0, 0);
+    rend::drawPrimitives(render_pass, NUM_VERTICES);
   }
 
   void renderFrustum(CommandBuffer &cmdBuf, SDL_GPURenderPass *render_pass,
@@ -0,0 +1,234 @@
+#include "FrameCapture.h"
+#include "../core/CommandBuffer.h"
+#include "../utils/PixelFormatConversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace candlewick {
+namespace multibody {
+
+  /// Convert depth buffer values to metric view-space depth, inverting the
+  /// projection matrix. Pixels with a (cleared) zero depth are left at zero.
+  static void linearizeDepth(const float *in, float *out, Uint32 count,
+                             const Mat4f &projection) {
+    const float A = projection(2, 2);
+    const float B = projection(2, 3);
+    if (projection(3, 2) != 0.f) {
+      // perspective: A = (f + n) / (n - f), B = 2fn / (n - f)
+      const float zNear = B / (A - 1.f);
+      const float zFar = B / (A + 1.f);
+      linearizeDepthConvert(in, out, count, zNear, zFar);
+    } else {
+      // orthographic: depth = A * z_view + B
+      for (Uint32 i = 0; i < count; i++)
+        out[i] = (B - in[i]) / A;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+      if (in[i] <= 0.f)
+        out[i] = 0.f;
+    }
+  }
+
+  size_t
+  appendCaptureDownloads(std::vector<media::TextureDownloadInfo> &downloads,
+                         const RobotScene::ViewTargets &targets,
+                         SDL_GPUTextureFormat color_format, Uint16 width,
+                         Uint16 height, const FrameCaptureConfig &config) {
+    const auto &gBuffer = *targets.gBuffer;
+    const bool needGBuffer = config.depth || config.normals;
+    if ((needGBuffer || config.instanceIds) && !gBuffer.initialized())
+      terminate_with_message("Cannot capture depth, normals or instance IDs: "
+                             "the scene's G-buffer was not initialized.");
+    if (config.instanceIds && !gBuffer.instanceIdMap)
+      terminate_with_message("Cannot capture instance IDs: they are not "
+                             "enabled in the RobotScene config.");
+
+    const bool has_msaa = targets.msaa;
+    const size_t start = downloads.size();
+    if (config.color)
+      downloads.push_back({targets.resolvedColor, color_format, width, height});
+    // depth is also needed to mask out the background normals
+    if (needGBuffer)
+      downloads.push_back({has_msaa ? gBuffer.resolveDepthCopyTex
+                                    : gBuffer.depthCopyTex,
+                           gBuffer.depthCopyTex.format(), width, height});
+    if (config.normals)
+      downloads.push_back(
+          {has_msaa ? gBuffer.resolveNormalMap : gBuffer.normalMap,
+           gBuffer.normalMap.format(), width, height});
+    if (config.instanceIds)
+      downloads.push_back({gBuffer.instanceIdMap,
+                           gBuffer.instanceIdMap.format(), width, height});
+    return downloads.size() - start;
+  }
+
+  FrameCapture
+  decodeFrameCapture(std::span<const media::DownloadResult> results,
+                     Uint16 width, Uint16 height, const Mat4f &projection,
+                     const FrameCaptureConfig &config) {
+    const bool needGBuffer = config.depth || config.normals;
+    const Uint32 numPixels = Uint32(width) * height;
+    FrameCapture capture;
+    capture.width = width;
+    capture.height = height;
+    size_t idx = 0;
+
+    if (config.color) {
+      auto &res = results[idx++];
+      capture.color.resize(res.payloadSize);
+      if (res.format == SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM)
+        bgraToRgbaConvert(res.data,
+                          reinterpret_cast<Uint32 *>(capture.color.data()),
+                          numPixels);
+      else
+        std::memcpy(capture.color.data(), res.data, res.payloadSize);
+    }
+
+    const float *rawDepth = nullptr;
+    if (needGBuffer)
+      rawDepth = reinterpret_cast<const float *>(results[idx++].data);
+
+    if (config.depth) {
+      switch (config.depthFormat) {
+      case DepthFormat::FLOAT32:
+        capture.depth.resize(numPixels);
+        linearizeDepth(rawDepth, capture.depth.data(), numPixels, projection);
+        break;
+      case DepthFormat::UINT16_MM: {
+        std::vector<float> metric(numPixels);
+        linearizeDepth(rawDepth, metric.data(), numPixels, projection);
+        capture.depthMm.resize(numPixels);
+        depthToUint16Convert(metric.data(), capture.depthMm.data(), numPixels,
+                             1000.f);
+        break;
+      }
+      }
+    }
+
+    if (config.normals) {
+      // the G-buffer stores the xy components of the view-space normal
+      const auto *packed =
+          reinterpret_cast<const Uint16 *>(results[idx++].data);
+      capture.normals.resize(3 * size_t(numPixels));
+      for (Uint32 i = 0; i < numPixels; i++) {
+        float *n = capture.normals.data() + 3 * size_t(i);
+        if (rawDepth[i] <= 0.f) {
+          n[0] = n[1] = n[2] = 0.f;
+          continue;
+        }
+        Float3 normal;
+        normal.x() = halfToFloat(packed[2 * i]);
+        normal.y() = halfToFloat(packed[2 * i + 1]);
+        // visible faces point towards the camera, i.e. towards +z
+        normal.z() =
+            std::sqrt(std::max(0.f, 1.f - normal.head<2>().squaredNorm()));
+        normal.normalize();
+        std::copy_n(normal.data(), 3, n);
+      }
+    }
+
+    if (config.instanceIds) {
+      const auto *ids = reinterpret_cast<const Uint32 *>(results[idx++].data);
+      capture.instanceIds.assign(ids, ids + numPixels);
+    }
+    return capture;
+  }
+
+  FrameCapture captureFrame(CommandBuffer &command_buffer,
+                            const RenderContext &renderer,
+                            const RobotScene &robot_scene, const Camera &camera,
+                            media::TransferBufferPool &pool,
+                            const FrameCaptureConfig &config) {
+    const auto [width, height] = renderer.window.sizeInPixels();
+    const auto w = Uint16(width);
+    const auto h = Uint16(height);
+
+    std::vector<media::TextureDownloadInfo> textures;
+    appendCaptureDownloads(textures, robot_scene.mainTargets(),
+                           renderer.colorFormat(), w, h, config);
+    if (textures.empty())
+      return FrameCapture{.width = w, .height = h};
+
+    auto results = media::downloadTextures(command_buffer, renderer.device,
+                                           pool, textures);
+    FrameCapture capture =
+        decodeFrameCapture(results, w, h, camera.projection, config);
+    SDL_UnmapGPUTransferBuffer(renderer.device, results[0].buffer);
+    return capture;
+  }
+
+  std::vector<Uint32> readInstanceIds(CommandBuffer &command_buffer,
+                                      const RenderContext &renderer,
+                                      const RobotScene &robot_scene,
+                                      media::TransferBufferPool &pool, Uint16 x,
+                                      Uint16 y, Uint16 width, Uint16 height) {
+    const Texture &idMap = robot_scene.gBuffer.instanceIdMap;
+    if (!idMap)
+      terminate_with_message("Cannot read instance IDs: they are not enabled "
+                             "in the RobotScene config.");
+    if (Uint32(x) + width > idMap.width() ||
+        Uint32(y) + height > idMap.height())
+      terminate_with_message(
+          "Region ({:d}, {:d}, {:d}, {:d}) is out of the {:d}x{:d} frame.", x, y,
+          width, height, idMap.width(), idMap.height());
+
+    const media::TextureDownloadInfo info{
+        .texture = idMap,
+        .format = idMap.format(),
+        .width = width,
+        .height = height,
+        .x = x,
+        .y = y,
+    };
+    auto res = media::downloadTextures(command_buffer, renderer.device, pool,
+                                       {&info, 1})[0];
+    std::vector<Uint32> ids(res.data, res.data + size_t(width) * height);
+    SDL_UnmapGPUTransferBuffer(renderer.device, res.buffer);
+    return ids;
+  }
+
+  template <typename T>
+  static std::vector<Uint8> toBytes(const std::vector<T> &data) {
+    std::vector<Uint8> bytes(data.size() * sizeof(T));
+    std::memcpy(bytes.data(), data.data(), bytes.size());
+    return bytes;
+  }
+
+  void saveFrameCapture(media::ImageWriter &writer, FrameCapture &&capture,
+                        std::string_view basename) {
+    using media::ImageFileFormat;
+    using media::PixelLayout;
+    const std::string base{basename};
+    auto submit = [&](std::string suffix, std::vector<Uint8> pixels,
+                      PixelLayout layout, ImageFileFormat format) {
+      writer.submit({
+          .filename = base + suffix,
+          .pixels = std::move(pixels),
+          .width = capture.width,
+          .height = capture.height,
+          .layout = layout,
+          .format = format,
+      });
+    };
+
+    if (!capture.color.empty())
+      submit("_color.png", std::move(capture.color), PixelLayout::RGBA8,
+             ImageFileFormat::PNG);
+    if (!capture.depth.empty())
+      submit("_depth.exr", toBytes(capture.depth), PixelLayout::R32F,
+             ImageFileFormat::EXR);
+    if (!capture.depthMm.empty())
+      submit("_depth.png", toBytes(capture.depthMm), PixelLayout::R16,
+             ImageFileFormat::PNG);
+    if (!capture.normals.empty())
+      submit("_normals.exr", toBytes(capture.normals), PixelLayout::RGB32F,
+             ImageFileFormat::EXR);
+    if (!capture.instanceIds.empty())
+      submit("_instance_ids.exr", toBytes(capture.instanceIds),
+             PixelLayout::R32UI, ImageFileFormat::EXR);
+  }
+
+} // namespace multibody
+} // namespace candlewick
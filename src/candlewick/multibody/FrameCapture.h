@@ -0,0 +1,111 @@
+#pragma once
+
+#include "RobotScene.h"
+#include "../core/Camera.h"
+#include "../utils/ImageWriter.h"
+#include "../utils/WriteTextureToImage.h"
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace candlewick {
+namespace multibody {
+
+  /// \brief Storage for the metric depth of a FrameCapture.
+  enum class DepthFormat {
+    /// 32-bit float, in meters.
+    FLOAT32,
+    /// 16-bit unsigned integer, in millimeters (saturated to 65.535m).
+    UINT16_MM,
+  };
+
+  struct FrameCaptureConfig {
+    bool color = true;
+    bool depth = true;
+    bool normals = true;
+    /// Requires RobotScene::Config::enable_instance_ids.
+    bool instanceIds = false;
+    DepthFormat depthFormat = DepthFormat::FLOAT32;
+  };
+
+  /// \brief CPU copy of the buffers of a rendered frame, for e.g. perception
+  /// dataset generation.
+  ///
+  /// All images are stored row-major, top row first. Pixels not covered by any
+  /// triangle mesh have zero depth and normal.
+  struct FrameCapture {
+    Uint32 width = 0;
+    Uint32 height = 0;
+    /// 8-bit RGBA color, as displayed in the window.
+    std::vector<Uint8> color;
+    /// Linear view-space depth, in meters (DepthFormat::FLOAT32).
+    std::vector<float> depth;
+    /// Linear view-space depth, in millimeters (DepthFormat::UINT16_MM).
+    std::vector<Uint16> depthMm;
+    /// View-space unit normals, as interleaved xyz triplets.
+    std::vector<float> normals;
+    /// Per-pixel instance IDs, see RobotScene::entityFromInstanceId().
+    std::vector<Uint32> instanceIds;
+  };
+
+  /// \brief Read back the color, metric depth and normals of the last frame
+  /// rendered by \p robot_scene, in a single copy pass.
+  ///
+  /// Depth and normals come from the scene's G-buffer, so they only cover
+  /// triangle meshes rendered by the opaque PBR pass. With MSAA, they are read
+  /// from the resolved G-buffer targets, whose values are averaged at
+  /// silhouettes.
+  /// \param camera The camera used to render the frame, whose projection is
+  /// inverted to recover metric depth.
+  /// \warning This submits the command buffer and waits for it to complete.
+  FrameCapture captureFrame(CommandBuffer &command_buffer,
+                            const RenderContext &renderer,
+                            const RobotScene &robot_scene, const Camera &camera,
+                            media::TransferBufferPool &pool,
+                            const FrameCaptureConfig &config = {});
+
+  /// \brief Append the texture downloads needed to capture the view rendered
+  /// to \p targets, in the order expected by decodeFrameCapture().
+  ///
+  /// This allows batching the readbacks of several views in a single
+  /// media::downloadTextures() call.
+  /// \returns The number of appended downloads.
+  size_t
+  appendCaptureDownloads(std::vector<media::TextureDownloadInfo> &downloads,
+                         const RobotScene::ViewTargets &targets,
+                         SDL_GPUTextureFormat color_format, Uint16 width,
+                         Uint16 height, const FrameCaptureConfig &config);
+
+  /// \brief Convert the downloads appended by appendCaptureDownloads() into a
+  /// FrameCapture. This does not unmap the transfer buffer.
+  /// \param projection Projection matrix of the camera used to render the
+  /// view.
+  FrameCapture
+  decodeFrameCapture(std::span<const media::DownloadResult> results,
+                     Uint16 width, Uint16 height, const Mat4f &projection,
+                     const FrameCaptureConfig &config);
+
+  /// \brief Read back the instance IDs of a region of the last frame rendered
+  /// by \p robot_scene, e.g. for picking.
+  ///
+  /// \returns The IDs of the `width x height` region starting at pixel (\p x,
+  /// \p y), row-major. Zero is the background, use
+  /// RobotScene::entityFromInstanceId() to get the corresponding entities.
+  /// \warning This submits the command buffer and waits for it to complete.
+  std::vector<Uint32> readInstanceIds(CommandBuffer &command_buffer,
+                                      const RenderContext &renderer,
+                                      const RobotScene &robot_scene,
+                                      media::TransferBufferPool &pool, Uint16 x,
+                                      Uint16 y, Uint16 width, Uint16 height);
+
+  /// \brief Asynchronously write the buffers of \p capture to files.
+  ///
+  /// This writes `<basename>_color.png`, `<basename>_depth.exr` (float depth)
+  /// or `<basename>_depth.png` (16-bit millimeters), `<basename>_normals.exr`
+  /// and `<basename>_instance_ids.exr`, for the buffers which are present.
+  void saveFrameCapture(media::ImageWriter &writer, FrameCapture &&capture,
+                        std::string_view basename);
+
+} // namespace multibody
+} // namespace candlewick
@@ -2,14 +2,18 @@
 #include "../core/LoadCoalGeometries.h"
 #include "../core/errors.h"
 #include "../utils/LoadMesh.h"
+#include "../utils/MeshTransforms.h"
 
 #include <pinocchio/multibody/geometry.hpp>
+#include <coal/BVH/BVH_model.h>
 #include <coal/hfield.h>
 
+#include <filesystem>
+
 namespace candlewick::multibody {
 
 void loadGeometryObject(const pin::GeometryObject &gobj,
-                        std::vector<MeshData> &meshData) {
+                        std::vector<MeshData> &meshData, bool loadMaterials) {
   using namespace coal;
 
   const CollisionGeometry &collgom = *gobj.geometry.get();
@@ -21,7 +25,22 @@ void loadGeometryObject(const pin::GeometryObject &gobj,
 
   switch (objType) {
   case OT_BVH: {
-    loadSceneMeshes(meshPath, meshData);
+    if (loadMaterials && !gobj.meshPath.empty() &&
+        loadSceneMeshes(meshPath, meshData) == mesh_load_retc::OK)
+      break;
+    MeshData md = loadCoalBVH(castCoalGeom<BVHModelBase>(collgom));
+    // undo the scaling baked in by pinocchio when loading the mesh file, which
+    // is applied again by the renderer. BVHs built in memory are not scaled.
+    const Float3 scale = gobj.meshScale.cast<float>();
+    const bool fromFile = !gobj.meshPath.empty() &&
+                          std::filesystem::is_regular_file(gobj.meshPath);
+    if (fromFile && (scale.array() != 1.f).any() &&
+        (scale.array() != 0.f).all()) {
+      Eigen::Affine3f transform = Eigen::Affine3f::Identity();
+      transform.scale(scale.cwiseInverse());
+      apply3DTransformInPlace(md, transform);
+    }
+    meshData.push_back(std::move(md));
     break;
   }
   case OT_GEOM: {
@@ -10,6 +10,15 @@ namespace candlewick::multibody {
 /// \brief Load an invidual pinocchio::GeometryObject 's component geometries
 /// into an array of \c MeshData.
 ///
+/// BVH geometries are converted from the vertices and triangles already stored
+/// in the coal::BVHModel (see loadCoalBVH()), which also works for geometries
+/// built in memory. Since pinocchio bakes pinocchio::GeometryObject::meshScale
+/// into these vertices when loading mesh files, the vertices of BVHs whose
+/// pinocchio::GeometryObject::meshPath is an existing file are divided by it.
+/// If \p loadMaterials is \c true, the mesh file at
+/// pinocchio::GeometryObject::meshPath is imported instead, with its materials,
+/// if it can be loaded.
+///
 /// \note
 /// The mesh materials' base colors will be overriden by the
 /// pinocchio::GeometryObject::meshColor attribute if either of the following
@@ -18,14 +27,16 @@ namespace candlewick::multibody {
 ///   - the pinocchio::GeometryObject::overrideMaterial flag is set to \c true.
 ///
 void loadGeometryObject(const pin::GeometryObject &gobj,
-                        std::vector<MeshData> &meshData);
+                        std::vector<MeshData> &meshData,
+                        bool loadMaterials = false);
 
 /// \copydoc loadGeometryObject(const pin::GeometryObject&,
-/// std::vector<MeshData> &)
+/// std::vector<MeshData> &, bool)
 inline std::vector<MeshData>
-loadGeometryObject(const pin::GeometryObject &gobj) {
+loadGeometryObject(const pin::GeometryObject &gobj,
+                   bool loadMaterials = false) {
   std::vector<MeshData> meshData;
-  loadGeometryObject(gobj, meshData);
+  loadGeometryObject(gobj, meshData, loadMaterials);
   return meshData;
 }
 
@@ -0,0 +1,166 @@
+#include "MultiViewRenderer.h"
+#include "../core/CommandBuffer.h"
+#include "../core/DepthAndShadowPass.h"
+#include "../core/RenderContext.h"
+
+#include <pinocchio/multibody/data.hpp>
+
+namespace candlewick {
+namespace multibody {
+
+  CameraIntrinsics CameraIntrinsics::fromFov(Radf fovY, Uint32 width,
+                                             Uint32 height, float zNear,
+                                             float zFar) {
+    const float f = 0.5f * float(height) / std::tan(0.5f * fovY);
+    return {
+        .fx = f,
+        .fy = f,
+        .cx = 0.5f * float(width),
+        .cy = 0.5f * float(height),
+        .width = width,
+        .height = height,
+        .zNear = zNear,
+        .zFar = zFar,
+    };
+  }
+
+  Mat4f CameraIntrinsics::projection() const {
+    // near-plane extents, with the image y-axis pointing down
+    const float left = -cx * zNear / fx;
+    const float right = (float(width) - cx) * zNear / fx;
+    const float bottom = -(float(height) - cy) * zNear / fy;
+    const float top = cy * zNear / fy;
+    return perspectiveMatrix(left, right, bottom, top, zNear, zFar);
+  }
+
+  Camera MultiViewRenderer::View::camera(const pin::Data &data) const {
+    SE3f pose = config.placement;
+    if (config.frame)
+      pose = data.oMf[*config.frame].cast<float>() * pose;
+    // the optical frame is rotated by pi around x w.r.t. the OpenGL camera
+    // frame (x right, y up, looking down -z)
+    Eigen::Isometry3f glPose;
+    glPose.linear() = pose.rotation() * Float3{1.f, -1.f, -1.f}.asDiagonal();
+    glPose.translation() = pose.translation();
+    return {
+        .projection = config.intrinsics.projection(),
+        .view = glPose.inverse(),
+    };
+  }
+
+  RobotScene::ViewTargets MultiViewRenderer::View::targets() const {
+    const bool msaa = bool(colorMsaa);
+    return {
+        .color = msaa ? colorMsaa : color,
+        .resolvedColor = color,
+        .depth = depth,
+        .gBuffer = gBuffer.get(),
+        .msaa = msaa,
+        .ssao = false,
+        .selected = false,
+    };
+  }
+
+  MultiViewRenderer::MultiViewRenderer(const RenderContext &renderer,
+                                       RobotScene &robot_scene)
+      : m_renderer(renderer), m_scene(robot_scene) {}
+
+  size_t MultiViewRenderer::addView(const SensorViewConfig &config) {
+    if (m_scene.pbrHasPrepass())
+      terminate_with_message("Sensor views do not support scenes configured "
+                             "with a depth pre-pass.");
+    const auto &intrinsics = config.intrinsics;
+    const Uint32 width = intrinsics.width;
+    const Uint32 height = intrinsics.height;
+    if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF)
+      terminate_with_message("Invalid sensor resolution {:d}x{:d}.", width,
+                             height);
+
+    const Device &device = m_renderer.device;
+    View view;
+    view.config = config;
+    auto resize = [&](SDL_GPUTextureCreateInfo desc) {
+      desc.width = width;
+      desc.height = height;
+      return desc;
+    };
+    view.color = Texture{
+        device, resize(m_renderer.resolvedColorTarget().description()),
+        "Sensor color target"};
+    if (m_renderer.msaaEnabled())
+      view.colorMsaa =
+          Texture{device, resize(m_renderer.colorTarget().description()),
+                  "Sensor color target [MSAA]"};
+    view.depth =
+        Texture{device, resize(m_renderer.depthTarget().description()),
+                "Sensor depth target"};
+    view.gBuffer = std::make_unique<RobotScene::GBuffer>();
+    m_scene.createGBuffer(*view.gBuffer, width, height);
+
+    m_views.push_back(std::move(view));
+    return m_views.size() - 1;
+  }
+
+  std::vector<FrameCapture>
+  MultiViewRenderer::render(const pin::Data &data, const AABB &world_bounds,
+                            media::TransferBufferPool &pool) {
+    std::vector<FrameCapture> captures;
+    if (m_views.empty())
+      return captures;
+
+    CommandBuffer command_buffer = m_renderer.acquireCommandBuffer();
+    // instance batches and shadow maps only depend on the scene, not on the
+    // view: build them once for all views
+    m_scene.collectOpaqueCastables(command_buffer);
+    if (m_scene.shadowsEnabled()) {
+      renderShadowPassFromAABB(command_buffer, m_scene.shadowPass,
+                               m_scene.directionalLight, m_scene.castables(),
+                               world_bounds, m_scene.instancedCastables());
+    }
+
+    std::vector<Camera> cameras;
+    cameras.reserve(m_views.size());
+    for (const View &view : m_views) {
+      const Camera &camera = cameras.emplace_back(view.camera(data));
+      const auto targets = view.targets();
+      m_scene.renderOpaque(command_buffer, camera, targets);
+      m_scene.renderTransparent(command_buffer, camera, targets);
+    }
+
+    // read back all the views in one copy pass
+    std::vector<media::TextureDownloadInfo> downloads;
+    std::vector<size_t> counts;
+    counts.reserve(m_views.size());
+    for (const View &view : m_views) {
+      const auto &intrinsics = view.config.intrinsics;
+      counts.push_back(appendCaptureDownloads(
+          downloads, view.targets(), m_renderer.colorFormat(),
+          Uint16(intrinsics.width), Uint16(intrinsics.height),
+          view.config.capture));
+    }
+    if (downloads.empty()) {
+      command_buffer.submit();
+      for (const View &view : m_views)
+        captures.push_back({.width = view.config.intrinsics.width,
+                            .height = view.config.intrinsics.height});
+      return captures;
+    }
+
+    auto results = media::downloadTextures(command_buffer, m_renderer.device,
+                                           pool, downloads);
+    std::span<const media::DownloadResult> remaining = results;
+    captures.reserve(m_views.size());
+    for (size_t i = 0; i < m_views.size(); i++) {
+      const auto &intrinsics = m_views[i].config.intrinsics;
+      captures.push_back(decodeFrameCapture(
+          remaining.first(counts[i]), Uint16(intrinsics.width),
+          Uint16(intrinsics.height), cameras[i].projection,
+          m_views[i].config.capture));
+      remaining = remaining.subspan(counts[i]);
+    }
+    SDL_UnmapGPUTransferBuffer(m_renderer.device, results[0].buffer);
+    return captures;
+  }
+
+} // namespace multibody
+} // namespace candlewick
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Multibody.h"
+#include "FrameCapture.h"
+#include "RobotScene.h"
+#include "../core/Camera.h"
+#include "../core/Texture.h"
+
+#include <pinocchio/spatial/se3.hpp>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace candlewick {
+namespace multibody {
+
+  /// \brief Pinhole camera intrinsics, in pixels.
+  struct CameraIntrinsics {
+    float fx;
+    float fy;
+    /// Principal point, from the top-left corner of the image.
+    float cx;
+    float cy;
+    Uint32 width;
+    Uint32 height;
+    float zNear = 0.01f;
+    float zFar = 20.f;
+
+    /// \brief Intrinsics of a centered camera with vertical field of view \p
+    /// fovY.
+    static CameraIntrinsics fromFov(Radf fovY, Uint32 width, Uint32 height,
+                                    float zNear = 0.01f, float zFar = 20.f);
+
+    /// \brief Projection matrix matching these intrinsics.
+    Mat4f projection() const;
+  };
+
+  /// \brief A camera sensor, optionally attached to a Pinocchio frame.
+  struct SensorViewConfig {
+    CameraIntrinsics intrinsics;
+    /// Frame the sensor is attached to. If empty, \ref placement is relative
+    /// to the world.
+    std::optional<pin::FrameIndex> frame = std::nullopt;
+    /// Placement of the sensor's optical frame (x right, y down, z forward)
+    /// relative to \ref frame.
+    SE3f placement = SE3f::Identity();
+    /// Buffers to read back after rendering.
+    FrameCaptureConfig capture{};
+  };
+
+  /// \brief Render a RobotScene from several camera sensors, to offscreen
+  /// targets.
+  ///
+  /// All views are rendered in a single command buffer, after a single shadow
+  /// pass shared by every view, and their buffers are read back with a single
+  /// copy pass. Offscreen targets use the formats and sample count of the
+  /// RenderContext, as the render pipelines are shared with the main view.
+  ///
+  /// Chunked heightfields and streamed point clouds select their chunks and
+  /// nodes for the main camera only: sensor views draw every chunk (at the
+  /// levels of the main camera) and every resident node.
+  ///
+  /// \warning SSAO and the depth pre-pass are not supported for the sensor
+  /// views.
+  class MultiViewRenderer {
+  public:
+    struct View {
+      SensorViewConfig config;
+      Texture colorMsaa{NoInit};
+      Texture color{NoInit};
+      Texture depth{NoInit};
+      /// Not movable, hence the indirection.
+      std::unique_ptr<RobotScene::GBuffer> gBuffer;
+
+      /// \brief Sensor camera, given the frame placements in \p data.
+      Camera camera(const pin::Data &data) const;
+      RobotScene::ViewTargets targets() const;
+    };
+
+    MultiViewRenderer(const RenderContext &renderer, RobotScene &robot_scene);
+
+    MultiViewRenderer(const MultiViewRenderer &) = delete;
+    MultiViewRenderer &operator=(const MultiViewRenderer &) = delete;
+
+    /// \brief Add a sensor view, allocating its render targets.
+    /// \returns The index of the view.
+    size_t addView(const SensorViewConfig &config);
+
+    void clearViews() { m_views.clear(); }
+
+    size_t numViews() const { return m_views.size(); }
+    const View &view(size_t i) const { return m_views.at(i); }
+
+    /// \brief Render every view and read back their buffers.
+    ///
+    /// \param data Pinocchio data, whose frame placements
+    /// (`pin::updateFramePlacements()`) are used to place the sensors.
+    /// \param world_bounds World-space scene bounds, used to fit the shadow
+    /// maps.
+    /// \returns One capture per view, in the order they were added.
+    /// \warning The scene must be up-to-date (see RobotScene::update()). This
+    /// submits the command buffer and waits for it to complete.
+    std::vector<FrameCapture> render(const pin::Data &data,
+                                     const AABB &world_bounds,
+                                     media::TransferBufferPool &pool);
+
+  private:
+    const RenderContext &m_renderer;
+    RobotScene &m_scene;
+    std::vector<View> m_views;
+  };
+
+} // namespace multibody
+} // namespace candlewick
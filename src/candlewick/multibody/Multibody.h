@@ -2,6 +2,7 @@
 
 #include <pinocchio/multibody/fwd.hpp>
 #include <entt/entity/registry.hpp>
+#include <SDL3/SDL_stdinc.h>
 
 namespace candlewick {
 /// \brief Support for the Pinocchio rigid-body algorithms library and the Coal
@@ -30,6 +31,9 @@ namespace multibody {
 
   struct PinGeomObjComponent {
     pin::GeomIndex geom_index;
+    /// Index of the robot instance owning the geometry, see
+    /// RobotScene::addRobot().
+    Uint32 robot = 0;
     operator auto() const { return geom_index; }
   };
 
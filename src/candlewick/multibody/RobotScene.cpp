@@ -5,12 +5,14 @@
 #include "../core/Components.h"
 #include "../core/TransformUniforms.h"
 #include "../core/Camera.h"
+#include "../core/Profiler.h"
 
 #include <entt/entity/registry.hpp>
 #include <coal/BVH/BVH_model.h>
 #include <pinocchio/multibody/data.hpp>
 #include <pinocchio/multibody/geometry.hpp>
 
+#include <algorithm>
 #include <ranges>
 #include <magic_enum/magic_enum_utility.hpp>
 #include <magic_enum/magic_enum_switch.hpp>
@@ -48,27 +50,47 @@ struct alignas(16) ShadowAtlasInfoUbo {
   std::array<Vec4u, kNumLights> regions;
 };
 
+struct alignas(16) InstancedCameraUbo {
+  GpuMat4 view;
+  GpuMat4 viewProj;
+  Uint32 firstInstance;
+};
+
+static void updateGeometryTransform(entt::registry &registry,
+                                    entt::entity ent,
+                                    const pin::GeometryObject &gobj,
+                                    const pin::SE3 &oMg,
+                                    TransformComponent &tr,
+                                    MeshMaterialComponent &mmc) {
+  SE3f pose = oMg.cast<float>();
+  Float3 scale = gobj.meshScale.cast<float>();
+  if (auto *unit = registry.try_get<const PinGeomUnitScaleComponent>(ent))
+    scale.array() *= unit->scale.array();
+  Float4 color = gobj.meshColor.cast<float>();
+  auto D = scale.homogeneous().asDiagonal();
+  tr.noalias() = pose.toHomogeneousMatrix() * D;
+  if (gobj.overrideMaterial) {
+    for (auto &mat : mmc.materials)
+      mat.baseColor = color;
+    if (color.w() < 1.0f) {
+      registry.remove<Opaque>(ent);
+    } else {
+      registry.emplace_or_replace<Opaque>(ent);
+    }
+  }
+}
+
 void updateRobotTransforms(entt::registry &registry,
                            const pin::GeometryModel &geom_model,
-                           const pin::GeometryData &geom_data) {
+                           const pin::GeometryData &geom_data, Uint32 robot) {
   auto view = registry.view<const PinGeomObjComponent, TransformComponent,
                             MeshMaterialComponent>();
-  for (auto [ent, geom_id, tr, mmc] : view.each()) {
-    auto &gobj = geom_model.geometryObjects[geom_id];
-    SE3f pose = geom_data.oMg[geom_id].cast<float>();
-    Float3 scale = gobj.meshScale.cast<float>();
-    Float4 color = gobj.meshColor.cast<float>();
-    auto D = scale.homogeneous().asDiagonal();
-    tr.noalias() = pose.toHomogeneousMatrix() * D;
-    if (gobj.overrideMaterial) {
-      for (auto &mat : mmc.materials)
-        mat.baseColor = color;
-      if (color.w() < 1.0f) {
-        registry.remove<Opaque>(ent);
-      } else {
-        registry.emplace_or_replace<Opaque>(ent);
-      }
-    }
+  for (auto [ent, obj, tr, mmc] : view.each()) {
+    if (obj.robot != robot)
+      continue;
+    const pin::GeomIndex geom_id = obj;
+    updateGeometryTransform(registry, ent, geom_model.geometryObjects[geom_id],
+                            geom_data.oMg[geom_id], tr, mmc);
   }
 }
 
@@ -124,22 +146,201 @@ entt::entity RobotScene::addEnvironmentObject(MeshData &&data, Mat4f placement,
   return entity;
 }
 
+std::vector<entt::entity>
+RobotScene::addEnvironmentInstances(MeshData &&data,
+                                    std::span<const Mat4f> placements,
+                                    std::span<const Float4> colors) {
+  CANDLEWICK_ASSERT(colors.size() <= 1 || colors.size() == placements.size(),
+                    "Expected one color per instance, or a single color.");
+  const Mesh &mesh =
+      m_environmentMeshes.emplace_back(createMesh(device(), data, true));
+  std::set<pipeline_req_t> required_pipelines{
+      {mesh.layout(), {PIPELINE_TRIANGLEMESH, false, RenderMode::FILL}}};
+  if (instancingEnabled()) {
+    required_pipelines.insert({mesh.layout(),
+                               {PIPELINE_TRIANGLEMESH, false, RenderMode::FILL,
+                                true}});
+  }
+  this->ensurePipelinesExist(required_pipelines);
+
+  std::vector<entt::entity> entities(placements.size());
+  m_registry.create(entities.begin(), entities.end());
+  for (size_t i = 0; i < entities.size(); i++) {
+    const entt::entity entity = entities[i];
+    PbrMaterial material = data.material;
+    if (!colors.empty())
+      material.baseColor = colors[colors.size() == 1 ? 0 : i];
+    m_registry.emplace<TransformComponent>(entity, placements[i]);
+    m_registry.emplace<Opaque>(entity);
+    m_registry.emplace<EnvironmentTag>(entity);
+    const auto &mmc = m_registry.emplace<MeshMaterialComponent>(
+        entity, mesh.borrow(), std::vector{std::move(material)});
+    updateTransparencyClassification(m_registry, entity, mmc);
+    addPipelineTagComponent(m_registry, entity, PIPELINE_TRIANGLEMESH);
+  }
+  return entities;
+}
+
+void RobotScene::updateEnvironmentInstances(
+    std::span<const entt::entity> entities, std::span<const Mat4f> placements) {
+  CANDLEWICK_ASSERT(entities.size() == placements.size(),
+                    "Expected one placement per entity.");
+  for (size_t i = 0; i < entities.size(); i++) {
+    if (!m_registry.valid(entities[i]))
+      continue;
+    if (auto *tr = m_registry.try_get<TransformComponent>(entities[i]))
+      *tr = placements[i];
+  }
+  m_instancesBatched = false;
+}
+
+entt::entity RobotScene::addHeightfieldChunked(
+    const Eigen::Ref<const Eigen::MatrixXf> &heights,
+    const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+    const Eigen::Ref<const Eigen::VectorXf> &ygrid, const Mat4f &placement,
+    const HeightfieldLodConfig &config) {
+  HeightfieldChunks chunks;
+  MeshData data = loadHeightfieldChunks(heights, xgrid, ygrid, chunks,
+                                        config.chunkSize, config.solid);
+  const PipelineType pipe_type =
+      config.solid ? PIPELINE_TRIANGLEMESH : PIPELINE_HEIGHTFIELD;
+  std::set<pipeline_req_t> required_pipelines{
+      {data.layout, {pipe_type, false, RenderMode::FILL}}};
+  this->ensurePipelinesExist(required_pipelines);
+
+  entt::entity entity =
+      addEnvironmentObject(std::move(data), placement, pipe_type);
+  const Mesh &mesh = m_registry.get<const MeshMaterialComponent>(entity).mesh;
+  m_registry.emplace<HeightfieldLodComponent>(entity, mesh, std::move(chunks),
+                                              config.lodDistance);
+  return entity;
+}
+
+void RobotScene::updateHeightfieldLods(const Camera &camera) {
+  auto view = m_registry.view<HeightfieldLodComponent,
+                              const TransformComponent>(entt::exclude<Disable>);
+  for (auto &&[entity, lod, tr] : view.each())
+    lod.update(tr, camera);
+}
+
+entt::entity RobotScene::addDisplacedHeightfield(
+    const Eigen::Ref<const Eigen::MatrixXf> &heights,
+    const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+    const Eigen::Ref<const Eigen::VectorXf> &ygrid, const Mat4f &placement) {
+  CANDLEWICK_ASSERT(
+      heights.rows() == xgrid.size(),
+      "Incompatible dimensions between x-grid and 'heights' matrix.");
+  CANDLEWICK_ASSERT(
+      heights.cols() == ygrid.size(),
+      "Incompatible dimensions between y-grid and 'heights' matrix.");
+  const auto nx = Uint32(heights.rows());
+  const auto ny = Uint32(heights.cols());
+  const Float2 origin{xgrid[0], ygrid[0]};
+  const Float2 spacing{(xgrid[nx - 1] - xgrid[0]) / float(nx - 1),
+                       (ygrid[ny - 1] - ygrid[0]) / float(ny - 1)};
+  CANDLEWICK_ASSERT(
+      xgrid.isApprox(Eigen::VectorXf::LinSpaced(nx, xgrid[0], xgrid[nx - 1])) &&
+          ygrid.isApprox(
+              Eigen::VectorXf::LinSpaced(ny, ygrid[0], ygrid[ny - 1])),
+      "Displaced heightfields require a uniform grid.");
+  const char *shader = m_config.displaced_heightfield_config.vertex_shader_path;
+  if (!shaderExists(device(), shader)) {
+    spdlog::warn("Shader '{:s}' for displaced heightfields not found in "
+                 "'{:s}', adding a chunked heightfield instead.",
+                 shader, currentShaderDirectory());
+    return addHeightfieldChunked(heights, xgrid, ygrid, placement);
+  }
+
+  HeightTexture height_tex{device(), nx, ny, origin, spacing};
+  CommandBuffer command_buffer{device()};
+  height_tex.upload(command_buffer, heights);
+  if (!command_buffer.submit())
+    terminate_with_message("Failed to submit command buffer: {:s}",
+                           SDL_GetError());
+
+  auto [it, inserted] = m_heightfieldGrids.try_emplace({nx, ny}, NoInit);
+  if (inserted)
+    it->second = createMesh(device(), loadHeightfieldGrid(nx, ny), true);
+  Mesh &grid = it->second;
+  const PipelineKey key{PIPELINE_DISPLACED_HEIGHTFIELD, false,
+                        RenderMode::FILL};
+  std::set<pipeline_req_t> required_pipelines{{grid.layout(), key}};
+  this->ensurePipelinesExist(required_pipelines);
+
+  entt::entity entity = m_registry.create();
+  m_registry.emplace<TransformComponent>(entity, placement);
+  m_registry.emplace<Opaque>(entity);
+  m_registry.emplace<EnvironmentTag>(entity);
+  m_registry.emplace<MeshMaterialComponent>(entity, grid.borrow(),
+                                            std::vector{PbrMaterial{}});
+  addPipelineTagComponent(m_registry, entity, PIPELINE_DISPLACED_HEIGHTFIELD);
+  m_registry.emplace<HeightTexture>(entity, std::move(height_tex));
+  return entity;
+}
+
+entt::entity RobotScene::addPointCloud(const Mat4f &placement) {
+  const PipelineKey key{PIPELINE_STREAMED_POINTCLOUD, false, RenderMode::FILL};
+  std::set<pipeline_req_t> required_pipelines{{PointCloud::layout(), key}};
+  this->ensurePipelinesExist(required_pipelines);
+
+  entt::entity entity = m_registry.create();
+  m_registry.emplace<TransformComponent>(entity, placement);
+  m_registry.emplace<EnvironmentTag>(entity);
+  addPipelineTagComponent(m_registry, entity, PIPELINE_STREAMED_POINTCLOUD);
+  m_registry.emplace<PointCloud>(entity, device());
+  return entity;
+}
+
+entt::entity
+RobotScene::addStreamedPointCloud(const std::string &path,
+                                  const Mat4f &placement,
+                                  const StreamedPointCloudConfig &config) {
+  const PipelineKey key{PIPELINE_STREAMED_POINTCLOUD, false, RenderMode::FILL};
+  std::set<pipeline_req_t> required_pipelines{{PointCloud::layout(), key}};
+  this->ensurePipelinesExist(required_pipelines);
+
+  entt::entity entity = m_registry.create();
+  m_registry.emplace<TransformComponent>(entity, placement);
+  m_registry.emplace<EnvironmentTag>(entity);
+  addPipelineTagComponent(m_registry, entity, PIPELINE_STREAMED_POINTCLOUD);
+  m_registry.emplace<StreamedPointCloud>(entity, device(), path, config);
+  return entity;
+}
+
+void RobotScene::updateStreamedPointClouds(const Camera &camera) {
+  auto view = m_registry.view<StreamedPointCloud, const TransformComponent>(
+      entt::exclude<Disable>);
+  for (auto &&[entity, cloud, tr] : view.each())
+    cloud.update(tr, camera);
+}
+
 void RobotScene::clearEnvironment() {
   auto view = m_registry.view<EnvironmentTag>();
   m_registry.destroy(view.begin(), view.end());
+  // displaced heightfields and environment instances only borrowed these
+  // meshes
+  m_heightfieldGrids.clear();
+  m_environmentMeshes.clear();
+  m_instancedCastables.clear();
+  m_instancesBatched = false;
 }
 
 void RobotScene::clearRobotGeometries() {
   auto view = m_registry.view<PinGeomObjComponent>();
   m_registry.destroy(view.begin(), view.end());
+  m_robots.clear();
+  m_instancedCastables.clear();
+  m_instancesBatched = false;
+  // entities only borrowed these meshes
+  m_modelAssets.clear();
+  m_unitPrimitiveMeshes.clear();
 }
 
 RobotScene::RobotScene(entt::registry &registry, const RenderContext &renderer)
     : m_registry(registry)
     , m_renderer(renderer)
     , m_config()
-    , m_geomModel(nullptr)
-    , m_geomData(nullptr)
+    , m_robots()
     , m_initialized(false)
     , m_pipelines() {
   assert(!hasInternalPointers());
@@ -158,6 +359,41 @@ RobotScene::RobotScene(entt::registry &registry, const RenderContext &renderer,
   this->loadModels(geom_model, geom_data);
 }
 
+void RobotScene::setConfig(const Config &config) {
+  if (m_initialized)
+    terminate_with_message(
+        "Cannot call setConfig() after render system was initialized.");
+
+  m_config = config;
+  if (m_config.enable_instance_ids) {
+    const char *shader =
+        m_config.triangle_config.opaque_instance_id.fragment_shader_path;
+    if (m_renderer.msaaEnabled()) {
+      spdlog::warn("Instance IDs require MSAA to be disabled (sample count "
+                   "{:d}), disabling them.",
+                   sdlSampleToValue(m_renderer.getMsaaSampleCount()));
+      m_config.enable_instance_ids = false;
+    } else if (!shaderExists(device(), shader)) {
+      spdlog::warn("Shader '{:s}' for instance IDs not found, disabling them.",
+                   shader);
+      m_config.enable_instance_ids = false;
+    }
+  }
+  if (m_config.enable_instancing) {
+    const auto &instanced = m_config.triangle_config.opaque_instanced;
+    for (const char *shader :
+         {instanced.vertex_shader_path, instanced.fragment_shader_path}) {
+      if (!shaderExists(device(), shader)) {
+        spdlog::warn("Shader '{:s}' for instanced draws not found, disabling "
+                     "instancing.",
+                     shader);
+        m_config.enable_instancing = false;
+        break;
+      }
+    }
+  }
+}
+
 auto createTextureWithMultisampledVariant(const Device &device,
                                           SDL_GPUTextureCreateInfo texture_desc,
                                           const char *name) {
@@ -181,19 +417,20 @@ auto createTextureWithMultisampledVariant(const Device &device,
   };
 }
 
-void RobotScene::initGBuffer() {
+void RobotScene::createGBuffer(GBuffer &gbuffer, Uint32 width,
+                               Uint32 height) const {
+  const Device &device = m_renderer.device;
   auto sample_count = m_renderer.getMsaaSampleCount();
-  const auto [width, height] = m_renderer.window.sizeInPixels();
-  std::tie(gBuffer.normalMap, gBuffer.resolveNormalMap) =
+  std::tie(gbuffer.normalMap, gbuffer.resolveNormalMap) =
       createTextureWithMultisampledVariant(
-          device(),
+          device,
           {
               .type = SDL_GPU_TEXTURETYPE_2D,
               .format = SDL_GPU_TEXTUREFORMAT_R16G16_FLOAT,
               .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
                        SDL_GPU_TEXTUREUSAGE_SAMPLER,
-              .width = Uint32(width),
-              .height = Uint32(height),
+              .width = width,
+              .height = height,
               .layer_count_or_depth = 1,
               .num_levels = 1,
               .sample_count = sample_count,
@@ -201,16 +438,16 @@ void RobotScene::initGBuffer() {
           },
           "GBuffer [Normal map]");
 
-  std::tie(gBuffer.depthCopyTex, gBuffer.resolveDepthCopyTex) =
+  std::tie(gbuffer.depthCopyTex, gbuffer.resolveDepthCopyTex) =
       createTextureWithMultisampledVariant(
-          device(),
+          device,
           {
               .type = SDL_GPU_TEXTURETYPE_2D,
               .format = SDL_GPU_TEXTUREFORMAT_R32_FLOAT,
               .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
                        SDL_GPU_TEXTUREUSAGE_SAMPLER,
-              .width = Uint32(width),
-              .height = Uint32(height),
+              .width = width,
+              .height = height,
               .layer_count_or_depth = 1,
               .num_levels = 1,
               .sample_count = sample_count,
@@ -218,16 +455,36 @@ void RobotScene::initGBuffer() {
           },
           "GBuffer [Depth copy]");
 
-  std::tie(gBuffer.accumTexture, gBuffer.resolveAccumTexture) =
+  if (m_config.enable_instance_ids) {
+    // integer targets cannot be resolved, see setConfig()
+    CANDLEWICK_ASSERT(!m_renderer.msaaEnabled(),
+                      "Instance IDs require MSAA to be disabled.");
+    SDL_GPUTextureCreateInfo texture_desc{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R32_UINT,
+        .usage =
+            SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        .props = 0,
+    };
+    gbuffer.instanceIdMap =
+        Texture{device, texture_desc, "GBuffer [Instance ID]"};
+  }
+
+  std::tie(gbuffer.accumTexture, gbuffer.resolveAccumTexture) =
       createTextureWithMultisampledVariant(
-          device(),
+          device,
           {
               .type = SDL_GPU_TEXTURETYPE_2D,
               .format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT,
               .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
                        SDL_GPU_TEXTUREUSAGE_SAMPLER,
-              .width = Uint32(width),
-              .height = Uint32(height),
+              .width = width,
+              .height = height,
               .layer_count_or_depth = 1,
               .num_levels = 1,
               .sample_count = sample_count,
@@ -235,16 +492,16 @@ void RobotScene::initGBuffer() {
           },
           "WBOIT Accumulation");
 
-  std::tie(gBuffer.revealTexture, gBuffer.resolveRevealTexture) =
+  std::tie(gbuffer.revealTexture, gbuffer.resolveRevealTexture) =
       createTextureWithMultisampledVariant(
-          device(),
+          device,
           {
               .type = SDL_GPU_TEXTURETYPE_2D,
               .format = SDL_GPU_TEXTUREFORMAT_R8_UNORM,
               .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
                        SDL_GPU_TEXTUREUSAGE_SAMPLER,
-              .width = Uint32(width),
-              .height = Uint32(height),
+              .width = width,
+              .height = height,
               .layer_count_or_depth = 1,
               .num_levels = 1,
               .sample_count = sample_count,
@@ -259,7 +516,12 @@ void RobotScene::initGBuffer() {
       .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
       .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
   };
-  gBuffer.sampler = SDL_CreateGPUSampler(device(), &sic);
+  gbuffer.sampler = SDL_CreateGPUSampler(device, &sic);
+}
+
+void RobotScene::initGBuffer() {
+  const auto [width, height] = m_renderer.window.sizeInPixels();
+  createGBuffer(gBuffer, Uint32(width), Uint32(height));
 }
 
 void RobotScene::initCompositePipeline(const MeshLayout &layout) {
@@ -329,8 +591,10 @@ void RobotScene::ensurePipelinesExist(
       }
       // configure shadow pass
       if (enable_shadows && !shadowPass.initialized()) {
+        ShadowPassConfig shadow_config = m_config.shadow_config;
+        shadow_config.enable_instancing = instancingEnabled();
         shadowPass = ShadowMapPass(device(), layout, m_renderer.depthFormat(),
-                                   m_config.shadow_config);
+                                   shadow_config);
       }
       if (!m_wboitComposite.initialized())
         this->initCompositePipeline(layout);
@@ -343,28 +607,82 @@ void RobotScene::loadModels(const pin::GeometryModel &geom_model,
   if (hasInternalPointers())
     this->clearRobotGeometries();
 
-  m_geomModel = &geom_model;
-  m_geomData = &geom_data;
+  this->addRobot("", geom_model, geom_data);
+}
 
-  // Phase 1. Load robot geometries and collect parameters for creating the
-  // required render pipelines.
-  std::set<pipeline_req_t> required_pipelines;
+auto RobotScene::loadModelAssets(const pin::GeometryModel &geom_model)
+    -> const RobotModelAssets & {
+  for (const auto &assets : m_modelAssets) {
+    if (assets.geomModel == &geom_model)
+      return assets;
+  }
 
+  RobotModelAssets assets{&geom_model, {}, {}, {}, {}};
   for (pin::GeomIndex geom_id = 0; geom_id < geom_model.ngeoms; geom_id++) {
-
     const auto &geom_obj = geom_model.geometryObjects[geom_id];
-    auto meshDatas = loadGeometryObject(geom_obj);
-    PipelineType pipeline_type = pinGeomToPipeline(*geom_obj.geometry);
+    const auto &geom = *geom_obj.geometry;
+    assets.pipelineTypes.push_back(pinGeomToPipeline(geom));
+
+    // boxes, spheres and ellipsoids share a unit mesh, scaled by their
+    // transform
+    std::optional<CoalUnitShape> unit;
+    if (geom.getObjectType() == coal::OT_GEOM)
+      unit = getCoalUnitShape(castCoalGeom<coal::ShapeBase>(geom));
+    if (unit) {
+      auto [it, inserted] =
+          m_unitPrimitiveMeshes.try_emplace(unit->primitive, NoInit);
+      if (inserted)
+        it->second =
+            createMesh(device(), loadCoalUnitPrimitive(unit->primitive), true);
+      PbrMaterial material;
+      material.baseColor = geom_obj.meshColor.cast<float>();
+      assets.meshes.push_back(it->second.borrow());
+      assets.materials.push_back({material});
+      assets.unitScales.push_back(unit->scale);
+      continue;
+    }
+
+    auto meshDatas =
+        loadGeometryObject(geom_obj, m_config.load_mesh_materials);
     Mesh mesh = createMeshFromBatch(device(), meshDatas, true);
     assert(validateMesh(mesh));
+    assets.meshes.push_back(std::move(mesh));
+    assets.materials.push_back(extractMaterials(meshDatas));
+    assets.unitScales.push_back(std::nullopt);
+  }
+  return m_modelAssets.emplace_back(std::move(assets));
+}
+
+Uint32 RobotScene::addRobot(std::string_view name,
+                            const pin::GeometryModel &geom_model,
+                            const pin::GeometryData &geom_data) {
+  if (!name.empty() && findRobot(name))
+    terminate_with_message("Robot instance \'{:s}\' already exists.", name);
+
+  const Uint32 robot = numRobots();
+  const bool shared = std::ranges::any_of(
+      m_robots, [&](const auto &r) { return r.geomModel == &geom_model; });
+  m_robots.push_back({std::string(name), &geom_model, &geom_data});
+
+  // Phase 1. Load robot geometries (once per model) and collect parameters
+  // for creating the required render pipelines.
+  const RobotModelAssets &assets = loadModelAssets(geom_model);
+  std::set<pipeline_req_t> required_pipelines;
+
+  for (pin::GeomIndex geom_id = 0; geom_id < geom_model.ngeoms; geom_id++) {
+    const PipelineType pipeline_type = assets.pipelineTypes[geom_id];
 
     // add entity for this geometry
     entt::entity entity = m_registry.create();
-    m_registry.emplace<PinGeomObjComponent>(entity, geom_id);
+    m_registry.emplace<PinGeomObjComponent>(entity, geom_id, robot);
     m_registry.emplace<TransformComponent>(entity);
+    const auto &unit_scale = assets.unitScales[geom_id];
+    if (unit_scale)
+      m_registry.emplace<PinGeomUnitScaleComponent>(entity, *unit_scale);
     const MeshMaterialComponent &mmc =
-        m_registry.emplace<MeshMaterialComponent>(entity, std::move(mesh),
-                                                  extractMaterials(meshDatas));
+        m_registry.emplace<MeshMaterialComponent>(
+            entity, assets.meshes[geom_id].borrow(),
+            std::vector(assets.materials[geom_id]));
     if (pipeline_type != PIPELINE_POINTCLOUD)
       m_registry.emplace<Opaque>(entity);
     bool is_transparent =
@@ -376,15 +694,44 @@ void RobotScene::loadModels(const pin::GeometryModel &geom_model,
         {layout, {pipeline_type, is_transparent, RenderMode::FILL}});
     required_pipelines.insert(
         {layout, {pipeline_type, is_transparent, RenderMode::LINE}});
+    // meshes are shared by the instances of the model, and by all primitives
+    // drawn with a unit mesh. without instancing (e.g. if its shader is not
+    // available, see setConfig()), these are drawn one by one with the
+    // regular opaque pipeline, which applies their scale in the transform.
+    if ((shared || unit_scale) && instancingEnabled() &&
+        pipeline_type == PIPELINE_TRIANGLEMESH && !is_transparent) {
+      required_pipelines.insert(
+          {layout, {pipeline_type, false, RenderMode::FILL, true}});
+    }
   }
 
-  // Phase 2. Init our render pipelines.
+  // Phase 2. Init our render pipelines. Pipelines already created for
+  // previous robot instances are reused.
   this->ensurePipelinesExist(required_pipelines);
   m_initialized = true;
+  return robot;
+}
+
+std::optional<Uint32> RobotScene::findRobot(std::string_view name) const {
+  for (Uint32 i = 0; i < numRobots(); i++) {
+    if (m_robots[i].name == name)
+      return i;
+  }
+  return std::nullopt;
 }
 
 void RobotScene::update() {
-  updateRobotTransforms(registry(), geomModel(), geomData());
+  m_instancesBatched = false;
+  // single pass over the geometry entities, whatever the number of robots
+  auto view = m_registry.view<const PinGeomObjComponent, TransformComponent,
+                              MeshMaterialComponent>();
+  for (auto [ent, obj, tr, mmc] : view.each()) {
+    const RobotInstance &robot = m_robots[obj.robot];
+    const pin::GeomIndex geom_id = obj;
+    updateGeometryTransform(m_registry, ent,
+                            robot.geomModel->geometryObjects[geom_id],
+                            robot.geomData->oMg[geom_id], tr, mmc);
+  }
 }
 
 void RobotScene::collectOpaqueCastables() {
@@ -395,26 +742,96 @@ void RobotScene::collectOpaqueCastables() {
 
   m_castables.clear();
 
-  // collect castable objects
-  all_view.each([this](auto &&tr, auto &&meshMaterial) {
-    m_castables.emplace_back(meshMaterial.mesh, tr);
+  // collect castable objects, with all chunks of chunked heightfields: those
+  // culled by the camera can still cast shadows into its view
+  all_view.each([this](entt::entity ent, auto &&tr, auto &&meshMaterial) {
+    auto *lod = m_registry.try_get<const HeightfieldLodComponent>(ent);
+    m_castables.emplace_back(lod ? lod->shadowMesh : meshMaterial.mesh, tr);
   });
+  m_instancedCastables.clear();
+  m_instancesBatched = false;
+}
+
+void RobotScene::collectOpaqueCastables(CommandBuffer &command_buffer) {
+  const bool batched =
+      instancingEnabled() && shadowPass.instancedPipeline.initialized() &&
+      m_pipelines.contains({PIPELINE_TRIANGLEMESH, false, RenderMode::FILL,
+                            true});
+  if (!batched) {
+    collectOpaqueCastables();
+    return;
+  }
+  this->batchOpaqueInstances(command_buffer);
+  m_instancesBatched = true;
+
+  m_castables.clear();
+  m_instancedCastables.clear();
+  auto add_castable = [this](entt::entity ent) {
+    auto [tr, obj] =
+        m_registry.get<const TransformComponent, const MeshMaterialComponent>(
+            ent);
+    auto *lod = m_registry.try_get<const HeightfieldLodComponent>(ent);
+    m_castables.emplace_back(lod ? lod->shadowMesh : obj.mesh, tr);
+  };
+  // batching only considers filled meshes
+  auto all_view = m_registry.view<const Opaque, const TransformComponent,
+                                  const MeshMaterialComponent,
+                                  pipeline_tag<PIPELINE_TRIANGLEMESH>>(
+      entt::exclude<Disable>);
+  for (auto [ent, tr, obj] : all_view.each()) {
+    if (obj.mode != RenderMode::FILL)
+      add_castable(ent);
+  }
+  for (entt::entity ent : m_unbatchedEntities)
+    add_castable(ent);
+  for (const InstanceBatch &batch : m_instanceBatches) {
+    const auto &obj = m_registry.get<const MeshMaterialComponent>(batch.entity);
+    m_instancedCastables.push_back(
+        {obj.mesh, batch.firstInstance, batch.numInstances});
+  }
+}
+
+auto RobotScene::mainTargets() const -> ViewTargets {
+  return {
+      .color = m_renderer.colorTarget(),
+      .resolvedColor = m_renderer.resolvedColorTarget(),
+      .depth = m_renderer.depthTarget(),
+      .gBuffer = &gBuffer,
+      .msaa = m_renderer.msaaEnabled(),
+      .ssao = true,
+      .selected = true,
+  };
 }
 
 void RobotScene::renderOpaque(CommandBuffer &command_buffer,
                               const Camera &camera) {
-  if (m_config.enable_ssao) {
+  renderOpaque(command_buffer, camera, mainTargets());
+}
+
+void RobotScene::renderTransparent(CommandBuffer &command_buffer,
+                                   const Camera &camera) {
+  renderTransparent(command_buffer, camera, mainTargets());
+}
+
+void RobotScene::renderOpaque(CommandBuffer &command_buffer,
+                              const Camera &camera,
+                              const ViewTargets &targets) {
+  RenderStatsPassScope stats_pass{RenderStatsPass::Opaque};
+  if (m_config.enable_ssao && targets.ssao) {
+    CANDLEWICK_PROFILE_SCOPE("SsaoPass::render");
     ssaoPass.render(command_buffer, camera);
   }
 
-  renderPBRTriangleGeometry(command_buffer, camera, false);
-  renderOtherGeometry(command_buffer, camera);
+  renderPBRTriangleGeometry(command_buffer, camera, false, targets);
+  renderOtherGeometry(command_buffer, camera, targets);
 }
 
 void RobotScene::renderTransparent(CommandBuffer &command_buffer,
-                                   const Camera &camera) {
-  renderPBRTriangleGeometry(command_buffer, camera, true);
-  compositeTransparencyPass(command_buffer);
+                                   const Camera &camera,
+                                   const ViewTargets &targets) {
+  RenderStatsPassScope stats_pass{RenderStatsPass::Transparent};
+  renderPBRTriangleGeometry(command_buffer, camera, true, targets);
+  compositeTransparencyPass(command_buffer, targets);
 }
 
 void RobotScene::render(CommandBuffer &command_buffer, const Camera &camera) {
@@ -427,20 +844,20 @@ void RobotScene::render(CommandBuffer &command_buffer, const Camera &camera) {
 /// with just two configuration options: whether to load or clear the color and
 /// depth targets.
 static SDL_GPURenderPass *
-getOpaqueRenderPass(const RenderContext &renderer,
+getOpaqueRenderPass(const RobotScene::ViewTargets &targets,
                     CommandBuffer &command_buffer, SDL_GPULoadOp color_load_op,
-                    SDL_GPULoadOp depth_load_op, bool has_normals_target,
-                    const RobotScene::GBuffer &gbuffer) {
-  SDL_GPUColorTargetInfo color_targets[3];
+                    SDL_GPULoadOp depth_load_op, bool has_normals_target) {
+  const RobotScene::GBuffer &gbuffer = *targets.gBuffer;
+  SDL_GPUColorTargetInfo color_targets[4];
   SDL_zero(color_targets);
-  color_targets[0].texture = renderer.colorTarget();
+  color_targets[0].texture = targets.color;
   color_targets[0].load_op = color_load_op;
   color_targets[0].store_op = SDL_GPU_STOREOP_STORE;
   color_targets[0].cycle = false;
 
   SDL_GPUDepthStencilTargetInfo depth_target;
   SDL_zero(depth_target);
-  depth_target.texture = renderer.depthTarget();
+  depth_target.texture = targets.depth;
   depth_target.clear_depth = 1.0f;
   depth_target.load_op = depth_load_op;
   depth_target.store_op = SDL_GPU_STOREOP_STORE;
@@ -451,7 +868,7 @@ getOpaqueRenderPass(const RenderContext &renderer,
     color_targets[1].load_op = SDL_GPU_LOADOP_CLEAR;
     color_targets[1].store_op = SDL_GPU_STOREOP_STORE;
     color_targets[1].cycle = false;
-    if (renderer.msaaEnabled()) {
+    if (targets.msaa) {
       color_targets[1].resolve_texture = gbuffer.resolveNormalMap;
       color_targets[1].store_op = SDL_GPU_STOREOP_RESOLVE;
     }
@@ -459,20 +876,28 @@ getOpaqueRenderPass(const RenderContext &renderer,
     color_targets[2].load_op = SDL_GPU_LOADOP_CLEAR;
     color_targets[2].store_op = SDL_GPU_STOREOP_STORE;
     color_targets[2].cycle = false;
-    if (renderer.msaaEnabled()) {
+    if (targets.msaa) {
       color_targets[2].resolve_texture = gbuffer.resolveDepthCopyTex;
       color_targets[2].store_op = SDL_GPU_STOREOP_RESOLVE;
     }
   }
   Uint32 num_color_targets = has_normals_target ? 3 : 1;
-  return SDL_BeginGPURenderPass(command_buffer, color_targets,
-                                num_color_targets, &depth_target);
+  if (has_normals_target && gbuffer.instanceIdMap) {
+    // cleared to zero, i.e. the background
+    color_targets[3].texture = gbuffer.instanceIdMap;
+    color_targets[3].load_op = SDL_GPU_LOADOP_CLEAR;
+    color_targets[3].store_op = SDL_GPU_STOREOP_STORE;
+    color_targets[3].cycle = false;
+    num_color_targets = 4;
+  }
+  return rend::beginRenderPass(
+      command_buffer, {color_targets, num_color_targets}, &depth_target);
 }
 
 static SDL_GPURenderPass *
-getTransparentRenderPass(const RenderContext &renderer,
-                         CommandBuffer &command_buffer,
-                         const RobotScene::GBuffer &gBuffer) {
+getTransparentRenderPass(const RobotScene::ViewTargets &targets,
+                         CommandBuffer &command_buffer) {
+  const RobotScene::GBuffer &gBuffer = *targets.gBuffer;
   SDL_GPUColorTargetInfo targets[2];
   SDL_zero(targets);
   targets[0].texture = gBuffer.accumTexture;
@@ -486,35 +911,36 @@ getTransparentRenderPass(const RenderContext &renderer,
 
   SDL_GPUDepthStencilTargetInfo depth_target;
   SDL_zero(depth_target);
-  depth_target.texture = renderer.depthTarget();
+  depth_target.texture = targets.depth;
   depth_target.load_op = SDL_GPU_LOADOP_LOAD;
   depth_target.store_op = SDL_GPU_STOREOP_STORE;
 
-  return SDL_BeginGPURenderPass(command_buffer, targets, 2, &depth_target);
+  return rend::beginRenderPass(command_buffer, targets, &depth_target);
 }
 
-void RobotScene::compositeTransparencyPass(CommandBuffer &command_buffer) {
+void RobotScene::compositeTransparencyPass(CommandBuffer &command_buffer,
+                                           const ViewTargets &targets) {
   // transparent triangle pipeline required
   if (!m_wboitComposite.initialized())
     return;
 
   SDL_GPUColorTargetInfo target;
   SDL_zero(target);
-  target.texture = m_renderer.colorTarget();
+  target.texture = targets.color;
   // op is LOAD - we want to keep results from opaque pass
   target.load_op = SDL_GPU_LOADOP_LOAD;
   target.store_op = SDL_GPU_STOREOP_STORE;
-  const bool has_msaa = m_renderer.msaaEnabled();
-  if (has_msaa) {
-    target.resolve_texture = m_renderer.resolvedColorTarget();
+  if (targets.msaa) {
+    target.resolve_texture = targets.resolvedColor;
     target.store_op = SDL_GPU_STOREOP_RESOLVE;
   }
 
   SDL_GPURenderPass *render_pass =
-      SDL_BeginGPURenderPass(command_buffer, &target, 1, nullptr);
+      rend::beginRenderPass(command_buffer, {&target, 1});
   m_wboitComposite.bind(render_pass);
 
   // Bind accumulation and revealage textures
+  const GBuffer &gBuffer = *targets.gBuffer;
   rend::bindFragmentSamplers(
       render_pass, 0,
       {
@@ -523,20 +949,21 @@ void RobotScene::compositeTransparencyPass(CommandBuffer &command_buffer) {
       });
 
   // Draw fullscreen quad
-  SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+  rend::drawPrimitives(render_pass, 6);
 
   SDL_EndGPURenderPass(render_pass);
 }
 
 void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
                                            const Camera &camera,
-                                           bool transparent) {
+                                           bool transparent,
+                                           const ViewTargets &targets) {
 
   const Uint32 numLights = shadowPass.numLights();
   // calculate light ubos
   LightArrayUbo lightUbo;
   lightUbo.numLights = numLights;
-  lightUbo.useSsao = m_config.enable_ssao ? 1u : 0u;
+  lightUbo.useSsao = m_config.enable_ssao && targets.ssao ? 1u : 0u;
   for (size_t i = 0; i < lightUbo.numLights; i++) {
     auto &dl = directionalLight[i];
     lightUbo.viewSpaceDir[i].head<3>() = camera.transformVector(dl.direction);
@@ -555,16 +982,27 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
   }
   const Mat4f viewProj = camera.viewProj();
 
+  // instance transforms are uploaded in a copy pass, before the render pass
+  const bool batched =
+      !transparent && instancingEnabled() &&
+      m_pipelines.contains({PIPELINE_TRIANGLEMESH, false, RenderMode::FILL,
+                            true});
+  // batches only depend on the transforms: build them once, and reuse them
+  // for every view until the next update()
+  if (batched && !m_instancesBatched) {
+    this->batchOpaqueInstances(command_buffer);
+    m_instancesBatched = true;
+  }
+
   // if geometry is opaque, this is the first render pass, hence we clear the
   // color target transparent objects do not participate in SSAO
   SDL_GPURenderPass *render_pass;
   if (transparent) {
-    render_pass = getTransparentRenderPass(m_renderer, command_buffer, gBuffer);
+    render_pass = getTransparentRenderPass(targets, command_buffer);
   } else {
     render_pass = getOpaqueRenderPass(
-        m_renderer, command_buffer, SDL_GPU_LOADOP_CLEAR,
-        pbrHasPrepass() ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_CLEAR, true,
-        gBuffer);
+        targets, command_buffer, SDL_GPU_LOADOP_CLEAR,
+        pbrHasPrepass() ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_CLEAR, true);
   }
 
   command_buffer.pushFragmentUniform(FragmentUniformSlots::LIGHTING, lightUbo);
@@ -603,6 +1041,10 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
         .normalMatrix = math::computeNormalMatrix(modelView),
     };
     command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, data);
+    if (!transparent && instanceIdsEnabled()) {
+      command_buffer.pushFragmentUniform(FragmentUniformSlots::INSTANCE_ID,
+                                         instanceIdFromEntity(ent));
+    }
     if (shadowsEnabled()) {
       LightSpaceMatricesUbo shadowUbo;
       shadowUbo.numLights = numLights;
@@ -613,6 +1055,15 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
       command_buffer.pushVertexUniform(VertexUniformSlots::LIGHT_MATRICES,
                                        shadowUbo);
     }
+    if (auto *lod = m_registry.try_get<const HeightfieldLodComponent>(ent)) {
+      // chunks share the material of the heightfield
+      command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL,
+                                         obj.materials[0]);
+      const Mesh &chunks = targets.selected ? lod->mesh : lod->shadowMesh;
+      rend::bindMesh(render_pass, chunks);
+      rend::draw(render_pass, chunks);
+      return;
+    }
     rend::bindMesh(render_pass, mesh);
     for (size_t j = 0; j < mesh.numViews(); j++) {
       command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL,
@@ -644,8 +1095,52 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
     if (auto pipeline =
             m_pipelines.get({PIPELINE_TRIANGLEMESH, false, RenderMode::FILL})) {
       pipeline->bind(render_pass);
-      for (auto ent : opaques | get_filter(RenderMode::FILL)) {
-        process_entities(ent);
+      if (batched) {
+        for (auto ent : m_unbatchedEntities)
+          process_entities(ent);
+      } else {
+        for (auto ent : opaques | get_filter(RenderMode::FILL)) {
+          process_entities(ent);
+        }
+      }
+    }
+
+    if (batched && !m_instanceBatches.empty()) {
+      m_pipelines.get({PIPELINE_TRIANGLEMESH, false, RenderMode::FILL, true})
+          ->bind(render_pass);
+      SDL_GPUBuffer *instance_buffer = m_instanceBuffer.buffer();
+      SDL_BindGPUVertexStorageBuffers(render_pass, 0, &instance_buffer, 1);
+      if (shadowsEnabled()) {
+        // the shader applies the model matrices itself
+        LightSpaceMatricesUbo shadowUbo;
+        shadowUbo.numLights = numLights;
+        for (size_t i = 0; i < numLights; i++)
+          shadowUbo.mvps[i] = lightViewProj[i];
+        command_buffer.pushVertexUniform(VertexUniformSlots::LIGHT_MATRICES,
+                                         shadowUbo);
+      }
+      InstancedCameraUbo cameraUbo{
+          .view = camera.view.matrix(),
+          .viewProj = viewProj,
+          .firstInstance = 0,
+      };
+      for (const InstanceBatch &batch : m_instanceBatches) {
+        const auto &obj = m_registry.get<const MeshMaterialComponent>(
+            batch.entity);
+        const Mesh &mesh = obj.mesh;
+        cameraUbo.firstInstance = batch.firstInstance;
+        command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM,
+                                         cameraUbo);
+        rend::bindMesh(render_pass, mesh);
+        for (size_t j = 0; j < mesh.numViews(); j++) {
+          PbrMaterial material = obj.materials[j];
+          // the base color of single-view meshes is in the instance data
+          if (mesh.numViews() == 1)
+            material.baseColor.setOnes();
+          command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL,
+                                             material);
+          rend::drawView(render_pass, mesh.view(j), batch.numInstances);
+        }
       }
     }
 
@@ -661,11 +1156,111 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
   SDL_EndGPURenderPass(render_pass);
 }
 
+/// Whether entities with materials \p lhs and \p rhs can be drawn in the same
+/// instanced batch. The base color of single-view meshes is per-instance data,
+/// and is ignored.
+static bool samePbrMaterials(std::span<const PbrMaterial> lhs,
+                             std::span<const PbrMaterial> rhs) {
+  const bool per_instance_color = lhs.size() == 1;
+  return std::ranges::equal(lhs, rhs, [&](const auto &a, const auto &b) {
+    return (per_instance_color || a.baseColor == b.baseColor) &&
+           a.metalness == b.metalness && a.roughness == b.roughness &&
+           a.ao == b.ao;
+  });
+}
+
+void RobotScene::batchOpaqueInstances(CommandBuffer &command_buffer) {
+  m_instanceBatches.clear();
+  m_instanceData.clear();
+  m_batchedEntities.clear();
+  m_unbatchedEntities.clear();
+
+  // entities sharing a mesh reference the same vertex buffers, and are batched
+  // by materials, numbered in order of appearance for each mesh
+  struct BatchItem {
+    entt::entity entity;
+    std::pair<SDL_GPUBuffer *, size_t> key;
+  };
+  std::map<SDL_GPUBuffer *, std::vector<std::span<const PbrMaterial>>>
+      mesh_materials;
+  std::vector<BatchItem> items;
+  std::vector<BatchItem> unbatched;
+
+  auto view = m_registry.view<const TransformComponent,
+                              const MeshMaterialComponent, const Opaque,
+                              pipeline_tag<PIPELINE_TRIANGLEMESH>>(
+      entt::exclude<Disable>);
+  for (auto [ent, tr, obj] : view.each()) {
+    if (obj.mode != RenderMode::FILL)
+      continue;
+    SDL_GPUBuffer *buffer = obj.mesh.vertexBuffers.front();
+    auto &materials = mesh_materials[buffer];
+    auto it = std::ranges::find_if(materials, [&](const auto &m) {
+      return samePbrMaterials(m, obj.materials);
+    });
+    const auto material_id = size_t(it - materials.begin());
+    if (it == materials.end())
+      materials.push_back(obj.materials);
+    items.push_back({ent, {buffer, material_id}});
+  }
+
+  const auto batch_sizes = sortInstanceBatches(
+      items, unbatched, [](const BatchItem &item) { return item.key; });
+  for (const BatchItem &item : items)
+    m_batchedEntities.push_back(item.entity);
+  for (const BatchItem &item : unbatched)
+    m_unbatchedEntities.push_back(item.entity);
+
+  Uint32 first = 0;
+  for (Uint32 size : batch_sizes) {
+    m_instanceBatches.push_back({m_batchedEntities[first], first, size});
+    first += size;
+  }
+  for (entt::entity ent : m_batchedEntities) {
+    const auto &[tr, obj] =
+        m_registry.get<const TransformComponent, const MeshMaterialComponent>(
+            ent);
+    PbrInstanceData &data = m_instanceData.emplace_back();
+    data.model = tr;
+    data.normalMatrix.setZero();
+    data.normalMatrix.topLeftCorner<3, 3>() = math::computeNormalMatrix(tr);
+    data.color = obj.materials.size() == 1 ? obj.materials[0].baseColor
+                                           : Float4::Ones();
+  }
+
+  if (m_instanceBatches.empty())
+    return;
+  if (!m_instanceBuffer.initialized())
+    m_instanceBuffer = InstanceBuffer{device()};
+  m_instanceBuffer.upload(command_buffer,
+                          std::span<const PbrInstanceData>(m_instanceData));
+}
+
+/// Vertex uniforms of HeightfieldDisplaced.vert.
+struct alignas(16) DisplacedHeightfieldUbo {
+  GpuMat4 mvp;
+  GpuVec2 origin;
+  GpuVec2 spacing;
+};
+
+/// Vertex uniforms of PointSprite.vert.
+struct alignas(16) PointSpriteUbo {
+  GpuMat4 model;
+  GpuMat4 viewProj;
+};
+
 void RobotScene::renderOtherGeometry(CommandBuffer &command_buffer,
-                                     const Camera &camera) {
+                                     const Camera &camera,
+                                     const ViewTargets &targets) {
+  // point cloud updates are uploaded in a copy pass, before the render pass
+  for (auto &&[entity, cloud] : m_registry.view<PointCloud>().each())
+    cloud.flush(command_buffer);
+  for (auto &&[entity, cloud] : m_registry.view<StreamedPointCloud>().each())
+    cloud.flush(command_buffer);
+
   SDL_GPURenderPass *render_pass =
-      getOpaqueRenderPass(m_renderer, command_buffer, SDL_GPU_LOADOP_LOAD,
-                          SDL_GPU_LOADOP_LOAD, false, gBuffer);
+      getOpaqueRenderPass(targets, command_buffer, SDL_GPU_LOADOP_LOAD,
+                          SDL_GPU_LOADOP_LOAD, false);
 
   const Mat4f viewProj = camera.viewProj();
 
@@ -685,14 +1280,59 @@ void RobotScene::renderOtherGeometry(CommandBuffer &command_buffer,
                         pipeline_tag<current_pipeline_type>>(
             entt::exclude<Disable>);
     for (auto &&[entity, tr, obj] : env_view.each()) {
-      const Mesh &mesh = obj.mesh;
+      auto *lod = m_registry.try_get<const HeightfieldLodComponent>(entity);
+      const Mesh &mesh =
+          lod ? (targets.selected ? lod->mesh : lod->shadowMesh) : obj.mesh;
       const GpuMat4 mvp = viewProj * tr;
       const GpuVec4 &color = obj.materials[0].baseColor;
-      command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, mvp)
-          .pushFragmentUniform(FragmentUniformSlots::MATERIAL, color);
+      if (auto *heights = m_registry.try_get<const HeightTexture>(entity)) {
+        const DisplacedHeightfieldUbo ubo{mvp, heights->origin,
+                                          heights->spacing};
+        command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, ubo);
+        rend::bindVertexSamplers(render_pass, 0, {heights->samplerBinding()});
+      } else if (current_pipeline_type == PIPELINE_POINTCLOUD) {
+        const PointSpriteUbo ubo{tr, viewProj};
+        command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, ubo);
+      } else {
+        command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, mvp);
+      }
+      command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL, color);
       rend::bindMesh(render_pass, mesh);
       rend::draw(render_pass, mesh);
     }
+
+    // point clouds have their own vertex layout, hence their own pipeline
+    if (current_pipeline_type != PIPELINE_STREAMED_POINTCLOUD)
+      return;
+    auto cloud_view = m_registry.view<const TransformComponent,
+                                      const PointCloud>(entt::exclude<Disable>);
+    for (auto &&[entity, tr, cloud] : cloud_view.each()) {
+      if (cloud.mesh().numViews() == 0)
+        continue;
+      const PointSpriteUbo ubo{tr, viewProj};
+      command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, ubo);
+      rend::bindMesh(render_pass, cloud.mesh());
+      rend::draw(render_pass, cloud.mesh());
+    }
+    auto streamed_view =
+        m_registry.view<const TransformComponent, const StreamedPointCloud>(
+            entt::exclude<Disable>);
+    for (auto &&[entity, tr, cloud] : streamed_view.each()) {
+      const PointSpriteUbo ubo{tr, viewProj};
+      command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, ubo);
+      auto draw_node = [&](const Mesh &node) {
+        if (node.numViews() == 0)
+          return;
+        rend::bindMesh(render_pass, node);
+        rend::draw(render_pass, node);
+      };
+      if (targets.selected) {
+        for (const Mesh *node : cloud.visibleNodes())
+          draw_node(*node);
+      } else {
+        cloud.forEachResidentNode(draw_node);
+      }
+    }
   });
   SDL_EndGPURenderPass(render_pass);
 }
@@ -706,6 +1346,8 @@ void RobotScene::release() {
 
   m_pipelines.clear();
   m_wboitComposite.release();
+  m_instanceBuffer.release();
+  m_meshUpdater.release();
 
   gBuffer.release();
   ssaoPass.release();
@@ -713,17 +1355,24 @@ void RobotScene::release() {
 }
 
 static RobotScene::PipelineConfig
-getPipelineConfig(const RobotScene::Config &cfg, RobotScene::PipelineType type,
-                  bool transparent) {
+getPipelineConfig(const RobotScene::Config &cfg,
+                  const RobotScene::PipelineKey &key) {
   using enum RobotScene::PipelineType;
-  switch (type) {
+  switch (key.type) {
   case PIPELINE_TRIANGLEMESH:
-    return transparent ? cfg.triangle_config.transparent
-                       : cfg.triangle_config.opaque;
+    if (key.transparent)
+      return cfg.triangle_config.transparent;
+    if (key.instanced)
+      return cfg.triangle_config.opaque_instanced;
+    return cfg.enable_instance_ids ? cfg.triangle_config.opaque_instance_id
+                                   : cfg.triangle_config.opaque;
   case PIPELINE_HEIGHTFIELD:
     return cfg.heightfield_config;
   case PIPELINE_POINTCLOUD:
+  case PIPELINE_STREAMED_POINTCLOUD:
     return cfg.pointcloud_config;
+  case PIPELINE_DISPLACED_HEIGHTFIELD:
+    return cfg.displaced_heightfield_config;
   }
 }
 
@@ -734,18 +1383,18 @@ RobotScene::createRenderPipeline(const PipelineKey &key,
                                  SDL_GPUTextureFormat depth_stencil_format) {
   assert(validateMeshLayout(layout));
 
-  auto [type, transparent, renderMode] = key;
+  auto [type, transparent, renderMode, instanced] = key;
   const auto sample_count = m_renderer.getMsaaSampleCount();
   spdlog::info("Building pipeline for type {:s} ({:d} MSAA)",
                magic_enum::enum_name(type), sdlSampleToValue(sample_count));
 
-  PipelineConfig pipe_config = getPipelineConfig(m_config, type, transparent);
+  PipelineConfig pipe_config = getPipelineConfig(m_config, key);
   auto vertexShader =
       Shader::fromMetadata(device(), pipe_config.vertex_shader_path);
   auto fragmentShader =
       Shader::fromMetadata(device(), pipe_config.fragment_shader_path);
 
-  SDL_GPUColorTargetDescription color_targets[3];
+  SDL_GPUColorTargetDescription color_targets[4];
   SDL_zero(color_targets);
   color_targets[0].format = render_target_format;
   color_targets[0].blend_state = {
@@ -829,9 +1478,14 @@ RobotScene::createRenderPipeline(const PipelineKey &key,
       // Opaque triangle mesh: add depth copy as 3rd G-buffer color target
       color_targets[2].format = gBuffer.depthCopyTex.format();
       desc.target_info.num_color_targets = 3;
+      if (instanceIdsEnabled()) {
+        color_targets[3].format = gBuffer.instanceIdMap.format();
+        desc.target_info.num_color_targets = 4;
+      }
     }
 
     spdlog::info(" > transparency:  {}", transparent);
+    spdlog::info(" > instanced:     {}", instanced);
     spdlog::info(" > render mode:   {:s}", magic_enum::enum_name(renderMode));
     spdlog::info(" > depth comp op: {:s}",
                  magic_enum::enum_name(depth_compare_op));
@@ -9,47 +9,59 @@
 #include "../core/RenderContext.h"
 #include "../core/LightUniforms.h"
 #include "../core/DepthAndShadowPass.h"
+#include "../core/HeightfieldLod.h"
+#include "../core/HeightTexture.h"
+#include "../core/PointCloud.h"
+#include "../core/StreamedPointCloud.h"
 #include "../core/Texture.h"
+#include "../core/InstanceBuffer.h"
+#include "../core/LoadCoalGeometries.h"
+#include "../core/MeshUpdater.h"
 #include "../posteffects/SSAO.h"
 #include "../utils/MeshData.h"
 
 #include <magic_enum/magic_enum.hpp>
 #include <entt/entity/fwd.hpp>
+#include <entt/entity/entity.hpp>
 #include <coal/fwd.hh>
 #include <pinocchio/multibody/fwd.hpp>
 #include <set>
+#include <optional>
+#include <string>
 
 namespace candlewick {
 enum class RenderMode;
 
 namespace multibody {
 
+  /// \brief Scale of the shared unit mesh drawn for a primitive geometry,
+  /// applied along with pinocchio::GeometryObject::meshScale.
+  /// \sa getCoalUnitShape()
+  struct PinGeomUnitScaleComponent {
+    Float3 scale;
+  };
+
   /// \brief A system for updating the transform components for robot geometry
   /// entities.
   ///
   /// This will also update the mesh materials.
   ///
-  /// Reads PinGeomObjComponent, updates TransformComponent.
+  /// Reads PinGeomObjComponent and PinGeomUnitScaleComponent, updates
+  /// TransformComponent.
+  /// \param robot Only update the geometries of this robot instance.
   void updateRobotTransforms(entt::registry &registry,
                              const pin::GeometryModel &geom_model,
-                             const pin::GeometryData &geom_data);
+                             const pin::GeometryData &geom_data,
+                             Uint32 robot = 0);
 
   /// \brief A render system for Pinocchio robot geometries using Pinocchio.
   ///
   /// This internally stores references to pinocchio::GeometryModel and
-  /// pinocchio::GeometryData objects.
+  /// pinocchio::GeometryData objects, one pair per robot instance. All robot
+  /// instances share the scene's render pipelines, shadow maps and
+  /// post-processing passes.
   class RobotScene final {
-    [[nodiscard]] bool hasInternalPointers() const {
-      return m_geomModel && m_geomData;
-    }
-
-    void compositeTransparencyPass(CommandBuffer &command_buffer);
-
-    void renderPBRTriangleGeometry(CommandBuffer &command_buffer,
-                                   const Camera &camera, bool transparent);
-
-    void renderOtherGeometry(CommandBuffer &command_buffer,
-                             const Camera &camera);
+    [[nodiscard]] bool hasInternalPointers() const { return !m_robots.empty(); }
 
     void initGBuffer();
 
@@ -60,6 +72,11 @@ namespace multibody {
       PIPELINE_TRIANGLEMESH,
       PIPELINE_HEIGHTFIELD,
       PIPELINE_POINTCLOUD,
+      PIPELINE_DISPLACED_HEIGHTFIELD,
+      /// Same shaders as PIPELINE_POINTCLOUD, with the vertex layout of
+      /// PointCloud (positions and colors in separate bindings) instead of
+      /// that of point cloud geometries.
+      PIPELINE_STREAMED_POINTCLOUD,
     };
     using enum PipelineType;
     enum VertexUniformSlots : Uint32 { TRANSFORM, LIGHT_MATRICES };
@@ -67,6 +84,7 @@ namespace multibody {
       MATERIAL,
       LIGHTING,
       ATLAS_INFO,
+      INSTANCE_ID,
     };
     enum FragmentSamplerSlots : Uint32 { SHADOW_MAP_SLOT, SSAO_SLOT };
 
@@ -82,7 +100,10 @@ namespace multibody {
       case PIPELINE_HEIGHTFIELD:
         return SDL_GPU_PRIMITIVETYPE_LINELIST;
       case PIPELINE_POINTCLOUD:
+      case PIPELINE_STREAMED_POINTCLOUD:
         return SDL_GPU_PRIMITIVETYPE_POINTLIST;
+      case PIPELINE_DISPLACED_HEIGHTFIELD:
+        return SDL_GPU_PRIMITIVETYPE_LINELIST;
       }
     }
 
@@ -105,15 +126,48 @@ namespace multibody {
             .fragment_shader_path = "PbrTransparent.frag",
             .cull_mode = SDL_GPU_CULLMODE_NONE,
         };
+        /// Opaque pipeline used when instance IDs are enabled.
+        PipelineConfig opaque_instance_id{
+            .vertex_shader_path = "PbrBasic.vert",
+            .fragment_shader_path = "PbrBasicInstanceId.frag",
+        };
+        /// Opaque pipeline for instanced draws of meshes shared by several
+        /// entities, reading per-instance transforms and colors from a storage
+        /// buffer.
+        PipelineConfig opaque_instanced{
+            .vertex_shader_path = "PbrBasicInstanced.vert",
+            .fragment_shader_path = "PbrBasicInstanced.frag",
+        };
       } triangle_config;
       PipelineConfig heightfield_config{
           .vertex_shader_path = "Hud3dElement.vert",
           .fragment_shader_path = "Hud3dElement.frag",
       };
-      PipelineConfig pointcloud_config;
+      PipelineConfig pointcloud_config{
+          .vertex_shader_path = "PointSprite.vert",
+          .fragment_shader_path = "PointSprite.frag",
+          .cull_mode = SDL_GPU_CULLMODE_NONE,
+      };
+      /// Heightfields whose grid is displaced by a HeightTexture.
+      PipelineConfig displaced_heightfield_config{
+          .vertex_shader_path = "HeightfieldDisplaced.vert",
+          .fragment_shader_path = "Hud3dElement.frag",
+      };
       bool enable_shadows = true;
       bool enable_ssao = true;
       bool triangle_has_prepass = false;
+      /// Write per-pixel instance IDs of opaque triangle meshes to an extra
+      /// R32_UINT G-buffer target (GBuffer::instanceIdMap). Requires MSAA to
+      /// be disabled, see setConfig().
+      bool enable_instance_ids = false;
+      /// Merge the draws of opaque entities sharing a mesh (e.g. the same
+      /// link of several instances of a robot model) into instanced draws.
+      /// Not used with instance IDs, see setConfig().
+      bool enable_instancing = true;
+      /// Import the mesh files of BVH geometries along with their materials,
+      /// instead of converting the vertices and triangles of the coal BVH
+      /// models (see loadGeometryObject()).
+      bool load_mesh_materials = false;
       Uint32 ssao_kernel_size = 16u;
       ShadowPassConfig shadow_config;
     };
@@ -122,6 +176,9 @@ namespace multibody {
       PipelineType type;
       bool transparent;
       RenderMode renderMode;
+      /// Whether the pipeline draws instances from a storage buffer of
+      /// transforms, see Config::enable_instancing.
+      bool instanced = false;
 
       auto operator<=>(const PipelineKey &) const = default;
     };
@@ -162,6 +219,8 @@ namespace multibody {
       // Depth copy as color target (avoids sampling MSAA depth stencil texture)
       Texture depthCopyTex{NoInit};
       Texture resolveDepthCopyTex{NoInit};
+      // Instance IDs, only allocated if Config::enable_instance_ids is set
+      Texture instanceIdMap{NoInit};
 
       // WBOIT buffers
       Texture accumTexture{NoInit};
@@ -181,6 +240,7 @@ namespace multibody {
         resolveNormalMap.destroy();
         depthCopyTex.destroy();
         resolveDepthCopyTex.destroy();
+        instanceIdMap.destroy();
         accumTexture.destroy();
         revealTexture.destroy();
         resolveAccumTexture.destroy();
@@ -192,6 +252,38 @@ namespace multibody {
       }
       ~GBuffer() noexcept { this->release(); }
     } gBuffer;
+
+    /// \brief Render targets for one view of the scene.
+    ///
+    /// By default, the scene renders to the RenderContext's targets and to its
+    /// own G-buffer (see mainTargets()). Offscreen views provide their own
+    /// targets, whose formats and sample count must match the RenderContext's
+    /// since render pipelines are shared.
+    struct ViewTargets {
+      /// Color target, possibly multisampled.
+      SDL_GPUTexture *color;
+      /// Resolve target for \ref color, used if \ref msaa is set.
+      SDL_GPUTexture *resolvedColor;
+      SDL_GPUTexture *depth;
+      const GBuffer *gBuffer;
+      bool msaa;
+      /// Whether to run the SSAO pass, which is bound to the scene's own
+      /// G-buffer and can only be used with the main targets.
+      bool ssao;
+      /// Whether heightfield chunks and streamed point cloud nodes were
+      /// selected for this view's camera (see updateHeightfieldLods() and
+      /// updateStreamedPointClouds()). Otherwise, all the chunks and all the
+      /// resident nodes are drawn.
+      bool selected;
+    };
+
+    /// \brief Targets of the main view: the RenderContext's color and depth
+    /// targets, and \ref gBuffer.
+    ViewTargets mainTargets() const;
+
+    /// \brief Allocate the textures of a G-buffer for a view of the given
+    /// size, using the RenderContext's sample count.
+    void createGBuffer(GBuffer &gbuffer, Uint32 width, Uint32 height) const;
     ShadowMapPass shadowPass{NoInit};
 
     /// \brief Non-initializing constructor.
@@ -206,25 +298,86 @@ namespace multibody {
 
     RobotScene(const RobotScene &) = delete;
 
-    void setConfig(const Config &config) {
-      if (m_initialized)
-        terminate_with_message(
-            "Cannot call setConfig() after render system was initialized.");
+    /// \brief Set the scene configuration, before the render system is
+    /// initialized.
+    ///
+    /// Instance IDs are disabled, with a warning, if MSAA is enabled (integer
+    /// targets cannot be resolved) or if their shader is not compiled.
+    /// Likewise, instancing is disabled if its vertex shader is not compiled.
+    void setConfig(const Config &config);
+
+    /// \brief A named robot in the scene, whose geometry entities carry its
+    /// index in PinGeomObjComponent::robot.
+    struct RobotInstance {
+      std::string name;
+      const pin::GeometryModel *geomModel;
+      const pin::GeometryData *geomData;
+    };
 
-      m_config = config;
-    }
+    /// \brief GPU meshes and materials of a GeometryModel, loaded once and
+    /// shared by all robot instances of that model.
+    struct RobotModelAssets {
+      const pin::GeometryModel *geomModel;
+      /// Meshes of the geometry objects, owned here and borrowed by the
+      /// entities.
+      std::vector<Mesh> meshes;
+      std::vector<std::vector<PbrMaterial>> materials;
+      std::vector<PipelineType> pipelineTypes;
+      /// Scale of the geometry objects drawn with a shared unit primitive mesh.
+      std::vector<std::optional<Float3>> unitScales;
+    };
 
     /// \brief Set the internal geometry model and data pointers, and load the
     /// corresponding models.
+    ///
+    /// This removes all robot instances, and adds the given one as robot 0.
     void loadModels(const pin::GeometryModel &geom_model,
                     const pin::GeometryData &geom_data);
 
-    /// \brief Update the transform component of the GeometryObject entities.
+    /// \brief Add a robot instance, whose geometry data is updated
+    /// independently of the others.
+    ///
+    /// The meshes of \p geom_model are only imported and uploaded the first
+    /// time it is added: further instances of the same model (by address)
+    /// reuse them, and only add entities with their own transforms.
+    /// \returns The index of the new instance.
+    Uint32 addRobot(std::string_view name, const pin::GeometryModel &geom_model,
+                    const pin::GeometryData &geom_data);
+
+    Uint32 numRobots() const { return Uint32(m_robots.size()); }
+
+    /// \brief Number of distinct geometry models loaded on the GPU.
+    size_t numRobotModels() const { return m_modelAssets.size(); }
+
+    const RobotInstance &robot(Uint32 index) const { return m_robots[index]; }
+
+    /// \brief Index of the robot instance called \p name, if any.
+    std::optional<Uint32> findRobot(std::string_view name) const;
+
+    /// \brief Update the transform component of the GeometryObject entities,
+    /// for all robot instances.
     void update();
 
     void collectOpaqueCastables();
+
+    /// \brief Collect the opaque shadow-casting objects, and batch those drawn
+    /// with instancing (uploading their instance data to \p command_buffer,
+    /// outside of any render pass).
+    ///
+    /// If the shadow pass supports instancing, the batched objects are
+    /// returned by instancedCastables() instead of castables(). The batches
+    /// are reused by the opaque renders (of every view) until the next
+    /// update(), so call this once per frame.
+    void collectOpaqueCastables(CommandBuffer &command_buffer);
+
     const std::vector<OpaqueCastable> &castables() const { return m_castables; }
 
+    /// \brief Instanced batches of shadow-casting objects, to pass to the
+    /// shadow pass along with castables().
+    InstancedCastables instancedCastables() const {
+      return {m_instanceBuffer.buffer(), m_instancedCastables};
+    }
+
     Uint32 numLights() const noexcept { return shadowPass.numLights(); }
 
     entt::entity
@@ -237,10 +390,101 @@ namespace multibody {
       return addEnvironmentObject(std::move(data), T.matrix(), pipe_type);
     }
 
+    /// \brief Add environment objects sharing a single mesh, uploaded once, at
+    /// each of \p placements. Opaque instances are drawn with instanced draws,
+    /// including in the shadow pass, whatever their colors.
+    ///
+    /// \param colors Base color of each instance, or a single color for all of
+    /// them. If empty, the material of \p data is used.
+    /// \returns The entities of the instances, in the order of \p placements.
+    /// \sa updateEnvironmentInstances()
+    std::vector<entt::entity>
+    addEnvironmentInstances(MeshData &&data, std::span<const Mat4f> placements,
+                            std::span<const Float4> colors = {});
+
+    /// \brief Set the placements of environment objects, e.g. of instances
+    /// returned by addEnvironmentInstances(), in bulk. Entities which were
+    /// destroyed, or have no transform, are skipped.
+    void updateEnvironmentInstances(std::span<const entt::entity> entities,
+                                    std::span<const Mat4f> placements);
+
+    /// \brief Add a heightfield environment object split into chunks, each
+    /// drawn with its own level of detail, and culled against the view
+    /// frustum.
+    ///
+    /// Drawn as lines by the heightfield pipeline, or as shaded triangles by
+    /// the triangle mesh pipeline if HeightfieldLodConfig::solid is set.
+    /// \sa updateHeightfieldLods()
+    entt::entity
+    addHeightfieldChunked(const Eigen::Ref<const Eigen::MatrixXf> &heights,
+                          const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+                          const Eigen::Ref<const Eigen::VectorXf> &ygrid,
+                          const Mat4f &placement,
+                          const HeightfieldLodConfig &config = {});
+
+    /// \brief Select the chunks and levels of detail of chunked heightfields
+    /// for \p camera. Call this before collectOpaqueCastables() and rendering.
+    void updateHeightfieldLods(const Camera &camera);
+
+    /// \brief Add a heightfield environment object, whose heights are stored
+    /// in a HeightTexture and displace a flat grid mesh in the vertex shader.
+    ///
+    /// The grid must be uniform. Grid meshes are shared by all displaced
+    /// heightfields of the same size. To change the heights of a region, call
+    /// HeightTexture::upload() on the entity's HeightTexture component with a
+    /// command buffer, outside of any render pass: only that region is
+    /// uploaded.
+    ///
+    /// If Config::displaced_heightfield_config's vertex shader is not
+    /// compiled, this falls back to addHeightfieldChunked() with a warning:
+    /// the entity then has no HeightTexture component, and its heights are
+    /// fixed.
+    entt::entity
+    addDisplacedHeightfield(const Eigen::Ref<const Eigen::MatrixXf> &heights,
+                            const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+                            const Eigen::Ref<const Eigen::VectorXf> &ygrid,
+                            const Mat4f &placement);
+
+    /// \brief Add an empty point cloud environment object, with a PointCloud
+    /// component.
+    ///
+    /// Its points are replaced by calling PointCloud::update() on the
+    /// component, e.g. every frame. The upload is recorded when rendering.
+    entt::entity addPointCloud(const Mat4f &placement = Mat4f::Identity());
+
+    /// \brief Add a point cloud environment object streamed from a point cloud
+    /// octree file, with a StreamedPointCloud component.
+    /// \sa buildPointOctree(), updateStreamedPointClouds()
+    entt::entity
+    addStreamedPointCloud(const std::string &path,
+                          const Mat4f &placement = Mat4f::Identity(),
+                          const StreamedPointCloudConfig &config = {});
+
+    /// \brief Select and load the nodes of streamed point clouds for \p
+    /// camera. Call this before rendering.
+    void updateStreamedPointClouds(const Camera &camera);
+
+    /// \brief Updater for in-place updates of vertex and index sub-ranges of
+    /// the scene's meshes (e.g. of their MeshMaterialComponent), for
+    /// deformable objects.
+    /// \sa flushMeshUpdates()
+    MeshUpdater &meshUpdater() {
+      if (!m_meshUpdater.initialized())
+        m_meshUpdater = MeshUpdater{device()};
+      return m_meshUpdater;
+    }
+
+    /// \brief Record the mesh updates staged since the last call, in a single
+    /// copy pass. Call this before rendering, outside of any render pass.
+    void flushMeshUpdates(CommandBuffer &command_buffer) {
+      m_meshUpdater.flush(command_buffer);
+    }
+
     /// \brief Destroy all entities with the EnvironmentTag component.
     void clearEnvironment();
     /// \brief Destroy all entities with the PinGeomObjComponent component
-    /// (Pinocchio geometry objects).
+    /// (Pinocchio geometry objects), remove all robot instances and release
+    /// their meshes.
     void clearRobotGeometries();
 
     GraphicsPipeline
@@ -256,6 +500,15 @@ namespace multibody {
 
     void renderTransparent(CommandBuffer &command_buffer, const Camera &camera);
 
+    /// \brief Render the opaque geometry of the scene to the given \p targets.
+    void renderOpaque(CommandBuffer &command_buffer, const Camera &camera,
+                      const ViewTargets &targets);
+
+    /// \brief Render the transparent geometry of the scene to the given \p
+    /// targets.
+    void renderTransparent(CommandBuffer &command_buffer, const Camera &camera,
+                           const ViewTargets &targets);
+
     /// \brief Release all resources.
     void release();
 
@@ -263,6 +516,21 @@ namespace multibody {
     const Config &config() const { return m_config; }
     inline bool pbrHasPrepass() const { return m_config.triangle_has_prepass; }
     inline bool shadowsEnabled() const { return m_config.enable_shadows; }
+    inline bool instanceIdsEnabled() const {
+      return m_config.enable_instance_ids;
+    }
+
+    /// \brief Value written to the instance ID target for a given entity.
+    /// Zero is reserved for the background.
+    static Uint32 instanceIdFromEntity(entt::entity entity) {
+      return entt::to_integral(entity) + 1;
+    }
+
+    /// \brief Entity for a value read from the instance ID target, or
+    /// `entt::null` for the background.
+    static entt::entity entityFromInstanceId(Uint32 id) {
+      return id == 0 ? entt::entity{entt::null} : entt::entity{id - 1};
+    }
 
     using pipeline_req_t = std::tuple<MeshLayout, PipelineKey>;
     /// \brief Ensure the render pipelines were properly created following the
@@ -270,23 +538,73 @@ namespace multibody {
     void
     ensurePipelinesExist(const std::set<pipeline_req_t> &required_pipelines);
 
-    /// \brief Getter for the pinocchio GeometryModel object.
-    const pin::GeometryModel &geomModel() const { return *m_geomModel; }
+    /// \brief Getter for the pinocchio GeometryModel object of robot 0.
+    const pin::GeometryModel &geomModel() const {
+      return *m_robots.front().geomModel;
+    }
 
-    /// \brief Getter for the pinocchio GeometryData object.
-    const pin::GeometryData &geomData() const { return *m_geomData; }
+    /// \brief Getter for the pinocchio GeometryData object of robot 0.
+    const pin::GeometryData &geomData() const {
+      return *m_robots.front().geomData;
+    }
 
     const Device &device() { return m_renderer.device; }
     entt::registry &registry() { return m_registry; }
     const entt::registry &registry() const { return m_registry; }
 
   private:
+    /// A run of entities drawn with a single instanced draw per mesh view.
+    struct InstanceBatch {
+      entt::entity entity; // first entity, providing the mesh and materials
+      Uint32 firstInstance;
+      Uint32 numInstances;
+    };
+
+    const RobotModelAssets &loadModelAssets(const pin::GeometryModel &model);
+
+    bool instancingEnabled() const {
+      return m_config.enable_instancing && !m_config.enable_instance_ids;
+    }
+
+    /// \brief Sort the opaque, filled triangle meshes into instanced batches
+    /// and remaining entities, and upload the instance transforms.
+    void batchOpaqueInstances(CommandBuffer &command_buffer);
+
+    void compositeTransparencyPass(CommandBuffer &command_buffer,
+                                   const ViewTargets &targets);
+
+    void renderPBRTriangleGeometry(CommandBuffer &command_buffer,
+                                   const Camera &camera, bool transparent,
+                                   const ViewTargets &targets);
+
+    void renderOtherGeometry(CommandBuffer &command_buffer,
+                             const Camera &camera, const ViewTargets &targets);
+
     entt::registry &m_registry;
     const RenderContext &m_renderer;
     Config m_config;
-    const pin::GeometryModel *m_geomModel;
-    const pin::GeometryData *m_geomData;
+    std::vector<RobotInstance> m_robots;
+    std::vector<RobotModelAssets> m_modelAssets;
+    /// Unit meshes shared by the primitive geometries of all models.
+    std::map<CoalUnitPrimitive, Mesh> m_unitPrimitiveMeshes;
+    InstanceBuffer m_instanceBuffer{NoInit};
+    MeshUpdater m_meshUpdater{NoInit};
+    std::vector<InstanceBatch> m_instanceBatches;
+    /// Instance data of m_batchedEntities, uploaded to m_instanceBuffer.
+    std::vector<PbrInstanceData> m_instanceData;
+    /// Entities of m_instanceBatches, in batch order.
+    std::vector<entt::entity> m_batchedEntities;
+    std::vector<entt::entity> m_unbatchedEntities;
     std::vector<OpaqueCastable> m_castables;
+    /// Grid meshes of displaced heightfields, by size.
+    std::map<std::pair<Uint32, Uint32>, Mesh> m_heightfieldGrids;
+    /// Meshes shared by environment instances, which only borrow them.
+    std::vector<Mesh> m_environmentMeshes;
+    std::vector<InstancedCastable> m_instancedCastables;
+    /// Whether the instance batches are up to date with the transforms, and
+    /// can be reused by the next opaque renders (e.g. of several views). Reset
+    /// by update() and updateEnvironmentInstances().
+    bool m_instancesBatched{false};
     bool m_initialized;
     PipelineManager m_pipelines;
     GraphicsPipeline m_wboitComposite{NoInit};
@@ -2,9 +2,13 @@
 #include "../core/Device.h"
 #include "../core/CameraControls.h"
 #include "../core/DepthAndShadowPass.h"
+#include "../core/Profiler.h"
 #include "RobotDebug.h"
 
 #include <pinocchio/algorithm/frames.hpp>
+#include <pinocchio/algorithm/geometry.hpp>
+#include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics.hpp>
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_hints.h>
 
@@ -36,6 +40,8 @@ _make_robot_scene_config(const Visualizer::Config &config) {
   RobotScene::Config rconfig;
   rconfig.enable_shadows = true;
   rconfig.ssao_kernel_size = config.ssaoKernelSize;
+  rconfig.enable_instance_ids = config.enableInstanceIds;
+  rconfig.load_mesh_materials = config.loadMeshMaterials;
   return rconfig;
 }
 
@@ -50,7 +56,11 @@ static RenderContext _create_renderer(const Visualizer::Config &config,
                   Window{"Candlewick Pinocchio visualizer", int(config.width),
                          int(config.height), flags},
                   config.depthStencilFormat};
-  r.enableMSAA(config.sampleCount);
+  // the instance ID target is an integer target, which cannot be resolved
+  if (config.enableInstanceIds && config.sampleCount > SDL_GPU_SAMPLECOUNT_1)
+    spdlog::info("Instance IDs enabled, rendering without MSAA.");
+  r.enableMSAA(config.enableInstanceIds ? SDL_GPU_SAMPLECOUNT_1
+                                        : config.sampleCount);
   return r;
 }
 
@@ -64,6 +74,7 @@ Visualizer::Visualizer(const Config &config, const pin::Model &model,
     , robotScene{registry, renderer}
     , debugScene{registry, renderer}
     , m_transferBuffers{renderer.device}
+    , m_sensorViews{renderer, robotScene}
 #ifdef CANDLEWICK_WITH_FFMPEG_SUPPORT
     , m_videoRecorder{NoInit}
 #endif
@@ -82,6 +93,7 @@ Visualizer::Visualizer(const Config &config, const pin::Model &model,
     , robotScene{registry, renderer}
     , debugScene{registry, renderer}
     , m_transferBuffers{renderer.device}
+    , m_sensorViews{renderer, robotScene}
 #ifdef CANDLEWICK_WITH_FFMPEG_SUPPORT
     , m_videoRecorder{NoInit}
 #endif
@@ -136,6 +148,8 @@ void Visualizer::resetCamera() {
 
 void Visualizer::loadViewerModel() {
   robotScene.loadModels(visualModel(), visualData());
+  for (const auto &robot : m_robots)
+    robotScene.addRobot(robot->name, robot->visualModel, robot->visualData);
 
   if (auto *robotDebug = debugScene.getSystem<RobotDebugSystem>("robot"_hs)) {
     robotDebug->reload(this->model(), this->data());
@@ -146,6 +160,105 @@ void Visualizer::loadViewerModel() {
   }
 }
 
+Visualizer::RobotInstance::RobotInstance(
+    std::string_view name, std::shared_ptr<const RobotModels> models,
+    const pin::Model &model, const pin::GeometryModel &visual_model)
+    : name(name)
+    , models(std::move(models))
+    , model(model)
+    , visualModel(visual_model)
+    , data(model)
+    , visualData(visual_model) {}
+
+auto Visualizer::emplaceRobot(std::string_view name,
+                              std::shared_ptr<const RobotModels> models,
+                              const pin::Model &model,
+                              const pin::GeometryModel &visual_model)
+    -> RobotInstance & {
+  if (name.empty())
+    terminate_with_message("Robot name cannot be empty.");
+  if (findRobot(name))
+    terminate_with_message("Robot \'{:s}\' already exists.", name);
+
+  auto &robot = *m_robots.emplace_back(std::make_unique<RobotInstance>(
+      name, std::move(models), model, visual_model));
+  pin::forwardKinematics(robot.model, robot.data, pin::neutral(robot.model));
+  pin::updateGeometryPlacements(robot.model, robot.data, robot.visualModel,
+                                robot.visualData);
+  robotScene.addRobot(name, robot.visualModel, robot.visualData);
+  return robot;
+}
+
+auto Visualizer::addRobot(std::string_view name, const pin::Model &model,
+                          const pin::GeometryModel &visual_model)
+    -> RobotInstance & {
+  auto models = std::make_shared<const RobotModels>(model, visual_model);
+  auto &robot = emplaceRobot(name, models, models->model, models->visualModel);
+  spdlog::info("Added robot \'{:s}\' with {:d} geometries", name,
+               robot.visualModel.ngeoms);
+  return robot;
+}
+
+auto Visualizer::addRobotInstance(std::string_view name,
+                                  std::string_view source) -> RobotInstance & {
+  if (source.empty())
+    return emplaceRobot(name, nullptr, this->model(), visualModel());
+  RobotInstance *src = findRobot(source);
+  if (!src)
+    terminate_with_message("No robot named \'{:s}\'.", source);
+  return emplaceRobot(name, src->models, src->model, src->visualModel);
+}
+
+auto Visualizer::findRobot(std::string_view name) -> RobotInstance * {
+  for (auto &robot : m_robots) {
+    if (robot->name == name)
+      return robot.get();
+  }
+  return nullptr;
+}
+
+void Visualizer::setRobotState(std::string_view name, const ConstVectorRef &q,
+                               const ConstVectorRef &v) {
+  RobotInstance *robot = findRobot(name);
+  if (!robot)
+    terminate_with_message("No robot named \'{:s}\'.", name);
+  if (v.size() == 0)
+    pin::forwardKinematics(robot->model, robot->data, q);
+  else
+    pin::forwardKinematics(robot->model, robot->data, q, v);
+}
+
+PointCloud &Visualizer::pointCloud(std::string_view name) {
+  auto it = m_pointClouds.find(name);
+  if (it == m_pointClouds.end())
+    it = m_pointClouds.emplace(name, robotScene.addPointCloud()).first;
+  return registry.get<PointCloud>(it->second);
+}
+
+PointCloud &
+Visualizer::setPointCloud(std::string_view name,
+                          const Eigen::Ref<const Eigen::Matrix3Xf> &positions) {
+  PointCloud &cloud = pointCloud(name);
+  cloud.update(positions);
+  return cloud;
+}
+
+PointCloud &Visualizer::setPointCloud(
+    std::string_view name, const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+    const Eigen::Ref<const PointCloud::ColorMatrix> &colors) {
+  PointCloud &cloud = pointCloud(name);
+  cloud.update(positions, colors);
+  return cloud;
+}
+
+void Visualizer::removePointCloud(std::string_view name) {
+  auto it = m_pointClouds.find(name);
+  if (it == m_pointClouds.end())
+    return;
+  registry.destroy(it->second);
+  m_pointClouds.erase(it);
+}
+
 void Visualizer::setCameraTarget(const Eigen::Ref<const Vector3> &target) {
   controller.lookAt1(target.cast<float>());
 }
@@ -165,6 +278,7 @@ Visualizer::~Visualizer() {
   this->stopRecording();
 #endif
   m_transferBuffers.release();
+  m_sensorViews.clearViews();
 
   robotScene.release();
   debugScene.release();
@@ -174,13 +288,23 @@ Visualizer::~Visualizer() {
 }
 
 void Visualizer::displayImpl() {
+  CANDLEWICK_PROFILE_FRAME();
   // update frames. needed for frame debug viz
   pin::updateFramePlacements(model(), data());
 
-  this->processEvents();
+  {
+    CANDLEWICK_PROFILE_SCOPE("processEvents");
+    this->processEvents();
+  }
 
-  robotScene.update();
-  debugScene.update();
+  {
+    CANDLEWICK_PROFILE_SCOPE("updateScenes");
+    for (auto &robot : m_robots)
+      pin::updateGeometryPlacements(robot->model, robot->data,
+                                    robot->visualModel, robot->visualData);
+    robotScene.update();
+    debugScene.update();
+  }
   this->render();
 
   if (m_shouldScreenshot) {
@@ -202,25 +326,50 @@ void Visualizer::displayImpl() {
 void Visualizer::render() {
 
   CommandBuffer command_buffer = renderer.acquireCommandBuffer();
-  robotScene.collectOpaqueCastables();
-  std::span castables = robotScene.castables();
-  renderShadowPassFromAABB(command_buffer, robotScene.shadowPass,
-                           robotScene.directionalLight, castables,
-                           worldSceneBounds);
-
-  robotScene.renderOpaque(command_buffer, controller);
-  debugScene.render(command_buffer, controller);
-  robotScene.renderTransparent(command_buffer, controller);
-  if (m_showGui)
+  robotScene.flushMeshUpdates(command_buffer);
+  {
+    CANDLEWICK_PROFILE_SCOPE("collectOpaqueCastables");
+    robotScene.updateHeightfieldLods(controller);
+    robotScene.updateStreamedPointClouds(controller);
+    robotScene.collectOpaqueCastables(command_buffer);
+    debugScene.collectInstances(command_buffer);
+  }
+  {
+    CANDLEWICK_PROFILE_SCOPE("renderShadowPassFromAABB");
+    std::span castables = robotScene.castables();
+    renderShadowPassFromAABB(command_buffer, robotScene.shadowPass,
+                             robotScene.directionalLight, castables,
+                             worldSceneBounds,
+                             robotScene.instancedCastables());
+  }
+
+  {
+    CANDLEWICK_PROFILE_SCOPE("renderOpaque");
+    robotScene.renderOpaque(command_buffer, controller);
+  }
+  {
+    CANDLEWICK_PROFILE_SCOPE("DebugScene::render");
+    debugScene.render(command_buffer, controller);
+  }
+  {
+    CANDLEWICK_PROFILE_SCOPE("renderTransparent");
+    robotScene.renderTransparent(command_buffer, controller);
+  }
+  if (m_showGui) {
+    CANDLEWICK_PROFILE_SCOPE("GuiSystem::render");
     guiSystem.render(command_buffer);
+  }
 
-  if (renderer.waitAndAcquireSwapchain(command_buffer)) {
-    // present (blit) main color target to swapchain
-    renderer.presentToSwapchain(command_buffer);
-  } else {
-    terminate_with_message("Failed to acquire swapchain: {:s}", SDL_GetError());
+  {
+    CANDLEWICK_PROFILE_SCOPE("waitAndAcquireSwapchain");
+    if (!renderer.waitAndAcquireSwapchain(command_buffer))
+      terminate_with_message("Failed to acquire swapchain: {:s}",
+                             SDL_GetError());
   }
+  // present (blit) main color target to swapchain
+  renderer.presentToSwapchain(command_buffer);
   command_buffer.submit();
+  render_stats::endFrame();
 }
 
 void Visualizer::takeScreenshot(std::string_view filename) {
@@ -228,10 +377,70 @@ void Visualizer::takeScreenshot(std::string_view filename) {
   auto [width, height] = renderer.window.sizeInPixels();
   spdlog::info("Saving {:d} x {:d} screenshot at: \'{:s}\'", width, height,
                filename);
-  media::saveTextureToFile(command_buffer, device(), m_transferBuffers,
-                           renderer.resolvedColorTarget(),
-                           renderer.colorFormat(), Uint16(width),
-                           Uint16(height), filename);
+  const SDL_GPUTextureFormat format = renderer.colorFormat();
+  auto res = media::downloadTexture(command_buffer, device(), m_transferBuffers,
+                                    renderer.resolvedColorTarget(), format,
+                                    Uint16(width), Uint16(height));
+
+  // only copy out of the mapped buffer here, conversion and encoding are
+  // done by the image writer's workers
+  media::ImageWriter::Job job{
+      .filename = std::string(filename),
+      .pixels = {},
+      .width = res.width,
+      .height = res.height,
+      .layout = format == SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM
+                    ? media::PixelLayout::BGRA8
+                    : media::PixelLayout::RGBA8,
+      .format = media::imageFileFormatFromFilename(filename),
+  };
+  const auto *data = reinterpret_cast<const Uint8 *>(res.data);
+  job.pixels.assign(data, data + res.payloadSize);
+  SDL_UnmapGPUTransferBuffer(device(), res.buffer);
+
+  m_imageWriter.submit(std::move(job));
+}
+
+FrameCapture Visualizer::captureFrame(const FrameCaptureConfig &config) {
+  CommandBuffer command_buffer{device()};
+  return multibody::captureFrame(command_buffer, renderer, robotScene,
+                                 controller.camera, m_transferBuffers, config);
+}
+
+void Visualizer::saveFrameCapture(std::string_view basename,
+                                  const FrameCaptureConfig &config) {
+  spdlog::info("Saving frame capture at: \'{:s}_*\'", basename);
+  multibody::saveFrameCapture(m_imageWriter, captureFrame(config), basename);
+}
+
+std::vector<FrameCapture> Visualizer::renderSensorViews() {
+  return m_sensorViews.render(data(), worldSceneBounds, m_transferBuffers);
+}
+
+void Visualizer::saveSensorViews(std::string_view basename) {
+  auto captures = renderSensorViews();
+  for (size_t i = 0; i < captures.size(); i++) {
+    multibody::saveFrameCapture(m_imageWriter, std::move(captures[i]),
+                                fmt::format("{:s}_{:d}", basename, i));
+  }
+}
+
+std::vector<Uint32> Visualizer::readInstanceIds(Uint16 x, Uint16 y,
+                                                Uint16 width, Uint16 height) {
+  CommandBuffer command_buffer{device()};
+  return multibody::readInstanceIds(command_buffer, renderer, robotScene,
+                                    m_transferBuffers, x, y, width, height);
+}
+
+std::optional<pin::GeomIndex>
+Visualizer::geometryIndexFromInstanceId(Uint32 id) const {
+  const entt::entity ent = RobotScene::entityFromInstanceId(id);
+  if (!registry.valid(ent))
+    return std::nullopt;
+  auto *obj = registry.try_get<PinGeomObjComponent>(ent);
+  if (obj && obj->robot == 0)
+    return obj->geom_index;
+  return std::nullopt;
 }
 
 void Visualizer::startRecording([[maybe_unused]] std::string_view filename) {
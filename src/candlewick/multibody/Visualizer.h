@@ -9,13 +9,19 @@
 #include "../core/DebugScene.h"
 #include "../core/RenderContext.h"
 #include "../utils/WriteTextureToImage.h"
+#include "../utils/ImageWriter.h"
+#include "FrameCapture.h"
+#include "MultiViewRenderer.h"
 #ifdef CANDLEWICK_WITH_FFMPEG_SUPPORT
 #include "../utils/VideoRecorder.h"
 #endif
 
 #include <pinocchio/visualizers/base-visualizer.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/multibody/geometry.hpp>
 #include <SDL3/SDL_mouse.h>
 #include <entt/entity/registry.hpp>
+#include <map>
 
 namespace candlewick::multibody {
 
@@ -53,6 +59,10 @@ void guiAddCameraParams(CylindricalCamera &controller,
 /// This visualizer is synchronous. The window is only updated when `display()`
 /// is called.
 ///
+/// Additional robots can be added to the same scene with addRobot(), e.g. to
+/// display a fleet of robots in a single window. They share the render
+/// pipelines, shadow maps and post-processing passes of the main robot.
+///
 /// \note So far, this visualizer class does not support displaying visual and
 /// collision geometries simulatenously.
 ///
@@ -94,6 +104,13 @@ public:
     SDL_GPUSampleCount sampleCount = SDL_GPU_SAMPLECOUNT_2;
     SDL_GPUTextureFormat depthStencilFormat = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
     Uint32 ssaoKernelSize = 16u;
+    /// Render per-pixel instance IDs, see readInstanceIds(). The instance
+    /// ID target cannot be multisampled, so this disables MSAA and
+    /// `sampleCount` is ignored.
+    bool enableInstanceIds = false;
+    /// Import the mesh files of BVH geometries with their materials, see
+    /// RobotScene::Config::load_mesh_materials.
+    bool loadMeshMaterials = false;
   };
 
   void resetCamera();
@@ -139,8 +156,139 @@ public:
 
   [[nodiscard]] bool shouldExit() const noexcept { return m_shouldExit; }
 
+  /// \brief Save a screenshot of the window contents.
+  ///
+  /// The frame is read back synchronously, but encoding and writing the file
+  /// happen asynchronously on the image writer's worker threads. The file
+  /// format is deduced from the extension (PNG, QOI or raw RGBA data).
+  /// \sa waitScreenshots()
   void takeScreenshot(std::string_view filename);
 
+  /// \brief Block until all pending screenshots are written to disk.
+  void waitScreenshots() { m_imageWriter.waitIdle(); }
+
+  media::ImageWriter &imageWriter() { return m_imageWriter; }
+
+  /// \brief Read back the color, metric depth and view-space normals of the
+  /// last rendered frame.
+  /// \sa multibody::captureFrame()
+  FrameCapture captureFrame(const FrameCaptureConfig &config = {});
+
+  /// \brief Capture the last rendered frame and write its buffers to
+  /// `<basename>_{color,depth,normals}.*` files, asynchronously.
+  /// \sa multibody::saveFrameCapture(), waitScreenshots()
+  void saveFrameCapture(std::string_view basename,
+                        const FrameCaptureConfig &config = {});
+
+  /// \brief Read back the instance IDs of a region of the last rendered frame.
+  /// \sa multibody::readInstanceIds(), geometryIndexFromInstanceId()
+  std::vector<Uint32> readInstanceIds(Uint16 x, Uint16 y, Uint16 width,
+                                      Uint16 height);
+
+  /// \brief Index of the visual GeometryObject of the main robot for an
+  /// instance ID, or `std::nullopt` for the background, environment objects
+  /// and other robots.
+  std::optional<pin::GeomIndex> geometryIndexFromInstanceId(Uint32 id) const;
+
+  /// \brief Copies of the models of robots added with addRobot(), shared by
+  /// all their instances.
+  struct RobotModels {
+    pin::Model model;
+    pin::GeometryModel visualModel;
+  };
+
+  /// \brief A robot displayed alongside the main one, with its own state.
+  struct RobotInstance {
+    std::string name;
+    /// Keeps the models alive. Null for instances of the main robot.
+    std::shared_ptr<const RobotModels> models;
+    const pin::Model &model;
+    const pin::GeometryModel &visualModel;
+    pin::Data data;
+    pin::GeometryData visualData;
+
+    RobotInstance(std::string_view name,
+                  std::shared_ptr<const RobotModels> models,
+                  const pin::Model &model,
+                  const pin::GeometryModel &visual_model);
+  };
+
+  /// \brief Add a named robot to the scene. The models are copied.
+  ///
+  /// Set its state with setRobotState(), and draw all robots with display().
+  RobotInstance &addRobot(std::string_view name, const pin::Model &model,
+                          const pin::GeometryModel &visual_model);
+
+  /// \brief Add another instance of the robot called \p source, or of the
+  /// main robot if \p source is empty.
+  ///
+  /// The instance shares the models and GPU meshes of \p source, and only
+  /// allocates its own kinematics data and transforms. Its opaque meshes are
+  /// drawn with those of the other instances, in instanced draws.
+  RobotInstance &addRobotInstance(std::string_view name,
+                                  std::string_view source = {});
+
+  /// \brief Number of robots added with addRobot(), not counting the main
+  /// robot.
+  size_t numRobots() const { return m_robots.size(); }
+
+  RobotInstance &robot(size_t i) { return *m_robots[i]; }
+  const RobotInstance &robot(size_t i) const { return *m_robots[i]; }
+
+  /// \brief Robot added with addRobot() called \p name, or `nullptr`.
+  RobotInstance *findRobot(std::string_view name);
+
+  /// \brief Run forward kinematics for the robot called \p name.
+  /// \param v Joint velocity, for frame velocity visualization. Can be empty.
+  void setRobotState(std::string_view name, const ConstVectorRef &q,
+                     const ConstVectorRef &v = VectorXs{});
+
+  /// \brief Replace the points of the point cloud called \p name, which is
+  /// created on first use. The points are drawn with
+  /// PointCloud::defaultColor.
+  ///
+  /// The points are uploaded with the next frame, and can be updated every
+  /// frame.
+  /// \sa RobotScene::addPointCloud()
+  PointCloud &
+  setPointCloud(std::string_view name,
+                const Eigen::Ref<const Eigen::Matrix3Xf> &positions);
+
+  /// \brief Replace the points of the point cloud called \p name, and their
+  /// colors.
+  PointCloud &
+  setPointCloud(std::string_view name,
+                const Eigen::Ref<const Eigen::Matrix3Xf> &positions,
+                const Eigen::Ref<const PointCloud::ColorMatrix> &colors);
+
+  /// \brief Remove the point cloud called \p name, if any.
+  void removePointCloud(std::string_view name);
+
+  /// \brief Add an offscreen camera sensor, e.g. attached to a robot frame.
+  /// \returns The index of the sensor view.
+  /// \sa MultiViewRenderer
+  size_t addSensorView(const SensorViewConfig &config) {
+    return m_sensorViews.addView(config);
+  }
+
+  void clearSensorViews() { m_sensorViews.clearViews(); }
+
+  size_t numSensorViews() const { return m_sensorViews.numViews(); }
+
+  const MultiViewRenderer::View &sensorView(size_t i) const {
+    return m_sensorViews.view(i);
+  }
+
+  /// \brief Render all sensor views for the last displayed configuration, and
+  /// read back their buffers.
+  /// \sa MultiViewRenderer::render()
+  std::vector<FrameCapture> renderSensorViews();
+
+  /// \brief Render all sensor views and write their buffers to
+  /// `<basename>_<index>_*` files, asynchronously.
+  /// \sa saveFrameCapture()
+  void saveSensorViews(std::string_view basename);
+
   void startRecording(std::string_view filename);
 
   /// \brief Stop recording the window.
@@ -184,10 +332,24 @@ public:
     removeFramesViz();
     robotScene.clearEnvironment();
     robotScene.clearRobotGeometries();
+    m_robots.clear();
+    m_pointClouds.clear();
   }
 
 private:
   media::TransferBufferPool m_transferBuffers;
+  media::ImageWriter m_imageWriter;
+  MultiViewRenderer m_sensorViews;
+  // stable addresses, referenced by the RobotScene
+  std::vector<std::unique_ptr<RobotInstance>> m_robots;
+  std::map<std::string, entt::entity, std::less<>> m_pointClouds;
+
+  PointCloud &pointCloud(std::string_view name);
+
+  RobotInstance &emplaceRobot(std::string_view name,
+                              std::shared_ptr<const RobotModels> models,
+                              const pin::Model &model,
+                              const pin::GeometryModel &visual_model);
   std::string m_currentScreenshotFilename;
   bool m_shouldScreenshot = false;
 #ifdef CANDLEWICK_WITH_FFMPEG_SUPPORT
@@ -84,6 +84,9 @@ void addPinocchioModelInfo(entt::registry &reg, const pin::Model &model,
       reg.sort<PinGeomObjComponent>(
           [&geom_model, sortSpecs](const PinGeomObjComponent &lhsId,
                                    const PinGeomObjComponent &rhsId) {
+            // geometries of other robot instances come last, unsorted
+            if (lhsId.robot != 0 || rhsId.robot != 0)
+              return lhsId.robot < rhsId.robot;
             auto &lhs = geom_model.geometryObjects[lhsId];
             auto &rhs = geom_model.geometryObjects[rhsId];
             for (int n = 0; n < sortSpecs->SpecsCount; n++) {
@@ -114,6 +117,9 @@ void addPinocchioModelInfo(entt::registry &reg, const pin::Model &model,
     auto &disabled = reg.storage<Disable>();
 
     for (auto [ent, id] : view.each()) {
+      // only list the geometries of \p geom_model, i.e. robot 0
+      if (id.robot != 0)
+        continue;
       auto &gobj = geom_model.geometryObjects[id];
 
       auto &mmc = reg.get<MeshMaterialComponent>(ent);
@@ -1,5 +1,6 @@
 #include "Visualizer.h"
 #include "RobotDebug.h"
+#include "../core/Profiler.h"
 
 #include <SDL3/SDL_events.h>
 
@@ -84,10 +85,28 @@ void Visualizer::guiCallbackImpl() {
     gui::addPinocchioModelInfo(registry, m_model, visualModel());
   }
 
+  if (!m_robots.empty() && ImGui::CollapsingHeader("Other robots")) {
+    for (const auto &robot : m_robots) {
+      ImGui::BulletText("%s: %d joints, %zu geometries", robot->name.c_str(),
+                        robot->model.njoints, robot->visualModel.ngeoms);
+    }
+  }
+
   if (auto robotDebug = debugScene.getSystem<RobotDebugSystem>("robot"_hs)) {
     robotDebug->renderDebugGui("Robot debug");
   }
 
+  if (ImGui::CollapsingHeader("Render statistics")) {
+    core_gui::addRenderStatsTable(render_stats::lastFrame());
+  }
+
+#ifdef CANDLEWICK_WITH_PROFILING
+  if (ImGui::CollapsingHeader("Frame profiler")) {
+    core_gui::addFrameProfilerPanel(FrameProfiler::instance(),
+                                    "candlewick_trace.json");
+  }
+#endif
+
   if (ImGui::CollapsingHeader(
 #ifdef CANDLEWICK_WITH_FFMPEG_SUPPORT
           "Screenshots/Video recording"
@@ -232,6 +232,7 @@ namespace ssao {
   }
 
   void SsaoPass::render(CommandBuffer &cmdBuf, const Camera &camera) {
+    RenderStatsPassScope stats_pass{RenderStatsPass::Ssao};
     // std140 layout: two mat4 (128 bytes) + uint (4 bytes) padded to 144 bytes.
     struct CameraUbo {
       GpuMat4 projection;
@@ -247,7 +248,7 @@ namespace ssao {
         .store_op = SDL_GPU_STOREOP_STORE,
     };
     SDL_GPURenderPass *render_pass =
-        SDL_BeginGPURenderPass(cmdBuf, &color_info, 1, nullptr);
+        rend::beginRenderPass(cmdBuf, {&color_info, 1});
 
     rend::bindFragmentSamplers(
         render_pass, 0,
@@ -260,7 +261,7 @@ namespace ssao {
     cmdBuf.pushFragmentUniform(0, g_ssaoParam)
         .pushFragmentUniform(1, cameraUniforms);
     pipeline.bind(render_pass);
-    SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+    rend::drawPrimitives(render_pass, 6);
     SDL_EndGPURenderPass(render_pass);
 
     const GpuVec2 blurDirections[] = {{1, 0}, {0, 1}};
@@ -269,7 +270,7 @@ namespace ssao {
       // if i = 0, render to pass 1 blur texture
       color_info.texture = (i == 0) ? blurPass1Tex : ssaoMap;
 
-      render_pass = SDL_BeginGPURenderPass(cmdBuf, &color_info, 1, nullptr);
+      render_pass = rend::beginRenderPass(cmdBuf, {&color_info, 1});
       blurPipeline.bind(render_pass);
 
       cmdBuf.pushFragmentUniform(0, blurDir);
@@ -279,7 +280,7 @@ namespace ssao {
               .texture = (i == 0) ? ssaoMap : blurPass1Tex,
               .sampler = texSampler,
           }});
-      SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+      rend::drawPrimitives(render_pass, 6);
       SDL_EndGPURenderPass(render_pass);
     }
   }
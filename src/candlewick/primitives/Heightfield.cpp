@@ -1,6 +1,10 @@
 #include "Heightfield.h"
 
 #include "Internal.h"
+#include "../core/DefaultVertex.h"
+
+#include <bit>
+#include <limits>
 
 namespace candlewick {
 
@@ -47,4 +51,263 @@ MeshData loadHeightfield(const Eigen::Ref<const Eigen::MatrixXf> &heights,
                   std::move(indexData)};
 }
 
+namespace detail {
+  /// Index of the vertex (i, j) of a chunk of size \p n, whose vertices on the
+  /// sides in \p mask are snapped down onto the grid of step \p coarse.
+  static Uint32 stitchedIndex(Uint32 i, Uint32 j, Uint32 n, Uint32 mask,
+                              Uint32 coarse) {
+    using enum HeightfieldChunks::StitchSide;
+    if ((i == 0 && (mask & STITCH_NEG_X)) || (i == n && (mask & STITCH_POS_X)))
+      j = j / coarse * coarse;
+    if ((j == 0 && (mask & STITCH_NEG_Y)) || (j == n && (mask & STITCH_POS_Y)))
+      i = i / coarse * coarse;
+    return j * (n + 1) + i;
+  }
+
+  /// Append the indices of a chunk pattern, skipping the primitives which
+  /// became degenerate after stitching.
+  static void addChunkPattern(std::vector<MeshData::IndexType> &indices,
+                              Uint32 n, Uint32 step, Uint32 mask, bool solid,
+                              bool flip) {
+    auto idx = [&](Uint32 i, Uint32 j) {
+      return stitchedIndex(i, j, n, mask, 2 * step);
+    };
+    auto add_line = [&](Uint32 a, Uint32 b) {
+      if (a != b)
+        indices.insert(indices.end(), {a, b});
+    };
+    auto add_triangle = [&](Uint32 a, Uint32 b, Uint32 c) {
+      if (a == b || b == c || a == c)
+        return;
+      if (flip)
+        std::swap(b, c);
+      indices.insert(indices.end(), {a, b, c});
+    };
+
+    for (Uint32 j = 0; j < n; j += step) {
+      for (Uint32 i = 0; i < n; i += step) {
+        const Uint32 a = idx(i, j);
+        const Uint32 b = idx(i + step, j);
+        const Uint32 c = idx(i + step, j + step);
+        const Uint32 d = idx(i, j + step);
+        if (solid) {
+          add_triangle(a, b, c);
+          add_triangle(a, c, d);
+        } else {
+          add_line(a, b);
+          add_line(a, d);
+          // close the far sides of the chunk
+          if (i + step == n)
+            add_line(b, c);
+          if (j + step == n)
+            add_line(d, c);
+        }
+      }
+    }
+  }
+} // namespace detail
+
+void HeightfieldChunks::selectLods(const Mat4f &modelMatrix,
+                                   const Float3 &cameraPos, float lodDistance,
+                                   std::span<Uint32> lods) const {
+  CANDLEWICK_ASSERT(lods.size() == numChunks(), "Wrong number of levels.");
+  CANDLEWICK_ASSERT(lodDistance > 0.f, "LOD distance must be positive.");
+  const float scale =
+      modelMatrix.topLeftCorner<3, 3>().colwise().norm().maxCoeff();
+  for (Uint32 k = 0; k < numChunks(); k++) {
+    const Float3 center =
+        (modelMatrix * bounds[k].center().cast<float>().homogeneous())
+            .head<3>();
+    const auto diagonal = (bounds[k].max_ - bounds[k].min_).cast<float>();
+    const float radius = 0.5f * scale * diagonal.norm();
+    const float dist = std::max((center - cameraPos).norm() - radius, 0.f);
+    const float ratio = dist / lodDistance;
+    Uint32 lod = 0;
+    if (ratio > 1.f)
+      lod = Uint32(std::ceil(std::log2(ratio)));
+    lods[k] = std::min(lod, numLods - 1);
+  }
+
+  // neighbours may differ by at most one level: only lower levels, until this
+  // holds everywhere
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Uint32 k = 0; k < numChunks(); k++) {
+      const Uint32 cx = k % chunksX;
+      const Uint32 cy = k / chunksX;
+      Uint32 min_neighbour = lods[k];
+      if (cx > 0)
+        min_neighbour = std::min(min_neighbour, lods[k - 1]);
+      if (cx + 1 < chunksX)
+        min_neighbour = std::min(min_neighbour, lods[k + 1]);
+      if (cy > 0)
+        min_neighbour = std::min(min_neighbour, lods[k - chunksX]);
+      if (cy + 1 < chunksY)
+        min_neighbour = std::min(min_neighbour, lods[k + chunksX]);
+      if (lods[k] > min_neighbour + 1) {
+        lods[k] = min_neighbour + 1;
+        changed = true;
+      }
+    }
+  }
+}
+
+Uint32 HeightfieldChunks::stitchMask(std::span<const Uint32> lods,
+                                     Uint32 chunk) const {
+  const Uint32 cx = chunk % chunksX;
+  const Uint32 cy = chunk / chunksX;
+  const Uint32 lod = lods[chunk];
+  Uint32 mask = 0;
+  if (cx > 0 && lods[chunk - 1] > lod)
+    mask |= STITCH_NEG_X;
+  if (cx + 1 < chunksX && lods[chunk + 1] > lod)
+    mask |= STITCH_POS_X;
+  if (cy > 0 && lods[chunk - chunksX] > lod)
+    mask |= STITCH_NEG_Y;
+  if (cy + 1 < chunksY && lods[chunk + chunksX] > lod)
+    mask |= STITCH_POS_Y;
+  return mask;
+}
+
+MeshData loadHeightfieldChunks(const Eigen::Ref<const Eigen::MatrixXf> &heights,
+                               const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+                               const Eigen::Ref<const Eigen::VectorXf> &ygrid,
+                               HeightfieldChunks &chunks, Uint32 chunkSize,
+                               bool solid) {
+  CANDLEWICK_ASSERT(
+      heights.rows() == xgrid.size(),
+      "Incompatible dimensions between x-grid and 'heights' matrix.");
+  CANDLEWICK_ASSERT(
+      heights.cols() == ygrid.size(),
+      "Incompatible dimensions between y-grid and 'heights' matrix.");
+  CANDLEWICK_ASSERT(heights.rows() >= 2 && heights.cols() >= 2,
+                    "Heightfield must have at least 2x2 heights.");
+  if (chunkSize < 2 || !std::has_single_bit(chunkSize))
+    terminate_with_message(
+        "Heightfield chunk size must be a power of two (got {:d}).", chunkSize);
+
+  const auto nx = (Sint32)heights.rows();
+  const auto ny = (Sint32)heights.cols();
+  const Uint32 n = chunkSize;
+  chunks.chunkSize = n;
+  chunks.numLods = Uint32(std::countr_zero(n)) + 1;
+  chunks.chunksX = (Uint32(nx - 1) + n - 1) / n;
+  chunks.chunksY = (Uint32(ny - 1) + n - 1) / n;
+  chunks.bounds.clear();
+  chunks.bounds.reserve(chunks.numChunks());
+  chunks.patterns.clear();
+
+  // Vertices: one block per chunk, padded past the end of the grid
+  auto grid_index = [n](Uint32 chunk_coord, Uint32 local, Sint32 size) {
+    return std::min(Sint32(chunk_coord * n + local), size - 1);
+  };
+  auto normal_at = [&](Sint32 i, Sint32 j) {
+    const Sint32 i0 = std::max(i - 1, 0), i1 = std::min(i + 1, nx - 1);
+    const Sint32 j0 = std::max(j - 1, 0), j1 = std::min(j + 1, ny - 1);
+    const float dzdx =
+        (heights(i1, j) - heights(i0, j)) / (xgrid[i1] - xgrid[i0]);
+    const float dzdy =
+        (heights(i, j1) - heights(i, j0)) / (ygrid[j1] - ygrid[j0]);
+    return Float3{-dzdx, -dzdy, 1.f}.normalized();
+  };
+
+  const Uint32 vertexCount = chunks.numChunks() * chunks.verticesPerChunk();
+  std::vector<PosOnlyVertex> lineVertices;
+  std::vector<DefaultVertex> solidVertices;
+  if (solid)
+    solidVertices.reserve(vertexCount);
+  else
+    lineVertices.reserve(vertexCount);
+
+  for (Uint32 cy = 0; cy < chunks.chunksY; cy++) {
+    for (Uint32 cx = 0; cx < chunks.chunksX; cx++) {
+      Float3 lo = Float3::Constant(std::numeric_limits<float>::max());
+      Float3 hi = -lo;
+      for (Uint32 j = 0; j <= n; j++) {
+        for (Uint32 i = 0; i <= n; i++) {
+          const Sint32 ih = grid_index(cx, i, nx);
+          const Sint32 jh = grid_index(cy, j, ny);
+          const Float3 pos{xgrid[ih], ygrid[jh], heights(ih, jh)};
+          lo = lo.cwiseMin(pos);
+          hi = hi.cwiseMax(pos);
+          if (solid) {
+            solidVertices.push_back({
+                .pos = pos,
+                .normal = normal_at(ih, jh),
+                .color = Float4::Ones(),
+                .tangent = Float3::Zero(),
+            });
+          } else {
+            lineVertices.emplace_back(pos);
+          }
+        }
+      }
+      chunks.bounds.emplace_back(lo.cast<coal::CoalScalar>(),
+                                 hi.cast<coal::CoalScalar>());
+    }
+  }
+
+  // Index patterns. Keep counter-clockwise triangles seen from above if one
+  // of the grids is decreasing (as e.g. for coal heightfields).
+  const bool flip = (xgrid[1] - xgrid[0]) * (ygrid[1] - ygrid[0]) < 0.f;
+  std::vector<MeshData::IndexType> indexData;
+  for (Uint32 lod = 0; lod < chunks.numLods; lod++) {
+    const bool coarsest = lod + 1 == chunks.numLods;
+    for (Uint32 mask = 0; mask < HeightfieldChunks::kNumStitchMasks; mask++) {
+      if (coarsest && mask > 0) {
+        // no coarser neighbour
+        chunks.patterns.push_back(chunks.patterns.back());
+        continue;
+      }
+      const Uint32 offset = Uint32(indexData.size());
+      detail::addChunkPattern(indexData, n, 1u << lod, mask, solid, flip);
+      chunks.patterns.push_back({offset, Uint32(indexData.size()) - offset});
+    }
+  }
+
+  if (solid)
+    return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    std::move(solidVertices), std::move(indexData)};
+  return MeshData{SDL_GPU_PRIMITIVETYPE_LINELIST, std::move(lineVertices),
+                  std::move(indexData)};
+}
+
+namespace detail {
+  struct alignas(16) GridIndexVertex {
+    GpuVec2 index;
+  };
+} // namespace detail
+
+template <> struct VertexTraits<detail::GridIndexVertex> {
+  static auto layout() {
+    return MeshLayout{}
+        .addBinding(0, sizeof(detail::GridIndexVertex))
+        .addAttribute(VertexAttrib::Position, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                      offsetof(detail::GridIndexVertex, index));
+  }
+};
+
+MeshData loadHeightfieldGrid(Uint32 nx, Uint32 ny) {
+  CANDLEWICK_ASSERT(nx >= 2 && ny >= 2,
+                    "Heightfield grid needs at least 2x2 points.");
+  std::vector<detail::GridIndexVertex> vertexData;
+  std::vector<MeshData::IndexType> indexData;
+  vertexData.reserve(nx * ny);
+  indexData.reserve(2 * ((nx - 1) * ny + nx * (ny - 1)));
+  for (Uint32 j = 0; j < ny; j++) {
+    for (Uint32 i = 0; i < nx; i++) {
+      vertexData.push_back({GpuVec2{float(i), float(j)}});
+      const Uint32 v = j * nx + i;
+      if (i != nx - 1)
+        indexData.insert(indexData.end(), {v, v + 1});
+      if (j != ny - 1)
+        indexData.insert(indexData.end(), {v, v + nx});
+    }
+  }
+  return MeshData{SDL_GPU_PRIMITIVETYPE_LINELIST, std::move(vertexData),
+                  std::move(indexData)};
+}
+
 } // namespace candlewick
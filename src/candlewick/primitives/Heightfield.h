@@ -1,7 +1,10 @@
 #pragma once
 
+#include "../core/Collision.h"
 #include "../utils/MeshData.h"
 
+#include <span>
+
 namespace candlewick {
 
 /// \brief Load a heightfield, as line geometry.
@@ -9,4 +12,97 @@ namespace candlewick {
 MeshData loadHeightfield(const Eigen::Ref<const Eigen::MatrixXf> &heights,
                          const Eigen::Ref<const Eigen::VectorXf> &xgrid,
                          const Eigen::Ref<const Eigen::VectorXf> &ygrid);
+
+/// \brief Layout of a heightfield mesh split into square chunks, with
+/// geomipmapped levels of detail (LODs).
+///
+/// Each chunk has its own block of \f$(C+1)^2\f$ vertices, where \f$C\f$ is the
+/// chunk size in cells. All chunks share the same index patterns, which index
+/// into the chunk's block (i.e. they are drawn with the block as vertex
+/// offset). Level \f$l\f$ only uses every \f$2^l\f$-th vertex along each
+/// direction.
+///
+/// To avoid cracks between neighbouring chunks, their levels must differ by at
+/// most one. There is a pattern for each level and each stitching mask: the
+/// sides of the chunk which border a coarser chunk have their odd vertices
+/// snapped onto the coarser ones.
+/// \sa loadHeightfieldChunks()
+struct HeightfieldChunks {
+  /// Bits of a stitching mask, set for the sides bordering a chunk with the
+  /// next coarser level.
+  enum StitchSide : Uint32 {
+    STITCH_NEG_X = 1u << 0,
+    STITCH_POS_X = 1u << 1,
+    STITCH_NEG_Y = 1u << 2,
+    STITCH_POS_Y = 1u << 3,
+  };
+  static constexpr Uint32 kNumStitchMasks = 16u;
+
+  struct IndexRange {
+    Uint32 indexOffset;
+    Uint32 indexCount;
+  };
+
+  /// Number of cells along each side of a chunk, a power of two.
+  Uint32 chunkSize;
+  Uint32 numLods;
+  Uint32 chunksX;
+  Uint32 chunksY;
+  /// Bounds of each chunk, in the heightfield frame. Chunks are stored
+  /// row-major, along x first.
+  std::vector<AABB> bounds;
+  /// Index patterns, by level then stitching mask.
+  std::vector<IndexRange> patterns;
+
+  Uint32 numChunks() const { return chunksX * chunksY; }
+  Uint32 verticesPerChunk() const { return (chunkSize + 1) * (chunkSize + 1); }
+  Uint32 chunkVertexOffset(Uint32 chunk) const {
+    return chunk * verticesPerChunk();
+  }
+  const IndexRange &pattern(Uint32 lod, Uint32 stitchMask) const {
+    return patterns[lod * kNumStitchMasks + stitchMask];
+  }
+
+  /// \brief Select the level of each chunk from its distance to the camera.
+  ///
+  /// Chunks closer than \p lodDistance use level 0, and the distance doubles
+  /// with each level. Levels are then lowered where needed so that neighbours
+  /// differ by at most one.
+  /// \param modelMatrix Placement of the heightfield in the world.
+  /// \param cameraPos Camera position, in the world.
+  /// \param lodDistance Distance up to which the finest level is used, must
+  /// be positive.
+  /// \param lods Output levels, of size numChunks().
+  void selectLods(const Mat4f &modelMatrix, const Float3 &cameraPos,
+                  float lodDistance, std::span<Uint32> lods) const;
+
+  /// \brief Stitching mask of a chunk, given the levels of all chunks.
+  Uint32 stitchMask(std::span<const Uint32> lods, Uint32 chunk) const;
+};
+
+/// \brief Load a heightfield split into chunks with levels of detail, as line
+/// geometry or as shaded triangles (with normals).
+///
+/// Grid sizes which are not a multiple of the chunk size are padded, by
+/// repeating the last row or column of heights.
+/// \param chunks Output chunk layout.
+/// \param chunkSize Number of cells along each side of a chunk, a power of two.
+/// \param solid Whether to output triangles instead of lines.
+/// \sa HeightfieldChunks
+/// \ingroup primitives1
+MeshData loadHeightfieldChunks(const Eigen::Ref<const Eigen::MatrixXf> &heights,
+                               const Eigen::Ref<const Eigen::VectorXf> &xgrid,
+                               const Eigen::Ref<const Eigen::VectorXf> &ygrid,
+                               HeightfieldChunks &chunks, Uint32 chunkSize = 64,
+                               bool solid = false);
+
+/// \brief Load a flat grid of \p nx by \p ny points, as line geometry, for
+/// heightfields displaced on the GPU.
+///
+/// The only vertex attribute is the (float) index of the grid point, as a
+/// two-component position. The same grid can be shared by all heightfields of
+/// that size.
+/// \sa HeightTexture
+/// \ingroup primitives1
+MeshData loadHeightfieldGrid(Uint32 nx, Uint32 ny);
 } // namespace candlewick
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include <zmq.hpp>
 #include <msgpack.hpp>
@@ -30,6 +34,102 @@ namespace runtime {
       return msgpack::object_handle();
   }
 
+  /// \brief Non-owning counterpart of ArrayMessage, which references the
+  /// buffer it was unpacked from.
+  /// \sa unpack_reference_all, get_array_view()
+  struct ArrayMessageView {
+    std::string_view dtype;
+    std::array<long, 2> dims{};
+    size_t ndim = 0;
+    const char *data = nullptr;
+    /// Payload size, in bytes.
+    size_t size = 0;
+  };
+
+  /// \brief msgpack::unpack_reference_func which makes unpacked str and bin
+  /// objects point into the input buffer instead of copying them to the zone.
+  inline bool unpack_reference_all(msgpack::type::object_type, std::size_t,
+                                   void *) {
+    return true;
+  }
+
+  /// \brief Read an ArrayMessage packed as `[dtype, dims, data]` into a view,
+  /// without copying its payload.
+  /// \returns Whether \p obj has the expected layout (at most two dims).
+  inline bool get_array_view(const msgpack::object &obj,
+                             ArrayMessageView &out) {
+    using msgpack::type::object_type;
+    if (obj.type != object_type::ARRAY || obj.via.array.size != 3)
+      return false;
+    const msgpack::object &dtype = obj.via.array.ptr[0];
+    const msgpack::object &dims = obj.via.array.ptr[1];
+    const msgpack::object &data = obj.via.array.ptr[2];
+    if (dtype.type != object_type::STR || dims.type != object_type::ARRAY ||
+        dims.via.array.size > out.dims.size())
+      return false;
+    out.dtype = {dtype.via.str.ptr, dtype.via.str.size};
+    out.ndim = dims.via.array.size;
+    for (size_t i = 0; i < out.ndim; i++) {
+      const msgpack::object &d = dims.via.array.ptr[i];
+      if (d.type != object_type::POSITIVE_INTEGER)
+        return false;
+      out.dims[i] = long(d.via.u64);
+    }
+    if (data.type == object_type::BIN) {
+      out.data = data.via.bin.ptr;
+      out.size = data.via.bin.size;
+    } else if (data.type == object_type::STR) {
+      out.data = data.via.str.ptr;
+      out.size = data.via.str.size;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Map a vector of doubles onto the payload of \p view.
+  ///
+  /// msgpack headers leave bin payloads at arbitrary offsets in the message,
+  /// so misaligned payloads are first copied to \p scratch, which only
+  /// allocates when its size changes.
+  /// \returns An empty map if \p view does not hold a `float64` vector.
+  inline Eigen::Map<const Eigen::VectorXd>
+  get_vector_map(const ArrayMessageView &view, Eigen::VectorXd &scratch) {
+    using MapType = Eigen::Map<const Eigen::VectorXd>;
+    const Eigen::Index n = view.ndim ? view.dims[0] : 0;
+    if (view.dtype != "float64" || view.ndim != 1 ||
+        view.size != size_t(n) * sizeof(double))
+      return MapType{nullptr, 0};
+    if (reinterpret_cast<std::uintptr_t>(view.data) % alignof(double) == 0)
+      return MapType{reinterpret_cast<const double *>(view.data), n};
+    scratch.resize(n);
+    std::memcpy(scratch.data(), view.data, view.size);
+    return MapType{scratch.data(), n};
+  }
+
+  /// \brief Map a row-major `N x K` array of \p dtype onto the payload of
+  /// \p view, as the `K x N` column-major matrix with the same memory (e.g.
+  /// one column per point).
+  ///
+  /// Misaligned payloads are first copied to \p scratch, as in
+  /// get_vector_map().
+  /// \returns An empty map if \p view does not hold such an array.
+  template <typename Scalar, int K>
+  Eigen::Map<const Eigen::Matrix<Scalar, K, Eigen::Dynamic>>
+  get_columns_map(const ArrayMessageView &view, std::string_view dtype,
+                  Eigen::Matrix<Scalar, K, Eigen::Dynamic> &scratch) {
+    using MapType = Eigen::Map<const Eigen::Matrix<Scalar, K, Eigen::Dynamic>>;
+    const Eigen::Index n = view.ndim ? view.dims[0] : 0;
+    if (view.dtype != dtype || view.ndim != 2 || view.dims[1] != K ||
+        view.size != size_t(n) * K * sizeof(Scalar))
+      return MapType{nullptr, K, 0};
+    if (reinterpret_cast<std::uintptr_t>(view.data) % alignof(Scalar) == 0)
+      return MapType{reinterpret_cast<const Scalar *>(view.data), K, n};
+    scratch.resize(K, n);
+    std::memcpy(scratch.data(), view.data, view.size);
+    return MapType{scratch.data(), K, n};
+  }
+
   namespace detail {
     template <typename S, typename T>
     using add_const_if_const_t =
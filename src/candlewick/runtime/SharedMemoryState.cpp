@@ -0,0 +1,216 @@
+#include "SharedMemoryState.h"
+#include "../core/errors.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace candlewick {
+namespace runtime {
+
+  // POSIX shared memory object names start with a slash, which Python's
+  // multiprocessing.shared_memory adds implicitly.
+  static std::string posix_shm_name(std::string_view name) {
+    if (name.empty())
+      terminate_with_message("Shared memory segment name cannot be empty.");
+    if (name.front() == '/')
+      return std::string{name};
+    return "/" + std::string{name};
+  }
+
+  static size_t segment_size(Uint32 nq, Uint32 nv) {
+    return SharedMemoryState::kDataOffset + sizeof(double) * (size_t(nq) + nv);
+  }
+
+  static void *map_segment(int fd, size_t size, const std::string &name) {
+    void *ptr =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      const int err = errno;
+      close(fd);
+      terminate_with_message("Failed to map shared memory segment {:s}: {:s}",
+                             name, std::strerror(err));
+    }
+    close(fd);
+    return ptr;
+  }
+
+  template <typename T> static T &field(void *ptr, size_t offset) {
+    return *reinterpret_cast<T *>(static_cast<char *>(ptr) + offset);
+  }
+
+  SharedMemoryState SharedMemoryState::create(std::string_view name, Uint32 nq,
+                                              Uint32 nv) {
+    SharedMemoryState shm;
+    shm.m_name = posix_shm_name(name);
+    shm.m_size = segment_size(nq, nv);
+    shm.m_nq = nq;
+    shm.m_nv = nv;
+
+    // remove a stale segment left by a crashed process
+    shm_unlink(shm.m_name.c_str());
+    int fd = shm_open(shm.m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+      terminate_with_message("Failed to create shared memory segment {:s}: "
+                             "{:s}",
+                             shm.m_name, std::strerror(errno));
+    if (ftruncate(fd, off_t(shm.m_size)) != 0) {
+      const int err = errno;
+      close(fd);
+      shm_unlink(shm.m_name.c_str());
+      terminate_with_message("Failed to resize shared memory segment {:s}: "
+                             "{:s}",
+                             shm.m_name, std::strerror(err));
+    }
+    shm.m_ptr = map_segment(fd, shm.m_size, shm.m_name);
+    shm.m_owner = true;
+
+    // ftruncate zero-fills the segment; write the magic number last so that
+    // clients never see a partial header
+    field<Uint32>(shm.m_ptr, 4) = kVersion;
+    field<Uint32>(shm.m_ptr, 8) = nq;
+    field<Uint32>(shm.m_ptr, 12) = nv;
+    std::atomic_ref<Uint32>{field<Uint32>(shm.m_ptr, 0)}.store(
+        kMagic, std::memory_order_release);
+    return shm;
+  }
+
+  SharedMemoryState SharedMemoryState::open(std::string_view name) {
+    SharedMemoryState shm;
+    shm.m_name = posix_shm_name(name);
+    int fd = shm_open(shm.m_name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+      terminate_with_message("Failed to open shared memory segment {:s}: {:s}",
+                             shm.m_name, std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < kDataOffset) {
+      close(fd);
+      terminate_with_message("Shared memory segment {:s} is not initialized.",
+                             shm.m_name);
+    }
+    shm.m_size = size_t(st.st_size);
+    shm.m_ptr = map_segment(fd, shm.m_size, shm.m_name);
+
+    const Uint32 magic = std::atomic_ref<Uint32>{field<Uint32>(shm.m_ptr, 0)}
+                             .load(std::memory_order_acquire);
+    const Uint32 version = field<Uint32>(shm.m_ptr, 4);
+    if (magic != kMagic || version != kVersion)
+      terminate_with_message("Shared memory segment {:s} has an unexpected "
+                             "header (magic {:#x}, version {:d}).",
+                             shm.m_name, magic, version);
+    shm.m_nq = field<Uint32>(shm.m_ptr, 8);
+    shm.m_nv = field<Uint32>(shm.m_ptr, 12);
+    if (shm.m_size < segment_size(shm.m_nq, shm.m_nv))
+      terminate_with_message("Shared memory segment {:s} is too small.",
+                             shm.m_name);
+    return shm;
+  }
+
+  SharedMemoryState::SharedMemoryState(SharedMemoryState &&other) noexcept
+      : m_name(std::move(other.m_name))
+      , m_ptr(std::exchange(other.m_ptr, nullptr))
+      , m_size(other.m_size)
+      , m_nq(other.m_nq)
+      , m_nv(other.m_nv)
+      , m_lastRead(other.m_lastRead)
+      , m_velocity(std::move(other.m_velocity))
+      , m_owner(std::exchange(other.m_owner, false)) {}
+
+  SharedMemoryState &
+  SharedMemoryState::operator=(SharedMemoryState &&other) noexcept {
+    if (this != &other) {
+      this->release();
+      m_name = std::move(other.m_name);
+      m_ptr = std::exchange(other.m_ptr, nullptr);
+      m_size = other.m_size;
+      m_nq = other.m_nq;
+      m_nv = other.m_nv;
+      m_lastRead = other.m_lastRead;
+      m_velocity = std::move(other.m_velocity);
+      m_owner = std::exchange(other.m_owner, false);
+    }
+    return *this;
+  }
+
+  Uint64 *SharedMemoryState::sequence() const {
+    return &field<Uint64>(m_ptr, kSequenceOffset);
+  }
+
+  double *SharedMemoryState::data() const {
+    return &field<double>(m_ptr, kDataOffset);
+  }
+
+  Uint64 SharedMemoryState::numWrites() const {
+    return std::atomic_ref<Uint64>{*sequence()}.load(
+               std::memory_order_acquire) /
+           2;
+  }
+
+  void SharedMemoryState::write(const Eigen::Ref<const Eigen::VectorXd> &q,
+                                const Eigen::Ref<const Eigen::VectorXd> &v) {
+    if (q.size() != m_nq || (v.size() != 0 && v.size() != m_nv))
+      terminate_with_message("Expected q and v of sizes ({:d}, {:d}), got "
+                             "({:d}, {:d}).",
+                             m_nq, m_nv, q.size(), v.size());
+    std::atomic_ref<Uint64> seq{*sequence()};
+    const Uint64 s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    double *out = data();
+    std::memcpy(out, q.data(), sizeof(double) * m_nq);
+    if (v.size())
+      std::memcpy(out + m_nq, v.data(), sizeof(double) * m_nv);
+    field<Uint32>(m_ptr, kHasVelocityOffset) = v.size() ? 1u : 0u;
+
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  bool SharedMemoryState::read(Eigen::VectorXd &q, Eigen::VectorXd &v) {
+    std::atomic_ref<Uint64> seq{*sequence()};
+    q.resize(m_nq);
+    m_velocity.resize(m_nv);
+    for (Uint32 attempt = 0; attempt < kMaxReadRetries; attempt++) {
+      const Uint64 s1 = seq.load(std::memory_order_acquire);
+      if (s1 == m_lastRead)
+        return false;
+      if (s1 & 1)
+        continue; // write in progress
+
+      const double *in = data();
+      std::memcpy(q.data(), in, sizeof(double) * m_nq);
+      std::memcpy(m_velocity.data(), in + m_nq, sizeof(double) * m_nv);
+      const Uint32 has_v = field<Uint32>(m_ptr, kHasVelocityOffset);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq.load(std::memory_order_relaxed) != s1)
+        continue;
+      m_lastRead = s1;
+      if (has_v)
+        v = m_velocity;
+      else
+        v.resize(0);
+      return true;
+    }
+    return false;
+  }
+
+  void SharedMemoryState::release() noexcept {
+    if (!m_ptr)
+      return;
+    munmap(m_ptr, m_size);
+    m_ptr = nullptr;
+    if (m_owner) {
+      shm_unlink(m_name.c_str());
+      m_owner = false;
+    }
+  }
+
+} // namespace runtime
+} // namespace candlewick
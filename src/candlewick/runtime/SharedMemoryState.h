@@ -0,0 +1,99 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <Eigen/Core>
+
+#include <string>
+#include <string_view>
+
+namespace candlewick {
+namespace runtime {
+
+  /// \brief Same-host transport for robot states, through a POSIX shared
+  /// memory segment protected by a seqlock.
+  ///
+  /// The segment holds a single fixed-layout record with the latest joint
+  /// configuration `q` and velocity `v` of the loaded model. Writers never
+  /// block, and readers retry when they observe a write in progress. Readers
+  /// only ever see the latest record: intermediate states published faster
+  /// than the reader polls are skipped, which is what a visualizer wants.
+  ///
+  /// The segment layout is (native byte order):
+  /// | offset | type         | contents                                  |
+  /// |--------|--------------|-------------------------------------------|
+  /// | 0      | `uint32`     | magic number, `kMagic`                    |
+  /// | 4      | `uint32`     | layout version, `kVersion`                |
+  /// | 8      | `uint32`     | `nq`                                      |
+  /// | 12     | `uint32`     | `nv`                                      |
+  /// | 64     | `uint64`     | sequence number, odd during writes        |
+  /// | 72     | `uint32`     | whether `v` is valid                      |
+  /// | 128    | `float64[]`  | `q`, followed by `v`                      |
+  ///
+  /// \note Only one writer is supported at a time.
+  class SharedMemoryState {
+  public:
+    static constexpr Uint32 kMagic = 0x53574443; // "CDWS"
+    static constexpr Uint32 kVersion = 1;
+    static constexpr size_t kSequenceOffset = 64;
+    static constexpr size_t kHasVelocityOffset = 72;
+    static constexpr size_t kDataOffset = 128;
+    /// Number of attempts of read() before giving up, e.g. if the writer
+    /// died in the middle of a write.
+    static constexpr Uint32 kMaxReadRetries = 1024;
+
+    /// \brief Create (or replace) the segment \p name, sized for a model with
+    /// \p nq and \p nv. The segment is unlinked when the returned object is
+    /// destroyed.
+    static SharedMemoryState create(std::string_view name, Uint32 nq,
+                                    Uint32 nv);
+
+    /// \brief Open an existing segment, e.g. from a client process.
+    static SharedMemoryState open(std::string_view name);
+
+    SharedMemoryState(const SharedMemoryState &) = delete;
+    SharedMemoryState &operator=(const SharedMemoryState &) = delete;
+    SharedMemoryState(SharedMemoryState &&other) noexcept;
+    SharedMemoryState &operator=(SharedMemoryState &&other) noexcept;
+    ~SharedMemoryState() noexcept { this->release(); }
+
+    /// \brief Publish a new state. \p v can be empty, in which case readers
+    /// are told that the velocity is not valid.
+    void write(const Eigen::Ref<const Eigen::VectorXd> &q,
+               const Eigen::Ref<const Eigen::VectorXd> &v = Eigen::VectorXd{});
+
+    /// \brief Copy out the latest state, if it was not already read.
+    ///
+    /// \param[out] q Resized to `nq`.
+    /// \param[out] v Resized to `nv` if the writer provided a velocity, and to
+    /// zero otherwise.
+    /// \returns Whether a new state was read. This is false if no consistent
+    /// state could be read in `kMaxReadRetries` attempts, in which case the
+    /// contents of \p q are unspecified.
+    bool read(Eigen::VectorXd &q, Eigen::VectorXd &v);
+
+    Uint32 nq() const { return m_nq; }
+    Uint32 nv() const { return m_nv; }
+    const std::string &name() const { return m_name; }
+    /// \brief Number of states published so far.
+    Uint64 numWrites() const;
+
+    void release() noexcept;
+
+  private:
+    SharedMemoryState() = default;
+    Uint64 *sequence() const;
+    double *data() const;
+
+    std::string m_name;
+    void *m_ptr = nullptr;
+    size_t m_size = 0;
+    Uint32 m_nq = 0;
+    Uint32 m_nv = 0;
+    Uint64 m_lastRead = 0;
+    /// Velocity read buffer, only copied out if the velocity is valid.
+    Eigen::VectorXd m_velocity;
+    bool m_owner = false;
+  };
+
+} // namespace runtime
+} // namespace candlewick
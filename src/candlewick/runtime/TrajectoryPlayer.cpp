@@ -0,0 +1,98 @@
+#include "TrajectoryPlayer.h"
+#include "candlewick/core/errors.h"
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace candlewick {
+namespace runtime {
+
+  void TrajectoryPlayer::load(Eigen::MatrixXd qs, Eigen::MatrixXd vs,
+                              std::vector<double> times) {
+    const auto T = Eigen::Index(times.size());
+    if (T == 0)
+      terminate_with_message("Trajectory cannot be empty.");
+    if (qs.rows() != m_model->nq || qs.cols() != T)
+      terminate_with_message("Expected configurations of shape ({:d}, {:d}), "
+                             "got ({:d}, {:d}).",
+                             T, m_model->nq, qs.cols(), qs.rows());
+    if (vs.size() && (vs.rows() != m_model->nv || vs.cols() != T))
+      terminate_with_message("Expected velocities of shape ({:d}, {:d}), got "
+                             "({:d}, {:d}).",
+                             T, m_model->nv, vs.cols(), vs.rows());
+    if (std::adjacent_find(times.begin(), times.end(),
+                           std::greater_equal<>{}) != times.end())
+      terminate_with_message("Trajectory timestamps must be strictly "
+                             "increasing.");
+
+    m_qs = std::move(qs);
+    m_vs = std::move(vs);
+    m_times = std::move(times);
+    m_time = m_times.front();
+    m_playing = false;
+  }
+
+  void TrajectoryPlayer::clear() {
+    m_qs.resize(0, 0);
+    m_vs.resize(0, 0);
+    m_times.clear();
+    m_time = 0.;
+    m_playing = false;
+  }
+
+  void TrajectoryPlayer::seek(double t) {
+    if (!loaded())
+      return;
+    m_time = std::clamp(t, startTime(), endTime());
+  }
+
+  void TrajectoryPlayer::advance(double dt) {
+    if (!m_playing)
+      return;
+    m_time += m_rate * dt;
+    const double start = startTime();
+    const double end = endTime();
+    const double duration = end - start;
+    if (m_time >= start && m_time <= end)
+      return;
+    if (m_loop && duration > 0.) {
+      m_time = start + std::fmod(m_time - start, duration);
+      if (m_time < start)
+        m_time += duration; // playing backwards
+    } else {
+      m_time = std::clamp(m_time, start, end);
+      m_playing = false;
+    }
+  }
+
+  void TrajectoryPlayer::evaluate(Eigen::VectorXd &q,
+                                  Eigen::VectorXd &v) const {
+    if (!loaded())
+      terminate_with_message("No trajectory loaded.");
+    if (m_times.size() == 1) {
+      q = m_qs.col(0);
+      v = m_vs.size() ? Eigen::VectorXd(m_vs.col(0)) : Eigen::VectorXd();
+      return;
+    }
+    // first waypoint strictly after the current time
+    const auto it = std::upper_bound(m_times.begin(), m_times.end(), m_time);
+    const size_t k1 = std::clamp<size_t>(size_t(it - m_times.begin()), 1,
+                                         m_times.size() - 1);
+    const size_t k0 = k1 - 1;
+    const double alpha = std::clamp(
+        (m_time - m_times[k0]) / (m_times[k1] - m_times[k0]), 0., 1.);
+
+    q.resize(m_model->nq);
+    const auto i0 = Eigen::Index(k0);
+    const auto i1 = Eigen::Index(k1);
+    pin::interpolate(*m_model, m_qs.col(i0), m_qs.col(i1), alpha, q);
+    if (m_vs.size())
+      v = (1. - alpha) * m_vs.col(i0) + alpha * m_vs.col(i1);
+    else
+      v.resize(0);
+  }
+
+} // namespace runtime
+} // namespace candlewick
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <pinocchio/multibody/model.hpp>
+
+#include <vector>
+
+namespace candlewick {
+namespace runtime {
+  namespace pin = pinocchio;
+
+  /// \brief Play back a timed trajectory uploaded to the runtime, at a chosen
+  /// rate.
+  ///
+  /// Configurations are interpolated on the configuration manifold with
+  /// pinocchio::interpolate(), and velocities linearly.
+  class TrajectoryPlayer {
+  public:
+    explicit TrajectoryPlayer(const pin::Model &model) : m_model(&model) {}
+
+    /// \brief Load a trajectory, replacing the current one. Playback is
+    /// paused at the first waypoint.
+    /// \param qs Configurations, one per column (`nq x T`).
+    /// \param vs Velocities, one per column (`nv x T`), or empty.
+    /// \param times Strictly increasing timestamps, of size `T`.
+    void load(Eigen::MatrixXd qs, Eigen::MatrixXd vs,
+              std::vector<double> times);
+
+    void clear();
+
+    bool loaded() const { return !m_times.empty(); }
+    bool playing() const { return m_playing; }
+
+    void play() { m_playing = loaded(); }
+    void pause() { m_playing = false; }
+
+    /// \brief Move the playback head to time \p t (clamped to the
+    /// trajectory's time range).
+    void seek(double t);
+
+    /// \brief Playback rate, e.g. 1 for real-time and 0.5 for half speed.
+    void setRate(double rate) { m_rate = rate; }
+    double rate() const { return m_rate; }
+
+    /// \brief Whether to restart from the beginning when reaching the end.
+    void setLoop(bool loop) { m_loop = loop; }
+    bool loop() const { return m_loop; }
+
+    /// \brief Current trajectory time.
+    double time() const { return m_time; }
+    double startTime() const { return loaded() ? m_times.front() : 0.; }
+    double endTime() const { return loaded() ? m_times.back() : 0.; }
+
+    /// \brief Advance playback by \p dt seconds of wall-clock time, if playing.
+    /// Playback stops at the end of the trajectory, unless looping.
+    void advance(double dt);
+
+    /// \brief Compute the state at the current time.
+    /// \param[out] v Set to zero size if the trajectory has no velocities.
+    void evaluate(Eigen::VectorXd &q, Eigen::VectorXd &v) const;
+
+  private:
+    const pin::Model *m_model;
+    Eigen::MatrixXd m_qs;
+    Eigen::MatrixXd m_vs;
+    std::vector<double> m_times;
+    double m_time = 0.;
+    double m_rate = 1.;
+    bool m_playing = false;
+    bool m_loop = false;
+  };
+
+} // namespace runtime
+} // namespace candlewick
@@ -1,6 +1,10 @@
 #include "candlewick/multibody/Multibody.h"
 #include "candlewick/multibody/Visualizer.h"
 #include "Messages.h"
+#include "TrajectoryPlayer.h"
+#ifndef _WIN32
+#include "SharedMemoryState.h"
+#endif
 
 #include <pinocchio/serialization/model.hpp>
 #include <pinocchio/serialization/geometry.hpp>
@@ -16,6 +20,10 @@
 
 #include <spdlog/cfg/env.h>
 
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
 namespace cdw = candlewick;
 namespace pin = pinocchio;
 using namespace cdw::runtime;
@@ -25,15 +33,42 @@ using cdw::multibody::Visualizer;
   constexpr std::string_view CMD_##name = #name
 
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(send_models);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(add_robot);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(add_robot_instance);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(state_update);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(point_cloud);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(send_cam_pose);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(reset_camera);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(start_recording);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(stop_recording);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(clean);
 CANDLEWICK_RUNTIME_DEFINE_COMMAND(toggle_gui);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(get_runtime_stats);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(send_trajectory);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(play_trajectory);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(pause_trajectory);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(seek_trajectory);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(set_trajectory_rate);
+CANDLEWICK_RUNTIME_DEFINE_COMMAND(set_trajectory_loop);
 
 using RowMat4d = Eigen::Matrix<pin::context::Scalar, 4, 4, Eigen::RowMajor>;
+using RowMatXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                               Eigen::RowMajor>;
+
+/// Counters for the state stream, sent back by the get_runtime_stats command.
+struct RuntimeStats {
+  /// Number of rendered frames.
+  Uint64 frames = 0;
+  /// Number of states received, over ZMQ or shared memory.
+  Uint64 received = 0;
+  /// Number of states applied, at most one per robot and frame.
+  Uint64 applied = 0;
+  /// Number of states which were superseded by a newer one before being
+  /// displayed.
+  Uint64 dropped = 0;
+
+  MSGPACK_DEFINE_MAP(frames, received, applied, dropped);
+};
 
 struct ApplicationContext {
   pin::Model model;
@@ -42,6 +77,14 @@ struct ApplicationContext {
   zmq::context_t ctx{};
   zmq::socket_t sync_sock{ctx, zmq::socket_type::rep};
   zmq::socket_t state_sock{ctx, zmq::socket_type::sub};
+#ifndef _WIN32
+  std::optional<SharedMemoryState> state_shm;
+#endif
+  RuntimeStats stats;
+  TrajectoryPlayer trajectory{model};
+  /// Whether the trajectory time was changed by a command, so that its state
+  /// should be displayed even if paused.
+  bool trajectory_changed = false;
 };
 
 /// Handle first incoming message.
@@ -80,8 +123,109 @@ bool handle_first_message(ApplicationContext &app_ctx) {
   return false;
 }
 
+/// Add a named robot, sent as a `(name, model, visual_model)` tuple of
+/// strings. Its states are published under the `state_update/<name>` topic.
+void add_robot(Visualizer &viz, zmq::message_t &&payload) {
+  auto oh = get_handle_from_zmq_msg(std::move(payload));
+  std::tuple<std::string, std::string, std::string> strings;
+  oh.get().convert(strings);
+  const auto &[name, model_str, geom_str] = strings;
+  pin::Model model;
+  pin::GeometryModel visual_model;
+  model.loadFromString(model_str);
+  visual_model.loadFromString(geom_str);
+  viz.addRobot(name, model, visual_model);
+}
+
+/// Load a trajectory sent as a `(q, v, times)` tuple of arrays, with q of
+/// shape `T x nq`, v of shape `T x nv` or None, and times of size `T`.
+void load_trajectory(TrajectoryPlayer &player, zmq::message_t &&payload) {
+  auto oh = get_handle_from_zmq_msg(std::move(payload));
+  std::tuple<ArrayMessage, std::optional<ArrayMessage>, ArrayMessage> arrays;
+  oh.get().convert(arrays);
+  const auto &[q_msg, v_msg, t_msg] = arrays;
+  // the payload is mapped as is, its size must match the dimensions
+  auto check_array = [](const ArrayMessage &msg, size_t ndim,
+                        const char *name) {
+    if (msg.dtype != "float64" || msg.ndim() != ndim)
+      cdw::terminate_with_message("Expected a {:d}D float64 array for {:s}.",
+                                  ndim, name);
+    // stop once the expected size exceeds the payload, before the product
+    // can overflow
+    bool valid = true;
+    size_t size = sizeof(double);
+    for (long dim : msg.dims) {
+      if (dim < 0 || (dim > 0 && size > msg.data.size() / size_t(dim))) {
+        valid = false;
+        break;
+      }
+      size *= size_t(dim);
+    }
+    if (!valid || msg.data.size() != size)
+      cdw::terminate_with_message("Data of {:s} ({:d} bytes) does not match "
+                                  "its dimensions.",
+                                  name, msg.data.size());
+  };
+  check_array(q_msg, 2, "q");
+  Eigen::MatrixXd qs = get_eigen_view_from_spec<RowMatXd>(q_msg).transpose();
+  Eigen::MatrixXd vs;
+  if (v_msg) {
+    check_array(*v_msg, 2, "v");
+    vs = get_eigen_view_from_spec<RowMatXd>(*v_msg).transpose();
+  }
+  check_array(t_msg, 1, "times");
+  auto t_view = get_eigen_view_from_spec<Eigen::VectorXd>(t_msg);
+  std::vector<double> times(t_view.begin(), t_view.end());
+  player.load(std::move(qs), std::move(vs), std::move(times));
+}
+
+double unpack_double(zmq::message_t &&payload) {
+  return get_handle_from_zmq_msg(std::move(payload)).get().as<double>();
+}
+
+/// Route trajectory playback commands.
+/// \returns Whether \p header was a trajectory command.
+bool trajectory_router(ApplicationContext &app_ctx, std::string_view header,
+                       zmq::message_t &&payload) {
+  TrajectoryPlayer &player = app_ctx.trajectory;
+  zmq::socket_t &sync_sock = app_ctx.sync_sock;
+  try {
+    if (header == CMD_send_trajectory) {
+      load_trajectory(player, std::move(payload));
+      spdlog::info("Loaded trajectory over [{:.3f}, {:.3f}]s",
+                   player.startTime(), player.endTime());
+    } else if (header == CMD_play_trajectory) {
+      if (!player.loaded())
+        cdw::terminate_with_message("No trajectory loaded.");
+      // restart a trajectory which was played through
+      if (player.time() >= player.endTime() && player.rate() > 0.)
+        player.seek(player.startTime());
+      player.play();
+    } else if (header == CMD_pause_trajectory) {
+      player.pause();
+    } else if (header == CMD_seek_trajectory) {
+      player.seek(unpack_double(std::move(payload)));
+    } else if (header == CMD_set_trajectory_rate) {
+      player.setRate(unpack_double(std::move(payload)));
+    } else if (header == CMD_set_trajectory_loop) {
+      player.setLoop(
+          get_handle_from_zmq_msg(std::move(payload)).get().as<bool>());
+    } else {
+      return false;
+    }
+  } catch (const std::exception &err) {
+    std::string err_msg{err.what()};
+    sync_sock.send(zmq::message_t(err_msg));
+    return true;
+  }
+  app_ctx.trajectory_changed = player.loaded();
+  sync_sock.send(zmq::str_buffer("ok"));
+  return true;
+}
+
 void pull_socket_router(Visualizer &viz, std::span<zmq::message_t, 2> msgs,
-                        zmq::socket_ref sync_sock) {
+                        ApplicationContext &app_ctx) {
+  zmq::socket_t &sync_sock = app_ctx.sync_sock;
   auto header = msgs[0].to_string_view();
   if (header == CMD_send_cam_pose) {
     auto oh = get_handle_from_zmq_msg(std::move(msgs[1]));
@@ -102,6 +246,22 @@ void pull_socket_router(Visualizer &viz, std::span<zmq::message_t, 2> msgs,
   } else if (header == CMD_send_models) {
     sync_sock.send(
         zmq::str_buffer("error: visualizer already has models open."));
+  } else if (header == CMD_add_robot || header == CMD_add_robot_instance) {
+    try {
+      if (header == CMD_add_robot) {
+        add_robot(viz, std::move(msgs[1]));
+      } else {
+        // (name, source), with an empty source for the main robot
+        auto oh = get_handle_from_zmq_msg(std::move(msgs[1]));
+        auto [name, source] =
+            oh.get().as<std::tuple<std::string, std::string>>();
+        viz.addRobotInstance(name, source);
+      }
+      sync_sock.send(zmq::str_buffer("ok"));
+    } catch (const std::exception &err) {
+      std::string err_msg{err.what()};
+      sync_sock.send(zmq::message_t(err_msg));
+    }
   } else if (header == CMD_start_recording) {
     auto filename = msgs[1].to_string_view();
     try {
@@ -114,46 +274,278 @@ void pull_socket_router(Visualizer &viz, std::span<zmq::message_t, 2> msgs,
   } else if (header == CMD_stop_recording) {
     char data{viz.stopRecording()};
     sync_sock.send(zmq::buffer(&data, 1));
+  } else if (header == CMD_get_runtime_stats) {
+    msgpack::sbuffer buf;
+    msgpack::pack(buf, app_ctx.stats);
+    sync_sock.send(zmq::buffer(buf.data(), buf.size()));
+  } else {
+    trajectory_router(app_ctx, header, std::move(msgs[1]));
   }
 }
 
+/// Persistent storage for decoding state updates, such that the steady state
+/// does not allocate.
+struct StateDecoder {
+  /// Only holds the msgpack object tree: payloads are referenced in place.
+  msgpack::zone zone;
+  /// Copies of misaligned payloads.
+  Eigen::VectorXd q_scratch;
+  Eigen::VectorXd v_scratch;
+};
+
+/// Decode a `(q, v)` state update and run forward kinematics, reading q and v
+/// directly from the message's memory. Returns false if the message is
+/// invalid, with the reason logged at debug level.
+bool apply_state_update(const pin::Model &model, pin::Data &data,
+                        const zmq::message_t &payload, StateDecoder &decoder) {
+  using msgpack::type::object_type;
+  decoder.zone.clear();
+  std::size_t offset = 0;
+  msgpack::object obj;
+  try {
+    obj = msgpack::unpack(decoder.zone,
+                          static_cast<const char *>(payload.data()),
+                          payload.size(), offset, unpack_reference_all);
+  } catch (const msgpack::unpack_error &err) {
+    spdlog::debug("Failed to unpack state update: {:s}", err.what());
+    return false;
+  }
+
+  ArrayMessageView q_msg, v_msg;
+  bool has_v = false;
+  bool valid = obj.type == object_type::ARRAY && obj.via.array.size == 2 &&
+               get_array_view(obj.via.array.ptr[0], q_msg);
+  if (valid && obj.via.array.ptr[1].type != object_type::NIL) {
+    has_v = true;
+    valid = get_array_view(obj.via.array.ptr[1], v_msg);
+  }
+  if (!valid) {
+    spdlog::debug("Invalid state update: expected a (q, v) pair of arrays.");
+    return false;
+  }
+
+  auto q = get_vector_map(q_msg, decoder.q_scratch);
+  if (q.size() != model.nq) {
+    spdlog::debug("Invalid state update: expected q of size {:d} (float64).",
+                  model.nq);
+    return false;
+  }
+  if (!has_v) {
+    pin::forwardKinematics(model, data, q);
+    return true;
+  }
+  auto v = get_vector_map(v_msg, decoder.v_scratch);
+  if (v.size() != model.nv) {
+    spdlog::debug("Invalid state update: expected v of size {:d} (float64).",
+                  model.nv);
+    return false;
+  }
+  pin::forwardKinematics(model, data, q, v);
+  return true;
+}
+
+/// Persistent storage for decoding point cloud updates.
+struct PointCloudDecoder {
+  msgpack::zone zone;
+  Eigen::Matrix3Xf positions_scratch;
+  cdw::PointCloud::ColorMatrix colors_scratch;
+};
+
+/// Decode a `(positions, colors)` point cloud update, with positions a `N x 3`
+/// float32 array and colors a `N x 4` uint8 array or None, and copy it to the
+/// point cloud's transfer buffer directly from the message's memory. Returns
+/// false if the message is invalid, with the reason logged at debug level.
+bool apply_point_cloud(Visualizer &viz, std::string_view name,
+                       const zmq::message_t &payload,
+                       PointCloudDecoder &decoder) {
+  using msgpack::type::object_type;
+  decoder.zone.clear();
+  std::size_t offset = 0;
+  msgpack::object obj;
+  try {
+    obj = msgpack::unpack(decoder.zone,
+                          static_cast<const char *>(payload.data()),
+                          payload.size(), offset, unpack_reference_all);
+  } catch (const msgpack::unpack_error &err) {
+    spdlog::debug("Failed to unpack point cloud: {:s}", err.what());
+    return false;
+  }
+
+  ArrayMessageView pos_msg, col_msg;
+  bool has_colors = false;
+  bool valid = obj.type == object_type::ARRAY && obj.via.array.size == 2 &&
+               get_array_view(obj.via.array.ptr[0], pos_msg);
+  if (valid && obj.via.array.ptr[1].type != object_type::NIL) {
+    has_colors = true;
+    valid = get_array_view(obj.via.array.ptr[1], col_msg);
+  }
+  auto positions = get_columns_map<float, 3>(pos_msg, "float32",
+                                             decoder.positions_scratch);
+  if (!valid || (positions.cols() == 0 && pos_msg.dims[0] != 0)) {
+    spdlog::debug("Invalid point cloud: expected a (N, 3) float32 array.");
+    return false;
+  }
+  if (!has_colors) {
+    viz.setPointCloud(name, positions);
+    return true;
+  }
+  auto colors =
+      get_columns_map<Uint8, 4>(col_msg, "uint8", decoder.colors_scratch);
+  if (colors.cols() != positions.cols()) {
+    spdlog::debug("Invalid point cloud: expected colors as a (N, 4) uint8 "
+                  "array.");
+    return false;
+  }
+  viz.setPointCloud(name, positions, colors);
+  return true;
+}
+
+/// State stream of a state update topic: 0 for the main robot's
+/// (`state_update`), and `i + 1` for the robot `i` added with add_robot
+/// (`state_update/<name>`).
+std::optional<size_t> state_stream_index(Visualizer &viz,
+                                         std::string_view topic) {
+  if (topic == CMD_state_update)
+    return 0;
+  if (!topic.starts_with(CMD_state_update) ||
+      topic[CMD_state_update.size()] != '/')
+    return std::nullopt;
+  const std::string_view name = topic.substr(CMD_state_update.size() + 1);
+  for (size_t i = 0; i < viz.numRobots(); i++) {
+    if (viz.robot(i).name == name)
+      return i + 1;
+  }
+  return std::nullopt;
+}
+
 void run_main_loop(Visualizer &viz, ApplicationContext &app_ctx) {
+  RuntimeStats &stats = app_ctx.stats;
+  StateDecoder state_decoder;
+  std::vector<std::optional<zmq::message_t>> latest_states;
+  PointCloudDecoder cloud_decoder;
+  // newest update of each point cloud, by name
+  std::vector<std::pair<std::string, std::optional<zmq::message_t>>>
+      latest_clouds;
+  TrajectoryPlayer &trajectory = app_ctx.trajectory;
+  Eigen::VectorXd traj_q, traj_v;
+  auto last_frame = std::chrono::steady_clock::now();
+#ifndef _WIN32
+  Eigen::VectorXd shm_q, shm_v;
+  Uint64 shm_writes = 0;
+#endif
 
   while (!viz.shouldExit()) {
+#ifndef _WIN32
+    // poll shared memory transport, which only holds the latest state
+    if (app_ctx.state_shm && app_ctx.state_shm->read(shm_q, shm_v)) {
+      const Uint64 writes = app_ctx.state_shm->numWrites();
+      stats.received += writes - shm_writes;
+      stats.dropped += writes - shm_writes - 1;
+      stats.applied++;
+      shm_writes = writes;
+      if (shm_v.size() == 0)
+        pin::forwardKinematics(viz.model(), viz.data(), shm_q);
+      else
+        pin::forwardKinematics(viz.model(), viz.data(), shm_q, shm_v);
+    }
+#endif
     std::array<zmq::message_t, 2> msgs;
 
-    // route subscriber socket
-    auto rec = zmq::recv_multipart_n(app_ctx.state_sock, msgs.begin(), 2,
-                                     zmq::recv_flags::dontwait);
-
-    if (rec) {
-      // route through message headers
-      auto header = msgs[0].to_string_view();
-      if (header == CMD_state_update) {
-        auto oh = get_handle_from_zmq_msg(std::move(msgs[1]));
-        msgpack::object obj = oh.get();
-        std::tuple<ArrayMessage, std::optional<ArrayMessage>> arrays;
-        obj.convert(arrays);
-        auto [q_msg, v_msg] = arrays;
-        auto q_view = get_eigen_view_from_spec<Eigen::VectorXd>(q_msg);
-        if (!v_msg) {
-          pin::forwardKinematics(viz.model(), viz.data(), q_view);
-        } else {
-          auto v_view = get_eigen_view_from_spec<Eigen::VectorXd>(*v_msg);
-          pin::forwardKinematics(viz.model(), viz.data(), q_view, v_view);
-        }
+    // drain the subscriber socket and only keep the newest state of each
+    // robot, so that display lags by at most one frame whatever the
+    // publishing rate. (ZMQ_CONFLATE does not support multipart messages.)
+    // messages which could not be applied are counted, and reported once per
+    // frame so that a misbehaving publisher does not flood the log.
+    size_t unknown_topics = 0;
+    size_t invalid_msgs = 0;
+    std::string last_unknown_topic;
+    latest_states.resize(viz.numRobots() + 1);
+    while (zmq::recv_multipart_n(app_ctx.state_sock, msgs.begin(), 2,
+                                 zmq::recv_flags::dontwait)) {
+      const auto topic = msgs[0].to_string_view();
+      if (topic.starts_with(CMD_point_cloud) &&
+          topic.size() > CMD_point_cloud.size() + 1 &&
+          topic[CMD_point_cloud.size()] == '/') {
+        const auto name = topic.substr(CMD_point_cloud.size() + 1);
+        auto it = std::ranges::find(latest_clouds, name,
+                                    [](auto &entry) -> std::string_view {
+                                      return entry.first;
+                                    });
+        if (it == latest_clouds.end())
+          it = latest_clouds.emplace(latest_clouds.end(), name, std::nullopt);
+        it->second = std::move(msgs[1]);
+        continue;
+      }
+      auto stream = state_stream_index(viz, topic);
+      if (!stream) {
+        unknown_topics++;
+        last_unknown_topic = topic;
+        continue;
       }
+      stats.received++;
+      auto &latest = latest_states[*stream];
+      if (latest)
+        stats.dropped++;
+      latest = std::move(msgs[1]);
     }
+    for (size_t i = 0; i < latest_states.size(); i++) {
+      if (!latest_states[i])
+        continue;
+      bool ok;
+      if (i == 0) {
+        ok = apply_state_update(viz.model(), viz.data(), *latest_states[i],
+                                state_decoder);
+      } else {
+        auto &robot = viz.robot(i - 1);
+        ok = apply_state_update(robot.model, robot.data, *latest_states[i],
+                                state_decoder);
+      }
+      latest_states[i].reset();
+      if (ok)
+        stats.applied++;
+      else
+        invalid_msgs++;
+    }
+    for (auto &[name, latest] : latest_clouds) {
+      if (!latest)
+        continue;
+      if (!apply_point_cloud(viz, name, *latest, cloud_decoder))
+        invalid_msgs++;
+      latest.reset();
+    }
+    if (unknown_topics > 0)
+      spdlog::warn("Ignored {:d} state update(s) with unknown topic (last: "
+                   "\'{:s}\').",
+                   unknown_topics, last_unknown_topic);
+    if (invalid_msgs > 0)
+      spdlog::warn("Ignored {:d} invalid state or point cloud update(s), set "
+                   "SPDLOG_LEVEL=debug for details.",
+                   invalid_msgs);
 
     // route synchronous socket
     // reuse our buffer for messages.
-    rec = zmq::recv_multipart_n(app_ctx.sync_sock, msgs.begin(), 2,
-                                zmq::recv_flags::dontwait);
+    auto rec = zmq::recv_multipart_n(app_ctx.sync_sock, msgs.begin(), 2,
+                                     zmq::recv_flags::dontwait);
     if (rec) {
-      pull_socket_router(viz, msgs, app_ctx.sync_sock);
+      pull_socket_router(viz, msgs, app_ctx);
+    }
+
+    // trajectory playback, which overrides streamed states while playing
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> frame_dt = now - last_frame;
+    trajectory.advance(frame_dt.count());
+    last_frame = now;
+    if (trajectory.playing() || app_ctx.trajectory_changed) {
+      trajectory.evaluate(traj_q, traj_v);
+      if (traj_v.size() == 0)
+        pin::forwardKinematics(viz.model(), viz.data(), traj_q);
+      else
+        pin::forwardKinematics(viz.model(), viz.data(), traj_q, traj_v);
+      app_ctx.trajectory_changed = false;
     }
 
     viz.display();
+    stats.frames++;
   }
 }
 
@@ -171,6 +563,12 @@ int main(int argc, char *argv[]) {
   app.add_option("--host", hostname, "Host name.")->capture_default_str();
   Uint16 port = 12000;
   app.add_option("-p,--port", port, "Base port")->capture_default_str();
+  std::string shm_name;
+#ifndef _WIN32
+  app.add_option("--shm-name", shm_name,
+                 "Also receive states through a POSIX shared memory segment "
+                 "with this name, created once the models are loaded.");
+#endif
 
   CLI11_PARSE(app, argc, argv);
 
@@ -181,6 +579,7 @@ int main(int argc, char *argv[]) {
   sync_sock.bind(fmt::format("tcp://{:s}:{:d}", hostname, port));
   state_sock.bind(fmt::format("tcp://{:s}:{:d}", hostname, port + 2));
   state_sock.set(zmq::sockopt::subscribe, CMD_state_update);
+  state_sock.set(zmq::sockopt::subscribe, CMD_point_cloud);
 
   std::string endpoint;
   endpoint = sync_sock.get(zmq::sockopt::last_endpoint);
@@ -193,6 +592,15 @@ int main(int argc, char *argv[]) {
   if (!loaded_models)
     return 1;
 
+#ifndef _WIN32
+  if (!shm_name.empty()) {
+    app_ctx.state_shm = SharedMemoryState::create(
+        shm_name, Uint32(app_ctx.model.nq), Uint32(app_ctx.model.nv));
+    spdlog::info("Shared memory state segment: {:s}",
+                 app_ctx.state_shm->name());
+  }
+#endif
+
   Visualizer::Config config;
   config.width = window_dims[0];
   config.height = window_dims[1];
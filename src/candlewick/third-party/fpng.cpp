@@ -41,6 +41,13 @@
 	#include <emmintrin.h>		// SSE2
 	#include <smmintrin.h>		// SSE4.1
 	#include <wmmintrin.h>		// pclmul
+
+	// The SSE4.1/PCLMUL functions are only called after runtime CPU detection, so only they are compiled for these instructions (not the whole file).
+	#if defined(__GNUC__) || defined(__clang__)
+		#define FPNG_SSE41_TARGET __attribute__((target("sse4.1,pclmul")))
+	#else
+		#define FPNG_SSE41_TARGET
+	#endif
 #endif
 
 #ifndef FPNG_NO_STDIO
@@ -252,7 +259,7 @@ namespace fpng
 	// See Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction":
 	// https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf
 	// Requires PCLMUL and SSE 4.1. This function skips Step 1 (fold by 4) for simplicity/less code.
-	static uint32_t crc32_pclmul(const uint8_t* p, size_t size, uint32_t crc)
+	FPNG_SSE41_TARGET static uint32_t crc32_pclmul(const uint8_t* p, size_t size, uint32_t crc)
 	{
 		assert(size >= 16);
 
@@ -404,7 +411,7 @@ namespace fpng
 	// See "Fast Computation of Adler32 Checksums":
 	// https://www.intel.com/content/www/us/en/developer/articles/technical/fast-computation-of-adler32-checksums.html
 	// SSE 4.1, 16 bytes per iteration
-	static uint32_t adler32_sse_16(const uint8_t* p, size_t len, uint32_t initial)
+	FPNG_SSE41_TARGET static uint32_t adler32_sse_16(const uint8_t* p, size_t len, uint32_t initial)
 	{
 		uint32_t s1 = initial & 0xFFFF, s2 = initial >> 16;
 		const uint32_t K = 65521;
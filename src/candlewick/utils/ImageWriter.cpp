@@ -0,0 +1,497 @@
+#include "ImageWriter.h"
+#include "PixelFormatConversion.h"
+#include "../core/errors.h"
+#include "../third-party/fpng.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+#include <spdlog/spdlog.h>
+
+namespace candlewick {
+namespace media {
+
+  static void init_fpng_once() {
+    static std::once_flag flag;
+    std::call_once(flag, [] { fpng::fpng_init(); });
+  }
+
+  Uint32 pixelLayoutSize(PixelLayout layout) {
+    switch (layout) {
+    case PixelLayout::RGBA8:
+    case PixelLayout::BGRA8:
+      return 4;
+    case PixelLayout::RGB8:
+      return 3;
+    case PixelLayout::R16:
+      return 2;
+    case PixelLayout::RGB16:
+      return 6;
+    case PixelLayout::R32F:
+    case PixelLayout::R32UI:
+      return 4;
+    case PixelLayout::RGB32F:
+      return 12;
+    }
+    return 0;
+  }
+
+  ImageFileFormat imageFileFormatFromFilename(std::string_view filename) {
+    auto ext = std::filesystem::path{filename}.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return char(std::tolower(c)); });
+    if (ext == ".png")
+      return ImageFileFormat::PNG;
+    if (ext == ".qoi")
+      return ImageFileFormat::QOI;
+    if (ext == ".exr")
+      return ImageFileFormat::EXR;
+    return ImageFileFormat::RAW;
+  }
+
+  // QOI ENCODER -----------------------------------------------------
+  // See the specification at https://qoiformat.org/qoi-specification.pdf
+
+  namespace {
+    struct QoiRgba {
+      Uint8 r, g, b, a;
+      bool operator==(const QoiRgba &) const = default;
+      Uint32 hash() const { return (r * 3u + g * 5u + b * 7u + a * 11u) % 64u; }
+    };
+
+    enum : Uint8 {
+      QOI_OP_INDEX = 0x00,
+      QOI_OP_DIFF = 0x40,
+      QOI_OP_LUMA = 0x80,
+      QOI_OP_RUN = 0xc0,
+      QOI_OP_RGB = 0xfe,
+      QOI_OP_RGBA = 0xff,
+    };
+  } // namespace
+
+  static void qoi_write_u32(std::vector<Uint8> &out, Uint32 v) {
+    // big-endian
+    out.push_back(Uint8(v >> 24));
+    out.push_back(Uint8(v >> 16));
+    out.push_back(Uint8(v >> 8));
+    out.push_back(Uint8(v));
+  }
+
+  static std::vector<Uint8> encode_qoi(const Uint8 *pixels, Uint32 width,
+                                       Uint32 height, Uint32 channels) {
+    const size_t numPixels = size_t(width) * height;
+    std::vector<Uint8> out;
+    // worst case: one tag + 4 bytes per pixel
+    out.reserve(14 + numPixels * (channels + 1) + 8);
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    qoi_write_u32(out, width);
+    qoi_write_u32(out, height);
+    out.push_back(Uint8(channels));
+    out.push_back(0); // sRGB with linear alpha
+
+    std::array<QoiRgba, 64> index{};
+    QoiRgba prev{0, 0, 0, 255};
+    Uint8 run = 0;
+    for (size_t i = 0; i < numPixels; i++) {
+      const Uint8 *p = pixels + i * channels;
+      QoiRgba px{p[0], p[1], p[2], channels == 4 ? p[3] : Uint8(255)};
+
+      if (px == prev) {
+        run++;
+        if (run == 62 || i + 1 == numPixels) {
+          out.push_back(Uint8(QOI_OP_RUN | (run - 1)));
+          run = 0;
+        }
+        continue;
+      }
+
+      if (run > 0) {
+        out.push_back(Uint8(QOI_OP_RUN | (run - 1)));
+        run = 0;
+      }
+
+      const Uint32 h = px.hash();
+      if (index[h] == px) {
+        out.push_back(Uint8(QOI_OP_INDEX | h));
+      } else {
+        index[h] = px;
+        if (px.a == prev.a) {
+          // differences wrap around
+          const auto vr = Sint8(px.r - prev.r);
+          const auto vg = Sint8(px.g - prev.g);
+          const auto vb = Sint8(px.b - prev.b);
+          const auto vg_r = Sint8(vr - vg);
+          const auto vg_b = Sint8(vb - vg);
+          if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+            out.push_back(
+                Uint8(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+          } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 &&
+                     vg_b > -9 && vg_b < 8) {
+            out.push_back(Uint8(QOI_OP_LUMA | (vg + 32)));
+            out.push_back(Uint8((vg_r + 8) << 4 | (vg_b + 8)));
+          } else {
+            out.insert(out.end(), {QOI_OP_RGB, px.r, px.g, px.b});
+          }
+        } else {
+          out.insert(out.end(), {QOI_OP_RGBA, px.r, px.g, px.b, px.a});
+        }
+      }
+      prev = px;
+    }
+
+    // end marker
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+  }
+
+  static bool write_file(const std::string &filename, const Uint8 *data,
+                         size_t size) {
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+      return false;
+    bool ok = std::fwrite(data, 1, size, file) == size;
+    ok &= std::fclose(file) == 0;
+    return ok;
+  }
+
+  // 16-BIT PNG ENCODER ----------------------------------------------
+  // fpng only handles 8-bit images. Depth images do not compress well with
+  // fast filters anyway, so we write stored (uncompressed) deflate blocks.
+
+  static void put_u32_be(std::vector<Uint8> &out, Uint32 v) {
+    qoi_write_u32(out, v);
+  }
+
+  static void png_write_chunk(std::vector<Uint8> &out, const char type[4],
+                              const Uint8 *data, size_t size) {
+    static const auto crcTable = [] {
+      std::array<Uint32, 256> table;
+      for (Uint32 n = 0; n < 256; n++) {
+        Uint32 c = n;
+        for (int k = 0; k < 8; k++)
+          c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+      }
+      return table;
+    }();
+    put_u32_be(out, Uint32(size));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    Uint32 crc = 0xFFFFFFFFu;
+    for (size_t i = start; i < out.size(); i++)
+      crc = crcTable[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+    put_u32_be(out, crc ^ 0xFFFFFFFFu);
+  }
+
+  bool writePng16(const std::string &filename, const Uint16 *pixels,
+                  Uint32 width, Uint32 height, Uint32 channels) {
+    if (channels != 1 && channels != 3)
+      return false;
+    // raw scanlines: filter byte (none) followed by big-endian samples
+    const size_t rowSize = 1 + size_t(width) * channels * 2;
+    std::vector<Uint8> raw(rowSize * height);
+    for (Uint32 y = 0; y < height; y++) {
+      Uint8 *row = raw.data() + y * rowSize;
+      const Uint16 *src = pixels + size_t(y) * width * channels;
+      row[0] = 0;
+      for (size_t i = 0; i < size_t(width) * channels; i++) {
+        row[1 + 2 * i] = Uint8(src[i] >> 8);
+        row[2 + 2 * i] = Uint8(src[i]);
+      }
+    }
+
+    // zlib stream made of stored deflate blocks
+    constexpr size_t maxBlock = 65535;
+    const size_t numBlocks = std::max<size_t>(1, (raw.size() + maxBlock - 1) /
+                                                     maxBlock);
+    std::vector<Uint8> zlib;
+    zlib.reserve(2 + raw.size() + 5 * numBlocks + 4);
+    zlib.insert(zlib.end(), {0x78, 0x01});
+    Uint32 a = 1, b = 0; // adler32
+    for (size_t blk = 0; blk < numBlocks; blk++) {
+      const size_t offset = blk * maxBlock;
+      const auto len = Uint16(std::min(maxBlock, raw.size() - offset));
+      const Uint8 final = blk + 1 == numBlocks;
+      zlib.insert(zlib.end(), {final, Uint8(len), Uint8(len >> 8),
+                               Uint8(~len), Uint8(Uint16(~len) >> 8)});
+      zlib.insert(zlib.end(), raw.begin() + offset,
+                  raw.begin() + offset + len);
+      for (size_t i = offset; i < offset + len; i++) {
+        a = (a + raw[i]) % 65521u;
+        b = (b + a) % 65521u;
+      }
+    }
+    put_u32_be(zlib, (b << 16) | a);
+
+    std::vector<Uint8> out;
+    out.reserve(zlib.size() + 64);
+    out.insert(out.end(), {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'});
+    std::vector<Uint8> ihdr;
+    put_u32_be(ihdr, width);
+    put_u32_be(ihdr, height);
+    // bit depth, color type (grayscale or RGB), compression, filter, interlace
+    ihdr.insert(ihdr.end(), {16, Uint8(channels == 1 ? 0 : 2), 0, 0, 0});
+    png_write_chunk(out, "IHDR", ihdr.data(), ihdr.size());
+    png_write_chunk(out, "IDAT", zlib.data(), zlib.size());
+    png_write_chunk(out, "IEND", nullptr, 0);
+    return write_file(filename, out.data(), out.size());
+  }
+
+  // OPENEXR ENCODER -------------------------------------------------
+  // Single-part scanline file, without compression. See "The OpenEXR File
+  // Layout" in the OpenEXR documentation. Everything is little-endian.
+
+  namespace {
+    struct ExrBuffer {
+      std::vector<Uint8> data;
+
+      template <typename T> void put(T v) {
+        static_assert(std::endian::native == std::endian::little,
+                      "The EXR writer assumes a little-endian host.");
+        const auto *p = reinterpret_cast<const Uint8 *>(&v);
+        data.insert(data.end(), p, p + sizeof(T));
+      }
+      void putString(const char *str) {
+        data.insert(data.end(), str, str + std::strlen(str) + 1);
+      }
+      void putAttribute(const char *name, const char *type, Uint32 size) {
+        putString(name);
+        putString(type);
+        put(size);
+      }
+    };
+  } // namespace
+
+  /// \p T is either float or Uint32 (4-byte samples).
+  template <typename T>
+  static bool write_exr_impl(const std::string &filename, const T *pixels,
+                             Uint32 width, Uint32 height, Uint32 channels) {
+    static_assert(sizeof(T) == 4);
+    // pixel type: UINT = 0, FLOAT = 2
+    constexpr Sint32 pixelType = std::is_floating_point_v<T> ? 2 : 0;
+    if (channels != 1 && channels != 3)
+      return false;
+    // channels are stored in alphabetical order
+    static const char *const rgbNames[] = {"B", "G", "R"};
+    static const Uint32 rgbIndices[] = {2, 1, 0};
+
+    ExrBuffer buf;
+    buf.put(Uint32(20000630)); // magic number
+    buf.put(Uint32(2));        // version 2, single-part scanline
+
+    Uint32 chlistSize = 1;
+    for (Uint32 c = 0; c < channels; c++)
+      chlistSize += 2 + 16;
+    buf.putAttribute("channels", "chlist", chlistSize);
+    for (Uint32 c = 0; c < channels; c++) {
+      buf.putString(channels == 1 ? "Y" : rgbNames[c]);
+      buf.put(pixelType);
+      buf.put(Uint32(0)); // pLinear + reserved
+      buf.put(Sint32(1)); // x sampling
+      buf.put(Sint32(1)); // y sampling
+    }
+    buf.put(Uint8(0));
+
+    buf.putAttribute("compression", "compression", 1);
+    buf.put(Uint8(0)); // NO_COMPRESSION
+    for (const char *window : {"dataWindow", "displayWindow"}) {
+      buf.putAttribute(window, "box2i", 16);
+      buf.put(Sint32(0));
+      buf.put(Sint32(0));
+      buf.put(Sint32(width - 1));
+      buf.put(Sint32(height - 1));
+    }
+    buf.putAttribute("lineOrder", "lineOrder", 1);
+    buf.put(Uint8(0)); // INCREASING_Y
+    buf.putAttribute("pixelAspectRatio", "float", 4);
+    buf.put(1.0f);
+    buf.putAttribute("screenWindowCenter", "v2f", 8);
+    buf.put(0.0f);
+    buf.put(0.0f);
+    buf.putAttribute("screenWindowWidth", "float", 4);
+    buf.put(1.0f);
+    buf.put(Uint8(0)); // end of header
+
+    // line offset table, one scanline per block
+    const Uint32 lineSize = width * channels * Uint32(sizeof(T));
+    const Uint64 tableStart = buf.data.size();
+    const Uint64 firstLine = tableStart + Uint64(height) * sizeof(Uint64);
+    for (Uint32 y = 0; y < height; y++)
+      buf.put(Uint64(firstLine + Uint64(y) * (8 + lineSize)));
+
+    buf.data.reserve(firstLine + size_t(height) * (8 + lineSize));
+    for (Uint32 y = 0; y < height; y++) {
+      buf.put(Sint32(y));
+      buf.put(lineSize);
+      const T *row = pixels + size_t(y) * width * channels;
+      for (Uint32 c = 0; c < channels; c++) {
+        const Uint32 src = channels == 1 ? 0 : rgbIndices[c];
+        for (Uint32 x = 0; x < width; x++)
+          buf.put(row[x * channels + src]);
+      }
+    }
+    return write_file(filename, buf.data.data(), buf.data.size());
+  }
+
+  bool writeExr(const std::string &filename, const float *pixels, Uint32 width,
+                Uint32 height, Uint32 channels) {
+    return write_exr_impl(filename, pixels, width, height, channels);
+  }
+
+  bool writeExr(const std::string &filename, const Uint32 *pixels,
+                Uint32 width, Uint32 height) {
+    return write_exr_impl(filename, pixels, width, height, 1);
+  }
+
+  bool writeImage(ImageWriter::Job &job) {
+    const size_t numPixels = size_t(job.width) * job.height;
+    const size_t expectedSize = numPixels * pixelLayoutSize(job.layout);
+    if (job.pixels.size() < expectedSize) {
+      spdlog::error("Image '{:s}': expected {:d} bytes of pixel data, got {:d}",
+                    job.filename, expectedSize, job.pixels.size());
+      return false;
+    }
+
+    if (job.layout == PixelLayout::BGRA8) {
+      bgraToRgbaConvert(reinterpret_cast<Uint32 *>(job.pixels.data()),
+                        Uint32(numPixels));
+      job.layout = PixelLayout::RGBA8;
+    }
+
+    const Uint8 *data = job.pixels.data();
+    const auto layout = job.layout;
+    const bool is8bit =
+        layout == PixelLayout::RGBA8 || layout == PixelLayout::RGB8;
+    Uint32 channels = 3;
+    if (layout == PixelLayout::RGBA8)
+      channels = 4;
+    else if (layout == PixelLayout::R16 || layout == PixelLayout::R32F ||
+             layout == PixelLayout::R32UI)
+      channels = 1;
+
+    switch (job.format) {
+    case ImageFileFormat::PNG:
+      if (is8bit) {
+        init_fpng_once();
+        return fpng::fpng_encode_image_to_file(
+            job.filename.c_str(), data, job.width, job.height, channels);
+      }
+      if (layout == PixelLayout::R16 || layout == PixelLayout::RGB16)
+        return writePng16(job.filename, reinterpret_cast<const Uint16 *>(data),
+                          job.width, job.height, channels);
+      break;
+    case ImageFileFormat::QOI:
+      if (is8bit) {
+        auto encoded = encode_qoi(data, job.width, job.height, channels);
+        return write_file(job.filename, encoded.data(), encoded.size());
+      }
+      break;
+    case ImageFileFormat::EXR:
+      if (layout == PixelLayout::R32F || layout == PixelLayout::RGB32F)
+        return writeExr(job.filename, reinterpret_cast<const float *>(data),
+                        job.width, job.height, channels);
+      if (layout == PixelLayout::R32UI)
+        return writeExr(job.filename, reinterpret_cast<const Uint32 *>(data),
+                        job.width, job.height);
+      break;
+    case ImageFileFormat::RAW:
+      return write_file(job.filename, data, expectedSize);
+    }
+    spdlog::error("Image '{:s}': unsupported combination of pixel layout and "
+                  "file format.",
+                  job.filename);
+    return false;
+  }
+
+  // WORKER POOL -----------------------------------------------------
+
+  ImageWriter::ImageWriter(Uint32 numThreads, Uint32 maxPendingJobs) {
+    if (numThreads == 0)
+      numThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    m_maxPending = maxPendingJobs > 0 ? maxPendingJobs : 2 * numThreads;
+    init_fpng_once();
+    m_workers.reserve(numThreads);
+    for (Uint32 i = 0; i < numThreads; i++)
+      m_workers.emplace_back([this] { this->workerLoop(); });
+  }
+
+  void ImageWriter::submit(Job job, Callback callback) {
+    std::unique_lock lock{m_mutex};
+    m_queueNotFull.wait(lock, [this] {
+      return m_stop || m_queue.size() + m_numActive < m_maxPending;
+    });
+    if (m_stop)
+      terminate_with_message("Cannot submit job to a stopped ImageWriter.");
+    m_queue.push_back({std::move(job), std::move(callback)});
+    m_queueNotEmpty.notify_one();
+  }
+
+  bool ImageWriter::trySubmit(Job &job, Callback callback) {
+    std::lock_guard lock{m_mutex};
+    if (m_stop || m_queue.size() + m_numActive >= m_maxPending)
+      return false;
+    m_queue.push_back({std::move(job), std::move(callback)});
+    m_queueNotEmpty.notify_one();
+    return true;
+  }
+
+  void ImageWriter::waitIdle() {
+    std::unique_lock lock{m_mutex};
+    m_idle.wait(lock, [this] { return m_queue.empty() && m_numActive == 0; });
+  }
+
+  Uint32 ImageWriter::numPending() const {
+    std::lock_guard lock{m_mutex};
+    return Uint32(m_queue.size()) + m_numActive;
+  }
+
+  void ImageWriter::workerLoop() {
+    while (true) {
+      Task task;
+      {
+        std::unique_lock lock{m_mutex};
+        m_queueNotEmpty.wait(lock,
+                             [this] { return m_stop || !m_queue.empty(); });
+        // drain the queue before stopping
+        if (m_queue.empty())
+          return;
+        task = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_numActive++;
+      }
+
+      bool ok = writeImage(task.job);
+      if (!ok)
+        spdlog::error("Failed to write image '{:s}'", task.job.filename);
+      if (task.callback)
+        task.callback(task.job.filename, ok);
+
+      {
+        std::lock_guard lock{m_mutex};
+        m_numActive--;
+        if (m_queue.empty() && m_numActive == 0)
+          m_idle.notify_all();
+      }
+      m_queueNotFull.notify_one();
+    }
+  }
+
+  ImageWriter::~ImageWriter() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_queueNotEmpty.notify_all();
+    m_queueNotFull.notify_all();
+    for (auto &worker : m_workers)
+      worker.join();
+  }
+
+} // namespace media
+} // namespace candlewick
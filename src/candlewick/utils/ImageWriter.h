@@ -0,0 +1,147 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace candlewick {
+namespace media {
+
+  /// \brief Image file formats supported by ImageWriter.
+  enum class ImageFileFormat {
+    /// PNG. 8-bit images are encoded with fpng, 16-bit images are stored
+    /// uncompressed.
+    PNG,
+    /// The "Quite OK Image Format" (https://qoiformat.org), 8-bit only.
+    QOI,
+    /// Uncompressed OpenEXR, for floating-point images.
+    EXR,
+    /// Raw pixel data, without any header.
+    RAW,
+  };
+
+  /// \brief Layout of pixels handed to ImageWriter.
+  enum class PixelLayout {
+    RGBA8,
+    BGRA8,
+    RGB8,
+    /// 16-bit grayscale, e.g. depth in millimeters.
+    R16,
+    /// 16-bit RGB.
+    RGB16,
+    /// 32-bit float, single channel.
+    R32F,
+    /// 32-bit float RGB.
+    RGB32F,
+    /// 32-bit unsigned integer, single channel.
+    R32UI,
+  };
+
+  /// \brief Size of a pixel with the given layout, in bytes.
+  Uint32 pixelLayoutSize(PixelLayout layout);
+
+  /// \brief Guess the file format from the filename's extension (`.png`,
+  /// `.qoi`, `.exr`, and anything else is written as raw data).
+  ImageFileFormat imageFileFormatFromFilename(std::string_view filename);
+
+  /// \brief Write a 16-bit grayscale (\p channels = 1) or RGB (\p channels =
+  /// 3) PNG image. Samples are in host byte order.
+  bool writePng16(const std::string &filename, const Uint16 *pixels,
+                  Uint32 width, Uint32 height, Uint32 channels);
+
+  /// \brief Write a single-channel (\p channels = 1, written as luminance
+  /// `Y`) or RGB (\p channels = 3) uncompressed OpenEXR image with 32-bit float
+  /// samples.
+  bool writeExr(const std::string &filename, const float *pixels, Uint32 width,
+                Uint32 height, Uint32 channels);
+
+  /// \brief Write a single-channel uncompressed OpenEXR image with 32-bit
+  /// unsigned integer samples (e.g. instance IDs), in channel `Y`.
+  bool writeExr(const std::string &filename, const Uint32 *pixels,
+                Uint32 width, Uint32 height);
+
+  /// \brief A pool of worker threads which encode and write images to disk.
+  ///
+  /// Jobs own their pixel buffers, so that the caller can move on to the next
+  /// frame as soon as a job is submitted. The number of pending jobs is bounded:
+  /// submit() blocks until a slot frees up, which keeps memory usage in check
+  /// when images are produced faster than they can be written.
+  class ImageWriter {
+  public:
+    struct Job {
+      std::string filename;
+      /// Pixel data, tightly packed, in the layout given by \ref layout.
+      std::vector<Uint8> pixels;
+      Uint32 width;
+      Uint32 height;
+      PixelLayout layout = PixelLayout::RGBA8;
+      ImageFileFormat format = ImageFileFormat::PNG;
+    };
+    /// \brief Completion callback, invoked from the worker thread which
+    /// processed the job.
+    using Callback = std::function<void(const std::string &filename, bool ok)>;
+
+    /// \param numThreads Number of worker threads. If zero, use half the
+    /// number of hardware threads.
+    /// \param maxPendingJobs Maximum number of queued jobs. If zero, use twice
+    /// the number of worker threads.
+    explicit ImageWriter(Uint32 numThreads = 0, Uint32 maxPendingJobs = 0);
+
+    ImageWriter(const ImageWriter &) = delete;
+    ImageWriter &operator=(const ImageWriter &) = delete;
+
+    /// \brief Queue a job, blocking while the queue is full.
+    void submit(Job job, Callback callback = {});
+
+    /// \brief Queue a job if the queue is not full.
+    /// \returns Whether the job was queued. If not, \p job is left untouched.
+    bool trySubmit(Job &job, Callback callback = {});
+
+    /// \brief Block until all submitted jobs were processed.
+    void waitIdle();
+
+    /// \brief Number of jobs which are either queued or being processed.
+    Uint32 numPending() const;
+
+    Uint32 numThreads() const { return Uint32(m_workers.size()); }
+
+    /// \brief Process the remaining jobs and join the worker threads.
+    ~ImageWriter();
+
+  private:
+    struct Task {
+      Job job;
+      Callback callback;
+    };
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<Task> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queueNotEmpty;
+    std::condition_variable m_queueNotFull;
+    std::condition_variable m_idle;
+    Uint32 m_maxPending;
+    Uint32 m_numActive = 0;
+    bool m_stop = false;
+  };
+
+  /// \brief Encode and write an image, synchronously.
+  ///
+  /// This is what the ImageWriter workers run. BGRA pixels are converted to
+  /// RGBA in place, hence the mutable buffer. Not every combination of layout
+  /// and file format is supported: 8-bit layouts go to PNG or QOI, 16-bit
+  /// layouts to PNG, and float and 32-bit integer layouts to EXR. Anything
+  /// can be written as raw data.
+  /// \returns Whether the file was successfully written.
+  bool writeImage(ImageWriter::Job &job);
+
+} // namespace media
+} // namespace candlewick
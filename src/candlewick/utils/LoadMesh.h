@@ -2,8 +2,11 @@
 
 #include "Utils.h"
 #include <SDL3/SDL_stdinc.h>
+#include <assimp/matrix4x4.h>
 #include <vector>
 
+struct aiMesh;
+
 namespace candlewick {
 
 /// Return codes for \ref loadSceneMeshes().
@@ -14,6 +17,10 @@ enum class mesh_load_retc : Uint16 {
   OK = 1 << 4,
 };
 
+/// \brief Convert a triangulated assimp mesh to MeshData, applying the given
+/// transform to its vertices.
+MeshData loadAiMesh(const aiMesh *inMesh, const aiMatrix4x4 transform);
+
 /// \brief Load the meshes from the given path.
 /// This is implemented using the assimp library.
 mesh_load_retc loadSceneMeshes(const char *path,
@@ -1,21 +1,677 @@
 #include "PixelFormatConversion.h"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define CANDLEWICK_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows using any intrinsic regardless of the compilation flags.
+#define CANDLEWICK_TARGET(isa)
+#else
+#define CANDLEWICK_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+// NEON is part of the baseline AArch64 instruction set.
+#define CANDLEWICK_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 namespace candlewick {
 
-void bgraToRgbaConvert(Uint32 *bgraPixels, Uint32 pixelCount) {
+// DISPATCH --------------------------------------------------------
+
+#ifdef CANDLEWICK_SIMD_X86
+static bool cpu_supports_sse41() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 19)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+static bool cpu_supports_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  // the OS must save the AVX registers (OSXSAVE + XCR0 bits 1 and 2)
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  if (!osxsave || ((_xgetbv(0) & 0x6) != 0x6))
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static bool isSimdLevelSupported(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return true;
+#ifdef CANDLEWICK_SIMD_X86
+  case SimdLevel::SSE4_1:
+    return cpu_supports_sse41();
+  case SimdLevel::AVX2:
+    return cpu_supports_avx2();
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+  case SimdLevel::NEON:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+SimdLevel detectSimdLevel() {
+  for (SimdLevel level :
+       {SimdLevel::AVX2, SimdLevel::SSE4_1, SimdLevel::NEON}) {
+    if (isSimdLevelSupported(level))
+      return level;
+  }
+  return SimdLevel::Scalar;
+}
+
+static std::atomic<SimdLevel> &current_simd_level() {
+  static std::atomic<SimdLevel> level{detectSimdLevel()};
+  return level;
+}
+
+SimdLevel getSimdLevel() {
+  return current_simd_level().load(std::memory_order_relaxed);
+}
+
+bool setSimdLevel(SimdLevel level) {
+  if (!isSimdLevelSupported(level))
+    return false;
+  current_simd_level().store(level, std::memory_order_relaxed);
+  return true;
+}
+
+// SCALAR KERNELS --------------------------------------------------
+// These define the reference results, and process the tails of the SIMD
+// kernels.
+
+static void bgra_to_rgba_scalar(const Uint32 *in, Uint32 *out, Uint32 begin,
+                                Uint32 end) {
   // define appropriate masks for BGRA format
-  Uint32 red_mask = 0x00FF0000;
-  Uint32 green_mask = 0x0000FF00;
-  Uint32 blue_mask = 0x000000FF;
-  Uint32 alpha_mask = 0xFF000000;
-
-  for (Uint32 i = 0; i < pixelCount; ++i) {
-    Uint32 pixel = bgraPixels[i];
-    bgraPixels[i] = ((pixel & red_mask) >> 16) |  // Extract Red
-                    ((pixel & green_mask)) |      // Keep Green
-                    ((pixel & blue_mask) << 16) | // Extract Blue
-                    (pixel & alpha_mask);         // Keep Alpha
+  const Uint32 red_mask = 0x00FF0000;
+  const Uint32 green_mask = 0x0000FF00;
+  const Uint32 blue_mask = 0x000000FF;
+  const Uint32 alpha_mask = 0xFF000000;
+
+  for (Uint32 i = begin; i < end; ++i) {
+    Uint32 pixel = in[i];
+    out[i] = ((pixel & red_mask) >> 16) |  // Extract Red
+             ((pixel & green_mask)) |      // Keep Green
+             ((pixel & blue_mask) << 16) | // Extract Blue
+             (pixel & alpha_mask);         // Keep Alpha
+  }
+}
+
+static void rgba_to_rgb_scalar(const Uint8 *in, Uint8 *out, Uint32 begin,
+                               Uint32 end) {
+  // front-to-back so that this also works in-place
+  for (Uint32 i = begin; i < end; ++i) {
+    Uint8 r = in[4 * i + 0];
+    Uint8 g = in[4 * i + 1];
+    Uint8 b = in[4 * i + 2];
+    out[3 * i + 0] = r;
+    out[3 * i + 1] = g;
+    out[3 * i + 2] = b;
+  }
+}
+
+static void depth_to_u16_scalar(const float *in, Uint16 *out, Uint32 begin,
+                                Uint32 end, float scale) {
+  for (Uint32 i = begin; i < end; ++i) {
+    // go through memcpy: the buffers overlap in the in-place variant
+    float v;
+    std::memcpy(&v, in + i, sizeof(float));
+    v *= scale;
+    // written such that NaNs are mapped to 0, like the SIMD max/min
+    v = v > 0.f ? v : 0.f;
+    v = v < 65535.f ? v : 65535.f;
+    const Uint16 r = Uint16(std::lrint(v));
+    std::memcpy(out + i, &r, sizeof(Uint16));
+  }
+}
+
+namespace {
+  // 8-bit fixed-point BT.601 coefficients, in the channel order of the input.
+  struct YuvCoeffs {
+    Sint32 y[3], u[3], v[3];
+    explicit YuvCoeffs(bool bgra)
+        : y{66, 129, 25}, u{-38, -74, 112}, v{112, -94, -18} {
+      if (bgra) {
+        std::swap(y[0], y[2]);
+        std::swap(u[0], u[2]);
+        std::swap(v[0], v[2]);
+      }
+    }
+  };
+} // namespace
+
+static void luma_row_scalar(const Uint8 *in, Uint8 *out, Uint32 begin,
+                            Uint32 end, const YuvCoeffs &k) {
+  for (Uint32 i = begin; i < end; ++i) {
+    const Uint8 *p = in + 4 * i;
+    const Sint32 y = k.y[0] * p[0] + k.y[1] * p[1] + k.y[2] * p[2];
+    out[i] = Uint8(((y + 128) >> 8) + 16);
+  }
+}
+
+// Each chroma sample averages a 2x2 block of pixels: the sums of 4 pixels are
+// scaled down by 2 more bits.
+static void chroma_row_scalar(const Uint8 *row0, const Uint8 *row1,
+                              Uint8 *outU, Uint8 *outV, Uint32 width,
+                              const YuvCoeffs &k) {
+  const Uint32 chromaWidth = (width + 1) / 2;
+  for (Uint32 i = 0; i < chromaWidth; ++i) {
+    const Uint32 x0 = 2 * i;
+    const Uint32 x1 = std::min(x0 + 1, width - 1);
+    Sint32 sum[3];
+    for (Uint32 c = 0; c < 3; c++)
+      sum[c] = row0[4 * x0 + c] + row0[4 * x1 + c] + row1[4 * x0 + c] +
+               row1[4 * x1 + c];
+    const Sint32 u = k.u[0] * sum[0] + k.u[1] * sum[1] + k.u[2] * sum[2];
+    const Sint32 v = k.v[0] * sum[0] + k.v[1] * sum[1] + k.v[2] * sum[2];
+    outU[i] = Uint8(((u + 512) >> 10) + 128);
+    outV[i] = Uint8(((v + 512) >> 10) + 128);
+  }
+}
+
+namespace {
+  // Coefficients for D = a / (b - d * c).
+  struct LinearizeCoeffs {
+    float a, b, c;
+    LinearizeCoeffs(float zNear, float zFar)
+        : a(2.f * zNear * zFar), b(zFar + zNear), c(zFar - zNear) {}
+  };
+} // namespace
+
+static void linearize_depth_scalar(const float *in, float *out, Uint32 begin,
+                                   Uint32 end, LinearizeCoeffs k) {
+  for (Uint32 i = begin; i < end; ++i) {
+    float denom = k.b - in[i] * k.c;
+    out[i] = k.a / denom;
+  }
+}
+
+// x86 KERNELS -----------------------------------------------------
+
+#ifdef CANDLEWICK_SIMD_X86
+CANDLEWICK_TARGET("sse4.1")
+static Uint32 bgra_to_rgba_sse41(const Uint32 *in, Uint32 *out, Uint32 n) {
+  const __m128i mask =
+      _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  Uint32 i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    px = _mm_shuffle_epi8(px, mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), px);
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("avx2")
+static Uint32 bgra_to_rgba_avx2(const Uint32 *in, Uint32 *out, Uint32 n) {
+  const __m256i mask = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, //
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  Uint32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    px = _mm256_shuffle_epi8(px, mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), px);
+  }
+  return i;
+}
+
+// The RGBA -> RGB kernels store full registers of which only the first 3/4
+// bytes are valid: the garbage bytes are overwritten by the next store, and
+// the loop stops early enough not to write past the end of the output.
+// Since input reads always stay ahead of output writes, this is safe in-place.
+
+CANDLEWICK_TARGET("sse4.1")
+static Uint32 rgba_to_rgb_sse41(const Uint8 *in, Uint8 *out, Uint32 n) {
+  const __m128i mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                     -1, -1, -1, -1);
+  Uint32 i = 0;
+  // 16 bytes are stored at offset 3 * i: require 3 * i + 16 <= 3 * n
+  for (; i + 6 <= n; i += 4) {
+    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i));
+    px = _mm_shuffle_epi8(px, mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 3 * i), px);
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("avx2")
+static Uint32 rgba_to_rgb_avx2(const Uint8 *in, Uint8 *out, Uint32 n) {
+  const __m256i mask = _mm256_setr_epi8(
+      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, //
+      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  // gather the 12 valid bytes of each 128-bit lane
+  const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  Uint32 i = 0;
+  // 32 bytes are stored at offset 3 * i: require 3 * i + 32 <= 3 * n
+  for (; i + 11 <= n; i += 8) {
+    __m256i px =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 4 * i));
+    px = _mm256_shuffle_epi8(px, mask);
+    px = _mm256_permutevar8x32_epi32(px, pack);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 3 * i), px);
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("sse4.1")
+static Uint32 depth_to_u16_sse41(const float *in, Uint16 *out, Uint32 n,
+                                 float scale) {
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 vzero = _mm_setzero_ps();
+  const __m128 vmax = _mm_set1_ps(65535.f);
+  Uint32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), vscale);
+    __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale);
+    // max(x, 0) returns 0 if x is NaN
+    a = _mm_min_ps(_mm_max_ps(a, vzero), vmax);
+    b = _mm_min_ps(_mm_max_ps(b, vzero), vmax);
+    __m128i r = _mm_packus_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("avx2")
+static Uint32 depth_to_u16_avx2(const float *in, Uint16 *out, Uint32 n,
+                                float scale) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256 vzero = _mm256_setzero_ps();
+  const __m256 vmax = _mm256_set1_ps(65535.f);
+  Uint32 i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 a = _mm256_mul_ps(_mm256_loadu_ps(in + i), vscale);
+    __m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), vscale);
+    a = _mm256_min_ps(_mm256_max_ps(a, vzero), vmax);
+    b = _mm256_min_ps(_mm256_max_ps(b, vzero), vmax);
+    __m256i r =
+        _mm256_packus_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    // packing works per 128-bit lane, restore the element order
+    r = _mm256_permute4x64_epi64(r, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("sse4.1")
+static Uint32 linearize_depth_sse41(const float *in, float *out, Uint32 n,
+                                    LinearizeCoeffs k) {
+  const __m128 va = _mm_set1_ps(k.a);
+  const __m128 vb = _mm_set1_ps(k.b);
+  const __m128 vc = _mm_set1_ps(k.c);
+  Uint32 i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 d = _mm_loadu_ps(in + i);
+    __m128 denom = _mm_sub_ps(vb, _mm_mul_ps(d, vc));
+    _mm_storeu_ps(out + i, _mm_div_ps(va, denom));
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("avx2")
+static Uint32 linearize_depth_avx2(const float *in, float *out, Uint32 n,
+                                   LinearizeCoeffs k) {
+  const __m256 va = _mm256_set1_ps(k.a);
+  const __m256 vb = _mm256_set1_ps(k.b);
+  const __m256 vc = _mm256_set1_ps(k.c);
+  Uint32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 d = _mm256_loadu_ps(in + i);
+    __m256 denom = _mm256_sub_ps(vb, _mm256_mul_ps(d, vc));
+    _mm256_storeu_ps(out + i, _mm256_div_ps(va, denom));
+  }
+  return i;
+}
+
+// The luma kernels widen each pixel to 16 bits, and multiply-add it with the
+// coefficients (c0, c1, c2, 0): summing the pairs gives the weighted sums.
+
+CANDLEWICK_TARGET("sse4.1")
+static __m128i luma_weighted_sse41(__m128i px, __m128i coeffs) {
+  __m128i lo = _mm_madd_epi16(_mm_cvtepu8_epi16(px), coeffs);
+  __m128i hi = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(px, 8)), coeffs);
+  __m128i y = _mm_hadd_epi32(lo, hi);
+  return _mm_srai_epi32(_mm_add_epi32(y, _mm_set1_epi32(128)), 8);
+}
+
+CANDLEWICK_TARGET("sse4.1")
+static Uint32 luma_row_sse41(const Uint8 *in, Uint8 *out, Uint32 n,
+                             const YuvCoeffs &k) {
+  const __m128i coeffs = _mm_setr_epi16(Sint16(k.y[0]), Sint16(k.y[1]),
+                                        Sint16(k.y[2]), 0, Sint16(k.y[0]),
+                                        Sint16(k.y[1]), Sint16(k.y[2]), 0);
+  const __m128i offset = _mm_set1_epi16(16);
+  Uint32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i));
+    __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i + 16));
+    __m128i y = _mm_packs_epi32(luma_weighted_sse41(a, coeffs),
+                                luma_weighted_sse41(b, coeffs));
+    y = _mm_add_epi16(y, offset);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packus_epi16(y, y));
+  }
+  return i;
+}
+
+CANDLEWICK_TARGET("avx2")
+static __m256i luma_weighted_avx2(__m256i px, __m256i coeffs) {
+  __m256i lo = _mm256_madd_epi16(
+      _mm256_cvtepu8_epi16(_mm256_castsi256_si128(px)), coeffs);
+  __m256i hi = _mm256_madd_epi16(
+      _mm256_cvtepu8_epi16(_mm256_extracti128_si256(px, 1)), coeffs);
+  // horizontal adds interleave the pixels of both 128-bit lanes
+  const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+  __m256i y = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(lo, hi), order);
+  return _mm256_srai_epi32(_mm256_add_epi32(y, _mm256_set1_epi32(128)), 8);
+}
+
+CANDLEWICK_TARGET("avx2")
+static Uint32 luma_row_avx2(const Uint8 *in, Uint8 *out, Uint32 n,
+                            const YuvCoeffs &k) {
+  const __m256i coeffs = _mm256_setr_epi16(
+      Sint16(k.y[0]), Sint16(k.y[1]), Sint16(k.y[2]), 0, Sint16(k.y[0]),
+      Sint16(k.y[1]), Sint16(k.y[2]), 0, Sint16(k.y[0]), Sint16(k.y[1]),
+      Sint16(k.y[2]), 0, Sint16(k.y[0]), Sint16(k.y[1]), Sint16(k.y[2]), 0);
+  const __m256i offset = _mm256_set1_epi16(16);
+  Uint32 i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 4 * i));
+    __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 4 * i + 32));
+    // packing works per 128-bit lane, restore the element order
+    __m256i y = _mm256_packs_epi32(luma_weighted_avx2(a, coeffs),
+                                   luma_weighted_avx2(b, coeffs));
+    y = _mm256_add_epi16(_mm256_permute4x64_epi64(y, 0xD8), offset);
+    y = _mm256_permute4x64_epi64(_mm256_packus_epi16(y, y), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm256_castsi256_si128(y));
+  }
+  return i;
+}
+#endif
+
+// NEON KERNELS ----------------------------------------------------
+
+#ifdef CANDLEWICK_SIMD_NEON
+static Uint32 bgra_to_rgba_neon(const Uint32 *in, Uint32 *out, Uint32 n) {
+  Uint32 i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x4_t px = vld4q_u8(reinterpret_cast<const uint8_t *>(in + i));
+    uint8x16_t tmp = px.val[0];
+    px.val[0] = px.val[2];
+    px.val[2] = tmp;
+    vst4q_u8(reinterpret_cast<uint8_t *>(out + i), px);
+  }
+  return i;
+}
+
+static Uint32 rgba_to_rgb_neon(const Uint8 *in, Uint8 *out, Uint32 n) {
+  Uint32 i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x4_t px = vld4q_u8(in + 4 * i);
+    uint8x16x3_t rgb{{px.val[0], px.val[1], px.val[2]}};
+    vst3q_u8(out + 3 * i, rgb);
+  }
+  return i;
+}
+
+static Uint32 depth_to_u16_neon(const float *in, Uint16 *out, Uint32 n,
+                                float scale) {
+  const float32x4_t vzero = vdupq_n_f32(0.f);
+  const float32x4_t vmax = vdupq_n_f32(65535.f);
+  Uint32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    float32x4_t a = vmulq_n_f32(vld1q_f32(in + i), scale);
+    float32x4_t b = vmulq_n_f32(vld1q_f32(in + i + 4), scale);
+    // vmaxnm returns the non-NaN operand
+    a = vminq_f32(vmaxnmq_f32(a, vzero), vmax);
+    b = vminq_f32(vmaxnmq_f32(b, vzero), vmax);
+    // round to nearest, ties to even
+    uint16x4_t ra = vmovn_u32(vcvtnq_u32_f32(a));
+    uint16x4_t rb = vmovn_u32(vcvtnq_u32_f32(b));
+    vst1q_u16(out + i, vcombine_u16(ra, rb));
+  }
+  return i;
+}
+
+static Uint32 linearize_depth_neon(const float *in, float *out, Uint32 n,
+                                   LinearizeCoeffs k) {
+  const float32x4_t va = vdupq_n_f32(k.a);
+  const float32x4_t vb = vdupq_n_f32(k.b);
+  Uint32 i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t d = vld1q_f32(in + i);
+    float32x4_t denom = vsubq_f32(vb, vmulq_n_f32(d, k.c));
+    vst1q_f32(out + i, vdivq_f32(va, denom));
+  }
+  return i;
+}
+
+static Uint32 luma_row_neon(const Uint8 *in, Uint8 *out, Uint32 n,
+                            const YuvCoeffs &k) {
+  const uint8x8_t c0 = vdup_n_u8(Uint8(k.y[0]));
+  const uint8x8_t c1 = vdup_n_u8(Uint8(k.y[1]));
+  const uint8x8_t c2 = vdup_n_u8(Uint8(k.y[2]));
+  const uint8x16_t offset = vdupq_n_u8(16);
+  Uint32 i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x4_t px = vld4q_u8(in + 4 * i);
+    // the weighted sums fit in 16 bits: (66 + 129 + 25) * 255 < 65536
+    uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), c0);
+    lo = vmlal_u8(lo, vget_low_u8(px.val[1]), c1);
+    lo = vmlal_u8(lo, vget_low_u8(px.val[2]), c2);
+    uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), c0);
+    hi = vmlal_u8(hi, vget_high_u8(px.val[1]), c1);
+    hi = vmlal_u8(hi, vget_high_u8(px.val[2]), c2);
+    // rounding shift: (x + 128) >> 8
+    uint8x16_t y = vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+    vst1q_u8(out + i, vaddq_u8(y, offset));
+  }
+  return i;
+}
+#endif
+
+// PUBLIC API ------------------------------------------------------
+
+void bgraToRgbaConvert(const Uint32 *bgraPixels, Uint32 *rgbaPixels,
+                       Uint32 pixelCount) {
+  Uint32 done = 0;
+  switch (getSimdLevel()) {
+#ifdef CANDLEWICK_SIMD_X86
+  case SimdLevel::AVX2:
+    done = bgra_to_rgba_avx2(bgraPixels, rgbaPixels, pixelCount);
+    break;
+  case SimdLevel::SSE4_1:
+    done = bgra_to_rgba_sse41(bgraPixels, rgbaPixels, pixelCount);
+    break;
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+  case SimdLevel::NEON:
+    done = bgra_to_rgba_neon(bgraPixels, rgbaPixels, pixelCount);
+    break;
+#endif
+  default:
+    break;
+  }
+  bgra_to_rgba_scalar(bgraPixels, rgbaPixels, done, pixelCount);
+}
+
+void bgraToRgbaConvert(Uint32 *bgraPixels, Uint32 pixelCount) {
+  bgraToRgbaConvert(bgraPixels, bgraPixels, pixelCount);
+}
+
+void rgbaToRgbConvert(const Uint8 *rgbaPixels, Uint8 *rgbPixels,
+                      Uint32 pixelCount) {
+  Uint32 done = 0;
+  switch (getSimdLevel()) {
+#ifdef CANDLEWICK_SIMD_X86
+  case SimdLevel::AVX2:
+    done = rgba_to_rgb_avx2(rgbaPixels, rgbPixels, pixelCount);
+    break;
+  case SimdLevel::SSE4_1:
+    done = rgba_to_rgb_sse41(rgbaPixels, rgbPixels, pixelCount);
+    break;
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+  case SimdLevel::NEON:
+    done = rgba_to_rgb_neon(rgbaPixels, rgbPixels, pixelCount);
+    break;
+#endif
+  default:
+    break;
+  }
+  rgba_to_rgb_scalar(rgbaPixels, rgbPixels, done, pixelCount);
+}
+
+void rgbaToRgbConvert(Uint8 *pixels, Uint32 pixelCount) {
+  rgbaToRgbConvert(pixels, pixels, pixelCount);
+}
+
+void rgbaToYuv420Convert(const Uint8 *pixels, Uint32 width, Uint32 height,
+                         Uint8 *const planes[3], const Uint32 pitches[3],
+                         bool bgra) {
+  if (width == 0 || height == 0)
+    return;
+  const YuvCoeffs k{bgra};
+  const SimdLevel level = getSimdLevel();
+  for (Uint32 j = 0; j < height; j++) {
+    const Uint8 *in = pixels + size_t(4 * width) * j;
+    Uint8 *out = planes[0] + size_t(pitches[0]) * j;
+    Uint32 done = 0;
+    switch (level) {
+#ifdef CANDLEWICK_SIMD_X86
+    case SimdLevel::AVX2:
+      done = luma_row_avx2(in, out, width, k);
+      break;
+    case SimdLevel::SSE4_1:
+      done = luma_row_sse41(in, out, width, k);
+      break;
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+    case SimdLevel::NEON:
+      done = luma_row_neon(in, out, width, k);
+      break;
+#endif
+    default:
+      break;
+    }
+    luma_row_scalar(in, out, done, width, k);
+  }
+
+  for (Uint32 j = 0; j < (height + 1) / 2; j++) {
+    const Uint32 r0 = 2 * j;
+    const Uint32 r1 = std::min(r0 + 1, height - 1);
+    chroma_row_scalar(pixels + size_t(4 * width) * r0,
+                      pixels + size_t(4 * width) * r1,
+                      planes[1] + size_t(pitches[1]) * j,
+                      planes[2] + size_t(pitches[2]) * j, width, k);
+  }
+}
+
+void depthToUint16Convert(const float *depth, Uint16 *out, Uint32 count,
+                          float scale) {
+  Uint32 done = 0;
+  switch (getSimdLevel()) {
+#ifdef CANDLEWICK_SIMD_X86
+  case SimdLevel::AVX2:
+    done = depth_to_u16_avx2(depth, out, count, scale);
+    break;
+  case SimdLevel::SSE4_1:
+    done = depth_to_u16_sse41(depth, out, count, scale);
+    break;
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+  case SimdLevel::NEON:
+    done = depth_to_u16_neon(depth, out, count, scale);
+    break;
+#endif
+  default:
+    break;
+  }
+  depth_to_u16_scalar(depth, out, done, count, scale);
+}
+
+Uint16 *depthToUint16Convert(float *depth, Uint32 count, float scale) {
+  // Outputs are written at half the byte offset of the inputs they come from,
+  // after those inputs were read.
+  auto *out = reinterpret_cast<Uint16 *>(depth);
+  depthToUint16Convert(depth, out, count, scale);
+  return out;
+}
+
+void linearizeDepthConvert(const float *depth, float *out, Uint32 count,
+                           float zNear, float zFar) {
+  const LinearizeCoeffs k{zNear, zFar};
+  Uint32 done = 0;
+  switch (getSimdLevel()) {
+#ifdef CANDLEWICK_SIMD_X86
+  case SimdLevel::AVX2:
+    done = linearize_depth_avx2(depth, out, count, k);
+    break;
+  case SimdLevel::SSE4_1:
+    done = linearize_depth_sse41(depth, out, count, k);
+    break;
+#endif
+#ifdef CANDLEWICK_SIMD_NEON
+  case SimdLevel::NEON:
+    done = linearize_depth_neon(depth, out, count, k);
+    break;
+#endif
+  default:
+    break;
+  }
+  linearize_depth_scalar(depth, out, done, count, k);
+}
+
+void linearizeDepthConvert(float *depth, Uint32 count, float zNear,
+                           float zFar) {
+  linearizeDepthConvert(depth, depth, count, zNear, zFar);
+}
+
+float halfToFloat(Uint16 h) {
+  const Uint32 sign = Uint32(h & 0x8000) << 16;
+  const Uint32 exponent = (h >> 10) & 0x1F;
+  const Uint32 mantissa = h & 0x3FF;
+  if (exponent == 0) {
+    // zero or subnormal
+    const float value = std::ldexp(float(mantissa), -24);
+    return (h & 0x8000) ? -value : value;
   }
+  Uint32 bits;
+  if (exponent == 0x1F)
+    bits = sign | 0x7F800000 | (mantissa << 13); // inf or NaN
+  else
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  return std::bit_cast<float>(bits);
 }
 
 } // namespace candlewick
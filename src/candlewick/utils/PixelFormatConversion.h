@@ -4,10 +4,112 @@
 
 namespace candlewick {
 
+/// \brief SIMD instruction sets used by the pixel format conversion kernels.
+enum class SimdLevel : Uint8 {
+  Scalar,
+  SSE4_1,
+  AVX2,
+  NEON,
+};
+
+/// \brief Best instruction set supported by the host CPU (and this build).
+SimdLevel detectSimdLevel();
+
+/// \brief Instruction set currently used by the pixel format conversion
+/// kernels. Defaults to detectSimdLevel().
+SimdLevel getSimdLevel();
+
+/// \brief Override the instruction set used by the conversion kernels, e.g.
+/// for testing or benchmarking purposes.
+///
+/// \returns false (and leaves the current level unchanged) if \p level is not
+/// supported by the host CPU.
+bool setSimdLevel(SimdLevel level);
+
 /// \brief In-place conversion from 8-bit BGRA to 8-bit RGBA.
 ///
 /// \param bgraPixels Pointer to input BGRA image.
 /// \param pixelCount Number of pixels in the BGRA image.
 void bgraToRgbaConvert(Uint32 *bgraPixels, Uint32 pixelCount);
 
+/// \brief Conversion from 8-bit BGRA to 8-bit RGBA.
+///
+/// \param bgraPixels Pointer to input BGRA image.
+/// \param rgbaPixels Pointer to output RGBA image (\p pixelCount elements).
+/// \param pixelCount Number of pixels in the BGRA image.
+void bgraToRgbaConvert(const Uint32 *bgraPixels, Uint32 *rgbaPixels,
+                       Uint32 pixelCount);
+
+/// \brief In-place packing of 8-bit RGBA pixels to 8-bit RGB (dropping alpha).
+///
+/// \param pixels Pointer to input RGBA image. On output, the first
+/// `3 * pixelCount` bytes hold the RGB image.
+/// \param pixelCount Number of pixels in the image.
+void rgbaToRgbConvert(Uint8 *pixels, Uint32 pixelCount);
+
+/// \brief Packing of 8-bit RGBA pixels to 8-bit RGB (dropping alpha).
+///
+/// \param rgbaPixels Pointer to input RGBA image.
+/// \param rgbPixels Pointer to output RGB image (`3 * pixelCount` bytes).
+/// \param pixelCount Number of pixels in the image.
+void rgbaToRgbConvert(const Uint8 *rgbaPixels, Uint8 *rgbPixels,
+                      Uint32 pixelCount);
+
+/// \brief Conversion from 8-bit RGBA (or BGRA) pixels to the planes of a YUV
+/// 4:2:0 frame (ITU-R BT.601, limited range), as written by the GPU
+/// media::YuvConversionPass.
+///
+/// The luma plane has `width x height` samples, and the chroma planes
+/// `(width + 1) / 2 x (height + 1) / 2` samples, each averaging the 2x2 block
+/// of pixels it covers (the last row and column are repeated for odd sizes).
+///
+/// \param pixels Pointer to the input image, tightly packed.
+/// \param width Image width.
+/// \param height Image height.
+/// \param planes Pointers to the output Y, U and V planes.
+/// \param pitches Row pitches of the output planes, in bytes.
+/// \param bgra Whether the input pixels are in BGRA order.
+void rgbaToYuv420Convert(const Uint8 *pixels, Uint32 width, Uint32 height,
+                         Uint8 *const planes[3], const Uint32 pitches[3],
+                         bool bgra = false);
+
+/// \brief Conversion from floating-point depth values to 16-bit unsigned
+/// integers.
+///
+/// Each output value is `depth * scale`, rounded to the nearest integer (ties
+/// to even) and saturated to `[0, 65535]`. NaNs are mapped to 0.
+/// Use e.g. `scale = 65535` for normalized depth, or `scale = 1000` to store
+/// metric depth in millimeters.
+void depthToUint16Convert(const float *depth, Uint16 *out, Uint32 count,
+                          float scale);
+
+/// \brief In-place variant of depthToUint16Convert().
+///
+/// \returns Pointer to the first `count` 16-bit values of the \p depth buffer.
+Uint16 *depthToUint16Convert(float *depth, Uint32 count, float scale);
+
+/// \brief Conversion from depth buffer values (in `[0, 1]`) to linear
+/// view-space depth.
+///
+/// This inverts the perspective projection built by perspectiveFromFov(), for
+/// the `[0, 1]` depth range used by SDL_gpu: depth buffer values are the NDC
+/// depth itself, without the `2 * depth - 1` remapping of OpenGL window depth.
+/// The \c linearizeDepth() shader function (utils.slang) uses the same
+/// convention.
+/// \param zNear Near plane distance of the perspective projection.
+/// \param zFar Far plane distance of the perspective projection.
+void linearizeDepthConvert(const float *depth, float *out, Uint32 count,
+                           float zNear, float zFar);
+
+/// \brief In-place variant of linearizeDepthConvert().
+void linearizeDepthConvert(float *depth, Uint32 count, float zNear,
+                           float zFar);
+
+/// \brief Conversion from an IEEE 754 half-precision float, e.g. a texel of a
+/// 16-bit float texture, to single precision.
+///
+/// All values are converted exactly, including subnormals, infinities and
+/// NaNs.
+float halfToFloat(Uint16 h);
+
 } // namespace candlewick
@@ -1,7 +1,10 @@
 #include "VideoRecorder.h"
+#include "PixelFormatConversion.h"
 #include "WriteTextureToImage.h"
+#include "YuvConversionPass.h"
 #include "../core/errors.h"
 #include "../core/Device.h"
+#include "../core/Shader.h"
 #include "../core/Texture.h"
 
 #include <SDL3/SDL_filesystem.h>
@@ -11,6 +14,7 @@
 #include <spdlog/fmt/std.h>
 
 extern "C" {
+#include <libavutil/imgutils.h>
 #include <libavutil/pixfmt.h>
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -71,6 +75,8 @@ namespace media {
     AVFrame *m_frame = nullptr;
     AVFrame *m_tmpFrame = nullptr;
     AVPacket *m_packet = nullptr;
+    bool m_gpuConversion;
+    YuvConversionPass m_yuvPass{NoInit};
 
     VideoRecorderImpl(int width, int height, std::string_view filename,
                       VideoRecorder::Settings settings);
@@ -81,6 +87,27 @@ namespace media {
     void writeFrame(const Uint8 *data, Uint32 payloadSize,
                     AVPixelFormat avPixelFormat);
 
+    /// Write a frame from 8-bit RGBA or BGRA pixels, converted with
+    /// rgbaToYuv420Convert(). Requires the input and output sizes to match.
+    void writeRgbaFrame(const Uint8 *data, bool bgra);
+
+    /// Whether frames in \p avPixelFormat can go through writeRgbaFrame().
+    bool canConvertRgba(AVPixelFormat avPixelFormat) const {
+      return (avPixelFormat == AV_PIX_FMT_RGBA ||
+              avPixelFormat == AV_PIX_FMT_BGRA) &&
+             m_frame->width == m_width && m_frame->height == m_height &&
+             m_codecContext->pix_fmt == AV_PIX_FMT_YUV420P;
+    }
+
+    /// Write a frame from YUV planes already in the encoder's format.
+    void writeYuvFrame(const YuvDownloadResult &planes);
+
+    /// Make the principal frame writable and stamp it.
+    void prepareFrame();
+
+    /// Send the principal frame to the encoder and write out packets.
+    void encodeFrame();
+
     void close() noexcept;
 
     ~VideoRecorderImpl() noexcept { this->close(); }
@@ -107,6 +134,8 @@ namespace media {
 
     av_write_trailer(m_formatContext);
 
+    m_yuvPass.release();
+
     // close out stream
     av_frame_free(&m_frame);
     av_frame_free(&m_tmpFrame);
@@ -122,7 +151,9 @@ namespace media {
   VideoRecorderImpl::VideoRecorderImpl(int width, int height,
                                        std::string_view filename,
                                        VideoRecorder::Settings settings)
-      : m_width(width), m_height(height) {
+      : m_width(width)
+      , m_height(height)
+      , m_gpuConversion(settings.gpuConversion) {
 
     assert(settings.outputWidth > 0);
     assert(settings.outputHeight > 0);
@@ -214,19 +245,51 @@ namespace media {
     // copy input payload to tmp frame
     memcpy(m_tmpFrame->data[0], data, payloadSize);
 
+    prepareFrame();
+    sws_scale(m_swsContext, m_tmpFrame->data, m_tmpFrame->linesize, 0, m_height,
+              m_frame->data, m_frame->linesize);
+    encodeFrame();
+  }
+
+  void VideoRecorderImpl::writeRgbaFrame(const Uint8 *data, bool bgra) {
+    assert(m_frame);
+    prepareFrame();
+    const Uint32 pitches[3] = {Uint32(m_frame->linesize[0]),
+                               Uint32(m_frame->linesize[1]),
+                               Uint32(m_frame->linesize[2])};
+    rgbaToYuv420Convert(data, Uint32(m_width), Uint32(m_height),
+                        m_frame->data, pitches, bgra);
+    encodeFrame();
+  }
+
+  void VideoRecorderImpl::writeYuvFrame(const YuvDownloadResult &planes) {
+    assert(m_frame);
+    assert(m_codecContext->pix_fmt == AV_PIX_FMT_YUV420P);
+    prepareFrame();
+    for (int i = 0; i < 3; i++) {
+      // planes are tightly packed, frame lines may be padded
+      av_image_copy_plane(m_frame->data[i], m_frame->linesize[i],
+                          planes.planes[i], int(planes.widths[i]),
+                          int(planes.widths[i]), int(planes.heights[i]));
+    }
+    encodeFrame();
+  }
+
+  void VideoRecorderImpl::prepareFrame() {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE]{0};
     // ensure frame writable
-    ret = av_frame_make_writable(m_frame);
+    int ret = av_frame_make_writable(m_frame);
     if (ret < 0) {
       terminate_with_message(
           "Failed to make frame writable: {:s}",
           av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, ret));
     }
     m_frame->pts = m_frameCounter++;
+  }
 
-    sws_scale(m_swsContext, m_tmpFrame->data, m_tmpFrame->linesize, 0, m_height,
-              m_frame->data, m_frame->linesize);
-
-    ret = avcodec_send_frame(m_codecContext, m_frame);
+  void VideoRecorderImpl::encodeFrame() {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE]{0};
+    int ret = avcodec_send_frame(m_codecContext, m_frame);
     if (ret < 0) {
       terminate_with_message(
           "Error sending frame {:s}",
@@ -311,14 +374,46 @@ namespace media {
                                           TransferBufferPool &pool,
                                           SDL_GPUTexture *texture,
                                           SDL_GPUTextureFormat format) {
+    auto &impl = *m_impl;
+    if (impl.m_gpuConversion && !impl.m_yuvPass.initialized() &&
+        !YuvConversionPass::isSupported(device)) {
+      spdlog::warn("[{}] GPU color conversion shaders not found in '{:s}', "
+                   "falling back to CPU conversion.",
+                   typeid(*this), currentShaderDirectory());
+      impl.m_gpuConversion = false;
+    }
+    if (impl.m_gpuConversion && !impl.m_yuvPass.initialized()) {
+      try {
+        impl.m_yuvPass = YuvConversionPass(
+            device, Uint32(impl.m_frame->width), Uint32(impl.m_frame->height));
+      } catch (const std::exception &e) {
+        spdlog::warn("[{}] GPU color conversion unavailable, falling back to "
+                     "CPU conversion: {:s}",
+                     typeid(*this), e.what());
+        impl.m_gpuConversion = false;
+      }
+    }
+
+    if (impl.m_gpuConversion) {
+      impl.m_yuvPass.render(command_buffer, texture);
+      auto res = impl.m_yuvPass.download(command_buffer, pool);
+      impl.writeYuvFrame(res);
+      SDL_UnmapGPUTransferBuffer(device, res.buffer);
+      return;
+    }
 
     auto res = downloadTexture(command_buffer, device, pool, texture, format,
                                Uint16(m_width), Uint16(m_height));
 
     AVPixelFormat outputFormat =
         convert_SDLTextureFormatTo_AVPixelFormat(format);
-    m_impl->writeFrame(reinterpret_cast<Uint8 *>(res.data), res.payloadSize,
-                       outputFormat);
+    if (impl.canConvertRgba(outputFormat)) {
+      impl.writeRgbaFrame(reinterpret_cast<Uint8 *>(res.data),
+                          outputFormat == AV_PIX_FMT_BGRA);
+    } else {
+      impl.writeFrame(reinterpret_cast<Uint8 *>(res.data), res.payloadSize,
+                      outputFormat);
+    }
 
     SDL_UnmapGPUTransferBuffer(device, res.buffer);
   }
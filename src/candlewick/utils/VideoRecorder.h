@@ -29,6 +29,11 @@ namespace media {
       int bitRate = 2'500'000u;
       int outputWidth = 0;
       int outputHeight = 0;
+      /// Rescale and convert frames to YUV 4:2:0 on the GPU before readback.
+      /// If disabled (or unavailable), full-size frames are read back and
+      /// converted on the CPU, with rgbaToYuv420Convert() if the output size
+      /// is the input size, and swscale otherwise.
+      bool gpuConversion = true;
     };
 
     /// \brief Constructor which will not open the file or stream.
@@ -53,12 +53,8 @@ namespace media {
     return _buffer;
   }
 
-  DownloadResult downloadTexture(CommandBuffer &command_buffer,
-                                 const Device &device, TransferBufferPool &pool,
-                                 SDL_GPUTexture *texture,
-                                 SDL_GPUTextureFormat format,
-                                 const Uint16 width, const Uint16 height) {
-
+  static Uint32 checkedPayloadSize(SDL_GPUTextureFormat format, Uint16 width,
+                                   Uint16 height) {
     // pixel size, in bytes
     const Uint32 pixelSize = SDL_GPUTextureFormatTexelBlockSize(format);
     const Uint32 requiredSize = width * height * pixelSize;
@@ -69,33 +65,75 @@ namespace media {
           "The required size for the payload ({:d} bytes) is different from "
           "the target texture's size ({:d} bytes)",
           requiredSize, texSize);
+    return requiredSize;
+  }
+
+  std::vector<DownloadResult>
+  downloadTextures(CommandBuffer &command_buffer, const Device &device,
+                   TransferBufferPool &pool,
+                   std::span<const TextureDownloadInfo> textures) {
+    // offsets into the transfer buffer, aligned for SIMD loads
+    constexpr Uint32 alignment = 16;
+    std::vector<Uint32> offsets;
+    offsets.reserve(textures.size());
+    Uint32 totalSize = 0;
+    for (auto &tex : textures) {
+      offsets.push_back(totalSize);
+      totalSize += checkedPayloadSize(tex.format, tex.width, tex.height);
+      totalSize = (totalSize + alignment - 1) / alignment * alignment;
+    }
 
-    SDL_GPUTransferBuffer *buffer = pool.acquireBuffer(requiredSize);
+    SDL_GPUTransferBuffer *buffer = pool.acquireBuffer(totalSize);
 
     SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
-    SDL_GPUTextureRegion source{
-        .texture = texture,
-        .layer = 0,
-        .w = width,
-        .h = height,
-    };
-    SDL_GPUTextureTransferInfo destination{
-        .transfer_buffer = buffer,
-        .offset = 0,
-    };
-    SDL_DownloadFromGPUTexture(copy_pass, &source, &destination);
+    for (size_t i = 0; i < textures.size(); i++) {
+      SDL_GPUTextureRegion source{
+          .texture = textures[i].texture,
+          .layer = 0,
+          .x = textures[i].x,
+          .y = textures[i].y,
+          .w = textures[i].width,
+          .h = textures[i].height,
+          .d = 1,
+      };
+      SDL_GPUTextureTransferInfo destination{
+          .transfer_buffer = buffer,
+          .offset = offsets[i],
+      };
+      SDL_DownloadFromGPUTexture(copy_pass, &source, &destination);
+    }
     SDL_EndGPUCopyPass(copy_pass);
-    command_buffer.submit();
-
-    return {
-        .data = reinterpret_cast<Uint32 *>(
-            SDL_MapGPUTransferBuffer(device, buffer, false)),
-        .format = format,
-        .width = width,
-        .height = height,
-        .buffer = buffer,
-        .payloadSize = requiredSize,
-    };
+
+    // the data is only available once the command buffer has completed
+    SDL_GPUFence *fence = command_buffer.submitAndAcquireFence();
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+    SDL_ReleaseGPUFence(device, fence);
+
+    auto *data =
+        static_cast<Uint8 *>(SDL_MapGPUTransferBuffer(device, buffer, false));
+    std::vector<DownloadResult> results;
+    results.reserve(textures.size());
+    for (size_t i = 0; i < textures.size(); i++) {
+      auto &tex = textures[i];
+      results.push_back({
+          .data = reinterpret_cast<Uint32 *>(data + offsets[i]),
+          .format = tex.format,
+          .width = tex.width,
+          .height = tex.height,
+          .buffer = buffer,
+          .payloadSize = checkedPayloadSize(tex.format, tex.width, tex.height),
+      });
+    }
+    return results;
+  }
+
+  DownloadResult downloadTexture(CommandBuffer &command_buffer,
+                                 const Device &device, TransferBufferPool &pool,
+                                 SDL_GPUTexture *texture,
+                                 SDL_GPUTextureFormat format,
+                                 const Uint16 width, const Uint16 height) {
+    const TextureDownloadInfo info{texture, format, width, height};
+    return downloadTextures(command_buffer, device, pool, {&info, 1})[0];
   }
 
   void saveTextureToFile(CommandBuffer &command_buffer, const Device &device,
@@ -112,13 +150,14 @@ namespace media {
     auto size = size_t(res.height * res.width);
     std::vector<Uint32> pixels_to_write;
     pixels_to_write.resize(size);
-    std::copy_n(res.data, size, pixels_to_write.begin());
 
     switch (format) {
     case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:
-      bgraToRgbaConvert(pixels_to_write.data(), res.width * res.height);
+      // convert while copying out of the mapped buffer
+      bgraToRgbaConvert(res.data, pixels_to_write.data(), Uint32(size));
       break;
     default:
+      std::copy_n(res.data, size, pixels_to_write.begin());
       break;
     }
 
@@ -2,6 +2,8 @@
 
 #include "../core/Core.h"
 #include <SDL3/SDL_gpu.h>
+#include <span>
+#include <vector>
 
 namespace candlewick {
 namespace media {
@@ -39,6 +41,27 @@ namespace media {
                                  SDL_GPUTextureFormat format,
                                  const Uint16 width, const Uint16 height);
 
+  struct TextureDownloadInfo {
+    SDL_GPUTexture *texture;
+    SDL_GPUTextureFormat format;
+    Uint16 width;
+    Uint16 height;
+    /// Offset of the downloaded region in the texture.
+    Uint16 x = 0;
+    Uint16 y = 0;
+  };
+
+  /// \brief Download several textures in a single copy pass, to the same
+  /// mapped buffer.
+  ///
+  /// This waits for the command buffer to complete. All results point into the
+  /// same transfer buffer, which must be unmapped once.
+  /// \warning Calling this function will submit the provided command buffer.
+  std::vector<DownloadResult>
+  downloadTextures(CommandBuffer &command_buffer, const Device &device,
+                   TransferBufferPool &pool,
+                   std::span<const TextureDownloadInfo> textures);
+
   void saveTextureToFile(CommandBuffer &command_buffer, const Device &device,
                          TransferBufferPool &pool, SDL_GPUTexture *texture,
                          SDL_GPUTextureFormat format, const Uint16 width,
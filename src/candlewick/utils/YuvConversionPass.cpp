@@ -0,0 +1,207 @@
+#include "YuvConversionPass.h"
+#include "WriteTextureToImage.h"
+
+#include "../core/CommandBuffer.h"
+#include "../core/Device.h"
+#include "../core/RenderContext.h"
+#include "../core/Shader.h"
+#include "../core/math_types.h"
+
+namespace candlewick {
+namespace media {
+
+  static Texture create_plane_texture(const Device &device, Uint32 width,
+                                      Uint32 height, const char *name) {
+    SDL_GPUTextureCreateInfo texture_desc{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8_UNORM,
+        .usage =
+            SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        .props = 0,
+    };
+    return Texture{device, texture_desc, name};
+  }
+
+  bool YuvConversionPass::isSupported(const Device &device) {
+    return shaderExists(device, "DrawQuad.vert") &&
+           shaderExists(device, "RgbToYuvLuma.frag") &&
+           shaderExists(device, "RgbToYuvChroma.frag");
+  }
+
+  YuvConversionPass::YuvConversionPass(const Device &device, Uint32 width,
+                                       Uint32 height)
+      : _device(device) {
+    // chroma planes are subsampled by 2, rounding up
+    const Uint32 chromaWidth = (width + 1) / 2;
+    const Uint32 chromaHeight = (height + 1) / 2;
+    lumaTex = create_plane_texture(device, width, height, "YUV luma plane");
+    chromaUTex = create_plane_texture(device, chromaWidth, chromaHeight,
+                                      "YUV chroma plane (U)");
+    chromaVTex = create_plane_texture(device, chromaWidth, chromaHeight,
+                                      "YUV chroma plane (V)");
+
+    // linear filtering performs the rescaling to the output size
+    SDL_GPUSamplerCreateInfo sampler_ci{
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+    };
+    sampler = SDL_CreateGPUSampler(device, &sampler_ci);
+
+    auto vertexShader = Shader::fromMetadata(device, "DrawQuad.vert");
+    auto lumaShader = Shader::fromMetadata(device, "RgbToYuvLuma.frag");
+    auto chromaShader = Shader::fromMetadata(device, "RgbToYuvChroma.frag");
+
+    SDL_GPUColorTargetDescription color_descs[2];
+    SDL_zero(color_descs);
+    color_descs[0].format = SDL_GPU_TEXTUREFORMAT_R8_UNORM;
+    color_descs[1].format = SDL_GPU_TEXTUREFORMAT_R8_UNORM;
+    SDL_GPUGraphicsPipelineCreateInfo pipeline_desc{
+        .vertex_shader = vertexShader,
+        .fragment_shader = lumaShader,
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .rasterizer_state{.fill_mode = SDL_GPU_FILLMODE_FILL,
+                          .cull_mode = SDL_GPU_CULLMODE_NONE},
+        .target_info{.color_target_descriptions = color_descs,
+                     .num_color_targets = 1,
+                     .has_depth_stencil_target = false},
+    };
+    lumaPipeline =
+        GraphicsPipeline(device, pipeline_desc, "YUV conversion [luma]");
+
+    pipeline_desc.fragment_shader = chromaShader;
+    pipeline_desc.target_info.num_color_targets = 2;
+    chromaPipeline =
+        GraphicsPipeline(device, pipeline_desc, "YUV conversion [chroma]");
+  }
+
+  YuvConversionPass::YuvConversionPass(YuvConversionPass &&other) noexcept
+      : _device(other._device)
+      , sampler(other.sampler)
+      , lumaPipeline(std::move(other.lumaPipeline))
+      , chromaPipeline(std::move(other.chromaPipeline))
+      , lumaTex(std::move(other.lumaTex))
+      , chromaUTex(std::move(other.chromaUTex))
+      , chromaVTex(std::move(other.chromaVTex)) {
+    other._device = nullptr;
+    other.sampler = nullptr;
+  }
+
+  YuvConversionPass &
+  YuvConversionPass::operator=(YuvConversionPass &&other) noexcept {
+    if (this != &other) {
+      this->release();
+#define _c(name) name = std::move(other.name)
+      _c(_device);
+      _c(sampler);
+      _c(lumaPipeline);
+      _c(chromaPipeline);
+      _c(lumaTex);
+      _c(chromaUTex);
+      _c(chromaVTex);
+#undef _c
+
+      other._device = nullptr;
+      other.sampler = nullptr;
+    }
+    return *this;
+  }
+
+  void YuvConversionPass::render(CommandBuffer &command_buffer,
+                                 SDL_GPUTexture *source) {
+    SDL_GPUColorTargetInfo color_infos[2];
+    SDL_zero(color_infos);
+    for (auto &info : color_infos) {
+      info.load_op = SDL_GPU_LOADOP_DONT_CARE;
+      info.store_op = SDL_GPU_STOREOP_STORE;
+    }
+    const SDL_GPUTextureSamplerBinding source_binding{.texture = source,
+                                                      .sampler = sampler};
+
+    color_infos[0].texture = lumaTex;
+    SDL_GPURenderPass *render_pass =
+        rend::beginRenderPass(command_buffer, {color_infos, 1});
+    lumaPipeline.bind(render_pass);
+    rend::bindFragmentSamplers(render_pass, 0, {source_binding});
+    rend::drawPrimitives(render_pass, 6);
+    SDL_EndGPURenderPass(render_pass);
+
+    color_infos[0].texture = chromaUTex;
+    color_infos[1].texture = chromaVTex;
+    render_pass = rend::beginRenderPass(command_buffer, color_infos);
+    chromaPipeline.bind(render_pass);
+    rend::bindFragmentSamplers(render_pass, 0, {source_binding});
+    rend::drawPrimitives(render_pass, 6);
+    SDL_EndGPURenderPass(render_pass);
+  }
+
+  YuvDownloadResult YuvConversionPass::download(CommandBuffer &command_buffer,
+                                                TransferBufferPool &pool) {
+    const Texture *planes[3] = {&lumaTex, &chromaUTex, &chromaVTex};
+    Uint32 offsets[3];
+    Uint32 requiredSize = 0;
+    for (size_t i = 0; i < 3; i++) {
+      // keep each plane's offset aligned for the backends' copy commands
+      offsets[i] = math::roundUpTo16(requiredSize);
+      requiredSize = offsets[i] + planes[i]->textureSize();
+    }
+
+    SDL_GPUTransferBuffer *buffer = pool.acquireBuffer(requiredSize);
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    for (size_t i = 0; i < 3; i++) {
+      SDL_GPUTextureRegion source{
+          .texture = *planes[i],
+          .layer = 0,
+          .w = planes[i]->width(),
+          .h = planes[i]->height(),
+          .d = 1,
+      };
+      SDL_GPUTextureTransferInfo destination{
+          .transfer_buffer = buffer,
+          .offset = offsets[i],
+      };
+      SDL_DownloadFromGPUTexture(copy_pass, &source, &destination);
+    }
+    SDL_EndGPUCopyPass(copy_pass);
+
+    SDL_GPUFence *fence = command_buffer.submitAndAcquireFence();
+    SDL_WaitForGPUFences(_device, true, &fence, 1);
+    SDL_ReleaseGPUFence(_device, fence);
+
+    auto *data = reinterpret_cast<const Uint8 *>(
+        SDL_MapGPUTransferBuffer(_device, buffer, false));
+    YuvDownloadResult result;
+    for (size_t i = 0; i < 3; i++) {
+      result.planes[i] = data + offsets[i];
+      result.widths[i] = planes[i]->width();
+      result.heights[i] = planes[i]->height();
+    }
+    result.buffer = buffer;
+    return result;
+  }
+
+  void YuvConversionPass::release() noexcept {
+    if (_device) {
+      if (sampler)
+        SDL_ReleaseGPUSampler(_device, sampler);
+      sampler = nullptr;
+      _device = nullptr;
+    }
+    lumaPipeline.release();
+    chromaPipeline.release();
+    lumaTex.destroy();
+    chromaUTex.destroy();
+    chromaVTex.destroy();
+  }
+
+} // namespace media
+} // namespace candlewick
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../core/GraphicsPipeline.h"
+#include "../core/Texture.h"
+#include <SDL3/SDL_gpu.h>
+
+namespace candlewick {
+namespace media {
+
+  class TransferBufferPool;
+
+  /// \brief Planes of a YUV 4:2:0 frame, read back from the GPU.
+  ///
+  /// The planes are tightly packed and live in a mapped transfer buffer.
+  /// \warning The user is expected to unmap the buffer once done.
+  struct YuvDownloadResult {
+    const Uint8 *planes[3];
+    Uint32 widths[3];
+    Uint32 heights[3];
+    SDL_GPUTransferBuffer *buffer; // used for unmapping later
+  };
+
+  /// \brief GPU pass which rescales a color texture and converts it to planar
+  /// YUV 4:2:0 (BT.601, limited range).
+  ///
+  /// The luma plane is rendered at the output resolution, and the two chroma
+  /// planes at half of it. Reading back these planes instead of the source
+  /// texture transfers 1.5 bytes per output pixel instead of 4 bytes per input
+  /// pixel, and requires no CPU-side color conversion.
+  struct YuvConversionPass {
+    SDL_GPUDevice *_device = nullptr;
+    SDL_GPUSampler *sampler = nullptr;
+    GraphicsPipeline lumaPipeline{NoInit};
+    GraphicsPipeline chromaPipeline{NoInit};
+    Texture lumaTex{NoInit};
+    Texture chromaUTex{NoInit};
+    Texture chromaVTex{NoInit};
+
+    YuvConversionPass(NoInitT) {}
+    /// \param device GPU device
+    /// \param width Output width.
+    /// \param height Output height.
+    YuvConversionPass(const Device &device, Uint32 width, Uint32 height);
+
+    YuvConversionPass(YuvConversionPass &&other) noexcept;
+    YuvConversionPass &operator=(YuvConversionPass &&other) noexcept;
+
+    bool initialized() const noexcept { return _device != nullptr; }
+
+    /// \brief Whether the conversion shaders are compiled and can be loaded
+    /// for \p device.
+    static bool isSupported(const Device &device);
+
+    Uint32 width() const { return lumaTex.width(); }
+    Uint32 height() const { return lumaTex.height(); }
+
+    /// \brief Render the Y, U and V planes from the \p source texture.
+    void render(CommandBuffer &command_buffer, SDL_GPUTexture *source);
+
+    /// \brief Download the planes rendered by render() to a mapped buffer.
+    ///
+    /// \warning Calling this function will submit the provided command buffer
+    /// and wait for it to complete.
+    YuvDownloadResult download(CommandBuffer &command_buffer,
+                               TransferBufferPool &pool);
+
+    void release() noexcept;
+
+    ~YuvConversionPass() noexcept { this->release(); }
+  };
+
+} // namespace media
+} // namespace candlewick
@@ -0,0 +1,98 @@
+#include "candlewick/multibody/MultiViewRenderer.h"
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/multibody/model.hpp>
+#include <gtest/gtest.h>
+
+using namespace candlewick;
+using multibody::CameraIntrinsics;
+
+namespace {
+/// Pinhole projection of a point in the optical frame (x right, y down, z
+/// forward), in pixels from the top-left corner of the image.
+Float2 pinhole(const CameraIntrinsics &k, const Float3 &p) {
+  return {k.fx * p.x() / p.z() + k.cx, k.fy * p.y() / p.z() + k.cy};
+}
+
+/// Pixel coordinates and NDC depth of a point in the optical frame, through
+/// the projection matrix of \p k.
+Float3 project(const CameraIntrinsics &k, const Float3 &p) {
+  // the OpenGL camera frame is rotated by pi around x
+  const Float4 clip = k.projection() * Float4{p.x(), -p.y(), -p.z(), 1.f};
+  const Float3 ndc = clip.head<3>() / clip.w();
+  return {0.5f * (ndc.x() + 1.f) * float(k.width),
+          0.5f * (1.f - ndc.y()) * float(k.height), ndc.z()};
+}
+
+const CameraIntrinsics kOffCenter{
+    .fx = 600.f,
+    .fy = 580.f,
+    .cx = 310.f,
+    .cy = 250.f,
+    .width = 640,
+    .height = 480,
+    .zNear = 0.1f,
+    .zFar = 10.f,
+};
+} // namespace
+
+GTEST_TEST(TestCameraIntrinsics, projection_matches_pinhole) {
+  const Float3 points[] = {
+      {0.f, 0.f, 1.f},   {0.3f, -0.2f, 2.f}, {-1.f, 0.5f, 4.f},
+      {0.05f, 0.7f, 0.5f}, {2.f, 1.f, 9.f},
+  };
+  for (const Float3 &p : points) {
+    const Float2 expected = pinhole(kOffCenter, p);
+    const Float3 actual = project(kOffCenter, p);
+    EXPECT_NEAR(actual.x(), expected.x(), 1e-2f) << p.transpose();
+    EXPECT_NEAR(actual.y(), expected.y(), 1e-2f) << p.transpose();
+  }
+}
+
+GTEST_TEST(TestCameraIntrinsics, image_corners_and_depth_range) {
+  const auto &k = kOffCenter;
+  // the near plane spans the whole image
+  const float z = k.zNear;
+  const Float3 topLeft = project(k, {-k.cx * z / k.fx, -k.cy * z / k.fy, z});
+  EXPECT_NEAR(topLeft.x(), 0.f, 1e-3f);
+  EXPECT_NEAR(topLeft.y(), 0.f, 1e-3f);
+  EXPECT_NEAR(topLeft.z(), -1.f, 1e-5f);
+  const Float3 bottomRight =
+      project(k, {(float(k.width) - k.cx) * z / k.fx,
+                  (float(k.height) - k.cy) * z / k.fy, z});
+  EXPECT_NEAR(bottomRight.x(), float(k.width), 1e-2f);
+  EXPECT_NEAR(bottomRight.y(), float(k.height), 1e-2f);
+  EXPECT_NEAR(project(k, {0.f, 0.f, k.zFar}).z(), 1.f, 1e-5f);
+}
+
+GTEST_TEST(TestCameraIntrinsics, from_fov) {
+  const Radf fovY{0.8f};
+  const float aspect = 16.f / 9.f;
+  const auto k = CameraIntrinsics::fromFov(fovY, 1280, 720, 0.05f, 50.f);
+  EXPECT_FLOAT_EQ(k.cx, 640.f);
+  EXPECT_FLOAT_EQ(k.cy, 360.f);
+  EXPECT_TRUE(k.projection().isApprox(
+      perspectiveFromFov(fovY, aspect, 0.05f, 50.f), 1e-5f));
+}
+
+GTEST_TEST(TestCameraIntrinsics, sensor_camera) {
+  const pin::Model model;
+  const pin::Data data{model};
+  multibody::MultiViewRenderer::View view;
+  view.config.intrinsics = kOffCenter;
+  // sensor at (1, 2, 0.5) looking down the world x-axis, image x-axis along
+  // -y and image y-axis along -z
+  Mat3f R;
+  R << 0.f, 0.f, 1.f, //
+      -1.f, 0.f, 0.f, //
+      0.f, -1.f, 0.f;
+  view.config.placement = SE3f{R, Float3{1.f, 2.f, 0.5f}};
+  const Camera camera = view.camera(data);
+
+  const Float3 world{4.f, 1.5f, 0.2f};
+  const Float3 optical = view.config.placement.actInv(world);
+  const Float2 expected = pinhole(kOffCenter, optical);
+  const Float4 clip = camera.viewProj() * world.homogeneous();
+  const Float2 ndc = clip.head<2>() / clip.w();
+  EXPECT_NEAR(0.5f * (ndc.x() + 1.f) * 640.f, expected.x(), 1e-2f);
+  EXPECT_NEAR(0.5f * (1.f - ndc.y()) * 480.f, expected.y(), 1e-2f);
+}
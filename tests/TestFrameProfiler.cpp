@@ -0,0 +1,93 @@
+#include "candlewick/core/Profiler.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using candlewick::FrameProfiler;
+
+GTEST_TEST(TestFrameProfiler, nested_zones) {
+  FrameProfiler profiler{4};
+  profiler.beginFrame();
+  profiler.beginZone("outer");
+  profiler.beginZone("inner");
+  profiler.endZone();
+  profiler.beginZone("inner");
+  profiler.endZone();
+  profiler.endZone();
+  profiler.beginZone("other");
+  profiler.endFrame(); // closes "other"
+
+  ASSERT_EQ(profiler.numFrames(), 1u);
+  const auto &frame = profiler.latestFrame();
+  ASSERT_EQ(frame.zones.size(), 4u);
+  EXPECT_STREQ(frame.zones[0].name, "outer");
+  EXPECT_EQ(frame.zones[0].depth, 0u);
+  EXPECT_EQ(frame.zones[1].depth, 1u);
+  EXPECT_EQ(frame.zones[2].depth, 1u);
+  EXPECT_EQ(frame.zones[3].depth, 0u);
+  EXPECT_LE(frame.zones[1].start + frame.zones[1].duration,
+            frame.zones[2].start);
+  EXPECT_EQ(frame.zoneDuration("inner"),
+            frame.zones[1].duration + frame.zones[2].duration);
+  EXPECT_LE(frame.zoneDuration("inner"), frame.zoneDuration("outer"));
+  EXPECT_LE(frame.zones[0].duration, frame.duration);
+}
+
+GTEST_TEST(TestFrameProfiler, ring_buffer) {
+  FrameProfiler profiler{3};
+  // zones outside of a frame are ignored
+  profiler.beginZone("ignored");
+  profiler.endZone();
+  EXPECT_EQ(profiler.numFrames(), 0u);
+
+  for (int i = 0; i < 5; i++) {
+    profiler.beginFrame();
+    profiler.endFrame();
+  }
+  ASSERT_EQ(profiler.numFrames(), 3u);
+  EXPECT_EQ(profiler.frame(0).index, 2u);
+  EXPECT_EQ(profiler.latestFrame().index, 4u);
+
+  // complete frames are not overwritten while recording the next one
+  profiler.beginFrame();
+  profiler.beginZone("zone");
+  ASSERT_EQ(profiler.numFrames(), 3u);
+  EXPECT_EQ(profiler.frame(0).index, 2u);
+  EXPECT_EQ(profiler.latestFrame().index, 4u);
+  EXPECT_TRUE(profiler.frame(0).zones.empty());
+  profiler.endFrame();
+  EXPECT_EQ(profiler.frame(0).index, 3u);
+  EXPECT_EQ(profiler.latestFrame().index, 5u);
+  EXPECT_EQ(profiler.latestFrame().zones.size(), 1u);
+
+  profiler.setEnabled(false);
+  profiler.beginFrame();
+  profiler.endFrame();
+  EXPECT_EQ(profiler.latestFrame().index, 5u);
+
+  profiler.clear();
+  EXPECT_EQ(profiler.numFrames(), 0u);
+}
+
+GTEST_TEST(TestFrameProfiler, chrome_trace) {
+  FrameProfiler profiler;
+  profiler.beginFrame();
+  profiler.beginZone("renderOpaque");
+  profiler.endZone();
+  profiler.endFrame();
+
+  const auto path =
+      std::filesystem::temp_directory_path() / "candlewick_test_trace.json";
+  profiler.writeChromeTrace(path.string());
+  std::ifstream file{path};
+  std::stringstream contents;
+  contents << file.rdbuf();
+  std::filesystem::remove(path);
+
+  EXPECT_NE(contents.str().find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(contents.str().find("\"renderOpaque\""), std::string::npos);
+  EXPECT_THROW(profiler.writeChromeTrace("/nonexistent/dir/trace.json"),
+               std::runtime_error);
+}
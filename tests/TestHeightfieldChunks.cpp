@@ -0,0 +1,157 @@
+#include "candlewick/primitives/Heightfield.h"
+#include <gtest/gtest.h>
+
+#include <set>
+
+using namespace candlewick;
+using StitchSide = HeightfieldChunks::StitchSide;
+
+namespace {
+struct HeightfieldFixture : ::testing::Test {
+  // 129 x 65 cells, not multiples of the chunk size
+  Eigen::MatrixXf heights = Eigen::MatrixXf::Random(130, 66);
+  Eigen::VectorXf xgrid = Eigen::VectorXf::LinSpaced(130, -6.5f, 6.5f);
+  Eigen::VectorXf ygrid = Eigen::VectorXf::LinSpaced(66, -3.3f, 3.3f);
+  HeightfieldChunks chunks;
+};
+
+/// Twice the signed area of a triangle of chunk vertices, in grid units.
+long doubleArea(Uint32 a, Uint32 b, Uint32 c, Uint32 n) {
+  auto x = [n](Uint32 v) { return long(v % (n + 1)); };
+  auto y = [n](Uint32 v) { return long(v / (n + 1)); };
+  return (x(b) - x(a)) * (y(c) - y(a)) - (x(c) - x(a)) * (y(b) - y(a));
+}
+} // namespace
+
+TEST_F(HeightfieldFixture, layout) {
+  MeshData data = loadHeightfieldChunks(heights, xgrid, ygrid, chunks, 32);
+  EXPECT_EQ(data.primitiveType, SDL_GPU_PRIMITIVETYPE_LINELIST);
+  EXPECT_EQ(chunks.chunkSize, 32u);
+  EXPECT_EQ(chunks.numLods, 6u);
+  EXPECT_EQ(chunks.chunksX, 5u);
+  EXPECT_EQ(chunks.chunksY, 3u);
+  EXPECT_EQ(chunks.bounds.size(), 15u);
+  EXPECT_EQ(chunks.patterns.size(), 6u * HeightfieldChunks::kNumStitchMasks);
+  EXPECT_EQ(data.numVertices(), 15u * 33u * 33u);
+
+  // the padded last chunk ends on the grid
+  const AABB &last = chunks.bounds.back();
+  EXPECT_FLOAT_EQ(float(last.max_.x()), 6.5f);
+  EXPECT_FLOAT_EQ(float(last.max_.y()), 3.3f);
+  for (const auto &range : chunks.patterns) {
+    EXPECT_LE(range.indexOffset + range.indexCount, data.numIndices());
+  }
+}
+
+TEST_F(HeightfieldFixture, stitched_patterns_are_crack_free) {
+  const Uint32 n = 16;
+  MeshData data =
+      loadHeightfieldChunks(heights, xgrid, ygrid, chunks, n, /*solid=*/true);
+  EXPECT_EQ(data.primitiveType, SDL_GPU_PRIMITIVETYPE_TRIANGLELIST);
+
+  for (Uint32 lod = 0; lod < chunks.numLods; lod++) {
+    const Uint32 coarse = 2u << lod;
+    const bool coarsest = lod + 1 == chunks.numLods;
+    for (Uint32 mask = 0; mask < HeightfieldChunks::kNumStitchMasks; mask++) {
+      const auto &range = chunks.pattern(lod, mask);
+      ASSERT_EQ(range.indexCount % 3, 0u);
+      // triangles tile the chunk, with a consistent orientation
+      long area = 0;
+      for (Uint32 k = 0; k < range.indexCount; k += 3) {
+        const Uint32 *tri = &data.indexData[range.indexOffset + k];
+        const long a = doubleArea(tri[0], tri[1], tri[2], n);
+        EXPECT_GT(a, 0);
+        area += a;
+      }
+      EXPECT_EQ(area, long(2 * n * n));
+
+      // stitched sides only use vertices of the coarser level
+      if (coarsest)
+        continue;
+      for (Uint32 k = 0; k < range.indexCount; k++) {
+        const Uint32 v = data.indexData[range.indexOffset + k];
+        const Uint32 i = v % (n + 1), j = v / (n + 1);
+        if ((i == 0 && (mask & StitchSide::STITCH_NEG_X)) ||
+            (i == n && (mask & StitchSide::STITCH_POS_X)))
+          EXPECT_EQ(j % coarse, 0u);
+        if ((j == 0 && (mask & StitchSide::STITCH_NEG_Y)) ||
+            (j == n && (mask & StitchSide::STITCH_POS_Y)))
+          EXPECT_EQ(i % coarse, 0u);
+      }
+    }
+  }
+}
+
+TEST_F(HeightfieldFixture, select_lods) {
+  loadHeightfieldChunks(heights, xgrid, ygrid, chunks, 8);
+  ASSERT_EQ(chunks.chunksX, 17u);
+  ASSERT_EQ(chunks.chunksY, 9u);
+  std::vector<Uint32> lods(chunks.numChunks());
+  const Float3 camera{-6.5f, -3.3f, 1.f};
+  chunks.selectLods(Mat4f::Identity(), camera, 0.5f, lods);
+
+  EXPECT_EQ(lods.front(), 0u);
+  EXPECT_GT(lods.back(), 0u);
+  for (Uint32 k = 0; k < chunks.numChunks(); k++) {
+    EXPECT_LT(lods[k], chunks.numLods);
+    const Uint32 mask = chunks.stitchMask(lods, k);
+    const Uint32 cx = k % chunks.chunksX;
+    if (cx + 1 < chunks.chunksX) {
+      EXPECT_LE(std::max(lods[k], lods[k + 1]) - std::min(lods[k], lods[k + 1]),
+                1u);
+      EXPECT_EQ(bool(mask & StitchSide::STITCH_POS_X), lods[k + 1] > lods[k]);
+    }
+    if (k + chunks.chunksX < chunks.numChunks()) {
+      const Uint32 up = lods[k + chunks.chunksX];
+      EXPECT_LE(std::max(lods[k], up) - std::min(lods[k], up), 1u);
+      EXPECT_EQ(bool(mask & StitchSide::STITCH_POS_Y), up > lods[k]);
+    }
+  }
+}
+
+GTEST_TEST(TestFrustumCulling, aabb_outside_clip_volume) {
+  const Mat4f mvp = Mat4f::Identity();
+  auto box = [](double x0, double y0, double z0, double x1, double y1,
+                double z1) {
+    return AABB{coal::Vec3s(x0, y0, z0), coal::Vec3s(x1, y1, z1)};
+  };
+  EXPECT_FALSE(isAABBOutsideFrustum(box(-.5, -.5, 0., .5, .5, .5), mvp));
+  // straddling a plane
+  EXPECT_FALSE(isAABBOutsideFrustum(box(.5, 0., 0., 2., .5, .5), mvp));
+  EXPECT_TRUE(isAABBOutsideFrustum(box(2., 0., 0., 3., .5, .5), mvp));
+  EXPECT_TRUE(isAABBOutsideFrustum(box(0., -3., 0., .5, -2., .5), mvp));
+  EXPECT_TRUE(isAABBOutsideFrustum(box(0., 0., 2., .5, .5, 3.), mvp));
+}
+
+GTEST_TEST(TestHeightfieldGrid, grid_indices) {
+  const Uint32 nx = 5, ny = 3;
+  MeshData data = loadHeightfieldGrid(nx, ny);
+  EXPECT_EQ(data.primitiveType, SDL_GPU_PRIMITIVETYPE_LINELIST);
+  EXPECT_EQ(data.numVertices(), nx * ny);
+  EXPECT_EQ(data.numIndices(), 2 * ((nx - 1) * ny + nx * (ny - 1)));
+  // vertices are the (float) grid indices, row by row
+  const auto positions = data.getAttribute<GpuVec2>(VertexAttrib::Position);
+  for (Uint32 j = 0; j < ny; j++) {
+    for (Uint32 i = 0; i < nx; i++) {
+      EXPECT_EQ(positions[j * nx + i].x(), float(i));
+      EXPECT_EQ(positions[j * nx + i].y(), float(j));
+    }
+  }
+  // lines join neighbouring grid points, each pair once
+  std::set<std::pair<Uint32, Uint32>> edges;
+  for (Uint32 k = 0; k < data.numIndices(); k += 2) {
+    const Uint32 a = data.indexData[k], b = data.indexData[k + 1];
+    ASSERT_LT(b, nx * ny);
+    EXPECT_TRUE(b == a + 1 || b == a + nx);
+    if (b == a + 1)
+      EXPECT_NE(b % nx, 0u);
+    EXPECT_TRUE(edges.emplace(a, b).second);
+  }
+}
+
+GTEST_TEST(TestHeightfieldGrid, smallest_grid) {
+  MeshData data = loadHeightfieldGrid(2, 2);
+  EXPECT_EQ(data.numVertices(), 4u);
+  const std::vector<MeshData::IndexType> expected{0, 1, 0, 2, 1, 3, 2, 3};
+  EXPECT_EQ(data.indexData, expected);
+}
@@ -0,0 +1,393 @@
+#include "candlewick/utils/ImageWriter.h"
+#include "candlewick/third-party/fpng.h"
+#include <gtest/gtest.h>
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+
+using namespace candlewick;
+using namespace candlewick::media;
+
+namespace {
+/// Temporary directory, removed with its contents.
+struct TempDir {
+  std::filesystem::path path;
+
+  explicit TempDir(const char *name)
+      : path(std::filesystem::temp_directory_path() /
+             ("candlewick_test_" + std::string(name))) {
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+  }
+  ~TempDir() { std::filesystem::remove_all(path); }
+
+  std::string file(const char *name) const { return (path / name).string(); }
+};
+
+std::vector<Uint8> readFile(const std::string &filename) {
+  std::ifstream file{filename, std::ios::binary};
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+std::vector<Uint8> randomBytes(size_t n, Uint32 seed) {
+  std::mt19937 gen{seed};
+  std::uniform_int_distribution<int> dist{0, 255};
+  std::vector<Uint8> bytes(n);
+  for (auto &b : bytes)
+    b = Uint8(dist(gen));
+  return bytes;
+}
+
+/// Minimal QOI decoder, to 4 channels.
+std::vector<Uint8> decodeQoi(const std::vector<Uint8> &data, Uint32 &width,
+                             Uint32 &height) {
+  auto u32 = [&](size_t i) {
+    return Uint32(data[i]) << 24 | Uint32(data[i + 1]) << 16 |
+           Uint32(data[i + 2]) << 8 | Uint32(data[i + 3]);
+  };
+  width = u32(4);
+  height = u32(8);
+  std::vector<Uint8> out;
+  std::array<std::array<Uint8, 4>, 64> index{};
+  std::array<Uint8, 4> px{0, 0, 0, 255};
+  size_t i = 14;
+  const size_t numPixels = size_t(width) * height;
+  while (out.size() < 4 * numPixels) {
+    const Uint8 b = data[i++];
+    Uint32 run = 1;
+    if (b == 0xfe) {
+      px = {data[i], data[i + 1], data[i + 2], px[3]};
+      i += 3;
+    } else if (b == 0xff) {
+      px = {data[i], data[i + 1], data[i + 2], data[i + 3]};
+      i += 4;
+    } else if ((b >> 6) == 0) {
+      px = index[b];
+    } else if ((b >> 6) == 1) {
+      px[0] = Uint8(px[0] + ((b >> 4) & 3) - 2);
+      px[1] = Uint8(px[1] + ((b >> 2) & 3) - 2);
+      px[2] = Uint8(px[2] + (b & 3) - 2);
+    } else if ((b >> 6) == 2) {
+      const int vg = (b & 0x3f) - 32;
+      const Uint8 b2 = data[i++];
+      px[0] = Uint8(px[0] + vg - 8 + ((b2 >> 4) & 0xf));
+      px[1] = Uint8(px[1] + vg);
+      px[2] = Uint8(px[2] + vg - 8 + (b2 & 0xf));
+    } else {
+      run = (b & 0x3f) + 1u;
+    }
+    index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64] = px;
+    for (Uint32 k = 0; k < run; k++)
+      out.insert(out.end(), px.begin(), px.end());
+  }
+  return out;
+}
+
+Uint32 readU32BE(const Uint8 *p) {
+  return Uint32(p[0]) << 24 | Uint32(p[1]) << 16 | Uint32(p[2]) << 8 |
+         Uint32(p[3]);
+}
+
+template <typename T> T readLE(const std::vector<Uint8> &data, size_t &pos) {
+  T value;
+  std::memcpy(&value, data.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+std::string readString(const std::vector<Uint8> &data, size_t &pos) {
+  std::string str{reinterpret_cast<const char *>(data.data() + pos)};
+  pos += str.size() + 1;
+  return str;
+}
+
+/// Decoded 16-bit PNG, checking the chunk CRCs and the zlib checksum. Only
+/// stored deflate blocks and unfiltered scanlines are supported, which is what
+/// writePng16() produces.
+struct Png16 {
+  Uint32 width = 0, height = 0, channels = 0;
+  std::vector<Uint16> samples;
+
+  explicit Png16(const std::vector<Uint8> &data) {
+    const Uint8 signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    EXPECT_TRUE(std::equal(std::begin(signature), std::end(signature),
+                           data.begin()));
+    std::vector<Uint8> zlib;
+    for (size_t pos = 8; pos + 12 <= data.size();) {
+      const Uint32 length = readU32BE(&data[pos]);
+      const std::string type{data.begin() + pos + 4, data.begin() + pos + 8};
+      const Uint8 *chunk = &data[pos + 8];
+      Uint32 crc = 0xFFFFFFFFu;
+      for (size_t i = pos + 4; i < pos + 8 + length; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+          crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+      }
+      EXPECT_EQ(crc ^ 0xFFFFFFFFu, readU32BE(chunk + length)) << type;
+      if (type == "IHDR") {
+        width = readU32BE(chunk);
+        height = readU32BE(chunk + 4);
+        EXPECT_EQ(chunk[8], 16); // bit depth
+        channels = chunk[9] == 0 ? 1 : chunk[9] == 2 ? 3 : 0;
+      } else if (type == "IDAT") {
+        zlib.insert(zlib.end(), chunk, chunk + length);
+      }
+      pos += 12 + length;
+    }
+
+    std::vector<Uint8> raw;
+    size_t pos = 2;
+    for (bool final = false; !final;) {
+      final = zlib[pos] & 1;
+      EXPECT_EQ(zlib[pos] >> 1, 0); // stored block
+      const Uint16 len = Uint16(zlib[pos + 1] | zlib[pos + 2] << 8);
+      const Uint16 nlen = Uint16(zlib[pos + 3] | zlib[pos + 4] << 8);
+      EXPECT_EQ(Uint16(~len), nlen);
+      raw.insert(raw.end(), zlib.begin() + pos + 5,
+                 zlib.begin() + pos + 5 + len);
+      pos += 5 + len;
+    }
+    Uint32 a = 1, b = 0;
+    for (Uint8 byte : raw) {
+      a = (a + byte) % 65521u;
+      b = (b + a) % 65521u;
+    }
+    EXPECT_EQ((b << 16) | a, readU32BE(&zlib[pos]));
+
+    const size_t rowSize = 1 + size_t(width) * channels * 2;
+    EXPECT_EQ(raw.size(), rowSize * height);
+    for (Uint32 y = 0; y < height; y++) {
+      const Uint8 *row = raw.data() + y * rowSize;
+      EXPECT_EQ(row[0], 0); // no filter
+      for (size_t i = 0; i < size_t(width) * channels; i++)
+        samples.push_back(Uint16(row[1 + 2 * i] << 8 | row[2 + 2 * i]));
+    }
+  }
+};
+
+/// Decoded uncompressed scanline OpenEXR image with 4-byte samples, as
+/// interleaved pixels in the order of \p channelNames.
+struct Exr {
+  Uint32 width = 0, height = 0;
+  std::vector<std::string> channels;
+  std::vector<Sint32> pixelTypes;
+  std::vector<Uint32> samples;
+
+  Exr(const std::vector<Uint8> &data,
+      const std::vector<std::string> &channelNames) {
+    size_t pos = 0;
+    EXPECT_EQ(readLE<Uint32>(data, pos), 20000630u);
+    EXPECT_EQ(readLE<Uint32>(data, pos), 2u);
+    while (true) {
+      const std::string name = readString(data, pos);
+      if (name.empty())
+        break;
+      const std::string type = readString(data, pos);
+      const Uint32 size = readLE<Uint32>(data, pos);
+      const size_t end = pos + size;
+      if (name == "channels") {
+        while (data[pos] != 0) {
+          channels.push_back(readString(data, pos));
+          pixelTypes.push_back(readLE<Sint32>(data, pos));
+          pos += 12;
+        }
+      } else if (name == "compression") {
+        EXPECT_EQ(data[pos], 0);
+      } else if (name == "dataWindow") {
+        EXPECT_EQ(readLE<Sint32>(data, pos), 0);
+        EXPECT_EQ(readLE<Sint32>(data, pos), 0);
+        width = Uint32(readLE<Sint32>(data, pos) + 1);
+        height = Uint32(readLE<Sint32>(data, pos) + 1);
+      }
+      pos = end;
+    }
+
+    std::vector<Uint64> offsets;
+    for (Uint32 y = 0; y < height; y++)
+      offsets.push_back(readLE<Uint64>(data, pos));
+    const size_t numChannels = channels.size();
+    samples.resize(size_t(width) * height * numChannels);
+    for (Uint32 y = 0; y < height; y++) {
+      pos = offsets[y];
+      EXPECT_EQ(readLE<Sint32>(data, pos), Sint32(y));
+      EXPECT_EQ(readLE<Uint32>(data, pos), width * numChannels * 4);
+      // channels are stored one after the other, in alphabetical order
+      for (size_t c = 0; c < numChannels; c++) {
+        const auto dst = std::find(channelNames.begin(), channelNames.end(),
+                                   channels[c]) -
+                         channelNames.begin();
+        for (Uint32 x = 0; x < width; x++)
+          samples[(size_t(y) * width + x) * numChannels + size_t(dst)] =
+              readLE<Uint32>(data, pos);
+      }
+    }
+    EXPECT_EQ(pos, data.size());
+  }
+};
+} // namespace
+
+GTEST_TEST(TestImageWriter, queued_images) {
+  const TempDir dir{"image_writer"};
+  constexpr Uint32 width = 37;
+  constexpr Uint32 height = 21;
+  const auto rgba = randomBytes(4 * width * height, 1);
+  // runs, small and medium differences exercise the other QOI operations
+  auto smooth = rgba;
+  for (size_t i = 4; i < smooth.size(); i++) {
+    const Uint8 step[] = {0, 1, 7};
+    smooth[i] = i % 4 == 3 ? 255 : Uint8(smooth[i - 4] + step[(i / 4) % 3]);
+  }
+
+  std::vector<Uint8> bgra = rgba;
+  for (size_t i = 0; i < bgra.size(); i += 4)
+    std::swap(bgra[i], bgra[i + 2]);
+  std::vector<Uint8> rgb;
+  for (size_t i = 0; i < rgba.size(); i += 4)
+    rgb.insert(rgb.end(), rgba.begin() + i, rgba.begin() + i + 3);
+
+  std::atomic<Uint32> numOk{0};
+  {
+    // fewer slots than jobs, so that submit() has to wait
+    ImageWriter writer{2, 2};
+    auto submit = [&](const char *name, const std::vector<Uint8> &pixels,
+                      PixelLayout layout) {
+      const std::string filename = dir.file(name);
+      writer.submit({filename, pixels, width, height, layout,
+                     imageFileFormatFromFilename(filename)},
+                    [&](const std::string &, bool ok) { numOk += ok; });
+    };
+    submit("rgba.png", rgba, PixelLayout::RGBA8);
+    submit("bgra.png", bgra, PixelLayout::BGRA8);
+    submit("rgb.png", rgb, PixelLayout::RGB8);
+    submit("rgba.qoi", smooth, PixelLayout::RGBA8);
+    submit("rgba.raw", rgba, PixelLayout::RGBA8);
+    writer.waitIdle();
+    EXPECT_EQ(writer.numPending(), 0u);
+  }
+  EXPECT_EQ(numOk, 5u);
+
+  for (const char *name : {"rgba.png", "bgra.png", "rgb.png"}) {
+    std::vector<Uint8> decoded;
+    Uint32 w, h, channels;
+    ASSERT_EQ(fpng::fpng_decode_file(dir.file(name).c_str(), decoded, w, h,
+                                     channels, 4),
+              fpng::FPNG_DECODE_SUCCESS)
+        << name;
+    EXPECT_EQ(w, width);
+    EXPECT_EQ(h, height);
+    if (name == std::string_view{"rgb.png"}) {
+      EXPECT_EQ(channels, 3u);
+      for (size_t i = 0; i < rgba.size(); i += 4) {
+        ASSERT_TRUE(std::equal(rgba.begin() + i, rgba.begin() + i + 3,
+                               decoded.begin() + i))
+            << "pixel " << i / 4;
+      }
+    } else {
+      EXPECT_EQ(channels, 4u);
+      // BGRA pixels are written as RGBA
+      EXPECT_EQ(decoded, rgba) << name;
+    }
+  }
+
+  Uint32 w, h;
+  EXPECT_EQ(decodeQoi(readFile(dir.file("rgba.qoi")), w, h), smooth);
+  EXPECT_EQ(w, width);
+  EXPECT_EQ(h, height);
+
+  EXPECT_EQ(readFile(dir.file("rgba.raw")), rgba);
+}
+
+GTEST_TEST(TestImageWriter, rejects_invalid_jobs) {
+  const TempDir dir{"image_writer_invalid"};
+  std::vector<bool> results;
+  std::mutex mutex;
+  {
+    ImageWriter writer{1};
+    auto callback = [&](const std::string &, bool ok) {
+      std::lock_guard lock{mutex};
+      results.push_back(ok);
+    };
+    // too few pixels
+    writer.submit({dir.file("short.png"), std::vector<Uint8>(10), 4, 4,
+                   PixelLayout::RGBA8, ImageFileFormat::PNG},
+                  callback);
+    // float pixels cannot go to PNG
+    writer.submit({dir.file("float.png"), std::vector<Uint8>(64), 4, 4,
+                   PixelLayout::R32F, ImageFileFormat::PNG},
+                  callback);
+  }
+  EXPECT_EQ(results, (std::vector<bool>{false, false}));
+  EXPECT_FALSE(std::filesystem::exists(dir.file("short.png")));
+  EXPECT_FALSE(std::filesystem::exists(dir.file("float.png")));
+}
+
+GTEST_TEST(TestImageWriter, png16) {
+  const TempDir dir{"image_writer_png16"};
+  constexpr Uint32 width = 23;
+  constexpr Uint32 height = 19;
+  for (Uint32 channels : {1u, 3u}) {
+    std::vector<Uint16> pixels(width * height * channels);
+    std::mt19937 gen{channels};
+    std::uniform_int_distribution<Uint32> dist{0, 65535};
+    for (auto &p : pixels)
+      p = Uint16(dist(gen));
+    const std::string filename = dir.file("image.png");
+    ASSERT_TRUE(writePng16(filename, pixels.data(), width, height, channels));
+    const Png16 png{readFile(filename)};
+    EXPECT_EQ(png.width, width);
+    EXPECT_EQ(png.height, height);
+    EXPECT_EQ(png.channels, channels);
+    EXPECT_EQ(png.samples, pixels);
+  }
+  // more than one deflate block
+  const std::vector<Uint16> large(300 * 200, 0xBEEF);
+  ASSERT_TRUE(writePng16(dir.file("large.png"), large.data(), 300, 200, 1));
+  EXPECT_EQ(Png16{readFile(dir.file("large.png"))}.samples, large);
+
+  EXPECT_FALSE(writePng16(dir.file("bad.png"), large.data(), 10, 10, 2));
+}
+
+GTEST_TEST(TestImageWriter, exr) {
+  const TempDir dir{"image_writer_exr"};
+  constexpr Uint32 width = 13;
+  constexpr Uint32 height = 7;
+  std::mt19937 gen{3};
+  std::uniform_real_distribution<float> dist{-10.f, 10.f};
+
+  std::vector<float> rgb(width * height * 3);
+  for (auto &v : rgb)
+    v = dist(gen);
+  ASSERT_TRUE(writeExr(dir.file("rgb.exr"), rgb.data(), width, height, 3));
+  const Exr rgbExr{readFile(dir.file("rgb.exr")), {"R", "G", "B"}};
+  EXPECT_EQ(rgbExr.width, width);
+  EXPECT_EQ(rgbExr.height, height);
+  EXPECT_EQ(rgbExr.channels, (std::vector<std::string>{"B", "G", "R"}));
+  EXPECT_EQ(rgbExr.pixelTypes, (std::vector<Sint32>{2, 2, 2}));
+  for (size_t i = 0; i < rgb.size(); i++)
+    ASSERT_EQ(std::bit_cast<float>(rgbExr.samples[i]), rgb[i]) << i;
+
+  std::vector<float> depth(rgb.begin(), rgb.begin() + width * height);
+  ASSERT_TRUE(writeExr(dir.file("depth.exr"), depth.data(), width, height, 1));
+  const Exr depthExr{readFile(dir.file("depth.exr")), {"Y"}};
+  EXPECT_EQ(depthExr.channels, (std::vector<std::string>{"Y"}));
+  EXPECT_EQ(depthExr.pixelTypes, (std::vector<Sint32>{2}));
+  for (size_t i = 0; i < depth.size(); i++)
+    ASSERT_EQ(std::bit_cast<float>(depthExr.samples[i]), depth[i]) << i;
+
+  std::vector<Uint32> ids(width * height);
+  for (Uint32 i = 0; i < ids.size(); i++)
+    ids[i] = i * 2654435761u;
+  ASSERT_TRUE(writeExr(dir.file("ids.exr"), ids.data(), width, height));
+  const Exr idsExr{readFile(dir.file("ids.exr")), {"Y"}};
+  EXPECT_EQ(idsExr.pixelTypes, (std::vector<Sint32>{0}));
+  EXPECT_EQ(idsExr.samples, ids);
+}
@@ -0,0 +1,88 @@
+#include "candlewick/core/InstanceBuffer.h"
+#include <gtest/gtest.h>
+
+using namespace candlewick;
+
+namespace {
+/// Entity-like handle, whose mesh and material are looked up in a table.
+struct Item {
+  Uint32 mesh;
+  Uint32 material;
+  Uint32 id;
+};
+
+std::vector<Uint32> ids(const std::vector<Item> &items) {
+  std::vector<Uint32> out;
+  for (const Item &item : items)
+    out.push_back(item.id);
+  return out;
+}
+
+std::vector<Uint32> sortBatches(std::vector<Item> &items,
+                                std::vector<Item> &unbatched) {
+  return sortInstanceBatches(items, unbatched, [](const Item &item) {
+    return std::pair{item.mesh, item.material};
+  });
+}
+} // namespace
+
+GTEST_TEST(TestInstanceBatching, empty) {
+  std::vector<Item> items, unbatched;
+  EXPECT_TRUE(sortBatches(items, unbatched).empty());
+  EXPECT_TRUE(items.empty());
+  EXPECT_TRUE(unbatched.empty());
+}
+
+GTEST_TEST(TestInstanceBatching, shared_meshes) {
+  // two meshes shared by several items, interleaved, and one unique mesh
+  std::vector<Item> items{
+      {1, 0, 0}, {2, 0, 1}, {1, 0, 2}, {3, 0, 3},
+      {2, 0, 4}, {1, 0, 5}, {2, 0, 6},
+  };
+  std::vector<Item> unbatched;
+  const auto sizes = sortBatches(items, unbatched);
+  EXPECT_EQ(sizes, (std::vector<Uint32>{3, 3}));
+  // batched items are grouped by mesh, in their original order
+  EXPECT_EQ(ids(items), (std::vector<Uint32>{0, 2, 5, 1, 4, 6}));
+  EXPECT_EQ(ids(unbatched), (std::vector<Uint32>{3}));
+}
+
+GTEST_TEST(TestInstanceBatching, different_materials) {
+  // items sharing a mesh are batched by material
+  std::vector<Item> items{
+      {1, 0, 0}, {1, 1, 1}, {1, 0, 2}, {1, 1, 3},
+      {2, 0, 4}, {2, 1, 5}, {1, 2, 6},
+  };
+  std::vector<Item> unbatched;
+  const auto sizes = sortBatches(items, unbatched);
+  EXPECT_EQ(sizes, (std::vector<Uint32>{2, 2}));
+  EXPECT_EQ(ids(items), (std::vector<Uint32>{0, 2, 1, 3}));
+  // a single item per (mesh, material) gives no batch
+  EXPECT_EQ(ids(unbatched), (std::vector<Uint32>{6, 4, 5}));
+}
+
+GTEST_TEST(TestInstanceBatching, instance_ranges) {
+  std::vector<Item> items;
+  for (Uint32 i = 0; i < 10; i++)
+    items.push_back({i % 3, 0, i});
+  std::vector<Item> unbatched{{7, 0, 100}};
+  const auto sizes = sortBatches(items, unbatched);
+  EXPECT_EQ(sizes, (std::vector<Uint32>{4, 3, 3}));
+  // the batches cover the batched items, which can be uploaded as is
+  Uint32 first = 0;
+  for (Uint32 size : sizes) {
+    for (Uint32 k = first; k < first + size; k++)
+      EXPECT_EQ(items[k].mesh, items[first].mesh);
+    first += size;
+  }
+  EXPECT_EQ(first, items.size());
+  // unbatched items are appended
+  EXPECT_EQ(ids(unbatched), (std::vector<Uint32>{100}));
+}
+
+GTEST_TEST(TestInstanceBatching, instance_data_layout) {
+  // matches the std430 layout of InstanceData in PbrBasicInstanced.vert
+  EXPECT_EQ(sizeof(PbrInstanceData), 144u);
+  EXPECT_EQ(offsetof(PbrInstanceData, normalMatrix), 64u);
+  EXPECT_EQ(offsetof(PbrInstanceData, color), 128u);
+}
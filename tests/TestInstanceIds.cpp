@@ -0,0 +1,27 @@
+#include "candlewick/multibody/RobotScene.h"
+#include <entt/entity/registry.hpp>
+#include <gtest/gtest.h>
+
+using candlewick::multibody::RobotScene;
+
+GTEST_TEST(TestInstanceIds, background) {
+  EXPECT_EQ(RobotScene::entityFromInstanceId(0), entt::entity{entt::null});
+}
+
+GTEST_TEST(TestInstanceIds, round_trip) {
+  entt::registry registry;
+  std::vector<entt::entity> entities;
+  for (int i = 0; i < 100; i++)
+    entities.push_back(registry.create());
+  // recycled entities carry a version in their upper bits
+  for (int i = 0; i < 100; i += 3)
+    registry.destroy(entities[size_t(i)]);
+  for (int i = 0; i < 20; i++)
+    entities.push_back(registry.create());
+
+  for (entt::entity ent : entities) {
+    const Uint32 id = RobotScene::instanceIdFromEntity(ent);
+    EXPECT_NE(id, 0u);
+    EXPECT_EQ(RobotScene::entityFromInstanceId(id), ent);
+  }
+}
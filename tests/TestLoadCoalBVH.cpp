@@ -0,0 +1,70 @@
+#include "candlewick/core/LoadCoalGeometries.h"
+#include "candlewick/core/DefaultVertex.h"
+#include "candlewick/utils/MeshData.h"
+#include <gtest/gtest.h>
+
+#include <coal/BVH/BVH_model.h>
+
+using namespace candlewick;
+
+namespace {
+coal::BVHModel<coal::OBBRSS>
+makeModel(const std::vector<coal::Vec3s> &vertices,
+          const std::vector<coal::Triangle> &tris) {
+  coal::BVHModel<coal::OBBRSS> model;
+  model.beginModel();
+  model.addSubModel(vertices, tris);
+  model.endModel();
+  return model;
+}
+} // namespace
+
+GTEST_TEST(LoadCoalBVH, tetrahedron) {
+  // centered on the origin, with outward-facing triangles
+  const std::vector<coal::Vec3s> vertices{
+      {1., 1., 1.}, {1., -1., -1.}, {-1., 1., -1.}, {-1., -1., 1.}};
+  const std::vector<coal::Triangle> tris{
+      {0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+  auto model = makeModel(vertices, tris);
+
+  MeshData md = loadCoalBVH(model);
+  EXPECT_EQ(md.primitiveType, SDL_GPU_PRIMITIVETYPE_TRIANGLELIST);
+  ASSERT_EQ(md.numVertices(), 4u);
+  ASSERT_EQ(md.numIndices(), 12u);
+  for (Uint32 i = 0; i < 12; i++)
+    EXPECT_EQ(md.indexData[i], tris[i / 3][i % 3]);
+
+  // the smooth normals of a regular tetrahedron point to its vertices
+  auto view = md.viewAs<const DefaultVertex>();
+  for (Uint32 i = 0; i < 4; i++) {
+    const Float3 pos = view[i].pos;
+    const Float3 normal = view[i].normal;
+    EXPECT_TRUE(pos.isApprox(vertices[i].cast<float>()));
+    EXPECT_TRUE(normal.isApprox(pos.normalized(), 1e-5f));
+    EXPECT_TRUE(Float3(view[i].tangent).isZero());
+  }
+}
+
+GTEST_TEST(LoadCoalBVH, large_grid) {
+  // enough triangles for the normals to be computed in parallel
+  constexpr Uint32 n = 256;
+  std::vector<coal::Vec3s> vertices;
+  std::vector<coal::Triangle> tris;
+  for (Uint32 j = 0; j <= n; j++)
+    for (Uint32 i = 0; i <= n; i++)
+      vertices.emplace_back(double(i), double(j), 0.);
+  for (Uint32 j = 0; j < n; j++) {
+    for (Uint32 i = 0; i < n; i++) {
+      const Uint32 k = j * (n + 1) + i;
+      tris.emplace_back(k, k + 1, k + n + 2);
+      tris.emplace_back(k, k + n + 2, k + n + 1);
+    }
+  }
+  auto model = makeModel(vertices, tris);
+
+  MeshData md = loadCoalBVH(model);
+  ASSERT_EQ(md.numVertices(), vertices.size());
+  ASSERT_EQ(md.numIndices(), 3 * tris.size());
+  for (const DefaultVertex &v : md.viewAs<const DefaultVertex>())
+    ASSERT_TRUE(Float3(v.normal).isApprox(Float3::UnitZ()));
+}
@@ -0,0 +1,126 @@
+#include "candlewick/core/MeshUpdater.h"
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace candlewick;
+
+namespace {
+// the staging layer never dereferences the buffers
+SDL_GPUBuffer *fakeBuffer(std::uintptr_t id) {
+  return reinterpret_cast<SDL_GPUBuffer *>(id * 16);
+}
+
+std::vector<std::byte> bytes(Uint8 first, Uint32 count) {
+  std::vector<std::byte> out(count);
+  for (Uint32 i = 0; i < count; i++)
+    out[i] = std::byte(first + i);
+  return out;
+}
+
+/// Contents of the range of \p upload in the staged data.
+std::vector<std::byte> stagedData(const MeshUpdateStaging &staging,
+                                  const MeshUpdateStaging::Upload &upload) {
+  auto data = staging.data().subspan(upload.srcOffset, upload.size);
+  return {data.begin(), data.end()};
+}
+} // namespace
+
+GTEST_TEST(TestMeshUpdater, staging_offsets) {
+  MeshUpdateStaging staging;
+  EXPECT_TRUE(staging.empty());
+  const auto a = bytes(0, 8);
+  const auto b = bytes(100, 4);
+  staging.add(fakeBuffer(1), 64, 16, a);
+  staging.add(fakeBuffer(2), 64, 0, b);
+  // empty updates are not staged
+  staging.add(fakeBuffer(1), 64, 0, {});
+  ASSERT_EQ(staging.uploads().size(), 2u);
+  EXPECT_EQ(staging.data().size(), 12u);
+
+  const auto &u0 = staging.uploads()[0];
+  EXPECT_EQ(u0.buffer, fakeBuffer(1));
+  EXPECT_EQ(u0.srcOffset, 0u);
+  EXPECT_EQ(u0.dstOffset, 16u);
+  EXPECT_EQ(u0.size, 8u);
+  EXPECT_EQ(stagedData(staging, u0), a);
+  const auto &u1 = staging.uploads()[1];
+  EXPECT_EQ(u1.buffer, fakeBuffer(2));
+  EXPECT_EQ(u1.srcOffset, 8u);
+  EXPECT_EQ(u1.dstOffset, 0u);
+  EXPECT_EQ(stagedData(staging, u1), b);
+
+  staging.clear();
+  EXPECT_TRUE(staging.empty());
+  EXPECT_TRUE(staging.data().empty());
+}
+
+GTEST_TEST(TestMeshUpdater, coalesce_disjoint) {
+  MeshUpdateStaging staging;
+  staging.add(fakeBuffer(1), 64, 32, bytes(0, 8));
+  staging.add(fakeBuffer(1), 64, 0, bytes(10, 8));
+  // same range, in another buffer
+  staging.add(fakeBuffer(2), 64, 8, bytes(20, 8));
+  staging.coalesce();
+  ASSERT_EQ(staging.uploads().size(), 3u);
+  EXPECT_EQ(staging.data().size(), 24u);
+  for (const auto &upload : staging.uploads())
+    EXPECT_EQ(upload.size, 8u);
+}
+
+GTEST_TEST(TestMeshUpdater, coalesce_adjacent) {
+  MeshUpdateStaging staging;
+  staging.add(fakeBuffer(1), 64, 8, bytes(8, 8));
+  staging.add(fakeBuffer(1), 64, 0, bytes(0, 8));
+  staging.add(fakeBuffer(1), 64, 16, bytes(16, 4));
+  staging.coalesce();
+  ASSERT_EQ(staging.uploads().size(), 1u);
+  const auto &upload = staging.uploads()[0];
+  EXPECT_EQ(upload.dstOffset, 0u);
+  EXPECT_EQ(upload.size, 20u);
+  EXPECT_EQ(stagedData(staging, upload), bytes(0, 20));
+  // the staged data is compacted
+  EXPECT_EQ(staging.data().size(), 20u);
+}
+
+GTEST_TEST(TestMeshUpdater, coalesce_overlapping) {
+  MeshUpdateStaging staging;
+  staging.add(fakeBuffer(1), 64, 0, bytes(0, 16));
+  // later updates win where they overlap
+  staging.add(fakeBuffer(1), 64, 4, bytes(100, 4));
+  staging.add(fakeBuffer(1), 64, 12, bytes(200, 8));
+  // bridges the first range and a disjoint one
+  staging.add(fakeBuffer(1), 64, 32, bytes(50, 4));
+  staging.add(fakeBuffer(1), 64, 18, bytes(150, 16));
+  staging.coalesce();
+  ASSERT_EQ(staging.uploads().size(), 1u);
+  const auto &upload = staging.uploads()[0];
+  EXPECT_EQ(upload.dstOffset, 0u);
+  EXPECT_EQ(upload.size, 36u);
+
+  auto expected = bytes(0, 36);
+  auto write = [&expected](Uint32 offset, const std::vector<std::byte> &src) {
+    std::copy(src.begin(), src.end(), expected.begin() + offset);
+  };
+  write(4, bytes(100, 4));
+  write(12, bytes(200, 8));
+  write(32, bytes(50, 4));
+  write(18, bytes(150, 16));
+  EXPECT_EQ(stagedData(staging, upload), expected);
+}
+
+GTEST_TEST(TestMeshUpdater, out_of_bounds) {
+  MeshUpdateStaging staging;
+  // ends exactly at the end of the buffer
+  staging.add(fakeBuffer(1), 64, 56, bytes(0, 8));
+  EXPECT_THROW(staging.add(fakeBuffer(1), 64, 60, bytes(0, 8)),
+               std::runtime_error);
+  EXPECT_THROW(staging.add(fakeBuffer(1), 64, 64, bytes(0, 1)),
+               std::runtime_error);
+  // offset + size would wrap around in 32 bits
+  EXPECT_THROW(staging.add(fakeBuffer(1), 64, ~0u, bytes(0, 2)),
+               std::runtime_error);
+  // rejected updates are not staged
+  EXPECT_EQ(staging.uploads().size(), 1u);
+  EXPECT_EQ(staging.data().size(), 8u);
+}
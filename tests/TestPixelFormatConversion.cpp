@@ -0,0 +1,352 @@
+#include "candlewick/utils/PixelFormatConversion.h"
+#include "candlewick/core/Camera.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace candlewick;
+
+// Test sizes which exercise both the vectorized loops and the scalar tails.
+static const Uint32 kSizes[] = {0, 1, 3, 7, 16, 33, 101, 1024 + 13};
+
+static std::vector<SimdLevel> supportedLevels() {
+  std::vector<SimdLevel> levels;
+  const SimdLevel prev = getSimdLevel();
+  for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE4_1,
+                          SimdLevel::AVX2, SimdLevel::NEON}) {
+    if (setSimdLevel(level))
+      levels.push_back(level);
+  }
+  setSimdLevel(prev);
+  return levels;
+}
+
+// Restore the dispatched instruction set at the end of each test.
+struct SimdLevelGuard {
+  SimdLevel prev = getSimdLevel();
+  ~SimdLevelGuard() { setSimdLevel(prev); }
+};
+
+static std::vector<Uint32> randomPixels(Uint32 n) {
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<Uint32> dist;
+  std::vector<Uint32> pixels(n);
+  for (auto &p : pixels)
+    p = dist(gen);
+  return pixels;
+}
+
+static std::vector<float> randomDepths(Uint32 n) {
+  std::mt19937 gen{7};
+  std::uniform_real_distribution<float> dist{-0.1f, 1.1f};
+  std::vector<float> depths(n);
+  for (auto &d : depths)
+    d = dist(gen);
+  // edge cases: exact ties, saturation, NaN
+  const float special[] = {0.f,
+                           1.f,
+                           0.5f / 1000.f,
+                           1.5f / 1000.f,
+                           70.f,
+                           -3.f,
+                           std::numeric_limits<float>::quiet_NaN()};
+  for (Uint32 i = 0; i < n && i < std::size(special); i++)
+    depths[n - 1 - i] = special[i];
+  return depths;
+}
+
+GTEST_TEST(TestPixelFormatConversion, detect) {
+  EXPECT_TRUE(setSimdLevel(SimdLevel::Scalar));
+  EXPECT_EQ(getSimdLevel(), SimdLevel::Scalar);
+  EXPECT_TRUE(setSimdLevel(detectSimdLevel()));
+  EXPECT_EQ(getSimdLevel(), detectSimdLevel());
+}
+
+GTEST_TEST(TestPixelFormatConversion, bgra_to_rgba) {
+  SimdLevelGuard guard;
+  for (SimdLevel level : supportedLevels()) {
+    for (Uint32 n : kSizes) {
+      auto src = randomPixels(n);
+      std::vector<Uint32> expected(n);
+      for (Uint32 i = 0; i < n; i++) {
+        Uint32 p = src[i];
+        expected[i] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) |
+                      ((p & 0xFF) << 16);
+      }
+      setSimdLevel(level);
+      std::vector<Uint32> out(n);
+      bgraToRgbaConvert(src.data(), out.data(), n);
+      EXPECT_EQ(out, expected) << "level " << int(level) << " n " << n;
+
+      bgraToRgbaConvert(src.data(), n);
+      EXPECT_EQ(src, expected) << "level " << int(level) << " n " << n;
+    }
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, rgba_to_rgb) {
+  SimdLevelGuard guard;
+  for (SimdLevel level : supportedLevels()) {
+    for (Uint32 n : kSizes) {
+      auto pixels = randomPixels(n);
+      std::vector<Uint8> src(4 * n);
+      std::memcpy(src.data(), pixels.data(), src.size());
+      std::vector<Uint8> expected(3 * n);
+      for (Uint32 i = 0; i < n; i++) {
+        for (Uint32 c = 0; c < 3; c++)
+          expected[3 * i + c] = src[4 * i + c];
+      }
+      setSimdLevel(level);
+      std::vector<Uint8> out(3 * n);
+      rgbaToRgbConvert(src.data(), out.data(), n);
+      EXPECT_EQ(out, expected) << "level " << int(level) << " n " << n;
+
+      rgbaToRgbConvert(src.data(), n);
+      src.resize(3 * n);
+      EXPECT_EQ(src, expected) << "level " << int(level) << " n " << n;
+    }
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, depth_to_uint16) {
+  SimdLevelGuard guard;
+  for (float scale : {65535.f, 1000.f}) {
+    for (Uint32 n : kSizes) {
+      const auto src = randomDepths(n);
+      setSimdLevel(SimdLevel::Scalar);
+      std::vector<Uint16> expected(n);
+      depthToUint16Convert(src.data(), expected.data(), n, scale);
+      for (Uint32 i = 0; i < n; i++) {
+        float v = src[i] * scale;
+        if (std::isnan(v) || v <= 0.f)
+          EXPECT_EQ(expected[i], 0u);
+        else if (v >= 65535.f)
+          EXPECT_EQ(expected[i], 65535u);
+        else
+          EXPECT_EQ(expected[i], Uint16(std::nearbyint(v)));
+      }
+
+      for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+        std::vector<Uint16> out(n);
+        depthToUint16Convert(src.data(), out.data(), n, scale);
+        EXPECT_EQ(out, expected) << "level " << int(level) << " n " << n;
+
+        auto inplace = src;
+        Uint16 *res = depthToUint16Convert(inplace.data(), n, scale);
+        EXPECT_TRUE(std::equal(res, res + n, expected.begin()))
+            << "level " << int(level) << " n " << n;
+      }
+    }
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, linearize_depth) {
+  SimdLevelGuard guard;
+  const float zNear = 0.01f;
+  const float zFar = 100.f;
+  for (Uint32 n : kSizes) {
+    std::vector<float> src(n);
+    for (Uint32 i = 0; i < n; i++)
+      src[i] = float(i) / float(std::max(n, 2u) - 1);
+
+    setSimdLevel(SimdLevel::Scalar);
+    std::vector<float> expected(n);
+    linearizeDepthConvert(src.data(), expected.data(), n, zNear, zFar);
+    if (n > 1) {
+      // depth 1 maps to the far plane
+      EXPECT_NEAR(expected[n - 1], zFar, 1e-3f * zFar);
+    }
+
+    for (SimdLevel level : supportedLevels()) {
+      setSimdLevel(level);
+      std::vector<float> out(n);
+      linearizeDepthConvert(src.data(), out.data(), n, zNear, zFar);
+      auto inplace = src;
+      linearizeDepthConvert(inplace.data(), n, zNear, zFar);
+      for (Uint32 i = 0; i < n; i++) {
+        EXPECT_FLOAT_EQ(out[i], expected[i]);
+        EXPECT_FLOAT_EQ(inplace[i], expected[i]);
+      }
+    }
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, linearize_projected_depth) {
+  // the depth buffer holds the NDC depth of perspectiveFromFov(), which must
+  // be mapped back to the view-space distance
+  SimdLevelGuard guard;
+  const float zNear = 0.05f;
+  const float zFar = 50.f;
+  const Mat4f proj = perspectiveFromFov(Radf(1.0f), 4.f / 3.f, zNear, zFar);
+  std::vector<float> distances, depths;
+  // the NDC depth is negative below 2 * zNear * zFar / (zFar + zNear), and
+  // those points are clipped away
+  for (float dist = 0.1f; dist < zFar; dist *= 1.3f) {
+    const Float4 clip = proj * Float4{0.1f, -0.2f, -dist, 1.f};
+    distances.push_back(dist);
+    depths.push_back(clip.z() / clip.w());
+  }
+  distances.push_back(zFar);
+  depths.push_back(1.f);
+
+  const Uint32 n = Uint32(depths.size());
+  for (SimdLevel level : supportedLevels()) {
+    setSimdLevel(level);
+    std::vector<float> out(n);
+    linearizeDepthConvert(depths.data(), out.data(), n, zNear, zFar);
+    for (Uint32 i = 0; i < n; i++)
+      EXPECT_NEAR(out[i], distances[i], 1e-3f * distances[i])
+          << "level " << int(level) << " depth " << depths[i];
+  }
+}
+
+namespace {
+// Reference BT.601 limited range conversion of a tightly packed RGBA image.
+struct YuvReference {
+  std::vector<Uint8> y, u, v;
+
+  YuvReference(const std::vector<Uint8> &rgba, Uint32 w, Uint32 h) {
+    const Uint32 cw = (w + 1) / 2, ch = (h + 1) / 2;
+    y.resize(w * h);
+    u.resize(cw * ch);
+    v.resize(cw * ch);
+    auto px = [&](Uint32 i, Uint32 j, Uint32 c) -> int {
+      return rgba[4 * (std::min(j, h - 1) * w + std::min(i, w - 1)) + c];
+    };
+    for (Uint32 j = 0; j < h; j++) {
+      for (Uint32 i = 0; i < w; i++) {
+        int r = px(i, j, 0), g = px(i, j, 1), b = px(i, j, 2);
+        y[j * w + i] = Uint8(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+      }
+    }
+    for (Uint32 j = 0; j < ch; j++) {
+      for (Uint32 i = 0; i < cw; i++) {
+        int s[3];
+        for (Uint32 c = 0; c < 3; c++)
+          s[c] = px(2 * i, 2 * j, c) + px(2 * i + 1, 2 * j, c) +
+                 px(2 * i, 2 * j + 1, c) + px(2 * i + 1, 2 * j + 1, c);
+        int cb = -38 * s[0] - 74 * s[1] + 112 * s[2];
+        int cr = 112 * s[0] - 94 * s[1] - 18 * s[2];
+        u[j * cw + i] = Uint8(((cb + 512) >> 10) + 128);
+        v[j * cw + i] = Uint8(((cr + 512) >> 10) + 128);
+      }
+    }
+  }
+};
+
+// Planes with padded rows, like those of an AVFrame.
+struct YuvPlanes {
+  static constexpr Uint32 kPadding = 7;
+  Uint32 widths[3], heights[3], pitches[3];
+  std::vector<Uint8> data[3];
+
+  YuvPlanes(Uint32 w, Uint32 h)
+      : widths{w, (w + 1) / 2, (w + 1) / 2}, heights{h, (h + 1) / 2,
+                                                     (h + 1) / 2} {
+    for (Uint32 p = 0; p < 3; p++) {
+      pitches[p] = widths[p] + kPadding;
+      data[p].assign(pitches[p] * heights[p], 0xAB);
+    }
+  }
+
+  void convert(const std::vector<Uint8> &pixels, bool bgra) {
+    Uint8 *planes[3] = {data[0].data(), data[1].data(), data[2].data()};
+    rgbaToYuv420Convert(pixels.data(), widths[0], heights[0], planes, pitches,
+                        bgra);
+  }
+
+  std::vector<Uint8> plane(Uint32 p) const {
+    std::vector<Uint8> out;
+    for (Uint32 j = 0; j < heights[p]; j++) {
+      auto row = data[p].begin() + pitches[p] * j;
+      out.insert(out.end(), row, row + widths[p]);
+      // the padding is left untouched
+      for (Uint32 i = widths[p]; i < pitches[p]; i++)
+        EXPECT_EQ(row[i], 0xAB);
+    }
+    return out;
+  }
+};
+} // namespace
+
+GTEST_TEST(TestPixelFormatConversion, rgba_to_yuv420) {
+  SimdLevelGuard guard;
+  const std::pair<Uint32, Uint32> sizes[] = {
+      {1, 1}, {2, 2}, {3, 5}, {7, 3}, {16, 4}, {33, 9}, {101, 17}, {640, 2}};
+  for (auto [w, h] : sizes) {
+    const auto pixels = randomPixels(w * h);
+    std::vector<Uint8> rgba(4 * w * h);
+    std::memcpy(rgba.data(), pixels.data(), rgba.size());
+    std::vector<Uint8> bgra = rgba;
+    for (Uint32 i = 0; i < w * h; i++)
+      std::swap(bgra[4 * i], bgra[4 * i + 2]);
+    const YuvReference expected{rgba, w, h};
+
+    for (SimdLevel level : supportedLevels()) {
+      setSimdLevel(level);
+      for (bool is_bgra : {false, true}) {
+        YuvPlanes out{w, h};
+        out.convert(is_bgra ? bgra : rgba, is_bgra);
+        EXPECT_EQ(out.plane(0), expected.y)
+            << "level " << int(level) << " size " << w << "x" << h;
+        EXPECT_EQ(out.plane(1), expected.u)
+            << "level " << int(level) << " size " << w << "x" << h;
+        EXPECT_EQ(out.plane(2), expected.v)
+            << "level " << int(level) << " size " << w << "x" << h;
+      }
+    }
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, rgba_to_yuv420_range) {
+  // black and white map to the ends of the limited range, with neutral chroma
+  for (Uint32 value : {0x00000000u, 0xFFFFFFFFu}) {
+    const std::vector<Uint32> pixels(17 * 3, value);
+    std::vector<Uint8> rgba(4 * pixels.size());
+    std::memcpy(rgba.data(), pixels.data(), rgba.size());
+    YuvPlanes out{17, 3};
+    out.convert(rgba, false);
+    for (Uint8 y : out.plane(0))
+      EXPECT_EQ(y, value ? 235 : 16);
+    for (Uint32 p = 1; p < 3; p++)
+      for (Uint8 c : out.plane(p))
+        EXPECT_EQ(c, 128);
+  }
+}
+
+GTEST_TEST(TestPixelFormatConversion, half_to_float) {
+  EXPECT_EQ(halfToFloat(0x0000), 0.f);
+  EXPECT_TRUE(std::signbit(halfToFloat(0x8000)));
+  EXPECT_EQ(halfToFloat(0x3C00), 1.f);
+  EXPECT_EQ(halfToFloat(0xC000), -2.f);
+  EXPECT_EQ(halfToFloat(0x3800), 0.5f);
+  EXPECT_EQ(halfToFloat(0x3555), 0.333251953125f);
+  // largest normal, smallest normal and smallest subnormal
+  EXPECT_EQ(halfToFloat(0x7BFF), 65504.f);
+  EXPECT_EQ(halfToFloat(0x0400), std::ldexp(1.f, -14));
+  EXPECT_EQ(halfToFloat(0x0001), std::ldexp(1.f, -24));
+  EXPECT_EQ(halfToFloat(0x83FF), -std::ldexp(1023.f, -24));
+  EXPECT_EQ(halfToFloat(0x7C00), std::numeric_limits<float>::infinity());
+  EXPECT_EQ(halfToFloat(0xFC00), -std::numeric_limits<float>::infinity());
+  EXPECT_TRUE(std::isnan(halfToFloat(0x7E00)));
+  EXPECT_TRUE(std::isnan(halfToFloat(0xFC01)));
+
+  // every finite value: (-1)^s * 2^(e - 15) * (1 + m / 1024), or
+  // 2^-14 * (m / 1024) for subnormals
+  for (Uint32 h = 0; h < 0x10000; h++) {
+    const Uint32 e = (h >> 10) & 0x1F;
+    if (e == 0x1F)
+      continue;
+    const float m = float(h & 0x3FF) / 1024.f;
+    float expected = e == 0 ? std::ldexp(m, -14)
+                            : std::ldexp(1.f + m, int(e) - 15);
+    if (h & 0x8000)
+      expected = -expected;
+    ASSERT_EQ(halfToFloat(Uint16(h)), expected) << "half " << h;
+  }
+}
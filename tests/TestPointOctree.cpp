@@ -0,0 +1,130 @@
+#include "candlewick/core/PointOctree.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace candlewick;
+
+namespace {
+constexpr Uint32 kNumPoints = 50000;
+const PointOctreeBuildConfig kConfig{.maxPointsPerNode = 1000,
+                                     .gridSize = 16};
+
+/// Flat random cloud, whose colors encode the point indices.
+struct TestCloud {
+  Eigen::Matrix3Xf positions = Eigen::Matrix3Xf::Random(3, kNumPoints);
+  PointColorMatrix colors{4, kNumPoints};
+
+  TestCloud() {
+    positions.row(2) *= 0.1f;
+    for (Uint32 i = 0; i < kNumPoints; i++)
+      colors.col(i) << Uint8(i), Uint8(i >> 8), Uint8(i >> 16), 255;
+  }
+};
+
+/// Octree file in the temporary directory, removed at the end of the test.
+struct TempOctreeFile {
+  std::string path;
+
+  explicit TempOctreeFile(const char *name)
+      : path((std::filesystem::temp_directory_path() /
+              ("candlewick_test_" + std::string(name) + ".cwpo"))
+                 .string()) {}
+  ~TempOctreeFile() { std::filesystem::remove(path); }
+};
+
+bool contains(const AABB &bounds, const Eigen::Vector3f &p) {
+  return (p.cast<coal::CoalScalar>().array() >= bounds.min_.array()).all() &&
+         (p.cast<coal::CoalScalar>().array() <= bounds.max_.array()).all();
+}
+} // namespace
+
+GTEST_TEST(TestPointOctree, roundtrip) {
+  const TestCloud cloud;
+  const auto &[positions, colors] = cloud;
+  const TempOctreeFile tmp{"roundtrip"};
+  buildPointOctree(tmp.path, positions, colors, kConfig);
+  PointOctreeFile file{tmp.path};
+  ASSERT_GT(file.numNodes(), 1u);
+  EXPECT_EQ(file.numPoints(), kNumPoints);
+
+  // every point is stored exactly once, inside the bounds of its node
+  std::vector<bool> seen(kNumPoints, false);
+  Eigen::Matrix3Xf node_positions;
+  PointColorMatrix node_colors;
+  for (Uint32 k = 0; k < file.numNodes(); k++) {
+    const PointOctreeNode &node = file.node(k);
+    EXPECT_LE(node.numPoints, kConfig.maxPointsPerNode);
+    file.readNode(k, node_positions, node_colors);
+    ASSERT_EQ(node_positions.cols(), node.numPoints);
+    for (Uint32 j = 0; j < node.numPoints; j++) {
+      const auto c = node_colors.col(j).cast<Uint32>();
+      const Uint32 i = c[0] | c[1] << 8 | c[2] << 16;
+      ASSERT_LT(i, kNumPoints);
+      EXPECT_FALSE(seen[i]);
+      seen[i] = true;
+      EXPECT_EQ(node_positions.col(j), positions.col(i));
+      EXPECT_TRUE(contains(node.bounds, node_positions.col(j)));
+    }
+    for (Uint32 child : node.children) {
+      if (child != PointOctreeNode::kNoChild)
+        EXPECT_EQ(file.node(child).depth, node.depth + 1);
+    }
+  }
+  EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](bool b) { return b; }));
+}
+
+GTEST_TEST(TestPointOctree, select_within_budget) {
+  const TestCloud cloud;
+  const TempOctreeFile tmp{"select_within_budget"};
+  buildPointOctree(tmp.path, cloud.positions, cloud.colors, kConfig);
+  PointOctreeFile file{tmp.path};
+  const Float3 camera{0.f, 0.f, 5.f};
+  std::vector<Uint32> selected;
+
+  // orthographic view of the whole cloud
+  const Mat4f model = Mat4f::Identity();
+  Mat4f proj = Mat4f::Identity();
+  proj.topLeftCorner<3, 3>() *= 0.5f;
+  file.selectNodes(model, proj, camera, 5000, selected);
+  ASSERT_FALSE(selected.empty());
+  EXPECT_EQ(selected.front(), 0u);
+  Uint64 numPoints = 0;
+  std::vector<bool> isSelected(file.numNodes(), false);
+  for (Uint32 k : selected) {
+    numPoints += file.node(k).numPoints;
+    isSelected[k] = true;
+  }
+  EXPECT_LE(numPoints, 5000u);
+  // selected nodes have selected parents
+  for (Uint32 k = 0; k < file.numNodes(); k++) {
+    for (Uint32 child : file.node(k).children) {
+      if (child != PointOctreeNode::kNoChild && isSelected[child])
+        EXPECT_TRUE(isSelected[k]);
+    }
+  }
+
+  // a larger budget selects everything
+  file.selectNodes(model, proj, camera, kNumPoints, selected);
+  EXPECT_EQ(selected.size(), file.numNodes());
+
+  // nothing is selected when the cloud is out of view
+  Mat4f away = Mat4f::Identity();
+  away.topRightCorner<3, 1>() << 10.f, 0.f, 0.f;
+  file.selectNodes(away, proj, camera, kNumPoints, selected);
+  EXPECT_TRUE(selected.empty());
+}
+
+GTEST_TEST(TestPointOctree, point_limit) {
+  const TestCloud cloud;
+  const TempOctreeFile file{"limit"};
+  PointOctreeBuildConfig config = kConfig;
+  config.maxPoints = kNumPoints - 1;
+  EXPECT_THROW(
+      buildPointOctree(file.path, cloud.positions, cloud.colors, config),
+      std::runtime_error);
+  config.maxPoints = kNumPoints;
+  buildPointOctree(file.path, cloud.positions, cloud.colors, config);
+  EXPECT_EQ(PointOctreeFile{file.path}.numPoints(), kNumPoints);
+}
@@ -0,0 +1,37 @@
+#include "candlewick/core/RenderStats.h"
+#include <gtest/gtest.h>
+
+using namespace candlewick;
+
+GTEST_TEST(TestRenderStats, bucketed_by_pass) {
+  render_stats::endFrame(); // start from a clean frame
+  {
+    RenderStatsPassScope scope{RenderStatsPass::Opaque};
+    render_stats::recordPipelineBind(SDL_GPU_PRIMITIVETYPE_TRIANGLELIST);
+    render_stats::recordDraw(36, 4);
+    {
+      RenderStatsPassScope nested{RenderStatsPass::Ssao};
+      render_stats::recordPipelineBind(SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP);
+      render_stats::recordDraw(6, 1);
+    }
+    EXPECT_EQ(render_stats::currentPass(), RenderStatsPass::Opaque);
+    render_stats::recordPipelineBind(SDL_GPU_PRIMITIVETYPE_LINELIST);
+    render_stats::recordDraw(10, 1);
+    render_stats::current().uniformBytes += 64;
+  }
+  EXPECT_EQ(render_stats::currentPass(), RenderStatsPass::Other);
+
+  const RenderStats &frame = render_stats::currentFrame();
+  const RenderCounters &opaque = frame[RenderStatsPass::Opaque];
+  EXPECT_EQ(opaque.drawCalls, 2u);
+  EXPECT_EQ(opaque.instances, 5u);
+  EXPECT_EQ(opaque.triangles, 48u); // lines are not counted
+  EXPECT_EQ(opaque.pipelineBinds, 2u);
+  EXPECT_EQ(opaque.uniformBytes, 64u);
+  EXPECT_EQ(frame[RenderStatsPass::Ssao].triangles, 4u);
+  EXPECT_EQ(frame.total().drawCalls, 3u);
+
+  render_stats::endFrame();
+  EXPECT_EQ(render_stats::lastFrame().total().drawCalls, 3u);
+  EXPECT_EQ(render_stats::currentFrame().total().drawCalls, 0u);
+}
@@ -1,6 +1,8 @@
 #include "candlewick/core/Shader.h"
 #include <gtest/gtest.h>
 
+#include <filesystem>
+
 using namespace candlewick;
 
 GTEST_TEST(TestShaderMetadata, uniform_buffer_only) {
@@ -87,3 +89,20 @@ GTEST_TEST(TestShaderMetadataReal, SolidColor_frag) {
   EXPECT_EQ(config.storage_textures, 0u);
   EXPECT_EQ(config.storage_buffers, 0u);
 }
+
+// Every shader stage source must be compiled, see process_shaders.py
+GTEST_TEST(TestShaderMetadataReal, all_stages_compiled) {
+  namespace fs = std::filesystem;
+  const fs::path compiled{CANDLEWICK_COMPILED_SHADERS_DIR};
+  for (const auto &entry : fs::directory_iterator{CANDLEWICK_SHADER_SRC_DIR}) {
+    // stage sources are named like PbrBasic.frag.slang, modules like
+    // utils.slang
+    const fs::path stem = entry.path().stem();
+    if (entry.path().extension() != ".slang" || !stem.has_extension())
+      continue;
+    for (const char *ext : {".spv", ".msl", ".json"}) {
+      const fs::path artifact = compiled / (stem.string() + ext);
+      EXPECT_TRUE(fs::exists(artifact)) << "missing " << artifact;
+    }
+  }
+}
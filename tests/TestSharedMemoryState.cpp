@@ -0,0 +1,114 @@
+#include "candlewick/runtime/SharedMemoryState.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace candlewick::runtime;
+
+static std::string segmentName(const char *test) {
+  return "candlewick_test_" + std::string(test) + "_" +
+         std::to_string(getpid());
+}
+
+GTEST_TEST(TestSharedMemoryState, roundtrip) {
+  auto server = SharedMemoryState::create(segmentName("roundtrip"), 7, 6);
+  auto client = SharedMemoryState::open(server.name());
+  EXPECT_EQ(client.nq(), 7u);
+  EXPECT_EQ(client.nv(), 6u);
+
+  Eigen::VectorXd q, v;
+  EXPECT_FALSE(server.read(q, v));
+
+  const Eigen::VectorXd q0 = Eigen::VectorXd::LinSpaced(7, 0., 1.);
+  client.write(q0);
+  ASSERT_TRUE(server.read(q, v));
+  EXPECT_EQ(q, q0);
+  EXPECT_EQ(v.size(), 0);
+  // already read
+  EXPECT_FALSE(server.read(q, v));
+
+  const Eigen::VectorXd v0 = Eigen::VectorXd::Constant(6, 3.);
+  client.write(q0, v0);
+  client.write(2 * q0, v0);
+  ASSERT_TRUE(server.read(q, v));
+  EXPECT_EQ(q, 2 * q0);
+  EXPECT_EQ(v, v0);
+  EXPECT_EQ(server.numWrites(), 3u);
+
+  EXPECT_THROW(client.write(Eigen::VectorXd::Zero(3)), std::runtime_error);
+}
+
+GTEST_TEST(TestSharedMemoryState, unlinked_by_owner) {
+  const std::string name = segmentName("unlink");
+  {
+    auto server = SharedMemoryState::create(name, 1, 1);
+  }
+  EXPECT_THROW(SharedMemoryState::open(name), std::runtime_error);
+}
+
+GTEST_TEST(TestSharedMemoryState, no_torn_reads) {
+  constexpr Uint32 n = 64;
+  auto server = SharedMemoryState::create(segmentName("torn"), n, n);
+  std::atomic_bool stop = false;
+  std::thread writer{[&, name = server.name()] {
+    auto client = SharedMemoryState::open(name);
+    Eigen::VectorXd q(n);
+    for (double k = 0.; !stop; k += 1.) {
+      q.setConstant(k);
+      client.write(q, q);
+    }
+  }};
+
+  // read while the writer is running, until enough states were published
+  constexpr Uint64 kMinWrites = 10000;
+  constexpr int kMinReads = 100;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  Eigen::VectorXd q, v;
+  int reads = 0;
+  int torn = 0;
+  while ((server.numWrites() < kMinWrites || reads < kMinReads) &&
+         std::chrono::steady_clock::now() < deadline) {
+    if (!server.read(q, v))
+      continue;
+    reads++;
+    // every coefficient comes from the same write
+    if (!(q.array() == q[0]).all() || !(v.array() == q[0]).all())
+      torn++;
+  }
+  stop = true;
+  writer.join();
+
+  EXPECT_GE(server.numWrites(), kMinWrites);
+  EXPECT_GE(reads, kMinReads);
+  EXPECT_EQ(torn, 0);
+}
+
+GTEST_TEST(TestSharedMemoryState, interrupted_write) {
+  auto server = SharedMemoryState::create(segmentName("interrupted"), 3, 3);
+  server.write(Eigen::VectorXd::Ones(3));
+  // a writer which died in the middle of a write leaves an odd sequence
+  // number behind
+  const int fd = shm_open(server.name().c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  void *ptr = mmap(nullptr, SharedMemoryState::kDataOffset,
+                   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(ptr, MAP_FAILED);
+  auto *seq = reinterpret_cast<Uint64 *>(static_cast<char *>(ptr) +
+                                         SharedMemoryState::kSequenceOffset);
+  *seq += 1;
+  Eigen::VectorXd q, v;
+  EXPECT_FALSE(server.read(q, v));
+  // the next complete write is read
+  *seq += 1;
+  EXPECT_TRUE(server.read(q, v));
+  EXPECT_EQ(q, Eigen::VectorXd::Ones(3));
+  munmap(ptr, SharedMemoryState::kDataOffset);
+}
@@ -0,0 +1,151 @@
+#include "candlewick/runtime/TrajectoryPlayer.h"
+#include <gtest/gtest.h>
+
+#include <pinocchio/multibody/joint/joints.hpp>
+
+using namespace candlewick::runtime;
+
+/// Two prismatic joints, so that configurations interpolate linearly.
+static pin::Model makeModel() {
+  pin::Model model;
+  auto j = model.addJoint(0, pin::JointModelPX(), pin::SE3::Identity(), "px");
+  model.addJoint(j, pin::JointModelPY(), pin::SE3::Identity(), "py");
+  return model;
+}
+
+/// Waypoints at t = 1, 2 and 4.
+static void loadTrajectory(TrajectoryPlayer &player, bool with_v) {
+  Eigen::MatrixXd qs(2, 3);
+  qs << 0., 1., 3., //
+      0., 2., 2.;
+  Eigen::MatrixXd vs;
+  if (with_v) {
+    vs.resize(2, 3);
+    vs << 1., 2., 0., //
+        2., 0., 0.;
+  }
+  player.load(std::move(qs), std::move(vs), {1., 2., 4.});
+}
+
+GTEST_TEST(TestTrajectoryPlayer, load) {
+  const auto model = makeModel();
+  TrajectoryPlayer player{model};
+  EXPECT_FALSE(player.loaded());
+  player.play();
+  EXPECT_FALSE(player.playing());
+
+  loadTrajectory(player, true);
+  EXPECT_TRUE(player.loaded());
+  EXPECT_FALSE(player.playing());
+  EXPECT_EQ(player.startTime(), 1.);
+  EXPECT_EQ(player.endTime(), 4.);
+  EXPECT_EQ(player.time(), 1.);
+
+  player.clear();
+  EXPECT_FALSE(player.loaded());
+  EXPECT_EQ(player.time(), 0.);
+}
+
+GTEST_TEST(TestTrajectoryPlayer, evaluate) {
+  const auto model = makeModel();
+  TrajectoryPlayer player{model};
+  loadTrajectory(player, true);
+  Eigen::VectorXd q, v;
+
+  player.evaluate(q, v);
+  EXPECT_TRUE(q.isApprox(Eigen::Vector2d(0., 0.)));
+  EXPECT_TRUE(v.isApprox(Eigen::Vector2d(1., 2.)));
+
+  player.seek(1.5);
+  player.evaluate(q, v);
+  EXPECT_TRUE(q.isApprox(Eigen::Vector2d(0.5, 1.)));
+  EXPECT_TRUE(v.isApprox(Eigen::Vector2d(1.5, 1.)));
+
+  // on a waypoint
+  player.seek(2.);
+  player.evaluate(q, v);
+  EXPECT_TRUE(q.isApprox(Eigen::Vector2d(1., 2.)));
+
+  player.seek(3.);
+  player.evaluate(q, v);
+  EXPECT_TRUE(q.isApprox(Eigen::Vector2d(2., 2.)));
+  EXPECT_TRUE(v.isApprox(Eigen::Vector2d(1., 0.)));
+
+  player.seek(4.);
+  player.evaluate(q, v);
+  EXPECT_TRUE(q.isApprox(Eigen::Vector2d(3., 2.)));
+
+  loadTrajectory(player, false);
+  player.evaluate(q, v);
+  EXPECT_EQ(v.size(), 0);
+}
+
+GTEST_TEST(TestTrajectoryPlayer, seek) {
+  const auto model = makeModel();
+  TrajectoryPlayer player{model};
+  // no trajectory
+  player.seek(2.);
+  EXPECT_EQ(player.time(), 0.);
+
+  loadTrajectory(player, false);
+  player.seek(2.5);
+  EXPECT_EQ(player.time(), 2.5);
+  EXPECT_FALSE(player.playing());
+  player.seek(-1.);
+  EXPECT_EQ(player.time(), 1.);
+  player.seek(10.);
+  EXPECT_EQ(player.time(), 4.);
+}
+
+GTEST_TEST(TestTrajectoryPlayer, advance) {
+  const auto model = makeModel();
+  TrajectoryPlayer player{model};
+  loadTrajectory(player, false);
+
+  // paused
+  player.advance(0.5);
+  EXPECT_EQ(player.time(), 1.);
+
+  player.play();
+  player.advance(0.5);
+  EXPECT_DOUBLE_EQ(player.time(), 1.5);
+
+  player.setRate(0.5);
+  player.advance(1.);
+  EXPECT_DOUBLE_EQ(player.time(), 2.);
+
+  // stop at the end
+  player.setRate(1.);
+  player.advance(5.);
+  EXPECT_EQ(player.time(), 4.);
+  EXPECT_FALSE(player.playing());
+
+  // backwards, stop at the start
+  player.play();
+  player.setRate(-2.);
+  player.advance(0.5);
+  EXPECT_DOUBLE_EQ(player.time(), 3.);
+  player.advance(5.);
+  EXPECT_EQ(player.time(), 1.);
+  EXPECT_FALSE(player.playing());
+}
+
+GTEST_TEST(TestTrajectoryPlayer, loop) {
+  const auto model = makeModel();
+  TrajectoryPlayer player{model};
+  loadTrajectory(player, false);
+  player.setLoop(true);
+  player.play();
+
+  // duration is 3 s
+  player.advance(4.);
+  EXPECT_DOUBLE_EQ(player.time(), 2.);
+  EXPECT_TRUE(player.playing());
+  player.advance(7.);
+  EXPECT_DOUBLE_EQ(player.time(), 3.);
+
+  player.setRate(-1.);
+  player.advance(2.5);
+  EXPECT_DOUBLE_EQ(player.time(), 3.5);
+  EXPECT_TRUE(player.playing());
+}